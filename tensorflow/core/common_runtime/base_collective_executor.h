@@ -98,12 +98,15 @@ class BaseCollectiveExecutor : public CollectiveExecutor {
   BaseCollectiveExecutor(CollectiveExecutorMgrInterface* cem,
                          CollectiveRemoteAccess* remote_access, int64_t step_id,
                          const DeviceMgr* dev_mgr,
-                         std::shared_ptr<UnboundedWorkQueue> work_queue)
+                         std::shared_ptr<UnboundedWorkQueue> work_queue,
+                         std::shared_ptr<CollectiveResidualStore>
+                             residual_store = nullptr)
       : CollectiveExecutor(cem),
         step_id_(step_id),
         dev_mgr_(dev_mgr),
         remote_access_(remote_access),
-        work_queue_(std::move(work_queue)) {}
+        work_queue_(std::move(work_queue)),
+        residual_store_(std::move(residual_store)) {}
 
   ~BaseCollectiveExecutor() override;
 
@@ -124,6 +127,10 @@ class BaseCollectiveExecutor : public CollectiveExecutor {
     work_queue_->Schedule(std::move(closure));
   }
 
+  CollectiveResidualStore* residual_store() override {
+    return residual_store_.get();
+  }
+
   // If we need to enforce an ordering on any portion of collective
   // implementation, and the ordering is encoded via attribute on the collective
   // op, this function will block until all dependencies for this collective
@@ -141,6 +148,9 @@ class BaseCollectiveExecutor : public CollectiveExecutor {
   // Ownership of `work_queue_` is shared between `this` and
   // `CollectiveExecutorMgr`.
   std::shared_ptr<UnboundedWorkQueue> work_queue_;
+  // Ownership of `residual_store_` is shared between `this` and
+  // `CollectiveExecutorMgr`, which keeps it across steps.
+  std::shared_ptr<CollectiveResidualStore> residual_store_;
   mutex launch_mu_;
   condition_variable launch_cv_;
   // collective instance key -> number of local devices for which NCCL ops have
@@ -0,0 +1,132 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/collective_compression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace collective_util {
+namespace {
+
+constexpr float kInt8MaxValue = 127;
+
+// Returns the scale of the int8 quantization of `values`[i] + `residual`[i].
+float Int8Scale(const float* values, const float* residual, int64_t n) {
+  float max_abs = 0;
+  for (int64_t i = 0; i < n; ++i) {
+    const float x = values[i] + (residual != nullptr ? residual[i] : 0);
+    max_abs = std::max(max_abs, std::abs(x));
+  }
+  return max_abs > 0 ? max_abs / kInt8MaxValue : 1;
+}
+
+}  // namespace
+
+DataType CompressedDataType(CollectiveCompression compression) {
+  switch (compression) {
+    case CollectiveCompression::kBfloat16:
+      return DT_BFLOAT16;
+    case CollectiveCompression::kInt8:
+      return DT_INT8;
+    case CollectiveCompression::kNone:
+      break;
+  }
+  LOG(FATAL) << "Unexpected compression "  // Crash OK
+             << static_cast<int>(compression);
+}
+
+int64_t CompressedNumElements(CollectiveCompression compression,
+                              int64_t num_elements) {
+  return compression == CollectiveCompression::kInt8
+             ? num_elements + static_cast<int64_t>(sizeof(float))
+             : num_elements;
+}
+
+void CompressWithErrorFeedback(CollectiveCompression compression,
+                               const Tensor& values, Tensor* residual,
+                               Tensor* compressed) {
+  const int64_t n = values.NumElements();
+  DCHECK_EQ(compressed->NumElements(), CompressedNumElements(compression, n));
+  const float* v = values.flat<float>().data();
+  float* r = nullptr;
+  if (residual != nullptr) {
+    DCHECK_EQ(residual->NumElements(), n);
+    r = residual->flat<float>().data();
+  }
+  switch (compression) {
+    case CollectiveCompression::kBfloat16: {
+      bfloat16* out = compressed->flat<bfloat16>().data();
+      for (int64_t i = 0; i < n; ++i) {
+        const float x = v[i] + (r != nullptr ? r[i] : 0);
+        out[i] = static_cast<bfloat16>(x);
+        if (r != nullptr) r[i] = x - static_cast<float>(out[i]);
+      }
+      break;
+    }
+    case CollectiveCompression::kInt8: {
+      const float scale = Int8Scale(v, r, n);
+      int8* out = compressed->flat<int8>().data();
+      for (int64_t i = 0; i < n; ++i) {
+        const float x = v[i] + (r != nullptr ? r[i] : 0);
+        const float q = std::min(
+            kInt8MaxValue, std::max(-kInt8MaxValue, std::round(x / scale)));
+        out[i] = static_cast<int8>(q);
+        if (r != nullptr) r[i] = x - q * scale;
+      }
+      std::memcpy(out + n, &scale, sizeof(scale));
+      break;
+    }
+    case CollectiveCompression::kNone:
+      LOG(FATAL) << "Unexpected compression kNone";  // Crash OK
+  }
+}
+
+void Decompress(CollectiveCompression compression, const Tensor& compressed,
+                Tensor* values) {
+  const int64_t n = values->NumElements();
+  DCHECK_EQ(compressed.NumElements(), CompressedNumElements(compression, n));
+  float* v = values->flat<float>().data();
+  switch (compression) {
+    case CollectiveCompression::kBfloat16: {
+      const bfloat16* in = compressed.flat<bfloat16>().data();
+      for (int64_t i = 0; i < n; ++i) {
+        v[i] = static_cast<float>(in[i]);
+      }
+      break;
+    }
+    case CollectiveCompression::kInt8: {
+      const int8* in = compressed.flat<int8>().data();
+      float scale;
+      std::memcpy(&scale, in + n, sizeof(scale));
+      for (int64_t i = 0; i < n; ++i) {
+        v[i] = in[i] * scale;
+      }
+      break;
+    }
+    case CollectiveCompression::kNone:
+      LOG(FATAL) << "Unexpected compression kNone";  // Crash OK
+  }
+}
+
+}  // namespace collective_util
+}  // namespace tensorflow
@@ -0,0 +1,56 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_COMPRESSION_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_COMPRESSION_H_
+
+#include <cstdint>
+
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.pb.h"
+
+namespace tensorflow {
+namespace collective_util {
+
+// Encoding of float values compressed with `compression`, which must not be
+// CollectiveCompression::kNone.
+//
+// kBfloat16 values are encoded as a DT_BFLOAT16 tensor of the same size.
+// kInt8 values are encoded as a DT_INT8 tensor holding the quantized values
+// followed by the bytes of their float scale.
+DataType CompressedDataType(CollectiveCompression compression);
+int64_t CompressedNumElements(CollectiveCompression compression,
+                              int64_t num_elements);
+
+// Encodes `values` + `*residual` into `compressed` and sets `*residual` to
+// the compression error, i.e. to `values` + `*residual` minus the value that
+// Decompress() returns, so that the error can be compensated the next time the
+// same values are compressed.  `residual` may be null to compress without
+// error feedback.
+//
+// `values` and `*residual` are 1-D DT_FLOAT tensors of the same size in host
+// memory, and `*compressed` is allocated with the type and size given above.
+void CompressWithErrorFeedback(CollectiveCompression compression,
+                               const Tensor& values, Tensor* residual,
+                               Tensor* compressed);
+
+// Decodes `compressed` into the 1-D DT_FLOAT tensor `*values`.
+void Decompress(CollectiveCompression compression, const Tensor& compressed,
+                Tensor* values);
+
+}  // namespace collective_util
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_COLLECTIVE_COMPRESSION_H_
@@ -0,0 +1,119 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/collective_compression.h"
+
+#include <cmath>
+
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace collective_util {
+namespace {
+
+Tensor Compressed(CollectiveCompression compression, int64_t num_elements) {
+  return Tensor(CompressedDataType(compression),
+                TensorShape({CompressedNumElements(compression,
+                                                   num_elements)}));
+}
+
+TEST(CollectiveCompressionTest, Sizes) {
+  EXPECT_EQ(CompressedDataType(CollectiveCompression::kBfloat16), DT_BFLOAT16);
+  EXPECT_EQ(CompressedNumElements(CollectiveCompression::kBfloat16, 10), 10);
+  EXPECT_EQ(CompressedDataType(CollectiveCompression::kInt8), DT_INT8);
+  EXPECT_EQ(CompressedNumElements(CollectiveCompression::kInt8, 10),
+            10 + static_cast<int64_t>(sizeof(float)));
+}
+
+TEST(CollectiveCompressionTest, Bfloat16RoundTrip) {
+  Tensor values = test::AsTensor<float>({0.0f, 1.0f, -2.5f, 1.0f / 3.0f});
+  Tensor compressed = Compressed(CollectiveCompression::kBfloat16, 4);
+  CompressWithErrorFeedback(CollectiveCompression::kBfloat16, values, nullptr,
+                            &compressed);
+  Tensor decompressed(DT_FLOAT, TensorShape({4}));
+  Decompress(CollectiveCompression::kBfloat16, compressed, &decompressed);
+  test::ExpectTensorNear<float>(values, decompressed, 1e-2);
+  // Values representable in bfloat16 are exact.
+  EXPECT_EQ(decompressed.flat<float>()(2), -2.5f);
+}
+
+TEST(CollectiveCompressionTest, Int8RoundTrip) {
+  Tensor values = test::AsTensor<float>({0.0f, 127.0f, -63.25f, 1.0f});
+  Tensor compressed = Compressed(CollectiveCompression::kInt8, 4);
+  CompressWithErrorFeedback(CollectiveCompression::kInt8, values, nullptr,
+                            &compressed);
+  // The scale is max |value| / 127, i.e. 1.
+  auto q = compressed.flat<int8>();
+  EXPECT_EQ(q(0), 0);
+  EXPECT_EQ(q(1), 127);
+  EXPECT_EQ(q(3), 1);
+  Tensor decompressed(DT_FLOAT, TensorShape({4}));
+  Decompress(CollectiveCompression::kInt8, compressed, &decompressed);
+  test::ExpectTensorNear<float>(values, decompressed, 0.25);
+}
+
+TEST(CollectiveCompressionTest, Int8AllZeros) {
+  Tensor values = test::AsTensor<float>({0.0f, 0.0f, 0.0f});
+  Tensor compressed = Compressed(CollectiveCompression::kInt8, 3);
+  CompressWithErrorFeedback(CollectiveCompression::kInt8, values, nullptr,
+                            &compressed);
+  Tensor decompressed(DT_FLOAT, TensorShape({3}));
+  Decompress(CollectiveCompression::kInt8, compressed, &decompressed);
+  test::ExpectTensorEqual<float>(values, decompressed);
+}
+
+TEST(CollectiveCompressionTest, ResidualIsCompressionError) {
+  for (CollectiveCompression compression :
+       {CollectiveCompression::kBfloat16, CollectiveCompression::kInt8}) {
+    Tensor values = test::AsTensor<float>({0.3f, -1.7f, 2.9f, 0.01f});
+    Tensor residual = test::AsTensor<float>({0.1f, 0.0f, -0.2f, 0.02f});
+    const Tensor initial_residual = tensor::DeepCopy(residual);
+    Tensor compressed = Compressed(compression, 4);
+    CompressWithErrorFeedback(compression, values, &residual, &compressed);
+    Tensor decompressed(DT_FLOAT, TensorShape({4}));
+    Decompress(compression, compressed, &decompressed);
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_NEAR(decompressed.flat<float>()(i) + residual.flat<float>()(i),
+                  values.flat<float>()(i) + initial_residual.flat<float>()(i),
+                  1e-6);
+    }
+  }
+}
+
+TEST(CollectiveCompressionTest, ErrorFeedbackCancelsBias) {
+  // 0.003 is below the int8 resolution of a chunk that also holds 1, so it is
+  // always rounded to 0 without error feedback.  With error feedback, the
+  // residual accumulates until it is sent, and the average is preserved.
+  Tensor values = test::AsTensor<float>({1.0f, 0.003f});
+  Tensor residual = test::AsTensor<float>({0.0f, 0.0f});
+  Tensor compressed = Compressed(CollectiveCompression::kInt8, 2);
+  Tensor decompressed(DT_FLOAT, TensorShape({2}));
+  constexpr int kNumSteps = 1000;
+  double sum = 0;
+  for (int step = 0; step < kNumSteps; ++step) {
+    CompressWithErrorFeedback(CollectiveCompression::kInt8, values, &residual,
+                              &compressed);
+    Decompress(CollectiveCompression::kInt8, compressed, &decompressed);
+    sum += decompressed.flat<float>()(1);
+  }
+  EXPECT_NEAR(sum / kNumSteps, 0.003, 1e-4);
+}
+
+}  // namespace
+}  // namespace collective_util
+}  // namespace tensorflow
@@ -77,6 +77,9 @@ class CollectiveExecutorMgr : public CollectiveExecutorMgrInterface {
   // collective op execution.  Ownership is shared between `this` and
   // `CollectiveRemoteAccessLocal`.
   std::shared_ptr<UnboundedWorkQueue> work_queue_;
+  // Error-feedback residuals of compressed collectives, kept across steps.
+  // Ownership is shared between `this` and the step-specific executors.
+  std::shared_ptr<CollectiveResidualStore> residual_store_;
 
  private:
   mutex exec_mu_;
@@ -23,6 +23,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_join.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/framework/cancellation.h"
@@ -80,13 +81,41 @@ const char* GetCollectiveName(const CollectiveParams* cp, bool nccl) {
       return nccl ? "NcclAllToAll" : "AllToAll";
 
     case REDUCE_SCATTER_COLLECTIVE:
-      return nccl ? "NcclReduceScatter" : "undef";
+      return nccl ? "NcclReduceScatter" : "RingReduceScatter";
 
     default:
       return "undef";
   }
 }
 
+// All-reduces of at most this many bytes use recursive halving/doubling
+// instead of the ring on CPU; larger ones are bandwidth bound and better served
+// by the ring, whose subdivisions pipeline the transfers.
+constexpr int64_t kRecursiveHalvingDoublingMaxBytes = 256 * 1024;
+
+// Returns true if `cp` should use RecursiveHalvingDoublingReduce rather than
+// RingReduce, i.e. if the tensor is small enough that the 2 * log2(N)
+// sequential exchanges of the former beat the 2 * (N - 1) of the latter. The
+// decision only depends on params shared by all the members of the instance.
+bool UseRecursiveHalvingDoubling(const CollectiveParams& cp) {
+  if (cp.instance.type != REDUCTION_COLLECTIVE ||
+      cp.group.device_type != DEVICE_CPU || cp.group.group_size <= 2 ||
+      absl::StartsWith(cp.instance.impl_details.communication_hint, "ring")) {
+    return false;
+  }
+  const int64_t num_bytes = cp.instance.shape.num_elements() *
+                            DataTypeSize(cp.instance.data_type);
+  return num_bytes <= kRecursiveHalvingDoublingMaxBytes;
+}
+
+// Returns the compression of the ring chunks requested by `hint`, i.e.
+// "ring_bf16" or "ring_int8".
+CollectiveCompression CompressionFromHint(const string& hint) {
+  if (hint == "ring_bf16") return CollectiveCompression::kBfloat16;
+  if (hint == "ring_int8") return CollectiveCompression::kInt8;
+  return CollectiveCompression::kNone;
+}
+
 string TaskNameFromDeviceName(const string& device_name) {
   DeviceNameUtils::ParsedName parsed_device;
   CHECK(DeviceNameUtils::ParseFullName(device_name, &parsed_device));
@@ -693,6 +722,11 @@ void CollectiveParamResolverLocal::AssignCollectiveType(CollectiveParams* cp) {
   //
   // After enough testing, we may simplify this logic to use NCCL whenever
   // available.
+  //
+  // Otherwise, small all-reduces on CPU use recursive halving/doubling rather
+  // than the ring, unless the ring is requested by `communication_hint`.  The
+  // "ring_bf16" and "ring_int8" hints also request the ring, compressing the
+  // chunks it sends.
   CollectiveImplementationInterface* col_impl;
   bool use_nccl =
       (nccl_ || cp->instance.impl_details.communication_hint == "nccl") &&
@@ -700,6 +734,17 @@ void CollectiveParamResolverLocal::AssignCollectiveType(CollectiveParams* cp) {
       CollectiveRegistry::LookupParamResolverInstance("NcclReduce", &col_impl)
           .ok();
   cp->instance.impl_details.collective_name = GetCollectiveName(cp, use_nccl);
+  if (!use_nccl && UseRecursiveHalvingDoubling(*cp) &&
+      CollectiveRegistry::LookupParamResolverInstance(
+          "RecursiveHalvingDoublingReduce", &col_impl)
+          .ok()) {
+    cp->instance.impl_details.collective_name =
+        "RecursiveHalvingDoublingReduce";
+  }
+  cp->instance.impl_details.compression =
+      cp->instance.impl_details.collective_name == "RingReduce"
+          ? CompressionFromHint(cp->instance.impl_details.communication_hint)
+          : CollectiveCompression::kNone;
   VLOG(1) << "AssignCollectiveType "
           << cp->instance.impl_details.collective_name;
 }
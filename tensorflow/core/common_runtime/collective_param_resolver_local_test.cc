@@ -201,6 +201,8 @@ TEST_F(CollectiveParamResolverLocalTest, CompleteParamsReduction1Task) {
       EXPECT_TRUE(cps[i]->group.members[j].is_local);
     }
     EXPECT_EQ(cps[i]->instance.impl_details.subdiv_source_rank.size(), 0);
+    EXPECT_EQ(cps[i]->instance.impl_details.collective_name,
+              "RecursiveHalvingDoublingReduce");
     EXPECT_FALSE(cps[i]->is_source);
     EXPECT_EQ(cps[i]->default_rank, i);
     EXPECT_TRUE(cps[i]->group.same_num_devices_per_task);
@@ -208,6 +210,59 @@ TEST_F(CollectiveParamResolverLocalTest, CompleteParamsReduction1Task) {
   }
 }
 
+TEST_F(CollectiveParamResolverLocalTest, CompleteParamsReductionUsesRing) {
+  // Large tensors, or a "ring" hint, select the ring all-reduce.  The
+  // "ring_bf16" and "ring_int8" hints also select compression.
+  struct {
+    int instance_key;
+    TensorShape shape;
+    string communication_hint;
+    CollectiveCompression compression;
+  } const kCases[] = {
+      {8, TensorShape({1 << 20}), "", CollectiveCompression::kNone},
+      {9, TensorShape({5}), "ring", CollectiveCompression::kNone},
+      {10, TensorShape({5}), "ring_bf16", CollectiveCompression::kBfloat16},
+      {11, TensorShape({1 << 20}), "ring_int8", CollectiveCompression::kInt8}};
+  for (const auto& c : kCases) {
+    CollectiveParams* cps[NUM_DEVS];
+    absl::Status statuses[NUM_DEVS];
+    Notification note[NUM_DEVS];
+    for (int i = 0; i < NUM_DEVS; ++i) {
+      cps[i] = new CollectiveParams();
+      CollectiveParams* cp = cps[i];
+      cp->group.group_key = 1;
+      cp->group.group_size = 3;
+      cp->group.device_type = DeviceType("CPU");
+      cp->group.num_tasks = 1;
+      cp->instance.instance_key = c.instance_key;
+      cp->instance.type = REDUCTION_COLLECTIVE;
+      cp->instance.data_type = DataType(DT_FLOAT);
+      cp->instance.shape = c.shape;
+      cp->instance.impl_details.subdiv_offsets.push_back(0);
+      cp->instance.impl_details.communication_hint = c.communication_hint;
+      Env::Default()->SchedClosure([this, i, cp, &note, &statuses]() {
+        string device =
+            strings::StrCat("/job:localhost/replica:0/task:0/device:CPU:", i);
+        prl_->CompleteParamsAsync(GetDeviceAttributes(device), cp,
+                                  nullptr /*CancellationManager*/,
+                                  [&statuses, &note, i](const absl::Status& s) {
+                                    statuses[i] = s;
+                                    note[i].Notify();
+                                  });
+      });
+    }
+    for (int i = 0; i < NUM_DEVS; ++i) {
+      note[i].WaitForNotification();
+    }
+    for (int i = 0; i < NUM_DEVS; ++i) {
+      TF_ASSERT_OK(statuses[i]);
+      EXPECT_EQ(cps[i]->instance.impl_details.collective_name, "RingReduce");
+      EXPECT_EQ(cps[i]->instance.impl_details.compression, c.compression);
+      cps[i]->Unref();
+    }
+  }
+}
+
 void InitializeCollectiveParamsForBroadcast(int instance_key, int device_idx,
                                             bool is_source,
                                             CollectiveParams* cp) {
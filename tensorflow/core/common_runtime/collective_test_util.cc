@@ -178,7 +178,8 @@ std::unique_ptr<CollectiveTestEnv> CreateCollectiveTestEnv(
       test_env->device_mgr.get(), test_env->device_resolver.get(), kStepId);
   test_env->col_exec.reset(new BaseCollectiveExecutor(
       test_env->col_exec_mgr.get(), test_env->remote_access, kStepId,
-      test_env->device_mgr.get(), test_env->work_queue));
+      test_env->device_mgr.get(), test_env->work_queue,
+      std::make_shared<CollectiveResidualStore>()));
   if (use_nccl) {
     ConfigProto config_proto;
     test_env->nccl_communicator = MaybeCreateNcclCommunicator(config_proto);
@@ -162,6 +162,8 @@ EagerContext::EagerContext(
           "TF_EAGER_ENABLE_SMALL_TENSOR_CPU_PINNING", false)),
       run_eager_op_as_function_(run_eager_op_as_function),
       jit_compile_rewrite_(jit_compile_rewrite),
+      op_sequence_replay_(
+          ReadBoolFromEnvVar("TF_EAGER_OP_SEQUENCE_REPLAY", false)),
       register_abstract_functions_local_only_(ReadBoolFromEnvVar(
           "TF_EAGER_REGISTER_ABSTRACT_FUNCTIONS_LOCAL_ONLY", false)) {
   ResetPFLR(device_mgr, opts.env, &opts.config, TF_GRAPH_DEF_VERSION,
@@ -473,6 +475,7 @@ void EagerContext::ClearCachesAndDefaultExecutor() {
     // during this time as well.
     mutex_lock ml(cache_mu_);
     default_executor_.WaitForAllPendingNodes().IgnoreError();
+    op_sequence_cache_.Clear();
     kernel_cache_.clear();
     for (auto& entry : registered_functions_) {
       entry.second->cached_kernel_keys->clear();
@@ -741,6 +744,13 @@ void EagerContext::SetRunEagerOpAsFunction(bool enable) {
   run_eager_op_as_function_ = enable;
 }
 
+void EagerContext::SetOpSequenceReplay(bool enable) {
+  op_sequence_replay_ = enable;
+  if (!enable) {
+    op_sequence_cache_.Clear();
+  }
+}
+
 bool EagerContext::JitCompileRewrite() const {
   VLOG(3) << "JitCompileRewrite: " << jit_compile_rewrite_;
   return jit_compile_rewrite_;
@@ -1138,6 +1148,8 @@ absl::Status EagerContext::RemoveFunction(const string& func) {
       for (auto& key : *registered_function->cached_kernel_keys) {
         kernel_cache_.erase(key);
       }
+      // Primitive ops that run as functions may use `func`.
+      op_sequence_cache_.Clear();
       registered_functions_.erase(func);
     }
     registered_function->Unref();
@@ -36,6 +36,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/eager/custom_device_op_handler.h"
 #include "tensorflow/core/common_runtime/eager/eager_executor.h"
 #include "tensorflow/core/common_runtime/eager/kernel_and_device.h"
+#include "tensorflow/core/common_runtime/eager/op_sequence_cache.h"
 #include "tensorflow/core/common_runtime/eager/rendezvous_cache.h"
 #include "tensorflow/core/common_runtime/process_function_library_runtime.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
@@ -151,6 +152,15 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
 
   void SetRunEagerOpAsFunction(bool enable) override;
 
+  // Whether the kernels of repeated sequences of primitive ops are replayed
+  // from `op_sequence_cache()`.  Defaults to the value of the
+  // TF_EAGER_OP_SEQUENCE_REPLAY environment variable.
+  bool OpSequenceReplay() const { return op_sequence_replay_; }
+
+  void SetOpSequenceReplay(bool enable);
+
+  OpSequenceCache* op_sequence_cache() { return &op_sequence_cache_; }
+
   bool JitCompileRewrite() const;
 
   void SetJitCompileRewrite(bool enable) override;
@@ -787,6 +797,8 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
       TF_GUARDED_BY(device_cache_mu_);
   std::unordered_map<std::string, std::vector<std::function<void()>>>
       remove_function_notifiers_ TF_GUARDED_BY(remove_function_notifiers_mu_);
+  // Holds references to kernels of `kernel_cache_`.
+  OpSequenceCache op_sequence_cache_;
 
   // Whether we should compute RunMetadata.
   std::atomic<bool> should_store_graphs_{false};
@@ -901,6 +913,7 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
   std::function<void()> resource_deallocator_ = nullptr;
   bool run_eager_op_as_function_;
   bool jit_compile_rewrite_;
+  std::atomic<bool> op_sequence_replay_;
 
   // Controls the behavior of
   // `EagerContext::RegisterFunction(AbstractFunction*)` in distributed
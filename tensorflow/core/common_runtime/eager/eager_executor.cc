@@ -32,10 +32,19 @@ bool IsAsyncWaitForRemoteFunctionEnabled() {
                                  true, &enabled));
   return enabled;
 }
+
+int GetParallelDispatchThreads(int parallel_dispatch_threads) {
+  if (parallel_dispatch_threads >= 0) return parallel_dispatch_threads;
+  int64_t num_threads = 0;
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_EAGER_ASYNC_PARALLEL_DISPATCH_THREADS",
+                                  0, &num_threads));
+  return static_cast<int>(num_threads);
+}
 }  // namespace
 
 EagerExecutor::EagerExecutor(bool async, bool enable_streaming_enqueue,
-                             int in_flight_nodes_limit)
+                             int in_flight_nodes_limit,
+                             int parallel_dispatch_threads)
     : next_node_id_(0),
       ok_(true),
       thread_(async ? tensorflow::Env::Default()->StartThread(
@@ -51,6 +60,15 @@ EagerExecutor::EagerExecutor(bool async, bool enable_streaming_enqueue,
     VLOG(4) << "EagerExecutor InFlightNodes limit is set to "
             << in_flight_nodes_limit_;
   }
+  const int num_dispatch_threads =
+      async ? GetParallelDispatchThreads(parallel_dispatch_threads) : 0;
+  if (num_dispatch_threads > 0) {
+    VLOG(4) << "EagerExecutor dispatches nodes in parallel on "
+            << num_dispatch_threads << " threads";
+    dispatch_thread_pool_ = std::make_unique<thread::ThreadPool>(
+        tensorflow::Env::Default(), "eager_parallel_dispatch",
+        num_dispatch_threads);
+  }
 }
 
 EagerExecutor::~EagerExecutor() {
@@ -160,11 +178,15 @@ absl::Status EagerExecutor::AddOrExecute(std::unique_ptr<EagerNode> node) {
     } else {
       status = status_;
       if (status.ok()) {
-        node_queue_.push(std::move(item));
-        // If there were no previous nodes pending, wake the run thread to
-        // start processing requests again.
-        if (node_queue_.size() == 1) {
-          nodes_pending_.notify_all();
+        if (ParallelDispatch()) {
+          AddToDependencyGraphLocked(std::move(item));
+        } else {
+          node_queue_.push(std::move(item));
+          // If there were no previous nodes pending, wake the run thread to
+          // start processing requests again.
+          if (node_queue_.size() == 1) {
+            nodes_pending_.notify_all();
+          }
         }
         if (in_flight_nodes_limit_ == 0) {
           return absl::OkStatus();
@@ -238,7 +260,9 @@ void EagerExecutor::NodeDone(const core::RefCountPtr<NodeItem>& item,
   DCHECK(item->state != NodeState::kDONE);
   item->state = NodeState::kDONE;
 
-  bool async = item->node->AsAsync() != nullptr;
+  // With parallel dispatch, all the nodes are in unfinished_nodes_ like async
+  // nodes.
+  bool async = item->node->AsAsync() != nullptr || ParallelDispatch();
   // If executing synchronously we don't need to notify if status is OK since
   // the node  was never added to the unfinished_nodes_ list and nobody should
   // ever be waiting for it.
@@ -292,9 +316,19 @@ void EagerExecutor::NodeDone(const core::RefCountPtr<NodeItem>& item,
         node_queue_.pop();
       }
       for (auto& it : unfinished_nodes_) {
+        // Nodes running on the dispatch threads finish normally, but their
+        // outputs must not be poisoned meanwhile.
+        if (ParallelDispatch() && it.second->state != NodeState::kPENDING &&
+            it.second->node->AsAsync() == nullptr) {
+          continue;
+        }
         items_to_destroy.push_front(std::move(it.second));
       }
       unfinished_nodes_.clear();
+      producers_.clear();
+      last_serial_node_id_.reset();
+    } else if (ParallelDispatch()) {
+      ReleaseDependentsLocked(item.get());
     }
     if (need_notification) {
       NotifyWaiters(item->id);
@@ -413,7 +447,10 @@ absl::Status EagerExecutor::RunItem(core::RefCountPtr<NodeItem> item,
   auto async_ref = item.get();
   async_ref->Ref();
 
-  TF_RETURN_IF_ERROR(MoveToUnfinished(std::move(item), from_queue));
+  // With parallel dispatch, the node is already in unfinished_nodes_.
+  if (!ParallelDispatch()) {
+    TF_RETURN_IF_ERROR(MoveToUnfinished(std::move(item), from_queue));
+  }
 
   async_node->RunAsync([this, async_ref](const absl::Status& status) {
     core::RefCountPtr<NodeItem> async_item(async_ref);
@@ -443,6 +480,79 @@ absl::Status EagerExecutor::MoveToUnfinished(core::RefCountPtr<NodeItem> item,
   return absl::OkStatus();
 }
 
+void EagerExecutor::AddToDependencyGraphLocked(
+    core::RefCountPtr<NodeItem> item) {
+  NodeItem* raw_item = item.get();
+  auto wait_for = [raw_item](NodeItem* other) {
+    raw_item->Ref();
+    other->dependents.emplace_back(raw_item);
+    ++raw_item->num_pending_dependencies;
+  };
+  std::vector<const TensorHandle*> inputs;
+  if (item->node->GetDataDependencies(&inputs, &item->outputs)) {
+    // The node waits for the last serial node, which waits for all the nodes
+    // before it, and for the unfinished nodes that produce its inputs.
+    if (last_serial_node_id_.has_value()) {
+      auto it = unfinished_nodes_.find(*last_serial_node_id_);
+      if (it != unfinished_nodes_.end()) wait_for(it->second.get());
+    }
+    for (const TensorHandle* input : inputs) {
+      auto it = producers_.find(input);
+      if (it != producers_.end()) wait_for(it->second);
+    }
+    for (const TensorHandle* output : item->outputs) {
+      producers_[output] = raw_item;
+    }
+  } else {
+    // The node waits for all the unfinished nodes.  Those added before the
+    // last serial node are done, or the last serial node waits for them.
+    auto it = last_serial_node_id_.has_value()
+                  ? unfinished_nodes_.lower_bound(*last_serial_node_id_)
+                  : unfinished_nodes_.begin();
+    for (; it != unfinished_nodes_.end(); ++it) {
+      wait_for(it->second.get());
+    }
+    last_serial_node_id_ = item->id;
+  }
+  DVLOG(3) << "Add Node: [id " << item->id << "] waiting for "
+           << item->num_pending_dependencies << " nodes";
+  unfinished_nodes_.emplace_hint(unfinished_nodes_.end(), item->id,
+                                 std::move(item));
+  if (raw_item->num_pending_dependencies == 0) {
+    DispatchLocked(raw_item);
+  }
+}
+
+void EagerExecutor::ReleaseDependentsLocked(NodeItem* item) {
+  for (const TensorHandle* output : item->outputs) {
+    auto it = producers_.find(output);
+    if (it != producers_.end() && it->second == item) {
+      producers_.erase(it);
+    }
+  }
+  std::vector<core::RefCountPtr<NodeItem>> dependents;
+  dependents.swap(item->dependents);
+  for (const core::RefCountPtr<NodeItem>& dependent : dependents) {
+    if (--dependent->num_pending_dependencies == 0) {
+      DispatchLocked(dependent.get());
+    }
+  }
+}
+
+void EagerExecutor::DispatchLocked(NodeItem* item) {
+  if (state_ == ExecutorState::kShutDown) return;
+  DCHECK(item->state == NodeState::kPENDING);
+  item->state = NodeState::kSCHEDULED;
+  item->Ref();
+  dispatch_thread_pool_->Schedule([this, item]() {
+    absl::Status status = RunItem(core::RefCountPtr<NodeItem>(item),
+                                  /*from_queue=*/false);
+    if (!status.ok()) {
+      VLOG(1) << "Failed to run item: " << status;
+    }
+  });
+}
+
 void EagerExecutor::AddCleanup(intptr_t key, std::function<void()> callback) {
   cleanups_[key].push_back(callback);
 }
@@ -21,6 +21,7 @@ limitations under the License.
 #include <functional>
 #include <map>
 #include <memory>
+#include <optional>
 #include <queue>
 #include <string>
 #include <unordered_map>
@@ -37,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/version.h"
 
@@ -44,6 +46,7 @@ namespace tensorflow {
 
 class AsyncEagerNode;
 class AsyncRemoteExecuteNode;
+class TensorHandle;
 namespace eager {
 class EagerClient;
 }
@@ -79,6 +82,17 @@ class EagerNode {
 
   // Indicates whether a node failure should make the executor unusable.
   virtual bool Fatal() const { return true; }
+
+  // Returns whether this node may run concurrently with other nodes when the
+  // executor dispatches nodes in parallel, in which case `inputs` and
+  // `outputs` are set to the handles it reads and produces.  Such a node must
+  // have no side effects, since it is only ordered after the nodes that
+  // produce its inputs.  Other nodes run alone, after all the nodes added
+  // before them.
+  virtual bool GetDataDependencies(std::vector<const TensorHandle*>* inputs,
+                                   std::vector<const TensorHandle*>* outputs) {
+    return false;
+  }
 };
 
 class AsyncEagerNode : public EagerNode {
@@ -110,13 +124,20 @@ class AsyncRemoteExecuteNode : public AsyncEagerNode {
 // TODO(agarwal): TFE_OpAddInput may currently block if it tries to access the
 // device of the input handle. Fix that.
 // TODO(agarwal): Implement support for control dependencies.
-// TODO(agarwal): Support out-of-order execution and dispatching multiple
-// EagerNode in parallel.
 // TODO(agarwal): Implement optimizations over EagerNode traces.
+//
+// In async mode, nodes run one after the other on the executor thread, unless
+// `parallel_dispatch_threads` is positive.  In that case, each node runs on a
+// thread pool of that size as soon as the nodes it depends on are done (see
+// EagerNode::GetDataDependencies), so independent ops overlap.  A negative
+// value reads the number of threads from the
+// TF_EAGER_ASYNC_PARALLEL_DISPATCH_THREADS environment variable, which
+// defaults to 0.
 class EagerExecutor {
  public:
   explicit EagerExecutor(bool async, bool enable_streaming_enqueue = true,
-                         int in_flight_nodes_limit = 0);
+                         int in_flight_nodes_limit = 0,
+                         int parallel_dispatch_threads = -1);
 
   ~EagerExecutor();
 
@@ -129,6 +150,9 @@ class EagerExecutor {
 
   bool Async() const;
 
+  // Whether nodes run in parallel when their dependencies allow it.
+  bool ParallelDispatch() const { return dispatch_thread_pool_ != nullptr; }
+
   bool StreamingEnqueue() const;
 
   // Inline execute node if executor is in sync mode.
@@ -195,6 +219,14 @@ class EagerExecutor {
     uint64 id;
     std::unique_ptr<EagerNode> node;
     NodeState state;
+
+    // Only used with parallel dispatch.
+    // The handles produced by this node, if it runs in parallel.
+    std::vector<const TensorHandle*> outputs;
+    // The number of unfinished nodes this node waits for.
+    int num_pending_dependencies = 0;
+    // The nodes that wait for this node.
+    std::vector<core::RefCountPtr<NodeItem>> dependents;
   };
 
   const char* StateStringLocked()
@@ -211,6 +243,16 @@ class EagerExecutor {
   void Run();
 
   absl::Status RunItem(core::RefCountPtr<NodeItem> item, bool from_queue);
+
+  // Adds `item` to `unfinished_nodes_` with its dependencies, and runs it if
+  // it does not have any.
+  void AddToDependencyGraphLocked(core::RefCountPtr<NodeItem> item)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(node_queue_mutex_);
+  // Runs the nodes that only waited for `item`, which is done.
+  void ReleaseDependentsLocked(NodeItem* item)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(node_queue_mutex_);
+  void DispatchLocked(NodeItem* item)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(node_queue_mutex_);
   absl::Status MoveToUnfinished(core::RefCountPtr<NodeItem> item,
                                 bool from_queue);
 
@@ -235,9 +277,17 @@ class EagerExecutor {
       TF_GUARDED_BY(node_queue_mutex_);
 
   // Ordered by NodeItem::id.
+  // With parallel dispatch, nodes are added here instead of to `node_queue_`,
+  // and stay here until they are done.
   std::map<uint64, core::RefCountPtr<NodeItem>, std::less<uint64>>
       unfinished_nodes_ TF_GUARDED_BY(node_queue_mutex_);
 
+  // With parallel dispatch, the unfinished nodes that produce each handle, and
+  // the id of the last node that runs alone.
+  absl::flat_hash_map<const TensorHandle*, NodeItem*> producers_
+      TF_GUARDED_BY(node_queue_mutex_);
+  std::optional<uint64> last_serial_node_id_ TF_GUARDED_BY(node_queue_mutex_);
+
   // `status_` is set based on any errors raised during execution of a
   // EagerNode.  It remains set until ClearError is called.
   absl::Status status_ TF_GUARDED_BY(node_queue_mutex_);
@@ -278,6 +328,10 @@ class EagerExecutor {
   // async nodes reach this number, enqueuing to the eager async queue is
   // blocked.
   const int64_t in_flight_nodes_limit_;
+
+  // Runs the nodes when dispatching in parallel, nullptr otherwise.  Declared
+  // last so that the running nodes finish before the rest is destroyed.
+  std::unique_ptr<thread::ThreadPool> dispatch_thread_pool_;
 };
 
 inline bool EagerExecutor::Async() const { return thread_ != nullptr; }
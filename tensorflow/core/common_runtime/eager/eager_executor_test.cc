@@ -14,11 +14,16 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/eager/eager_executor.h"
 
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "xla/tsl/lib/core/status_test_util.h"
 #include "xla/tsl/protobuf/error_codes.pb.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/status_matchers.h"
 #include "tensorflow/core/platform/test.h"
@@ -102,6 +107,57 @@ class TestAsyncEagerNode : public AsyncEagerNode {
   absl::Status run_return_status_;
 };
 
+// A node that runs `fn`, and reads and produces the given handles when
+// `parallelizable` is true.
+class TestParallelEagerNode : public EagerNode {
+ public:
+  TestParallelEagerNode(std::vector<const TensorHandle*> inputs,
+                        std::vector<const TensorHandle*> outputs,
+                        std::function<absl::Status()> fn,
+                        bool parallelizable = true,
+                        std::atomic<bool>* aborted = nullptr)
+      : inputs_(std::move(inputs)),
+        outputs_(std::move(outputs)),
+        fn_(std::move(fn)),
+        parallelizable_(parallelizable),
+        aborted_(aborted) {}
+
+  absl::Status Run() override { return fn_(); }
+
+  void Abort(absl::Status status) override {
+    if (aborted_ != nullptr) *aborted_ = true;
+  }
+
+  bool GetDataDependencies(std::vector<const TensorHandle*>* inputs,
+                           std::vector<const TensorHandle*>* outputs) override {
+    if (!parallelizable_) return false;
+    *inputs = inputs_;
+    *outputs = outputs_;
+    return true;
+  }
+
+  string DebugString() const override { return "testParallelEagerNode"; }
+
+ private:
+  std::vector<const TensorHandle*> inputs_;
+  std::vector<const TensorHandle*> outputs_;
+  std::function<absl::Status()> fn_;
+  bool parallelizable_;
+  std::atomic<bool>* aborted_;
+};
+
+// The executor only compares the addresses of the handles.
+const TensorHandle* FakeHandle(int i) {
+  static char handles[8];
+  return reinterpret_cast<const TensorHandle*>(&handles[i]);
+}
+
+std::unique_ptr<EagerExecutor> ParallelExecutor() {
+  return std::make_unique<EagerExecutor>(
+      /*async=*/true, /*enable_streaming_enqueue=*/true,
+      /*in_flight_nodes_limit=*/0, /*parallel_dispatch_threads=*/4);
+}
+
 TEST(EagerExecutorTest, TestSyncExecutorWithEagerNode) {
   auto sync_executor = std::make_unique<EagerExecutor>(
       /*async=*/false, /*enable_streaming_enqueue=*/true);
@@ -281,5 +337,113 @@ TEST(EagerExecutorTest, TestAsyncExecutorAddNodesAfterShutdown) {
       async_executor->AddOrExecute(std::move(node)),
       tensorflow::testing::StatusIs(tensorflow::error::FAILED_PRECONDITION));
 }
+
+TEST(EagerExecutorTest, TestParallelDispatchRunsIndependentNodesConcurrently) {
+  auto executor = ParallelExecutor();
+  ASSERT_TRUE(executor->ParallelDispatch());
+
+  // Each node waits for the other one to start.
+  Notification a_started;
+  Notification b_started;
+  auto wait_for = [](Notification* other) -> absl::Status {
+    if (!other->WaitForNotificationWithTimeout(10 * 1000 * 1000)) {
+      return errors::Internal("Nodes did not run concurrently");
+    }
+    return absl::OkStatus();
+  };
+  TF_ASSERT_OK(executor->AddOrExecute(std::make_unique<TestParallelEagerNode>(
+      std::vector<const TensorHandle*>{}, std::vector{FakeHandle(0)}, [&] {
+        a_started.Notify();
+        return wait_for(&b_started);
+      })));
+  TF_ASSERT_OK(executor->AddOrExecute(std::make_unique<TestParallelEagerNode>(
+      std::vector<const TensorHandle*>{}, std::vector{FakeHandle(1)}, [&] {
+        b_started.Notify();
+        return wait_for(&a_started);
+      })));
+  TF_ASSERT_OK(executor->WaitForAllPendingNodes());
+  TF_ASSERT_OK(executor->ShutDown());
+}
+
+TEST(EagerExecutorTest, TestParallelDispatchFollowsDependencies) {
+  auto executor = ParallelExecutor();
+  std::atomic<bool> a_done(false);
+  std::atomic<bool> serial_done(false);
+  std::atomic<int> num_after_a(0);
+
+  // A produces handle 0, which B and C read.
+  TF_ASSERT_OK(executor->AddOrExecute(std::make_unique<TestParallelEagerNode>(
+      std::vector<const TensorHandle*>{}, std::vector{FakeHandle(0)}, [&] {
+        Env::Default()->SleepForMicroseconds(20 * 1000);
+        a_done = true;
+        return absl::OkStatus();
+      })));
+  for (int i = 0; i < 2; ++i) {
+    TF_ASSERT_OK(executor->AddOrExecute(std::make_unique<TestParallelEagerNode>(
+        std::vector{FakeHandle(0)}, std::vector{FakeHandle(1 + i)}, [&] {
+          if (!a_done) return errors::Internal("Ran before its input");
+          ++num_after_a;
+          return absl::OkStatus();
+        })));
+  }
+  // A serial node runs after all the nodes before it, and before the nodes
+  // after it.
+  TF_ASSERT_OK(executor->AddOrExecute(std::make_unique<TestParallelEagerNode>(
+      std::vector<const TensorHandle*>{}, std::vector<const TensorHandle*>{},
+      [&] {
+        if (num_after_a != 2) return errors::Internal("Ran too early");
+        serial_done = true;
+        return absl::OkStatus();
+      },
+      /*parallelizable=*/false)));
+  TF_ASSERT_OK(executor->AddOrExecute(std::make_unique<TestParallelEagerNode>(
+      std::vector<const TensorHandle*>{}, std::vector{FakeHandle(3)}, [&] {
+        if (!serial_done) return errors::Internal("Ran before serial node");
+        return absl::OkStatus();
+      })));
+  TF_ASSERT_OK(executor->WaitForAllPendingNodes());
+  EXPECT_EQ(num_after_a, 2);
+  TF_ASSERT_OK(executor->ShutDown());
+}
+
+TEST(EagerExecutorTest, TestParallelDispatchFailureAbortsPendingNodes) {
+  auto executor = ParallelExecutor();
+  std::atomic<bool> b_ran(false);
+  std::atomic<bool> b_aborted(false);
+
+  TF_ASSERT_OK(executor->AddOrExecute(std::make_unique<TestParallelEagerNode>(
+      std::vector<const TensorHandle*>{}, std::vector{FakeHandle(0)}, [] {
+        Env::Default()->SleepForMicroseconds(20 * 1000);
+        return errors::Internal("test");
+      })));
+  TF_ASSERT_OK(executor->AddOrExecute(std::make_unique<TestParallelEagerNode>(
+      std::vector{FakeHandle(0)}, std::vector{FakeHandle(1)},
+      [&] {
+        b_ran = true;
+        return absl::OkStatus();
+      },
+      /*parallelizable=*/true, &b_aborted)));
+
+  EXPECT_THAT(executor->WaitForAllPendingNodes(),
+              tensorflow::testing::StatusIs(tensorflow::error::INTERNAL));
+  EXPECT_FALSE(b_ran);
+  EXPECT_TRUE(b_aborted);
+  EXPECT_THAT(executor->AddOrExecute(std::make_unique<TestParallelEagerNode>(
+                  std::vector<const TensorHandle*>{},
+                  std::vector<const TensorHandle*>{},
+                  [] { return absl::OkStatus(); })),
+              tensorflow::testing::StatusIs(tensorflow::error::INTERNAL));
+
+  // The executor runs nodes again once the error is cleared.
+  executor->ClearError();
+  std::atomic<bool> c_ran(false);
+  TF_ASSERT_OK(executor->AddOrExecute(std::make_unique<TestParallelEagerNode>(
+      std::vector{FakeHandle(0)}, std::vector{FakeHandle(2)}, [&] {
+        c_ran = true;
+        return absl::OkStatus();
+      })));
+  TF_ASSERT_OK(executor->WaitForAllPendingNodes());
+  EXPECT_TRUE(c_ran);
+}
 }  // namespace
 }  // namespace tensorflow
@@ -67,6 +67,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/eager/copy_to_device_node.h"
 #include "tensorflow/core/common_runtime/eager/execute_node.h"
 #include "tensorflow/core/common_runtime/eager/kernel_and_device.h"
+#include "tensorflow/core/common_runtime/eager/op_sequence_cache.h"
 #include "tensorflow/core/common_runtime/eager/tensor_handle.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/function.h"
@@ -1238,12 +1239,73 @@ absl::Status SetOpDevice(EagerContext& ctx, EagerOperation* op,
   return absl::OkStatus();
 }
 
+// Builds what the kernel and device of the primitive op `op` depend on, for
+// OpSequenceCache.  This mirrors GetKernelCacheKey, except that the inputs are
+// described by the fields of their handles that GetDeviceForInput uses.
+absl::Status GetOpSequenceSignature(EagerOperation* op,
+                                    OpSequenceCache::Op* signature) {
+  EagerContext& ctx = op->EagerContext();
+  Fprint128 key = op->MutableAttrs()->CacheKey(op->DeviceName());
+  key = tsl::FingerprintCat128(key, ctx.AllowSoftPlacement());
+  key = tsl::FingerprintCat128(key, ctx.RunEagerOpAsFunction());
+  signature->key = key;
+  signature->device = std::get<Device*>(op->Device());
+  if (!ctx.RunEagerOpAsFunction()) return absl::OkStatus();
+
+  const absl::InlinedVector<TensorHandle*, 4>* inputs;
+  TF_RETURN_IF_ERROR(op->TensorHandleInputs(&inputs));
+  signature->inputs.reserve(inputs->size());
+  for (TensorHandle* input : *inputs) {
+    OpSequenceCache::Input& sig = signature->inputs.emplace_back();
+    sig.dtype = input->dtype;
+    sig.is_local = input->Type() == TensorHandle::LOCAL;
+    sig.device = input->device();
+    sig.resource_device = input->resource_device();
+    if (input->dtype == DT_RESOURCE) {
+      TF_RETURN_IF_ERROR(input->GetResourceHandleDtypesAndShapes(
+          &sig.resource_dtypes_and_shapes));
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status SetOutKernel(core::RefCountPtr<KernelAndDevice> kernel,
+                          int* num_retvals,
+                          core::RefCountPtr<KernelAndDevice>* out_kernel) {
+  int num_outputs = kernel->num_outputs();
+  if (num_outputs > *num_retvals) {
+    return errors::InvalidArgument("Expecting ", num_outputs,
+                                   " outputs, but *num_retvals is ",
+                                   *num_retvals);
+  }
+  *num_retvals = num_outputs;
+  *out_kernel = std::move(kernel);
+  return absl::OkStatus();
+}
+
 absl::Status GetOrCreateKernelAndDevice(
     EagerOperation* op, TensorHandle** retvals, int* num_retvals,
     core::RefCountPtr<KernelAndDevice>* out_kernel) {
   EagerContext& ctx = op->EagerContext();
   Device* device = std::get<Device*>(op->Device());
 
+  // Functions are excluded since their name may depend on the values of their
+  // inputs, see below.
+  const bool replay_op_sequence = ctx.OpSequenceReplay() && !op->is_function();
+  OpSequenceCache::Op op_signature;
+  if (replay_op_sequence) {
+    TF_RETURN_IF_ERROR(GetOpSequenceSignature(op, &op_signature));
+    Device* replayed_device = nullptr;
+    core::RefCountPtr<KernelAndDevice> kernel =
+        ctx.op_sequence_cache()->Lookup(op_signature, &replayed_device);
+    if (kernel != nullptr) {
+      if (device == nullptr) {
+        op->SetDevice(replayed_device);
+      }
+      return SetOutKernel(std::move(kernel), num_retvals, out_kernel);
+    }
+  }
+
   // Update the EagerOperation with information about the boolean input tensors
   // when small constant optimization is enabled.
   auto is_small_constant_optimization_enabled =
@@ -1338,6 +1400,7 @@ absl::Status GetOrCreateKernelAndDevice(
                         input_resource_variable_dtypes_and_shapes,
                         reuse_rendezvous_for_functions));
   core::RefCountPtr<KernelAndDevice> kernel = ctx.GetCachedKernel(cache_key);
+  bool kernel_is_cached = kernel != nullptr;
   AbstractOperationPtr wrapped_op_releaser;
   // We can eliminate some overhead by running simple functions using regular
   // CallOp kernel. However, it is tricky to figure out which functions should
@@ -1567,20 +1630,16 @@ absl::Status GetOrCreateKernelAndDevice(
       // If the kernel is already in the cache, this discards the passed-in
       // kernel and returns the cached kernel.
       kernel = ctx.AddKernelToCache(cache_key, std::move(kernel));
+      kernel_is_cached = true;
     }
   }
 
-  int num_outputs = kernel->num_outputs();
-  if (num_outputs > *num_retvals) {
-    return errors::InvalidArgument("Expecting ", num_outputs,
-                                   " outputs, but *num_retvals is ",
-                                   *num_retvals);
+  if (replay_op_sequence && kernel_is_cached) {
+    ctx.op_sequence_cache()->Record(std::move(op_signature),
+                                    std::get<Device*>(op->Device()),
+                                    kernel.get());
   }
-  *num_retvals = num_outputs;
-
-  kernel->Ref();  // Ownership of reference is passed to out_kernel.
-  out_kernel->reset(kernel.get());
-  return absl::OkStatus();
+  return SetOutKernel(std::move(kernel), num_retvals, out_kernel);
 }
 
 absl::Status CreateUnshapedOutput(
@@ -1618,6 +1677,29 @@ absl::Status CreateUnshapedOutput(
 #endif  // !IS_MOBILE_PLATFORM
 }
 
+// Returns whether the AsyncExecuteNode of `op` only interacts with other nodes
+// through its inputs and outputs, and so may run concurrently with them: `op`
+// must be a stateless primitive op whose inputs and outputs are local and are
+// not resources.
+bool IsParallelizable(const EagerOperation& op, const KernelAndDevice& kernel,
+                      absl::Span<TensorHandle* const> inputs,
+                      absl::Span<TensorHandle* const> retvals) {
+  if (op.is_function() || kernel.IsCrossProcess()) return false;
+  const OpDef* op_def = nullptr;
+  if (!OpDefForOp(op.Name(), &op_def).ok() || op_def->is_stateful()) {
+    return false;
+  }
+  for (absl::Span<TensorHandle* const> handles : {inputs, retvals}) {
+    for (const TensorHandle* handle : handles) {
+      if (handle->dtype == DT_RESOURCE ||
+          handle->Type() != TensorHandle::LOCAL) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 absl::Status AddOrExecuteNode(core::RefCountPtr<KernelAndDevice> kernel,
                               EagerOperation* op, TensorHandle** retvals) {
   EagerExecutor& executor = op->Executor();
@@ -1657,10 +1739,15 @@ absl::Status AddOrExecuteNode(core::RefCountPtr<KernelAndDevice> kernel,
     }
     const absl::InlinedVector<TensorHandle*, 4>* inputs;
     TF_RETURN_IF_ERROR(op->TensorHandleInputs(&inputs));
+    const bool parallelizable =
+        executor.ParallelDispatch() &&
+        IsParallelizable(*op, *kernel, *inputs,
+                         absl::MakeConstSpan(retvals, num_outputs));
     auto node = std::make_unique<AsyncExecuteNode>(
         &ctx, *inputs, eager_func_params, std::move(kernel), graph_collector,
         op->GetCancellationManager(),
-        absl::Span<TensorHandle*>(retvals, num_outputs), op->GetStackTrace());
+        absl::Span<TensorHandle*>(retvals, num_outputs), op->GetStackTrace(),
+        parallelizable);
     // Release the inputs from the eager operation since the AsyncExecuteNode
     // would have taken ownership. This allows the inputs to be forwarded if
     // possible.
@@ -23,6 +23,7 @@ limitations under the License.
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/platform.h"
@@ -160,7 +161,8 @@ class AsyncExecuteNode : public EagerNode {
                    GraphCollector* graph_collector,
                    CancellationManager* cancellation_manager,
                    absl::Span<TensorHandle*> retvals,
-                   std::optional<ManagedStackTrace> stack_trace)
+                   std::optional<ManagedStackTrace> stack_trace,
+                   bool parallelizable = false)
       : EagerNode(),
         ctx_(ctx),
         inputs_(inputs),
@@ -168,7 +170,8 @@ class AsyncExecuteNode : public EagerNode {
         kernel_(std::move(kernel)),
         graph_collector_(graph_collector),
         cancellation_manager_(cancellation_manager),
-        stack_trace_(stack_trace) {
+        stack_trace_(stack_trace),
+        parallelizable_(parallelizable) {
     // Copy the output handles, since the container for them might get
     // destroyed.
     for (auto handle : retvals) {
@@ -236,6 +239,14 @@ class AsyncExecuteNode : public EagerNode {
     return out;
   }
 
+  bool GetDataDependencies(std::vector<const TensorHandle*>* inputs,
+                           std::vector<const TensorHandle*>* outputs) override {
+    if (!parallelizable_) return false;
+    inputs->assign(inputs_.begin(), inputs_.end());
+    outputs->assign(retvals_.begin(), retvals_.end());
+    return true;
+  }
+
  private:
   EagerContext* ctx_;
   absl::InlinedVector<TensorHandle*, 4> inputs_;
@@ -245,6 +256,9 @@ class AsyncExecuteNode : public EagerNode {
   CancellationManager* const cancellation_manager_;
   std::optional<ManagedStackTrace> stack_trace_;
   absl::InlinedVector<TensorHandle*, 2> retvals_;
+  // Whether the kernel only interacts with other nodes through its inputs and
+  // outputs.
+  const bool parallelizable_;
 };
 
 }  // namespace tensorflow
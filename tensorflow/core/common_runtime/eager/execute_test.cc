@@ -22,11 +22,15 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/monitoring/cell_reader.h"
+#include "tensorflow/core/platform/status_matchers.h"
 #include "tensorflow/core/platform/test.h"
+#include "tsl/platform/statusor.h"
 
 namespace tensorflow {
 namespace {
 
+using ::tensorflow::testing::IsOkAndHolds;
+
 TEST(ExecuteTest, EagerOperationAsFunction) {
   StaticDeviceMgr device_mgr(
       DeviceFactory::NewDevice("CPU", {}, "/job:localhost/replica:0/task:0"));
@@ -428,5 +432,85 @@ TEST(ExecuteTest, MultipleNestedCompiledFunction) {
   ctx->Unref();
 }
 
+// Runs the binary op `name` on `x` and `y`, and returns the scalar result.
+template <typename T>
+absl::StatusOr<T> RunBinaryOp(EagerContext* ctx, const char* name,
+                              ImmediateExecutionTensorHandle* x,
+                              ImmediateExecutionTensorHandle* y) {
+  auto op = std::make_unique<EagerOperation>(ctx);
+  TF_RETURN_IF_ERROR(op->Reset(
+      /*op=*/name,
+      /*raw_device_name=*/"/job:localhost/replica:0/task:0/device:CPU:0"));
+  TF_RETURN_IF_ERROR(op->AddInput(x));
+  TF_RETURN_IF_ERROR(op->AddInput(y));
+  std::vector<TensorHandle*> retvals(1);
+  int num_retvals = retvals.size();
+  TF_RETURN_IF_ERROR(EagerExecute(op.get(), retvals.data(), &num_retvals));
+  core::RefCountPtr<TensorHandle> result(retvals[0]);
+  const Tensor* t;
+  TF_RETURN_IF_ERROR(result->Tensor(&t));
+  return t->scalar<T>()();
+}
+
+TEST(ExecuteTest, OpSequenceReplay) {
+  for (bool run_eager_op_as_function : {false, true}) {
+    StaticDeviceMgr device_mgr(DeviceFactory::NewDevice(
+        "CPU", {}, "/job:localhost/replica:0/task:0"));
+    auto ctx = new EagerContext(
+        SessionOptions(),
+        tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_EXPLICIT,
+        false, &device_mgr, /*device_mgr_owned=*/false, /*rendezvous=*/nullptr,
+        /*cluster_flr=*/nullptr, /*collective_executor_mgr=*/nullptr,
+        run_eager_op_as_function);
+    ctx->SetOpSequenceReplay(true);
+    OpSequenceCache* cache = ctx->op_sequence_cache();
+
+    auto x = core::RefCountPtr<ImmediateExecutionTensorHandle>(
+        ctx->CreateLocalHandleFromTFTensor(test::AsScalar<int64_t>(3),
+                                           ctx->HostCPUName().c_str()));
+    auto y = core::RefCountPtr<ImmediateExecutionTensorHandle>(
+        ctx->CreateLocalHandleFromTFTensor(test::AsScalar<int64_t>(2),
+                                           ctx->HostCPUName().c_str()));
+
+    // The first iteration records the sequence, the others replay it.
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_THAT(RunBinaryOp<int64_t>(ctx, "Mul", x.get(), y.get()),
+                  IsOkAndHolds(6));
+      EXPECT_THAT(RunBinaryOp<int64_t>(ctx, "Add", x.get(), y.get()),
+                  IsOkAndHolds(5));
+    }
+    EXPECT_EQ(cache->num_replayed_ops(), 4);
+
+    // A different op ends the replay and starts a new recording.
+    EXPECT_THAT(RunBinaryOp<int64_t>(ctx, "Mul", x.get(), y.get()),
+                IsOkAndHolds(6));
+    EXPECT_THAT(RunBinaryOp<int64_t>(ctx, "Sub", x.get(), y.get()),
+                IsOkAndHolds(1));
+    EXPECT_EQ(cache->num_replayed_ops(), 5);
+    EXPECT_THAT(RunBinaryOp<int64_t>(ctx, "Sub", x.get(), y.get()),
+                IsOkAndHolds(1));
+    EXPECT_EQ(cache->num_replayed_ops(), 6);
+
+    // Inputs of another type need another kernel.
+    auto z = core::RefCountPtr<ImmediateExecutionTensorHandle>(
+        ctx->CreateLocalHandleFromTFTensor(test::AsScalar<int32_t>(2),
+                                           ctx->HostCPUName().c_str()));
+    EXPECT_THAT(RunBinaryOp<int32_t>(ctx, "Sub", z.get(), z.get()),
+                IsOkAndHolds(0));
+    EXPECT_EQ(cache->num_replayed_ops(), 6);
+
+    // Clearing the kernel cache also drops the recorded sequence.
+    ctx->ClearCachesAndThreadExecutors();
+    EXPECT_THAT(RunBinaryOp<int32_t>(ctx, "Sub", z.get(), z.get()),
+                IsOkAndHolds(0));
+    EXPECT_EQ(cache->num_replayed_ops(), 6);
+
+    x.reset();
+    y.reset();
+    z.reset();
+    ctx->Unref();
+  }
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,103 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/eager/op_sequence_cache.h"
+
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+bool SameOp(const OpSequenceCache::Op& a, const OpSequenceCache::Op& b) {
+  return a.key == b.key && a.device == b.device && a.inputs == b.inputs;
+}
+
+}  // namespace
+
+bool OpSequenceCache::Input::operator==(const Input& other) const {
+  if (dtype != other.dtype || is_local != other.is_local ||
+      device != other.device || resource_device != other.resource_device ||
+      resource_dtypes_and_shapes.size() !=
+          other.resource_dtypes_and_shapes.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < resource_dtypes_and_shapes.size(); ++i) {
+    const DtypeAndPartialTensorShape& a = resource_dtypes_and_shapes[i];
+    const DtypeAndPartialTensorShape& b = other.resource_dtypes_and_shapes[i];
+    if (a.dtype != b.dtype || !a.shape.IsIdenticalTo(b.shape)) return false;
+  }
+  return true;
+}
+
+core::RefCountPtr<KernelAndDevice> OpSequenceCache::Lookup(const Op& op,
+                                                           Device** device) {
+  mutex_lock l(mu_);
+  if (entries_.empty()) return nullptr;
+  // Outside of a replay, an op that matches the start of the recorded
+  // sequence closes the loop.
+  const size_t index = replaying_ ? next_ : 0;
+  const Entry& entry = entries_[index];
+  if (!SameOp(entry.op, op)) {
+    if (replaying_) {
+      VLOG(2) << "Op sequence replay stopped after " << index << " of "
+              << entries_.size() << " ops";
+      ResetLocked();
+    }
+    return nullptr;
+  }
+  if (!replaying_) {
+    VLOG(2) << "Replaying a sequence of " << entries_.size() << " ops";
+    replaying_ = true;
+  }
+  next_ = (index + 1) % entries_.size();
+  ++num_replayed_ops_;
+  *device = entry.device;
+  core::RefCountPtr<KernelAndDevice> kernel(entry.kernel.get());
+  kernel->Ref();
+  return kernel;
+}
+
+void OpSequenceCache::Record(Op op, Device* device, KernelAndDevice* kernel) {
+  mutex_lock l(mu_);
+  // Another thread may have started a replay since the lookup of `op`.
+  if (replaying_) return;
+  if (entries_.size() >= kMaxSequenceLength) {
+    ResetLocked();
+  }
+  kernel->Ref();
+  entries_.push_back(
+      {std::move(op), device, core::RefCountPtr<KernelAndDevice>(kernel)});
+}
+
+void OpSequenceCache::Clear() {
+  mutex_lock l(mu_);
+  ResetLocked();
+}
+
+int64_t OpSequenceCache::num_replayed_ops() const {
+  mutex_lock l(mu_);
+  return num_replayed_ops_;
+}
+
+void OpSequenceCache::ResetLocked() {
+  entries_.clear();
+  replaying_ = false;
+  next_ = 0;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,112 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_OP_SEQUENCE_CACHE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_OP_SEQUENCE_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/container/inlined_vector.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/eager/kernel_and_device.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// Records the kernels of the primitive ops executed eagerly, and replays them
+// when the same sequence of ops is executed again, e.g. by the body of a
+// Python training loop.
+//
+// While a sequence is replayed, each op only needs to be compared with the op
+// expected next to get its kernel and device, which skips placement, the
+// computation of the kernel cache key and the kernel cache lookup done by
+// GetOrCreateKernelAndDevice.  Any other op ends the replay, and the sequence
+// is recorded again starting from that op.
+//
+// Only kernels that are also in the kernel cache of the EagerContext may be
+// recorded, and the cache must be cleared whenever the kernel cache is.
+class OpSequenceCache {
+ public:
+  // The maximum number of ops in a recorded sequence.  Longer sequences are
+  // dropped so that programs without loops do not accumulate kernels.
+  static constexpr size_t kMaxSequenceLength = 1024;
+
+  // What the kernel of an input depends on.
+  struct Input {
+    DataType dtype;
+    bool is_local;
+    Device* device;
+    Device* resource_device;
+    std::vector<DtypeAndPartialTensorShape> resource_dtypes_and_shapes;
+
+    bool operator==(const Input& other) const;
+  };
+
+  // What the kernel and device of an op depend on.
+  struct Op {
+    // The attributes, requested device and execution options of the op.
+    Fprint128 key;
+    // The device of the op before placement, if any.
+    Device* device = nullptr;
+    // Only set when the inputs are part of the kernel cache key.
+    absl::InlinedVector<Input, 4> inputs;
+  };
+
+  OpSequenceCache() = default;
+  OpSequenceCache(const OpSequenceCache&) = delete;
+  OpSequenceCache& operator=(const OpSequenceCache&) = delete;
+
+  // Returns the kernel of `op` if it is the next op of the sequence being
+  // replayed, or the first op of the recorded sequence, in which case a replay
+  // starts.  `*device` is set to the device the op was placed on.  Otherwise
+  // returns nullptr, and the kernel of `op` should be Record()ed.
+  core::RefCountPtr<KernelAndDevice> Lookup(const Op& op, Device** device);
+
+  // Appends `op`, placed on `device`, with `kernel` to the recorded sequence.
+  void Record(Op op, Device* device, KernelAndDevice* kernel);
+
+  // Drops the recorded sequence and the references to its kernels.
+  void Clear();
+
+  // The number of ops whose kernel was returned by Lookup().
+  int64_t num_replayed_ops() const;
+
+ private:
+  struct Entry {
+    Op op;
+    Device* device;
+    core::RefCountPtr<KernelAndDevice> kernel;
+  };
+
+  void ResetLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  mutable mutex mu_;
+  std::vector<Entry> entries_ TF_GUARDED_BY(mu_);
+  // Whether `entries_` is being replayed, and the index of the next op.
+  bool replaying_ TF_GUARDED_BY(mu_) = false;
+  size_t next_ TF_GUARDED_BY(mu_) = 0;
+  int64_t num_replayed_ops_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_OP_SEQUENCE_CACHE_H_
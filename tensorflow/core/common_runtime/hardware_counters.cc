@@ -0,0 +1,135 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hardware_counters.h"
+
+#include <cstdint>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "tensorflow/core/framework/step_stats.pb.h"
+
+namespace tensorflow {
+namespace {
+
+enum Counter {
+  kCycles,
+  kInstructions,
+  kLlcMisses,
+  kBranchMisses,
+  kNumCounters
+};
+
+// The counters of one thread, read together as a perf event group led by the
+// cycle counter. Counters that the CPU doesn't provide are left out.
+class ThreadCounters {
+ public:
+  ThreadCounters() {
+#ifdef __linux__
+    static constexpr uint64_t kConfigs[kNumCounters] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for (int counter = 0; counter < kNumCounters; ++counter) {
+      perf_event_attr attr = {};
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = kConfigs[counter];
+      attr.read_format = PERF_FORMAT_GROUP;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      const int fd = syscall(SYS_perf_event_open, &attr, /*pid=*/0,
+                             /*cpu=*/-1, /*group_fd=*/group_fd_, /*flags=*/0);
+      if (fd < 0) {
+        // Without cycles, there is no group to add the other counters to.
+        if (counter == kCycles) return;
+        continue;
+      }
+      if (counter == kCycles) group_fd_ = fd;
+      fds_.push_back(fd);
+      counters_.push_back(static_cast<Counter>(counter));
+    }
+#endif
+  }
+
+  ~ThreadCounters() {
+#ifdef __linux__
+    for (int fd : fds_) close(fd);
+#endif
+  }
+
+  bool Read(HardwareCounters* values) const {
+#ifdef __linux__
+    if (group_fd_ < 0) return false;
+    // The number of counters followed by their values, in the order in which
+    // they were added to the group.
+    uint64_t buffer[kNumCounters + 1];
+    const ssize_t size = read(group_fd_, buffer, sizeof(buffer));
+    if (size < static_cast<ssize_t>(sizeof(uint64_t)) ||
+        buffer[0] != counters_.size()) {
+      return false;
+    }
+    values->Clear();
+    for (size_t i = 0; i < counters_.size(); ++i) {
+      switch (counters_[i]) {
+        case kCycles:
+          values->set_cycles(buffer[i + 1]);
+          break;
+        case kInstructions:
+          values->set_instructions(buffer[i + 1]);
+          break;
+        case kLlcMisses:
+          values->set_llc_misses(buffer[i + 1]);
+          break;
+        case kBranchMisses:
+          values->set_branch_misses(buffer[i + 1]);
+          break;
+        default:
+          break;
+      }
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+ private:
+  int group_fd_ = -1;
+  std::vector<int> fds_;
+  std::vector<Counter> counters_;
+};
+
+}  // namespace
+
+bool ReadThreadHardwareCounters(HardwareCounters* counters) {
+  // Closed when the thread exits.
+  static thread_local ThreadCounters thread_counters;
+  return thread_counters.Read(counters);
+}
+
+void SubtractHardwareCounters(const HardwareCounters& end,
+                              const HardwareCounters& begin,
+                              HardwareCounters* difference) {
+  difference->set_cycles(end.cycles() - begin.cycles());
+  difference->set_instructions(end.instructions() - begin.instructions());
+  difference->set_llc_misses(end.llc_misses() - begin.llc_misses());
+  difference->set_branch_misses(end.branch_misses() - begin.branch_misses());
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,37 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_HARDWARE_COUNTERS_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_HARDWARE_COUNTERS_H_
+
+#include "tensorflow/core/framework/step_stats.pb.h"
+
+namespace tensorflow {
+
+// Reads the CPU cycles, instructions, last level cache misses and branch
+// misses counted in user space on the calling thread, with the Linux
+// perf_event_open() interface. The counters of a thread are opened by its
+// first call, and counters the CPU doesn't provide read as 0. Returns false if
+// hardware counters are not supported, e.g. when not on Linux or when the PMU
+// is not exposed to a virtual machine.
+bool ReadThreadHardwareCounters(HardwareCounters* counters);
+
+// Sets `difference` to the events counted between `begin` and `end`.
+void SubtractHardwareCounters(const HardwareCounters& end,
+                              const HardwareCounters& begin,
+                              HardwareCounters* difference);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_HARDWARE_COUNTERS_H_
@@ -0,0 +1,64 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hardware_counters.h"
+
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Does some work that can't be optimized away.
+int Work(int n) {
+  volatile int sum = 0;
+  for (int i = 0; i < n; ++i) sum = sum + i;
+  return sum;
+}
+
+TEST(HardwareCountersTest, CountsEventsOfThread) {
+  HardwareCounters begin;
+  if (!ReadThreadHardwareCounters(&begin)) {
+    GTEST_SKIP() << "Hardware counters are not supported.";
+  }
+  Work(100000);
+  HardwareCounters end;
+  ASSERT_TRUE(ReadThreadHardwareCounters(&end));
+  HardwareCounters difference;
+  SubtractHardwareCounters(end, begin, &difference);
+  EXPECT_GT(difference.cycles(), 0);
+  EXPECT_GT(difference.instructions(), 100000);
+}
+
+TEST(HardwareCountersTest, SubtractHardwareCounters) {
+  HardwareCounters begin;
+  begin.set_cycles(10);
+  begin.set_instructions(20);
+  begin.set_llc_misses(1);
+  begin.set_branch_misses(2);
+  HardwareCounters end;
+  end.set_cycles(110);
+  end.set_instructions(220);
+  end.set_llc_misses(4);
+  end.set_branch_misses(3);
+  HardwareCounters difference;
+  SubtractHardwareCounters(end, begin, &difference);
+  EXPECT_EQ(difference.cycles(), 100);
+  EXPECT_EQ(difference.instructions(), 200);
+  EXPECT_EQ(difference.llc_misses(), 3);
+  EXPECT_EQ(difference.branch_misses(), 1);
+}
+
+}  // namespace
+}  // namespace tensorflow
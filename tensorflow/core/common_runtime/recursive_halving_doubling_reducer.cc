@@ -0,0 +1,329 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/recursive_halving_doubling_reducer.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+
+namespace tensorflow {
+
+namespace {
+// Key to be used for BufRendezvous by the reducer.
+string ReduceBufKey(const string& exec_key, int step, int src_rank,
+                    int dst_rank) {
+  return strings::StrCat(exec_key, ":rhd:", step, ":", src_rank, ":",
+                         dst_rank);
+}
+}  // namespace
+
+RecursiveHalvingDoublingReducer::RecursiveHalvingDoublingReducer()
+    : col_ctx_(nullptr), col_params_(nullptr), num_chunks_(0), chunk_elts_(0) {}
+
+int RecursiveHalvingDoublingReducer::LargestPowerOfTwo(int group_size) {
+  int p = 1;
+  while (2 * p <= group_size) p *= 2;
+  return p;
+}
+
+absl::Status RecursiveHalvingDoublingReducer::InitializeCollectiveParams(
+    CollectiveParams* col_params) {
+  if (col_params->instance.type != REDUCTION_COLLECTIVE ||
+      col_params->instance.impl_details.collective_name !=
+          "RecursiveHalvingDoublingReduce") {
+    return errors::Internal(
+        "RecursiveHalvingDoublingReducer cannot run collective ",
+        col_params->instance.impl_details.collective_name, " of type ",
+        col_params->instance.type);
+  }
+  if (col_params->group.device_type != DEVICE_CPU) {
+    return errors::Unimplemented(
+        "RecursiveHalvingDoublingReducer only supports CPU devices, got ",
+        col_params->group.device_type.type_string());
+  }
+  return absl::OkStatus();
+}
+
+absl::Status RecursiveHalvingDoublingReducer::InitializeCollectiveContext(
+    std::shared_ptr<CollectiveContext> col_ctx) {
+  DCHECK(col_ctx->dev_mgr);
+  col_ctx_ = col_ctx;
+  col_params_ = col_ctx->col_params.get();
+  return collective_util::InitializeDeviceAndLocality(
+      col_ctx->dev_mgr, col_ctx->device_name, &col_ctx->device,
+      &col_ctx->device_locality);
+}
+
+void RecursiveHalvingDoublingReducer::Run(StatusCallback done) {
+  CHECK(col_ctx_);
+  CHECK(col_params_);
+  // Like `RingReducer`, this doesn't require non-overlapping collectives.
+  col_ctx_->col_exec->UnblockDependencies(*col_params_);
+
+  // Start by copying input to output if they're not already the same, i.e. if
+  // we're not computing in-place on the input tensor.
+  if ((col_ctx_->input != col_ctx_->output) &&
+      (DMAHelper::base(col_ctx_->input) != DMAHelper::base(col_ctx_->output))) {
+    Notification note;
+    absl::Status status;
+    tsl::profiler::TraceMe activity("MemCpyAsync",
+                                    tsl::profiler::TraceMeLevel::kInfo);
+    CollectiveRemoteAccessLocal::MemCpyAsync(
+        col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
+        col_ctx_->device, col_ctx_->op_ctx->input_alloc_attr(0),
+        col_ctx_->op_ctx->output_alloc_attr(0), col_ctx_->input,
+        col_ctx_->output, 0 /*dev_to_dev_stream_index*/,
+        [&note, &status](const absl::Status& s) {
+          status.Update(s);
+          note.Notify();
+        });
+    note.WaitForNotification();
+    if (!status.ok()) {
+      done(status);
+      return;
+    }
+  }
+
+  // The reduce-scatter splits the tensor into one chunk per device taking
+  // part in it.
+  num_chunks_ = LargestPowerOfTwo(col_params_->group.group_size);
+  chunk_elts_ = CollectiveAdapter::AlignedChunkElts(
+      DataTypeSize(col_ctx_->output->dtype()),
+      col_ctx_->output->NumElements(), num_chunks_);
+  AllocatorAttributes attr = col_ctx_->op_ctx->output_alloc_attr(0);
+  ca_.reset(MakeCollectiveAdapter(col_ctx_->output, num_chunks_,
+                                  col_ctx_->device->GetAllocator(attr)));
+
+  absl::Status status;
+  {
+    tsl::profiler::TraceMe activity("RecursiveHalvingDoublingReduce",
+                                    tsl::profiler::TraceMeLevel::kInfo);
+    status = RunExchanges();
+  }
+  if (status.ok()) {
+    ca_->ConsumeFinalValue(col_ctx_->output);
+  } else {
+    StartAbort(status);
+  }
+  ca_.reset();
+  done(status);
+}
+
+absl::Status RecursiveHalvingDoublingReducer::RunExchanges() {
+  const int group_size = col_params_->group.group_size;
+  const int rank = col_params_->default_rank;
+  const int num_extra = group_size - num_chunks_;
+  int log2_num_chunks = 0;
+  while ((1 << log2_num_chunks) < num_chunks_) ++log2_num_chunks;
+  Allocator* allocator =
+      col_ctx_->device->GetAllocator(col_ctx_->op_ctx->output_alloc_attr(0));
+  Tensor value = ca_->Value();
+  int step = 0;
+
+  // Fold: among the first 2 * num_extra devices, the even ones hand their
+  // value to the next odd one and sit out the reduce-scatter and all-gather.
+  // The remaining devices get a virtual rank in [0, num_chunks_).
+  int vrank;
+  if (rank < 2 * num_extra) {
+    if (rank % 2 == 0) {
+      TF_RETURN_IF_ERROR(Exchange(step, rank + 1, &value, nullptr));
+      // Wait for the final value, after the fold step and the halving and
+      // doubling steps.
+      const int unfold_step = 1 + 2 * log2_num_chunks;
+      return Exchange(unfold_step, rank + 1, nullptr, &value);
+    }
+    Tensor tmp(allocator, value.dtype(), value.shape());
+    TF_RETURN_IF_ERROR(Exchange(step, rank - 1, nullptr, &tmp));
+    TF_RETURN_IF_ERROR(collective_util::ComputeBinOp(
+        col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+        col_params_->merge_op, &value, &tmp));
+    vrank = rank / 2;
+  } else {
+    vrank = rank - num_extra;
+  }
+  ++step;
+  auto real_rank = [num_extra](int v) {
+    return v < num_extra ? 2 * v + 1 : v + num_extra;
+  };
+
+  // Reduce-scatter by recursive halving: in each step, exchange half of the
+  // chunks still being reduced with the peer whose virtual rank differs in
+  // one bit, and reduce the other half with the peer's copy of it.
+  int begin = 0;
+  int end = num_chunks_;
+  for (int mask = num_chunks_ / 2; mask > 0; mask /= 2, ++step) {
+    const int mid = (begin + end) / 2;
+    const bool keep_lower = (vrank & mask) == 0;
+    const int keep_begin = keep_lower ? begin : mid;
+    const int keep_end = keep_lower ? mid : end;
+    const int send_begin = keep_lower ? mid : begin;
+    const int send_end = keep_lower ? end : mid;
+    const int peer = real_rank(vrank ^ mask);
+
+    Tensor send = ChunkRangeAlias(send_begin, send_end);
+    Tensor keep = ChunkRangeAlias(keep_begin, keep_end);
+    Tensor tmp;
+    if (keep.NumElements() > 0) {
+      tmp = Tensor(allocator, keep.dtype(), keep.shape());
+    }
+    TF_RETURN_IF_ERROR(Exchange(step, peer, &send, &tmp));
+    if (keep.NumElements() > 0) {
+      TF_RETURN_IF_ERROR(collective_util::ComputeBinOp(
+          col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+          col_params_->merge_op, &keep, &tmp));
+    }
+    begin = keep_begin;
+    end = keep_end;
+  }
+
+  // This device now owns the fully reduced chunk `begin`.
+  if (col_params_->final_op) {
+    Tensor chunk = ChunkRangeAlias(begin, end);
+    if (chunk.NumElements() > 0) {
+      Tensor group_size_val = ca_->Scalar(group_size);
+      TF_RETURN_IF_ERROR(collective_util::ComputeBinOp(
+          col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+          col_params_->final_op, &chunk, &group_size_val));
+    }
+  }
+
+  // All-gather by recursive doubling: in each step, exchange all the reduced
+  // chunks gathered so far with the peer holding the adjacent range.
+  for (int mask = 1; mask < num_chunks_; mask *= 2, ++step) {
+    const int size = end - begin;
+    const bool peer_above = (vrank & mask) == 0;
+    const int peer_begin = peer_above ? end : begin - size;
+    const int peer = real_rank(vrank ^ mask);
+
+    Tensor send = ChunkRangeAlias(begin, end);
+    Tensor recv = ChunkRangeAlias(peer_begin, peer_begin + size);
+    TF_RETURN_IF_ERROR(Exchange(step, peer, &send, &recv));
+    begin = std::min(begin, peer_begin);
+    end = begin + 2 * size;
+  }
+
+  // Unfold: hand the final value back to the device folded into this one.
+  if (rank < 2 * num_extra) {
+    TF_RETURN_IF_ERROR(Exchange(step, rank - 1, &value, nullptr));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status RecursiveHalvingDoublingReducer::Exchange(int step, int peer_rank,
+                                                      const Tensor* send,
+                                                      Tensor* recv) {
+  // Empty ranges are skipped on both sides of the exchange.
+  if (send != nullptr && send->NumElements() == 0) send = nullptr;
+  if (recv != nullptr && recv->NumElements() == 0) recv = nullptr;
+  const int rank = col_params_->default_rank;
+  const CollGroupMember& peer = col_params_->group.members[peer_rank];
+
+  mutex mu;
+  absl::Status status;
+  BlockingCounter pending((send != nullptr) + (recv != nullptr));
+  auto done = [&mu, &status, &pending](const absl::Status& s) {
+    {
+      mutex_lock l(mu);
+      status.Update(s);
+    }
+    pending.DecrementCount();
+  };
+  if (send != nullptr) {
+    string send_buf_key =
+        ReduceBufKey(col_ctx_->exec_key, step, rank, peer_rank);
+    VLOG(3) << "DispatchSend " << send_buf_key << " from_device "
+            << col_ctx_->device_name << " to_device " << peer.device.name()
+            << " num_elements " << send->NumElements();
+    col_ctx_->col_exec->remote_access()->PostToPeer(
+        peer.device.name(), peer.task, send_buf_key, col_ctx_->device,
+        col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->output_alloc_attr(0), send,
+        col_ctx_->device_locality, col_ctx_->op_ctx->cancellation_manager(),
+        done);
+  }
+  if (recv != nullptr) {
+    string recv_buf_key =
+        ReduceBufKey(col_ctx_->exec_key, step, peer_rank, rank);
+    VLOG(3) << "DispatchRecv " << recv_buf_key << " from_device "
+            << peer.device.name() << " to_device " << col_ctx_->device_name
+            << " num_elements " << recv->NumElements();
+    col_ctx_->col_exec->remote_access()->RecvFromPeer(
+        peer.device.name(), peer.task, peer.is_local, recv_buf_key,
+        col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->output_alloc_attr(0), recv,
+        col_ctx_->device_locality, 0 /*stream_index*/,
+        col_ctx_->op_ctx->cancellation_manager(), done);
+  }
+  pending.Wait();
+  mutex_lock l(mu);
+  return status;
+}
+
+int64_t RecursiveHalvingDoublingReducer::ChunkRangeElts(int begin,
+                                                        int end) const {
+  const int64_t total_elts = ca_->Value().NumElements();
+  return std::min(total_elts, end * chunk_elts_) -
+         std::min(total_elts, begin * chunk_elts_);
+}
+
+Tensor RecursiveHalvingDoublingReducer::ChunkRangeAlias(int begin,
+                                                        int end) const {
+  if (ChunkRangeElts(begin, end) == 0) {
+    // Like CollectiveAdapter::ChunkAlias, take empty slices from the front of
+    // the tensor to avoid an illegal offset.
+    return ca_->Value().Slice(0, 0);
+  }
+  const int64_t total_elts = ca_->Value().NumElements();
+  return ca_->Value().Slice(std::min(total_elts, begin * chunk_elts_),
+                            std::min(total_elts, end * chunk_elts_));
+}
+
+void RecursiveHalvingDoublingReducer::StartAbort(const absl::Status& s) {
+  // As in RingAlg::StartAbort, abort the outstanding transfers of the other
+  // devices unless this is a cancellation, which already cancels them.
+  LOG(ERROR) << "Aborting RecursiveHalvingDoublingReduce with " << s;
+  if (col_ctx_->op_ctx->cancellation_manager() == nullptr ||
+      (!col_ctx_->op_ctx->cancellation_manager()->IsCancelled() &&
+       !col_ctx_->op_ctx->cancellation_manager()->IsCancelling())) {
+    col_ctx_->col_exec->StartAbort(s);
+  }
+}
+
+namespace {
+REGISTER_COLLECTIVE(RecursiveHalvingDoublingReduce,
+                    RecursiveHalvingDoublingReducer);
+}  // namespace
+
+}  // namespace tensorflow
@@ -0,0 +1,87 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_RECURSIVE_HALVING_DOUBLING_REDUCER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_RECURSIVE_HALVING_DOUBLING_REDUCER_H_
+
+#include <memory>
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/tensor.h"
+
+namespace tensorflow {
+
+// Recursive halving/doubling (Rabenseifner) implementation of collective
+// all-reduce.
+//
+// With P the largest power of two not exceeding the group size N, the
+// algorithm first folds the N - P extra devices into their neighbours, then
+// runs a reduce-scatter by recursive halving followed by an all-gather by
+// recursive doubling among P devices, and finally sends the result back to
+// the folded devices. That is 2 * log2(P) (+ 2 if N is not a power of two)
+// sequential exchanges instead of the 2 * (N - 1) of RingReducer, which makes
+// it preferable for small tensors where latency dominates. Only CPU devices
+// are supported.
+class RecursiveHalvingDoublingReducer
+    : public CollectiveImplementationInterface {
+ public:
+  RecursiveHalvingDoublingReducer();
+  ~RecursiveHalvingDoublingReducer() override = default;
+
+  absl::Status InitializeCollectiveParams(
+      CollectiveParams* col_params) override;
+
+  // Initializes members of CollectiveContext not yet initialized, i.e. device
+  // and device_locality.  Also saves the CollectiveContext in this object.
+  absl::Status InitializeCollectiveContext(
+      std::shared_ptr<CollectiveContext> col_ctx) override;
+
+  // Begins async execution of the all-reduce.
+  // Must be called in a blockable thread.
+  void Run(StatusCallback done) override;
+
+  // Returns the largest power of two not exceeding `group_size`.
+  static int LargestPowerOfTwo(int group_size);
+
+ private:
+  // Runs all the exchanges of the algorithm for this device, blocking until
+  // they are complete.
+  absl::Status RunExchanges();
+
+  // Concurrently sends `send` (unless null) to and receives `recv` (unless
+  // null) from the device at `peer_rank` in exchange `step`, and waits for
+  // both to complete.
+  absl::Status Exchange(int step, int peer_rank, const Tensor* send,
+                        Tensor* recv);
+
+  // Returns a tensor aliasing the chunks [`begin`, `end`) of the flattened
+  // output.
+  Tensor ChunkRangeAlias(int begin, int end) const;
+
+  // Number of elements in the chunks [`begin`, `end`).
+  int64_t ChunkRangeElts(int begin, int end) const;
+
+  // Aborts outstanding transfers of the collective executor after `s`.
+  void StartAbort(const absl::Status& s);
+
+  std::shared_ptr<CollectiveContext> col_ctx_;
+  const CollectiveParams* col_params_;  // Not owned
+  std::unique_ptr<CollectiveAdapter> ca_;
+  int num_chunks_;
+  int64_t chunk_elts_;
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_RECURSIVE_HALVING_DOUBLING_REDUCER_H_
@@ -0,0 +1,74 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/recursive_halving_doubling_reducer.h"
+
+#include "tensorflow/core/common_runtime/reduction_collective_test_util.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class RecursiveHalvingDoublingReducerTest : public ReductionCollectiveTest {
+ protected:
+  RecursiveHalvingDoublingReducerTest()
+      : ReductionCollectiveTest("RecursiveHalvingDoublingReduce",
+                                REDUCTION_COLLECTIVE) {}
+};
+
+TEST_F(RecursiveHalvingDoublingReducerTest, LargestPowerOfTwo) {
+  EXPECT_EQ(RecursiveHalvingDoublingReducer::LargestPowerOfTwo(1), 1);
+  EXPECT_EQ(RecursiveHalvingDoublingReducer::LargestPowerOfTwo(2), 2);
+  EXPECT_EQ(RecursiveHalvingDoublingReducer::LargestPowerOfTwo(3), 2);
+  EXPECT_EQ(RecursiveHalvingDoublingReducer::LargestPowerOfTwo(8), 8);
+  EXPECT_EQ(RecursiveHalvingDoublingReducer::LargestPowerOfTwo(13), 8);
+}
+
+TEST_F(RecursiveHalvingDoublingReducerTest, RejectsGpu) {
+  core::RefCountPtr<RecursiveHalvingDoublingReducer> reducer(
+      new RecursiveHalvingDoublingReducer());
+  EXPECT_EQ(InitializeGpuCollectiveParams(reducer.get()).code(),
+            absl::StatusCode::kUnimplemented);
+}
+
+#define DEF_TEST(B, T, W, D, L, A)                                       \
+  TEST_F(RecursiveHalvingDoublingReducerTest,                            \
+         DaTy##B##_Wkr##W##_Dev##D##_Len##L##_Abrt##A) {                 \
+    RunTest<T>(DT_##B, W, D, L, A);                                      \
+  }
+
+// Power of two group sizes.
+DEF_TEST(FLOAT, float, 1, 2, 1, 0)
+DEF_TEST(FLOAT, float, 1, 4, 1001, 0)
+DEF_TEST(FLOAT, float, 2, 4, 4096, 0)
+DEF_TEST(FLOAT, float, 2, 8, 9408, 0)
+// Fewer elements than chunks.
+DEF_TEST(FLOAT, float, 2, 4, 3, 0)
+// Group sizes that are not powers of two, folding extra devices.
+DEF_TEST(FLOAT, float, 1, 3, 1001, 0)
+DEF_TEST(FLOAT, float, 1, 5, 17, 0)
+DEF_TEST(FLOAT, float, 2, 3, 4095, 0)
+DEF_TEST(FLOAT, float, 1, 7, 1, 0)
+DEF_TEST(DOUBLE, double, 1, 6, 1001, 0)
+DEF_TEST(INT32, int32, 1, 5, 1001, 0)
+DEF_TEST(INT64, int64_t, 2, 3, 4095, 0)
+// Failure cases.
+DEF_TEST(FLOAT, float, 1, 4, 1001, 1)
+DEF_TEST(FLOAT, float, 1, 5, 1001, 4)
+DEF_TEST(FLOAT, float, 2, 4, 1001, 7)
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,87 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/reduction_collective_test_util.h"
+
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace {
+
+std::unique_ptr<OpKernel> GetBinOp(const string& op, DataType dtype,
+                                   DeviceBase* device) {
+  NodeDef node_def;
+  TF_CHECK_OK(NodeDefBuilder("bin_op_node", op)
+                  .Attr("T", dtype)
+                  .Input(FakeInput(dtype))
+                  .Input(FakeInput(dtype))
+                  .Finalize(&node_def));
+  absl::Status status;
+  std::unique_ptr<OpKernel> k = CreateOpKernel(
+      DEVICE_CPU, device, device->GetAllocator(AllocatorAttributes()),
+      node_def, TF_GRAPH_DEF_VERSION, &status);
+  TF_CHECK_OK(status);
+  return k;
+}
+
+}  // namespace
+
+ReductionCollectiveTest::DeviceInstance::DeviceInstance(
+    int rank, const string& collective_name, CollectiveType collective_type,
+    DataType dtype, int output_len, CollectiveTestEnv* test_env)
+    : test_env_(test_env), output_(dtype, TensorShape({output_len})) {
+  const int group_size =
+      test_env_->num_workers * test_env_->num_devices_per_worker;
+  const int input_len = collective_type == REDUCE_SCATTER_COLLECTIVE
+                            ? group_size * output_len
+                            : output_len;
+  input_ = Tensor(dtype, TensorShape({input_len}));
+  col_params_ = CreateCollectiveParams(*test_env_, rank, collective_name,
+                                       collective_type, dtype, output_.shape());
+  string dev_name = col_params_->group.members[rank].device.name();
+  TF_CHECK_OK(test_env_->device_mgr->LookupDevice(dev_name, &device_));
+  merge_op_ = GetBinOp("Add", dtype, device_);
+  final_op_ = GetBinOp("Div", dtype, device_);
+  col_params_->merge_op = merge_op_.get();
+  col_params_->final_op = final_op_.get();
+}
+
+void ReductionCollectiveTest::DeviceInstance::DoCollective() {
+  status_ =
+      RunCollective(test_env_, col_params_.get(), device_, &input_, &output_);
+}
+
+ReductionCollectiveTest::DeviceInstance* ReductionCollectiveTest::AddInstance(
+    int rank, DataType dtype, int output_len) {
+  instances_.push_back(std::make_unique<DeviceInstance>(
+      rank, collective_name_, collective_type_, dtype, output_len,
+      test_env_.get()));
+  return instances_.back().get();
+}
+
+absl::Status ReductionCollectiveTest::InitializeGpuCollectiveParams(
+    CollectiveImplementationInterface* impl) {
+  test_env_ = CreateCollectiveTestEnv(1, 2, DEVICE_CPU);
+  core::RefCountPtr<CollectiveParams> col_params =
+      CreateCollectiveParams(*test_env_, 0, collective_name_, collective_type_,
+                             DT_FLOAT, TensorShape({4}));
+  col_params->group.device_type = DEVICE_GPU;
+  return impl->InitializeCollectiveParams(col_params.get());
+}
+
+}  // namespace tensorflow
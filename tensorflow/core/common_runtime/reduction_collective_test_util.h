@@ -0,0 +1,139 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_REDUCTION_COLLECTIVE_TEST_UTIL_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_REDUCTION_COLLECTIVE_TEST_UTIL_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/collective_test_util.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+
+// Test fixture of CPU reduction collectives that average the inputs of the
+// group, with Add as merge op and Div as final op.  The device of rank r
+// outputs the whole mean for REDUCTION_COLLECTIVE, or its r-th slice for
+// REDUCE_SCATTER_COLLECTIVE.
+class ReductionCollectiveTest : public ::testing::Test {
+ protected:
+  class DeviceInstance {
+   public:
+    // The input is `output_len` elements long for an all-reduce and
+    // group_size * `output_len` for a reduce-scatter.
+    DeviceInstance(int rank, const string& collective_name,
+                   CollectiveType collective_type, DataType dtype,
+                   int output_len, CollectiveTestEnv* test_env);
+
+    void DoCollective();
+
+    CollectiveTestEnv* test_env_;
+    Tensor input_;
+    Tensor output_;
+    Device* device_;
+    core::RefCountPtr<CollectiveParams> col_params_;
+    std::unique_ptr<OpKernel> merge_op_;
+    std::unique_ptr<OpKernel> final_op_;
+    absl::Status status_;
+  };
+
+  ReductionCollectiveTest(const string& collective_name,
+                          CollectiveType collective_type)
+      : collective_name_(collective_name), collective_type_(collective_type) {}
+
+  // Adds the instance of `rank` to instances_.
+  DeviceInstance* AddInstance(int rank, DataType dtype, int output_len);
+
+  // Returns the status of `impl`'s InitializeCollectiveParams for a group of
+  // GPU devices.
+  absl::Status InitializeGpuCollectiveParams(
+      CollectiveImplementationInterface* impl);
+
+  // Runs the collective on `num_workers` * `num_devices` CPU devices, with
+  // outputs of `output_len` elements, and checks their values.  With a
+  // positive `fail_after`, the remote access of the group fails after that
+  // many actions, which must fail the collective on all devices.
+  template <typename T>
+  void RunTest(DataType dtype, int num_workers, int num_devices,
+               int output_len, int fail_after) {
+    test_env_ = CreateCollectiveTestEnv(num_workers, num_devices, DEVICE_CPU);
+    test_env_->remote_access->set_fail_after(fail_after);
+    const int group_size = num_workers * num_devices;
+    const int input_len = collective_type_ == REDUCE_SCATTER_COLLECTIVE
+                              ? group_size * output_len
+                              : output_len;
+    std::vector<T> expected(input_len, T(0));
+    for (int rank = 0; rank < group_size; ++rank) {
+      auto flat = AddInstance(rank, dtype, output_len)->input_.flat<T>();
+      for (int i = 0; i < input_len; ++i) {
+        const T value = static_cast<T>(rank * 10 + i);
+        flat(i) = value;
+        expected[i] += value;
+      }
+    }
+
+    std::atomic<int> done(0);
+    for (auto& di : instances_) {
+      SchedClosure([&di, &done] {
+        di->DoCollective();
+        ++done;
+      });
+    }
+    while (done < group_size) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+
+    if (fail_after > 0) {
+      for (auto& di : instances_) {
+        EXPECT_NE(di->status_.message().find("Deliberate failure"),
+                  string::npos);
+      }
+      return;
+    }
+    for (int i = 0; i < input_len; ++i) {
+      expected[i] /= static_cast<T>(group_size);
+    }
+    for (int rank = 0; rank < group_size; ++rank) {
+      TF_EXPECT_OK(instances_[rank]->status_);
+      const int offset =
+          collective_type_ == REDUCE_SCATTER_COLLECTIVE ? rank * output_len : 0;
+      std::vector<T> expected_output(expected.begin() + offset,
+                                     expected.begin() + offset + output_len);
+      test::ExpectTensorEqual<T>(test::AsTensor<T>(expected_output),
+                                 instances_[rank]->output_);
+    }
+  }
+
+  const string collective_name_;
+  const CollectiveType collective_type_;
+  std::unique_ptr<CollectiveTestEnv> test_env_;
+  std::vector<std::unique_ptr<DeviceInstance>> instances_;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_REDUCTION_COLLECTIVE_TEST_UTIL_H_
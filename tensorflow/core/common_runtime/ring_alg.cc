@@ -408,9 +408,9 @@ void RingAlg::DispatchSend(RingField* rf, const StatusCallback& done) {
       col_params_->group.members[send_to_dev_idx].device.name(),
       col_params_->group.members[send_to_dev_idx].task, send_buf_key,
       col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
-      col_ctx_->op_ctx->output_alloc_attr(0), &rf->chunk,
-      col_ctx_->device_locality, col_ctx_->op_ctx->cancellation_manager(),
-      done);
+      col_ctx_->op_ctx->output_alloc_attr(0),
+      rf->compressed ? &rf->wire_chunk : &rf->chunk, col_ctx_->device_locality,
+      col_ctx_->op_ctx->cancellation_manager(), done);
 }
 
 void RingAlg::DispatchRecv(RingField* rf, const StatusCallback& done) {
@@ -418,12 +418,17 @@ void RingAlg::DispatchRecv(RingField* rf, const StatusCallback& done) {
   string recv_buf_key =
       RingAlgBufKey(name_, col_ctx_->exec_key, rf->second_pass, rf->sc_idx,
                     (rf->rank + (group_size_ - 1)) % group_size_);
+  Tensor* dst_tensor = &rf->chunk;
+  if (rf->compressed) {
+    dst_tensor = &rf->wire_chunk;
+  } else if (!rf->second_pass && (col_params_->merge_op != nullptr)) {
+    dst_tensor = &rf->tmp_chunk;
+  }
   VLOG(3) << "DispatchRecv rank=" << col_params_->default_rank << " recv key "
           << recv_buf_key << " chunk " << ca_->TBounds(rf->chunk) << " into "
-          << ((col_params_->merge_op != nullptr) ? "tmp_chunk" : "chunk");
-  Tensor* dst_tensor = (!rf->second_pass && (col_params_->merge_op != nullptr))
-                           ? &rf->tmp_chunk
-                           : &rf->chunk;
+          << (dst_tensor == &rf->chunk
+                  ? "chunk"
+                  : (rf->compressed ? "wire_chunk" : "tmp_chunk"));
   col_ctx_->col_exec->remote_access()->RecvFromPeer(
       col_params_->group.members[rf->recv_dev_idx].device.name(),
       col_params_->group.members[rf->recv_dev_idx].task,
@@ -76,6 +76,8 @@ class RingAlg : public CollectiveImplementationInterface {
     bool is_final = false;  // is the last field in the pass for this rank
     Tensor chunk;           // alias to field values
     Tensor tmp_chunk;
+    bool compressed = false;  // is the value sent as wire_chunk?
+    Tensor wire_chunk;        // encoding of the value sent and recv'd
     absl::Status status;
     string DebugString() const;
   };
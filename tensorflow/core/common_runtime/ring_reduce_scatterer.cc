@@ -0,0 +1,135 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/ring_reduce_scatterer.h"
+
+#include <cstring>
+#include <utility>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+
+namespace tensorflow {
+
+absl::Status RingReduceScatterer::InitializeCollectiveParams(
+    CollectiveParams* col_params) {
+  DCHECK_EQ(col_params->instance.type, REDUCE_SCATTER_COLLECTIVE);
+  DCHECK_EQ(col_params->instance.impl_details.collective_name,
+            "RingReduceScatter");
+  if (col_params->group.device_type != DEVICE_CPU) {
+    return errors::Unimplemented(
+        "RingReduceScatter only supports CPU devices, got ",
+        col_params->group.device_type.type_string());
+  }
+  // Each device must end the pass with its own slice fully reduced, which
+  // needs the ring to follow the rank order, i.e. a single subdiv at offset 0.
+  if (!col_params->instance.impl_details.subdiv_offsets.empty() &&
+      (col_params->instance.impl_details.subdiv_offsets.size() > 1 ||
+       col_params->instance.impl_details.subdiv_offsets[0] != 0)) {
+    return errors::InvalidArgument(
+        "RingReduceScatter cannot take any subdiv offset other than 0.");
+  }
+  if (col_params->instance.impl_details.subdiv_offsets.empty()) {
+    col_params->instance.impl_details.subdiv_offsets.push_back(0);
+  }
+  // Skips the checks of RingReducer, which are specific to all-reduce.
+  return RingAlg::InitializeCollectiveParams(col_params);
+}
+
+void RingReduceScatterer::Run(StatusCallback done) {
+  DCHECK(col_ctx_);
+  DCHECK(col_params_);
+  // Since `RingReduceScatterer` doesn't require non-overlapping collectives,
+  // unblock any collective that is blocked on this instance.
+  col_ctx_->col_exec->UnblockDependencies(*col_params_);
+
+  done_ = std::move(done);
+  group_size_ = col_params_->group.group_size;
+  num_subdivs_ = static_cast<int>(
+      col_params_->instance.impl_details.subdiv_permutations.size());
+  DCHECK_EQ(num_subdivs_, 1);
+
+  const Tensor* input = col_ctx_->input;
+  Tensor* output = col_ctx_->output;
+  const int64_t slice_elts = output->NumElements();
+  if (input->NumElements() != group_size_ * slice_elts) {
+    done_(errors::InvalidArgument(
+        "RingReduceScatter input of shape ", input->shape().DebugString(),
+        " does not split into ", group_size_, " slices of shape ",
+        output->shape().DebugString()));
+    return;
+  }
+  if (slice_elts == 0) {
+    done_(absl::OkStatus());
+    return;
+  }
+
+  // The ring fully reduces chunk c on the device of rank c - 1, so the slice
+  // of rank r is copied to chunk r + 1 of a temporary buffer.  The slices are
+  // padded with zeros to keep the chunks aligned.
+  const int64_t elt_bytes = DataTypeSize(input->dtype());
+  const int64_t chunk_elts = CollectiveAdapter::AlignedChunkElts(
+      elt_bytes, input->NumElements(), group_size_);
+  const int64_t slice_bytes = slice_elts * elt_bytes;
+  const int64_t chunk_bytes = chunk_elts * elt_bytes;
+  Allocator* allocator =
+      col_ctx_->device->GetAllocator(col_ctx_->op_ctx->output_alloc_attr(0));
+  Tensor buffer(allocator, input->dtype(),
+                TensorShape({group_size_ * chunk_elts}));
+  {
+    tsl::profiler::TraceMe activity("CopyInput",
+                                    tsl::profiler::TraceMeLevel::kInfo);
+    char* buffer_base = static_cast<char*>(DMAHelper::base(&buffer));
+    const char* input_base = static_cast<const char*>(DMAHelper::base(input));
+    for (int r = 0; r < group_size_; ++r) {
+      char* chunk = buffer_base + ((r + 1) % group_size_) * chunk_bytes;
+      memcpy(chunk, input_base + r * slice_bytes, slice_bytes);
+      memset(chunk + slice_bytes, 0, chunk_bytes - slice_bytes);
+    }
+  }
+  ca_.reset(MakeCollectiveAdapter(&buffer, group_size_, allocator,
+                                  /*align_chunks=*/false));
+  if (col_params_->final_op) {
+    group_size_tensor_ = ca_->Scalar(group_size_);
+  }
+
+  if (RunAsyncParts()) {
+    Tensor chunk =
+        ca_->ChunkAlias((col_params_->default_rank + 1) % group_size_);
+    memcpy(DMAHelper::base(output), DMAHelper::base(&chunk), slice_bytes);
+  }
+  // Unlike in RingAlg::Finish, the output is not the value of the adapter.
+  absl::Status s;
+  {
+    mutex_lock l(status_mu_);
+    s = status_;
+  }
+  rfv_.clear();
+  ca_.reset();
+  done_(s);
+}
+
+namespace {
+REGISTER_COLLECTIVE(RingReduceScatter, RingReduceScatterer);
+}  // namespace
+
+}  // namespace tensorflow
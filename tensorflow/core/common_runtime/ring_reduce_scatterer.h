@@ -0,0 +1,54 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_RING_REDUCE_SCATTERER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_RING_REDUCE_SCATTERER_H_
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/common_runtime/ring_reducer.h"
+#include "tensorflow/core/framework/collective.h"
+
+namespace tensorflow {
+
+// Ring-algorithm implementation of collective reduce-scatter.
+//
+// The input of every device is split along its first dimension into
+// group_size slices, and the device of rank r outputs the reduction of the
+// r-th slices of all the inputs.  This runs only the first pass of
+// RingReducer, with the chunks arranged so that the chunk that is fully reduced
+// on each device is its own slice, and sends half the data of an all-reduce.
+// Only CPU devices are supported.
+class RingReduceScatterer : public RingReducer {
+ public:
+  // The group size scalar of the final op is a host tensor that Run sets
+  // before using it, so it never has to be waited for.
+  RingReduceScatterer()
+      : RingReducer(REDUCE_SCATTER_COLLECTIVE, "ReduceScatter") {
+    group_size_tensor_ready_.Notify();
+  }
+  ~RingReduceScatterer() override {}
+
+  absl::Status InitializeCollectiveParams(
+      CollectiveParams* col_params) override;
+
+  // Begins async execution of the ring reduce-scatter algorithm.
+  // Must be called in a blockable thread.
+  void Run(StatusCallback done) override;
+
+ private:
+  friend class RingReduceScattererTest;
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_RING_REDUCE_SCATTERER_H_
@@ -0,0 +1,81 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/ring_reduce_scatterer.h"
+
+#include <memory>
+
+#include "tensorflow/core/common_runtime/collective_test_util.h"
+#include "tensorflow/core/common_runtime/reduction_collective_test_util.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class RingReduceScattererTest : public ReductionCollectiveTest {
+ protected:
+  RingReduceScattererTest()
+      : ReductionCollectiveTest("RingReduceScatter",
+                                REDUCE_SCATTER_COLLECTIVE) {}
+};
+
+TEST_F(RingReduceScattererTest, RejectsGpu) {
+  core::RefCountPtr<RingReduceScatterer> scatterer(new RingReduceScatterer());
+  EXPECT_EQ(InitializeGpuCollectiveParams(scatterer.get()).code(),
+            absl::StatusCode::kUnimplemented);
+}
+
+TEST_F(RingReduceScattererTest, RejectsSubdivOffsets) {
+  test_env_ = CreateCollectiveTestEnv(1, 4, DEVICE_CPU);
+  core::RefCountPtr<CollectiveParams> col_params = CreateCollectiveParams(
+      *test_env_, 0, "RingReduceScatter", REDUCE_SCATTER_COLLECTIVE, DT_FLOAT,
+      TensorShape({4}));
+  col_params->instance.impl_details.subdiv_offsets = {0, 2};
+  core::RefCountPtr<RingReduceScatterer> scatterer(new RingReduceScatterer());
+  EXPECT_EQ(scatterer->InitializeCollectiveParams(col_params.get()).code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST_F(RingReduceScattererTest, RejectsIndivisibleInput) {
+  test_env_ = CreateCollectiveTestEnv(1, 2, DEVICE_CPU);
+  DeviceInstance* di = AddInstance(0, DT_FLOAT, /*output_len=*/3);
+  di->input_ = Tensor(DT_FLOAT, TensorShape({5}));
+  di->DoCollective();
+  EXPECT_EQ(di->status_.code(), absl::StatusCode::kInvalidArgument);
+}
+
+#define DEF_TEST(B, T, W, D, L, A)                                       \
+  TEST_F(RingReduceScattererTest,                                        \
+         DaTy##B##_Wkr##W##_Dev##D##_Len##L##_Abrt##A) {                 \
+    RunTest<T>(DT_##B, W, D, L, A);                                      \
+  }
+
+DEF_TEST(FLOAT, float, 1, 1, 5, 0)
+DEF_TEST(FLOAT, float, 1, 2, 1, 0)
+DEF_TEST(FLOAT, float, 1, 4, 1001, 0)
+DEF_TEST(FLOAT, float, 2, 4, 4096, 0)
+DEF_TEST(FLOAT, float, 2, 3, 17, 0)
+DEF_TEST(FLOAT, float, 1, 7, 3, 0)
+DEF_TEST(DOUBLE, double, 1, 6, 1001, 0)
+DEF_TEST(INT32, int32, 1, 5, 1001, 0)
+DEF_TEST(INT64, int64_t, 2, 3, 4095, 0)
+// Failure cases.
+DEF_TEST(FLOAT, float, 1, 4, 1001, 1)
+DEF_TEST(FLOAT, float, 2, 4, 1001, 5)
+
+}  // namespace
+}  // namespace tensorflow
@@ -20,6 +20,7 @@ limitations under the License.
 #include <functional>
 #include <utility>
 
+#include "tensorflow/core/common_runtime/collective_compression.h"
 #include "tensorflow/core/common_runtime/collective_rma_local.h"
 #include "tensorflow/core/common_runtime/collective_util.h"
 #include "tensorflow/core/common_runtime/copy_tensor.h"
@@ -121,7 +122,7 @@ void RingReducer::ContinueAfterInputCopy() {
   AllocatorAttributes attr = col_ctx_->op_ctx->output_alloc_attr(0);
   ca_.reset(MakeCollectiveAdapter(col_ctx_->output, group_size_ * num_subdivs_,
                                   col_ctx_->device->GetAllocator(attr)));
-
+  compression_ = EffectiveCompression();
   if (col_params_->final_op) {
     // Create an on-device scalar value from group_size_ that may be needed
     // later.
@@ -160,6 +161,43 @@ void RingReducer::ContinueAfterInputCopy() {
     // Value won't be used, so no need to initialize.
     group_size_tensor_ready_.Notify();
   }
+
+  if (compression_ != CollectiveCompression::kNone) {
+    // The residual of a tensor must persist across steps, so it is keyed on
+    // the residual id that the caller gives to the tensor, or else on the
+    // instance key.
+    const CollImplDetails& impl_details = col_params_->instance.impl_details;
+    const string residual_key = strings::StrCat(
+        col_params_->group.group_key, ":",
+        impl_details.residual_id.empty()
+            ? strings::StrCat("instance ", col_params_->instance.instance_key)
+            : strings::StrCat("id ", impl_details.residual_id),
+        ":", col_ctx_->device_name);
+    CollectiveResidualStore* residual_store =
+        col_ctx_->col_exec->residual_store();
+    for (int pass = 0; pass < 2; ++pass) {
+      const string key = strings::StrCat(residual_key, ":", pass);
+      Tensor residual;
+      absl::Status s = residual_store->Acquire(key, DT_FLOAT,
+                                               ca_->Value().shape(), &residual);
+      if (!s.ok()) {
+        if (pass > 0) residual_store->Release(residual_key + ":0");
+        done_(s);
+        return;
+      }
+      residual_ca_[pass].reset(
+          MakeCollectiveAdapter(&residual, group_size_ * num_subdivs_,
+                                col_ctx_->device->GetAllocator(attr)));
+    }
+    // Releases the residuals before the next step may acquire them.
+    done_ = [residual_store, residual_key,
+             done = std::move(done_)](const absl::Status& s) {
+      residual_store->Release(residual_key + ":0");
+      residual_store->Release(residual_key + ":1");
+      done(s);
+    };
+  }
+
   Finish(RunAsyncParts());
 }
 
@@ -169,6 +207,47 @@ void RingReducer::InitRingField(RingField* rf, int chunk_idx, int subdiv_idx,
   if (rf->do_recv) {
     rf->tmp_chunk = ca_->TempChunk(rf->sc_idx);
   }
+  if (compression_ != CollectiveCompression::kNone &&
+      (rf->do_send || rf->do_recv)) {
+    rf->compressed = true;
+    rf->wire_chunk = Tensor(
+        col_ctx_->device->GetAllocator(col_ctx_->op_ctx->output_alloc_attr(0)),
+        collective_util::CompressedDataType(compression_),
+        TensorShape({collective_util::CompressedNumElements(
+            compression_, rf->chunk.NumElements())}));
+  }
+}
+
+CollectiveCompression RingReducer::EffectiveCompression() const {
+  const CollectiveCompression compression =
+      col_params_->instance.impl_details.compression;
+  if (compression == CollectiveCompression::kNone) {
+    return compression;
+  }
+  // The decision must be the same on all devices, as they need to agree on
+  // what is sent, so it only depends on the params of the instance and the
+  // executor type.
+  const OpKernel* merge_op = col_params_->merge_op;
+  if (col_params_->instance.data_type != DT_FLOAT ||
+      col_params_->group.device_type != DEVICE_CPU || merge_op == nullptr ||
+      (merge_op->type_string() != "Add" &&
+       merge_op->type_string() != "AddV2") ||
+      col_ctx_->col_exec->residual_store() == nullptr) {
+    VLOG(1) << "RingReducer sends exact values for instance "
+            << col_params_->instance.instance_key
+            << ", compression only applies to sums of floats on CPU.";
+    return CollectiveCompression::kNone;
+  }
+  return compression;
+}
+
+void RingReducer::CompressChunk(RingField* rf) {
+  Tensor residual = residual_ca_[rf->second_pass]->ChunkAlias(rf->sc_idx);
+  collective_util::CompressWithErrorFeedback(compression_, rf->chunk,
+                                             &residual, &rf->wire_chunk);
+  if (rf->second_pass) {
+    collective_util::Decompress(compression_, rf->wire_chunk, &rf->chunk);
+  }
 }
 
 // At the beginning of the algorithm initialize a RingField struct for
@@ -255,6 +334,11 @@ bool RingReducer::RunAsyncParts() {
           case RF_RECV:
             CHECK_GT(recv_pending_count, 0);
             --recv_pending_count;
+            if (rf->compressed) {
+              collective_util::Decompress(
+                  compression_, rf->wire_chunk,
+                  rf->second_pass ? &rf->chunk : &rf->tmp_chunk);
+            }
             if (!rf->second_pass) {
               rf->action = RF_REDUCE;
               absl::Status s = collective_util::ComputeBinOp(
@@ -287,6 +371,11 @@ bool RingReducer::RunAsyncParts() {
             rf->action = RF_DONE;
             break;
           case RF_SEND_READY:
+            // In the second pass, a received wire_chunk is forwarded as is.
+            if (rf->compressed && rf->do_send &&
+                !(rf->second_pass && rf->do_recv)) {
+              CompressChunk(rf);
+            }
             if (rf->do_send) {
               rf->action = RF_SEND;
               auto send_complete = [this, rf, &ready_queue,
@@ -313,7 +402,7 @@ bool RingReducer::RunAsyncParts() {
             break;
         }
         if (rf->action == RF_DONE) {
-          if (rf->second_pass) {
+          if (rf->second_pass || first_pass_only_) {
             ++field_done_count;
             break;  // from do while(!dispatched)
           } else {
@@ -28,6 +28,15 @@ namespace tensorflow {
 class Device;
 
 // Ring-algorithm implementation of collective all-reduce.
+//
+// Sums of float values on CPU may send the chunks compressed, as requested by
+// CollImplDetails::compression.  The compression error of every chunk is kept
+// in the CollectiveResidualStore of the executor and added back to the same
+// chunk in the next step (error feedback), so that it is not lost.  The
+// residuals of a tensor are found by CollImplDetails::residual_id, or by the
+// instance key if it has none, and reductions that run concurrently must not
+// share them.  Other reductions, or executors without a residual store, send
+// exact values.
 class RingReducer : public RingAlg {
  public:
   RingReducer() : RingAlg(REDUCTION_COLLECTIVE, "Reduce") {}
@@ -43,16 +52,39 @@ class RingReducer : public RingAlg {
       CollectiveParams* col_params) override;
 
  protected:
+  // For subclasses that only run the first pass of the ring, at the end of
+  // which every chunk is fully reduced on a single device.
+  RingReducer(CollectiveType type, const string& name)
+      : RingAlg(type, name), first_pass_only_(true) {}
+
   void InitRingField(RingField* rf, int chunk_idx, int subdiv_idx,
                      int field_idx) override;
 
- private:
-  void ContinueAfterInputCopy();
   bool RunAsyncParts();
 
   Tensor group_size_tensor_;
   Notification group_size_tensor_ready_;
 
+ private:
+  void ContinueAfterInputCopy();
+
+  // Returns the compression of the chunks of this instance, which is
+  // CollectiveCompression::kNone unless it is requested and supported.
+  CollectiveCompression EffectiveCompression() const;
+
+  // Encodes the value of `rf` into its wire_chunk, with error feedback.  In
+  // the second pass, the value is also replaced by its decoding, so that every
+  // device ends up with the same value.
+  void CompressChunk(RingField* rf);
+
+  CollectiveCompression compression_ = CollectiveCompression::kNone;
+  // Error-feedback residuals of the first and second pass, with the chunks of
+  // the output.
+  std::unique_ptr<CollectiveAdapter> residual_ca_[2];
+
+  // Whether RunAsyncParts stops after the first pass.
+  const bool first_pass_only_ = false;
+
   friend class RingReducerTest;
   friend class RingReducerInitParamsTest;
 };
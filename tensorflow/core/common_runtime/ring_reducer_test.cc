@@ -15,6 +15,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/ring_reducer.h"
 
 #include <algorithm>
+#include <cmath>
 
 #include "absl/memory/memory.h"
 #include "tensorflow/core/common_runtime/base_collective_executor.h"
@@ -36,8 +37,11 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/refcount.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/unbounded_work_queue.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/public/version.h"
@@ -84,13 +88,22 @@ class RingReducerTest : public ::testing::Test {
   void Init(int num_workers, int num_devices, DataType dtype,
             const TensorShape& shape, const DeviceType& device_type,
             int num_subdivs, int fail_after) {
-    test_env_ = CreateCollectiveTestEnv(num_workers, num_devices, device_type);
+    // Later calls reuse the environment, and thus its residual store.
+    if (test_env_ == nullptr) {
+      test_env_ =
+          CreateCollectiveTestEnv(num_workers, num_devices, device_type);
+    }
     test_env_->remote_access->set_fail_after(fail_after);
+    instances_.clear();
     for (int wi = 0; wi < num_workers; ++wi) {
       for (int di = 0; di < num_devices; ++di) {
         int rank = wi * num_devices + di;
         instances_.push_back(std::make_unique<DeviceInstance>(
             rank, num_subdivs, dtype, shape, test_env_.get()));
+        instances_.back()->col_params_->instance.impl_details.compression =
+            compression_;
+        instances_.back()->col_params_->instance.impl_details.residual_id =
+            residual_id_;
       }
     }
   }
@@ -153,6 +166,80 @@ class RingReducerTest : public ::testing::Test {
     }
   }
 
+  // Runs `num_steps` steps of `num_reductions` concurrent all-reduces of float
+  // values with `compression`, in one group.  Like eager collectives, every
+  // reduction has a new instance key in every step, and only its residual id
+  // stays the same.  The result of every step must be the same on all devices
+  // and within `tolerance` of the exact mean.  Thanks to error feedback, the
+  // compression errors of successive steps of a reduction cancel out, so their
+  // average must be within `tolerance` / `num_steps` of the exact mean.
+  void RunCompressedTest(CollectiveCompression compression, int num_workers,
+                         int num_devices, int num_subdivs, int tensor_len,
+                         int num_steps, float tolerance,
+                         int num_reductions = 1) {
+    compression_ = compression;
+    const int group_size = num_workers * num_devices;
+    const auto input = [](int r, int di, int i) {
+      return static_cast<float>((di + 1) * std::sin(di + (r + 1) * 0.1 * i));
+    };
+    std::vector<std::vector<double>> expected(
+        num_reductions, std::vector<double>(tensor_len, 0));
+    for (int r = 0; r < num_reductions; ++r) {
+      for (int di = 0; di < group_size; ++di) {
+        for (int i = 0; i < tensor_len; ++i) {
+          expected[r][i] += input(r, di, i) / static_cast<double>(group_size);
+        }
+      }
+    }
+    std::vector<std::vector<double>> average(
+        num_reductions, std::vector<double>(tensor_len, 0));
+    for (int step = 0; step < num_steps; ++step) {
+      std::vector<std::unique_ptr<DeviceInstance>> instances;
+      for (int r = 0; r < num_reductions; ++r) {
+        residual_id_ = strings::StrCat("grad", r);
+        Init(num_workers, num_devices, DT_FLOAT, TensorShape({tensor_len}),
+             DEVICE_CPU, num_subdivs, 0);
+        for (int di = 0; di < group_size; ++di) {
+          instances_[di]->col_params_->instance.instance_key +=
+              step * num_reductions + r;
+          instances_[di]->InitTensor([&input, r, di](Tensor* t) {
+            for (int i = 0; i < t->NumElements(); ++i) {
+              t->flat<float>()(i) = input(r, di, i);
+            }
+          });
+          instances.push_back(std::move(instances_[di]));
+        }
+      }
+      instances_ = std::move(instances);
+      Reduce(0);
+      for (int r = 0; r < num_reductions; ++r) {
+        const Tensor& result_tensor = instances_[r * group_size]->tensor();
+        for (int di = 0; di < group_size; ++di) {
+          TF_ASSERT_OK(instances_[r * group_size + di]->status_);
+          test::ExpectTensorEqual<float>(
+              result_tensor, instances_[r * group_size + di]->tensor());
+        }
+        auto result = result_tensor.flat<float>();
+        for (int i = 0; i < tensor_len; ++i) {
+          EXPECT_NEAR(result(i), expected[r][i], tolerance)
+              << "reduction " << r << " step " << step << " element " << i;
+          average[r][i] += result(i) / static_cast<double>(num_steps);
+        }
+      }
+    }
+    for (int r = 0; r < num_reductions; ++r) {
+      for (int i = 0; i < tensor_len; ++i) {
+        EXPECT_NEAR(average[r][i], expected[r][i],
+                    tolerance / num_steps + 1e-5)
+            << "reduction " << r << " element " << i;
+      }
+    }
+    // All steps of a reduction share its residuals of both passes on every
+    // device.
+    EXPECT_EQ(test_env_->col_exec->residual_store()->size(),
+              2 * num_reductions * group_size);
+  }
+
   class DeviceInstance {
    public:
     DeviceInstance(int rank, int num_subdivs, DataType dtype,
@@ -199,6 +286,8 @@ class RingReducerTest : public ::testing::Test {
 
   std::unique_ptr<CollectiveTestEnv> test_env_;
   std::vector<std::unique_ptr<DeviceInstance>> instances_;
+  CollectiveCompression compression_ = CollectiveCompression::kNone;
+  string residual_id_;
   mutex mu_;
   int32 reduce_counter_ TF_GUARDED_BY(mu_) = 0;
 };
@@ -427,6 +516,115 @@ DEF_TEST(INT64, CPU, 2, 8, 3, 4095, 0)
 DEF_TEST(FLOAT, CPU, 2, 8, 1, 9408, 1)
 DEF_TEST(FLOAT, CPU, 2, 8, 1, 9408, 7)
 DEF_TEST(FLOAT, CPU, 2, 8, 2, 9408, 11)
+
+// Compression tests
+TEST_F(RingReducerTest, CompressedBfloat16) {
+  RunCompressedTest(CollectiveCompression::kBfloat16, 1, 4, 1, 1001, 8, 0.05);
+}
+
+TEST_F(RingReducerTest, CompressedInt8) {
+  RunCompressedTest(CollectiveCompression::kInt8, 1, 4, 1, 1001, 8, 0.1);
+}
+
+TEST_F(RingReducerTest, CompressedInt8MultiWorkerSubdivs) {
+  RunCompressedTest(CollectiveCompression::kInt8, 2, 4, 2, 4095, 8, 0.3);
+}
+
+TEST_F(RingReducerTest, CompressedInt8FewerElementsThanChunks) {
+  RunCompressedTest(CollectiveCompression::kInt8, 1, 4, 1, 3, 4, 0.1);
+}
+
+// Two eager reductions of same-shape tensors in one group, e.g. gradients of
+// two layers, have the same op name.  They must keep separate residuals.
+TEST_F(RingReducerTest, CompressedInt8ConcurrentReductions) {
+  RunCompressedTest(CollectiveCompression::kInt8, 1, 4, 1, 1001, 8, 0.1,
+                    /*num_reductions=*/2);
+}
+
+TEST(CollectiveResidualStoreTest, RejectsConcurrentUse) {
+  CollectiveResidualStore store;
+  Tensor residual;
+  TF_ASSERT_OK(store.Acquire("a", DT_FLOAT, TensorShape({4}), &residual));
+  EXPECT_EQ(residual.NumElements(), 4);
+  Tensor other;
+  EXPECT_TRUE(absl::IsFailedPrecondition(
+      store.Acquire("a", DT_FLOAT, TensorShape({4}), &other)));
+  TF_EXPECT_OK(store.Acquire("b", DT_FLOAT, TensorShape({4}), &other));
+
+  residual.flat<float>()(0) = 1.0f;
+  store.Release("a");
+  Tensor again;
+  TF_ASSERT_OK(store.Acquire("a", DT_FLOAT, TensorShape({4}), &again));
+  EXPECT_EQ(again.flat<float>()(0), 1.0f);
+  store.Release("a");
+  store.Release("b");
+  EXPECT_EQ(store.size(), 2);
+}
+
+TEST_F(RingReducerTest, CompressionIgnoredForDoubles) {
+  compression_ = CollectiveCompression::kInt8;
+  RunTest<double>(DT_DOUBLE, DEVICE_CPU, 1, 4, 1, 1001, 0);
+}
+
+// Reports the throughput of the all-reduce of the mean of `tensor_len` floats
+// across `num_devices` local CPU devices, sending exact or compressed chunks.
+// Compression trades the cost of encoding and decoding for fewer bytes sent,
+// which only pays off when the transport, unlike the local memcpys here, is
+// bandwidth bound.
+static void BM_RingReduce(::testing::benchmark::State& state) {
+  const auto compression = static_cast<CollectiveCompression>(state.range(0));
+  const int num_devices = state.range(1);
+  const int tensor_len = state.range(2);
+  std::unique_ptr<CollectiveTestEnv> test_env =
+      CreateCollectiveTestEnv(1, num_devices, DEVICE_CPU);
+  std::vector<Tensor> tensors;
+  std::vector<Device*> devices(num_devices);
+  std::vector<std::unique_ptr<OpKernel>> merge_ops;
+  std::vector<std::unique_ptr<OpKernel>> final_ops;
+  for (int rank = 0; rank < num_devices; ++rank) {
+    core::RefCountPtr<CollectiveParams> col_params =
+        CreateCollectiveParams(*test_env, rank, "RingReduce",
+                               REDUCTION_COLLECTIVE, DT_FLOAT,
+                               TensorShape({tensor_len}));
+    TF_CHECK_OK(test_env->device_mgr->LookupDevice(
+        col_params->group.members[rank].device.name(), &devices[rank]));
+    merge_ops.push_back(GetAdd(DT_FLOAT, DEVICE_CPU, devices[rank]));
+    final_ops.push_back(GetDiv(DT_FLOAT, DEVICE_CPU, devices[rank]));
+    tensors.emplace_back(DT_FLOAT, TensorShape({tensor_len}));
+    tensors.back().flat<float>().setRandom();
+  }
+  for (auto s : state) {
+    BlockingCounter counter(num_devices);
+    for (int rank = 0; rank < num_devices; ++rank) {
+      SchedClosure([&, rank] {
+        core::RefCountPtr<CollectiveParams> col_params =
+            CreateCollectiveParams(*test_env, rank, "RingReduce",
+                                   REDUCTION_COLLECTIVE, DT_FLOAT,
+                                   TensorShape({tensor_len}));
+        col_params->instance.impl_details.compression = compression;
+        col_params->merge_op = merge_ops[rank].get();
+        col_params->final_op = final_ops[rank].get();
+        TF_CHECK_OK(RunCollective(test_env.get(), col_params.get(),
+                                  devices[rank], &tensors[rank],
+                                  &tensors[rank]));
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  }
+  state.SetBytesProcessed(state.iterations() * tensor_len * sizeof(float));
+  state.SetLabel(compression == CollectiveCompression::kNone ? "exact"
+                 : compression == CollectiveCompression::kBfloat16
+                     ? "bf16"
+                     : "int8");
+}
+BENCHMARK(BM_RingReduce)
+    ->Args({static_cast<int>(CollectiveCompression::kNone), 4, 1 << 20})
+    ->Args({static_cast<int>(CollectiveCompression::kBfloat16), 4, 1 << 20})
+    ->Args({static_cast<int>(CollectiveCompression::kInt8), 4, 1 << 20})
+    ->Args({static_cast<int>(CollectiveCompression::kNone), 8, 1 << 22})
+    ->Args({static_cast<int>(CollectiveCompression::kBfloat16), 8, 1 << 22})
+    ->Args({static_cast<int>(CollectiveCompression::kInt8), 8, 1 << 22});
 #endif
 
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -17,6 +17,7 @@ limitations under the License.
 #include <memory>
 
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
+#include "tensorflow/core/common_runtime/hardware_counters.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -29,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/scanner.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace {
@@ -49,6 +51,20 @@ bool IsSend(const NodeDef* node) {
   return node->op() == "_Send" || node->op() == "_HostSend";
 }
 
+// Whether the NodeExecStats record the hardware counters of the kernels.
+bool RecordHardwareCounters() {
+  static const bool record_hardware_counters = [] {
+    bool value = false;
+    absl::Status status = ReadBoolFromEnvVar("TF_STEP_STATS_HARDWARE_COUNTERS",
+                                             /*default_val=*/false, &value);
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+    }
+    return value;
+  }();
+  return record_hardware_counters;
+}
+
 }  // namespace
 
 NodeExecStatsWrapper::NodeExecStatsWrapper(
@@ -122,9 +138,23 @@ void NodeExecStatsWrapper::RecordComputeStarted() {
   stats_->set_op_start_rel_micros(now_nanos / EnvTime::kMicrosToNanos -
                                   stats_->all_start_micros());
   stats_->set_op_start_rel_nanos(now_nanos - stats_->all_start_nanos());
+  // Read last so that the bookkeeping above is not counted.
+  if (RecordHardwareCounters() &&
+      ReadThreadHardwareCounters(&compute_start_counters_)) {
+    compute_start_thread_id_ = Env::Default()->GetCurrentThreadId();
+  }
 }
 
 void NodeExecStatsWrapper::RecordComputeEnded() {
+  // Asynchronous kernels may end on another thread, whose counters can't be
+  // compared with those of the thread they started on.
+  HardwareCounters end_counters;
+  if (compute_start_thread_id_ != -1 &&
+      compute_start_thread_id_ == Env::Default()->GetCurrentThreadId() &&
+      ReadThreadHardwareCounters(&end_counters)) {
+    SubtractHardwareCounters(end_counters, compute_start_counters_,
+                             stats_->mutable_hardware_counters());
+  }
   int64_t now_nanos = Env::Default()->NowNanos();
   DCHECK_NE(stats_->all_start_micros(), 0);
   DCHECK_NE(stats_->all_start_nanos(), 0);
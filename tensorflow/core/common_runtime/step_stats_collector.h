@@ -129,6 +129,10 @@ class NodeExecStatsWrapper : public NodeExecStatsInterface {
   std::unique_ptr<NodeExecStats> stats_;
   const NodeDef* const node_;                       // Not owned.
   StepStatsCollector* const step_stats_collector_;  // Not owned.
+  // The hardware counters of the thread that started the computation, if they
+  // are recorded, and that thread, or -1.
+  HardwareCounters compute_start_counters_;
+  int32 compute_start_thread_id_ = -1;
 };
 
 // Statistics collection interface for step execution.
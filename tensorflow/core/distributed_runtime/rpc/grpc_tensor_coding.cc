@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
 
+#include <vector>
+
 #include "grpcpp/support/byte_buffer.h"
 #include "grpcpp/support/slice.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
@@ -24,7 +26,9 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/io/proto_encode_helper.h"
+#include "tensorflow/core/platform/coding.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/tstring.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
 
 namespace tensorflow {
@@ -134,6 +138,108 @@ static void EncodeSkeleton(const Tensor& val, io::ProtoEncodeHelper* e) {
 #endif
 }
 
+// Encodes a DT_STRING "val" like the POD tensors above, except that (E) is
+// the packed string encoding of tensor_content that Tensor::FromProto parses:
+//
+// E1:  <varint32 lengths of all the strings of val>
+// E2:  <bytes of all the strings of val>
+//
+// instead of a repeated string_val field, so that neither side needs a
+// TensorProto with a copy of every string.  E1 and the strings up to
+// "kLargeStringBytes" are copied into contiguous grpc::Slices, while each
+// larger string is sent from a grpc::Slice that shares its backing store.
+static void EncodeStringTensorToByteBuffer(const RecvTensorResponse& response,
+                                           const Tensor& val,
+                                           ::grpc::ByteBuffer* result) {
+  const size_t kLargeStringBytes = 1024;
+
+  absl::InlinedVector<char, 128UL> skeleton(
+      SkeletonEncodingSizeUpperBound(val));
+  io::ProtoEncodeHelper e_skeleton(skeleton.data(), skeleton.size());
+  EncodeSkeleton(val, &e_skeleton);
+
+  const auto strings = val.flat<tstring>();
+  const int64_t num_strings = strings.size();
+  size_t lengths_bytes = 0;
+  size_t strings_bytes = 0;
+  for (int64_t i = 0; i < num_strings; ++i) {
+    lengths_bytes += core::VarintLength(strings(i).size());
+    strings_bytes += strings(i).size();
+  }
+  const size_t content_bytes = lengths_bytes + strings_bytes;
+  uint32 overall_tensor_proto_bytesize =
+      (e_skeleton.size() +
+       VarLengthEncodingSize(TensorProto::kTensorContentFieldNumber,
+                             content_bytes));
+  string header;  // All of RecvTensorResponse except the tensor() field
+  response.AppendToString(&header);
+  size_t expected_size =
+      (header.size() +
+       VarLengthEncodingSize(RecvTensorResponse::kTensorFieldNumber,
+                             overall_tensor_proto_bytesize));
+
+  // (A) through (E1)
+  absl::InlinedVector<char, 1024UL> space(expected_size - strings_bytes);
+  io::ProtoEncodeHelper e(space.data(), space.size() - lengths_bytes);
+  e.WriteRawBytes(header);
+  e.WriteVarlengthBeginning(RecvTensorResponse::kTensorFieldNumber,
+                            overall_tensor_proto_bytesize);
+  e.WriteRawBytes(StringPiece(e_skeleton.data(), e_skeleton.size()));
+  e.WriteVarlengthBeginning(TensorProto::kTensorContentFieldNumber,
+                            content_bytes);
+  char* p = space.data() + e.size();
+  for (int64_t i = 0; i < num_strings; ++i) {
+    p = core::EncodeVarint32(p, strings(i).size());
+  }
+  CHECK_EQ(p, space.data() + space.size());
+
+  // (E2) Runs of small strings are copied after the pending prefix, if any,
+  // while large strings that own their bytes share the tensor backing store.
+  std::vector<::grpc::Slice> slices;
+  StringPiece pending(space.data(), space.size());
+  int64_t run_begin = 0;
+  size_t run_bytes = 0;
+  auto add_run = [&](int64_t run_end) {
+    if (pending.size() + run_bytes == 0) return;
+    ::grpc::Slice slice(pending.size() + run_bytes);
+    char* dst = reinterpret_cast<char*>(const_cast<uint8_t*>(slice.begin()));
+    memcpy(dst, pending.data(), pending.size());
+    dst += pending.size();
+    for (int64_t i = run_begin; i < run_end; ++i) {
+      memcpy(dst, strings(i).data(), strings(i).size());
+      dst += strings(i).size();
+    }
+    slices.push_back(std::move(slice));
+    pending = StringPiece();
+  };
+  const TensorBuffer* buf = DMAHelper::buffer(&val);
+  for (int64_t i = 0; i < num_strings; ++i) {
+    const tstring& s = strings(i);
+    if (s.size() <= kLargeStringBytes || s.type() == tstring::VIEW) {
+      run_bytes += s.size();
+      continue;
+    }
+    add_run(i);
+    buf->Ref();
+    slices.emplace_back(
+        const_cast<void*>(static_cast<const void*>(s.data())), s.size(),
+        [](void* backing) { static_cast<TensorBuffer*>(backing)->Unref(); },
+        const_cast<TensorBuffer*>(buf));
+    run_begin = i + 1;
+    run_bytes = 0;
+  }
+  add_run(num_strings);
+
+  size_t total_bytes = 0;
+  for (const ::grpc::Slice& slice : slices) {
+    total_bytes += slice.size();
+  }
+  CHECK_EQ(total_bytes, expected_size);
+
+  ::grpc::ByteBuffer tmp(slices.data(), slices.size());
+  result->Swap(&tmp);
+}
+
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
                               ::grpc::ByteBuffer* result) {
   const int kLargeTensorBytes = 1024;
@@ -153,7 +259,9 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
   }
   response.set_require_ack(require_ack);
   response.set_send_start_micros(Env::Default()->NowMicros());
-  if (!DataTypeCanUseMemcpy(val.dtype())) {
+  if (val.dtype() == DT_STRING) {
+    EncodeStringTensorToByteBuffer(response, val, result);
+  } else if (!DataTypeCanUseMemcpy(val.dtype())) {
     // Straightforward but slow path for complicated kinds of tensor data
     // TODO(jeff,sanjay): If this becomes an issue, we could
     // go directly from val -> ByteBuffer, with some effort.
@@ -50,6 +50,9 @@ class GrpcTensorCodingTest : public ::testing::Test {
     EXPECT_EQ(t.dtype(), result_tensor.dtype());
     EXPECT_EQ(t.shape().DebugString(), result_tensor.shape().DebugString());
     EXPECT_EQ(t.DebugString(), result_tensor.DebugString());
+    if (t.dtype() == DT_STRING) {
+      test::ExpectTensorEqual<tstring>(t, result_tensor);
+    }
   }
 
   template <typename T>
@@ -100,4 +103,21 @@ TEST_F(GrpcTensorCodingTest, Simple) {
 
 TEST_F(GrpcTensorCodingTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(GrpcTensorCodingTest, LargeStringsShareTensorMemory) {
+  Tensor t = test::AsTensor<tstring>(
+      {"a", string(2000, 'x'), "b", "", string(3000, 'y')}, {5});
+  Validate(t, false);
+
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeTensorToByteBuffer(false, t, false, &buf);
+  std::vector<::grpc::Slice> slices;
+  (void)buf.Dump(&slices);
+  // The header with "a", then "x...x", "b" and "y...y".
+  ASSERT_EQ(slices.size(), 4);
+  EXPECT_EQ(static_cast<const void*>(slices[1].begin()),
+            static_cast<const void*>(t.flat<tstring>()(1).data()));
+  EXPECT_EQ(static_cast<const void*>(slices[3].begin()),
+            static_cast<const void*>(t.flat<tstring>()(4).data()));
+}
+
 }  // namespace tensorflow
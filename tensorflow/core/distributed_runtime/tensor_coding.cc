@@ -15,11 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include <vector>
+
 #include "google/protobuf/any.pb.h"
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/platform/tstring.h"
 
 namespace tensorflow {
 
@@ -141,6 +144,33 @@ bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
   return input->DecrementRecursionDepthAndPopLimit(p.first);
 }
 
+// Reads the `num_bytes` of packed tensor_content of the DT_STRING tensor `t`,
+// i.e. the varint32 lengths of all its strings followed by their bytes, as
+// produced by port::EncodeStringList.  The bytes are read directly into the
+// strings, without going through a TensorProto, so short strings need no
+// allocation at all.
+bool ReadStringTensorContent(protobuf::io::CodedInputStream* input,
+                             int num_bytes, Tensor* t) {
+  auto strings = t->flat<tstring>();
+  const int64_t num_strings = strings.size();
+  std::vector<uint32> lengths(num_strings);
+  int64_t remaining = num_bytes;
+  for (int64_t i = 0; i < num_strings; ++i) {
+    const int position = input->CurrentPosition();
+    if (!input->ReadVarint32(&lengths[i])) return false;
+    remaining -= input->CurrentPosition() - position;
+  }
+  for (int64_t i = 0; i < num_strings; ++i) {
+    remaining -= lengths[i];
+  }
+  if (remaining != 0) return false;
+  for (int64_t i = 0; i < num_strings; ++i) {
+    strings(i).resize_uninitialized(lengths[i]);
+    if (!input->ReadRaw(strings(i).mdata(), lengths[i])) return false;
+  }
+  return true;
+}
+
 }  // namespace
 
 bool TensorResponse::ParseTensorSubmessage(
@@ -166,7 +196,10 @@ bool TensorResponse::ParseTensorSubmessage(
         if ((wt != WIRETYPE_VARINT) || !input->ReadVarint32(&v)) return false;
         if (seen_tensor_content) return false;
         tensor_meta->set_dtype(static_cast<DataType>(static_cast<int>(v)));
-        if (!DataTypeCanUseMemcpy(tensor_meta->dtype())) return false;
+        if (!DataTypeCanUseMemcpy(tensor_meta->dtype()) &&
+            tensor_meta->dtype() != DT_STRING) {
+          return false;
+        }
         break;
       }
       case TensorProto::kTensorShapeFieldNumber: {
@@ -196,6 +229,11 @@ bool TensorResponse::ParseTensorSubmessage(
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
         Tensor t(allocator_, tensor_meta->dtype(), shape);
+        if (tensor_meta->dtype() == DT_STRING) {
+          if (!ReadStringTensorContent(input, num_bytes, &t)) return false;
+          tensor_ = std::move(t);
+          break;
+        }
         StringPiece buf = t.tensor_data();
         if (static_cast<size_t>(num_bytes) != buf.size()) return false;
         // TODO(jeff,sanjay): Figure out a way to avoid this copy if
@@ -103,6 +103,9 @@ class TensorResponseTest : public ::testing::Test {
       EXPECT_EQ(result.dtype(), src.dtype());
       EXPECT_EQ(result.shape().DebugString(), src.shape().DebugString());
       EXPECT_EQ(result.DebugString(), src.DebugString());
+      if (src.dtype() == DT_STRING) {
+        test::ExpectTensorEqual<tstring>(src, result);
+      }
     }
   }
 
@@ -156,6 +159,15 @@ TEST_F(TensorResponseTest, Simple) {
 
 TEST_F(TensorResponseTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(TensorResponseTest, StringTensorMixedLengths) {
+  // Empty, inline and allocated strings, from packed tensor_content as well as
+  // from string_val.
+  Tensor a = test::AsTensor<tstring>(
+      {"", "id", string(5000, 'x'), "", string(23, 'y'), "z"}, {2, 3});
+  Validate(a, false, true);
+  Validate(a, false, false);
+}
+
 string MakeFloatTensorTestCase(int num_elems) {
   std::vector<int8> v(num_elems);
   for (int i = 0; i < num_elems; i++) {
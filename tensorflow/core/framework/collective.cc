@@ -14,8 +14,11 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/framework/collective.h"
 
+#include <cstring>
+
 #include "absl/strings/escaping.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/str_util.h"
@@ -48,6 +51,40 @@ std::vector<RegistrationInfo>* MutableCollectiveRegistry() {
 }
 }  // namespace
 
+absl::Status CollectiveResidualStore::Acquire(const string& key,
+                                              DataType dtype,
+                                              const TensorShape& shape,
+                                              Tensor* residual) {
+  mutex_lock l(mu_);
+  Entry& entry = residuals_[key];
+  if (entry.in_use) {
+    return errors::FailedPrecondition(
+        "The compression residual ", key,
+        " is used by another collective. Concurrent reductions must have "
+        "different residual ids.");
+  }
+  if (!entry.residual.IsInitialized() || entry.residual.dtype() != dtype ||
+      entry.residual.shape() != shape) {
+    entry.residual = Tensor(dtype, shape);
+    memset(entry.residual.data(), 0, entry.residual.TotalBytes());
+  }
+  entry.in_use = true;
+  *residual = entry.residual;
+  return absl::OkStatus();
+}
+
+void CollectiveResidualStore::Release(const string& key) {
+  mutex_lock l(mu_);
+  auto it = residuals_.find(key);
+  DCHECK(it != residuals_.end() && it->second.in_use) << key;
+  if (it != residuals_.end()) it->second.in_use = false;
+}
+
+int CollectiveResidualStore::size() const {
+  mutex_lock l(mu_);
+  return residuals_.size();
+}
+
 string CollGroupRuntimeDetails::ToString() const {
   return strings::StrCat("CollGroupRuntimeDetails {communicator_key=",
                          absl::CEscape(communicator_key), "}");
@@ -18,6 +18,7 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
@@ -26,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/intrusive_ptr.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 
@@ -91,6 +93,14 @@ struct CollGroupParams {
       : group_key(0), group_size(0), device_type(DEVICE_CPU), num_tasks(0) {}
 };
 
+// Lossy encodings of the values that a reduction collective may send between
+// devices instead of the full-precision values.
+enum class CollectiveCompression {
+  kNone = 0,  // Exact, full-precision values.
+  kBfloat16,  // Values rounded to bfloat16.
+  kInt8,      // Values quantized to int8, with one float scale per chunk.
+};
+
 // The best implementation of a collective op depends on many factors
 // including the number of devices involved, the topology of
 // interconnects between them and the sizes of inputs.  This structure
@@ -116,6 +126,11 @@ struct CollImplDetails {
                               // e.g. ring or nccl
   float timeout_seconds;      // If non zero, set a completion timeout for the
                               // collective op to detect staleness.
+  // Encoding of the chunks sent between devices, reduction only.
+  CollectiveCompression compression = CollectiveCompression::kNone;
+  // Identifies the error-feedback residual of a compressed reduction across
+  // steps.  The instance key is used if it is empty.
+  string residual_id;
 };
 
 // Data common to all members of a collective instance.
@@ -314,6 +329,37 @@ class CollectiveRemoteAccess {
   virtual void StartAbort(const absl::Status& s) = 0;
 };
 
+// Error-feedback residuals of lossy collective compression: the compression
+// error of a step is kept here and added back to the values compressed in the
+// next step, so that it is not lost.  Unlike CollectiveExecutors, which are
+// step-specific, a store outlives the steps.  A residual belongs to a single
+// reduced tensor, and is used by one collective at a time.
+class CollectiveResidualStore {
+ public:
+  // Sets `residual` to the residual registered under `key`, sharing its buffer
+  // with the stored tensor, and holds it until Release(`key`).  The residual is
+  // (re)initialized to zeros on host memory if it does not exist yet or has a
+  // different `dtype` or `shape`.  Returns FailedPrecondition if the residual
+  // is already held.
+  absl::Status Acquire(const string& key, DataType dtype,
+                       const TensorShape& shape, Tensor* residual);
+
+  // Releases the residual held under `key`.
+  void Release(const string& key);
+
+  // Returns the number of residuals in the store.
+  int size() const;
+
+ private:
+  struct Entry {
+    Tensor residual;
+    bool in_use = false;
+  };
+
+  mutable mutex mu_;
+  absl::flat_hash_map<string, Entry> residuals_ TF_GUARDED_BY(mu_);
+};
+
 // A step-specific object that can execute a collective operation completely
 // described by a CollectiveParams object.
 class CollectiveExecutor : public core::RefCounted {
@@ -354,6 +400,10 @@ class CollectiveExecutor : public core::RefCounted {
 
   virtual CollectiveRemoteAccess* remote_access() { return nullptr; }
 
+  // Returns the residuals of lossy compression, which persist across steps,
+  // or nullptr if compression with error feedback is not supported.
+  virtual CollectiveResidualStore* residual_store() { return nullptr; }
+
   // `WaitForDependencies` and `Launched` are used for fine-grained control of
   // execution order between collective instances.  These functions are intended
   // to be called in `Run` function of collective implementations, and may be
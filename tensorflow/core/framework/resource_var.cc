@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/framework/resource_var.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/framework/resource_handle.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
 
@@ -45,4 +47,61 @@ std::string Var::MakeRefCountingHandleName(int64_t resource_id) const {
   std::string handle_name = absl::StrFormat("%s%d", debug_name_, resource_id);
   return handle_name;
 }
+
+void Var::StartDirtyRowTracking() {
+  mutex_lock l(dirty_rows_mu_);
+  dirty_rows_.clear();
+  all_rows_dirty_ = false;
+  tracks_dirty_rows_.store(true, std::memory_order_relaxed);
+}
+
+namespace {
+
+template <typename Index>
+void InsertRows(const Tensor& indices, int64_t num_rows,
+                absl::flat_hash_set<int64_t>* rows) {
+  const auto flat = indices.flat<Index>();
+  for (int64_t i = 0; i < flat.size(); ++i) {
+    const int64_t row = flat(i);
+    if (row >= 0 && row < num_rows) rows->insert(row);
+  }
+}
+
+}  // namespace
+
+void Var::MarkRowsDirty(const Tensor& indices) {
+  if (!tracks_dirty_rows()) return;
+  // Sparse updates may run under a shared lock on mu_, which still excludes
+  // dense updates that change the shape of the tensor.
+  const int64_t num_rows = tensor_.dims() > 0 ? tensor_.dim_size(0) : 0;
+  mutex_lock l(dirty_rows_mu_);
+  if (all_rows_dirty_) return;
+  if (indices.dtype() == DT_INT32) {
+    InsertRows<int32>(indices, num_rows, &dirty_rows_);
+  } else if (indices.dtype() == DT_INT64) {
+    InsertRows<int64_t>(indices, num_rows, &dirty_rows_);
+  } else {
+    all_rows_dirty_ = true;
+    dirty_rows_.clear();
+  }
+}
+
+void Var::MarkAllRowsDirty() {
+  if (!tracks_dirty_rows()) return;
+  mutex_lock l(dirty_rows_mu_);
+  all_rows_dirty_ = true;
+  dirty_rows_.clear();
+}
+
+void Var::TakeDirtyRows(std::vector<int64_t>* rows, bool* all_rows) {
+  rows->clear();
+  mutex_lock l(dirty_rows_mu_);
+  *all_rows = all_rows_dirty_;
+  if (!all_rows_dirty_) {
+    rows->assign(dirty_rows_.begin(), dirty_rows_.end());
+    std::sort(rows->begin(), rows->end());
+  }
+  dirty_rows_.clear();
+  all_rows_dirty_ = false;
+}
 }  //  end namespace tensorflow
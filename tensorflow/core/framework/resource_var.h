@@ -16,8 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_RESOURCE_VAR_H_
 #define TENSORFLOW_CORE_FRAMEWORK_RESOURCE_VAR_H_
 
+#include <atomic>
 #include <string>
+#include <vector>
 
+#include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/framework/resource_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -110,11 +113,38 @@ class Var : public ResourceBase {
   // so desired.
   std::atomic<bool> copy_on_read_mode{false};
 
+  // Dirty-row tracking, used to checkpoint only the rows (along dimension 0)
+  // of a large, sparsely updated variable that changed since its previous
+  // checkpoint. Tracking is off until StartDirtyRowTracking() is called, which
+  // also forgets all previously recorded writes. The methods below are
+  // thread-safe and do not require mu().
+  void StartDirtyRowTracking();
+  bool tracks_dirty_rows() const {
+    return tracks_dirty_rows_.load(std::memory_order_relaxed);
+  }
+
+  // Records that the rows in `indices`, an int32 or int64 tensor in host
+  // memory, were written by a sparse update. Out-of-range indices are ignored.
+  void MarkRowsDirty(const Tensor& indices);
+
+  // Records that the whole variable was written, e.g. by a dense update.
+  void MarkAllRowsDirty();
+
+  // Returns the rows written since tracking started or since the previous
+  // call, in increasing order, and forgets them. Sets `*all_rows` instead if
+  // the whole variable was written.
+  void TakeDirtyRows(std::vector<int64_t>* rows, bool* all_rows);
+
  private:
   mutex mu_;
   Tensor tensor_;
   std::string debug_name_;
 
+  std::atomic<bool> tracks_dirty_rows_{false};
+  mutex dirty_rows_mu_;
+  absl::flat_hash_set<int64_t> dirty_rows_ TF_GUARDED_BY(dirty_rows_mu_);
+  bool all_rows_dirty_ TF_GUARDED_BY(dirty_rows_mu_) = false;
+
   ~Var() override {}
   Var(const Var&) = delete;
   void operator=(const Var&) = delete;
@@ -34,5 +34,41 @@ TEST(ResourceVarTest, Uninitialize) {
   EXPECT_FALSE(var->is_initialized);
   EXPECT_TRUE(var->tensor()->data() == nullptr);
 }
+
+TEST(ResourceVarTest, DirtyRowTracking) {
+  RefCountPtr<Var> var{new Var(DT_FLOAT)};
+  *(var->tensor()) = Tensor(DT_FLOAT, TensorShape({10, 4}));
+
+  Tensor indices(DT_INT32, TensorShape({3}));
+  indices.vec<int32>().setValues({7, 2, 7});
+  // Nothing is recorded until tracking starts.
+  EXPECT_FALSE(var->tracks_dirty_rows());
+  var->MarkRowsDirty(indices);
+
+  std::vector<int64_t> rows;
+  bool all_rows;
+  var->StartDirtyRowTracking();
+  var->TakeDirtyRows(&rows, &all_rows);
+  EXPECT_FALSE(all_rows);
+  EXPECT_TRUE(rows.empty());
+
+  var->MarkRowsDirty(indices);
+  Tensor more_indices(DT_INT64, TensorShape({2}));
+  more_indices.vec<int64_t>().setValues({0, 12});
+  var->MarkRowsDirty(more_indices);
+  var->TakeDirtyRows(&rows, &all_rows);
+  EXPECT_FALSE(all_rows);
+  EXPECT_EQ(rows, std::vector<int64_t>({0, 2, 7}));
+
+  // Taking the rows resets them.
+  var->TakeDirtyRows(&rows, &all_rows);
+  EXPECT_TRUE(rows.empty());
+
+  var->MarkRowsDirty(indices);
+  var->MarkAllRowsDirty();
+  var->TakeDirtyRows(&rows, &all_rows);
+  EXPECT_TRUE(all_rows);
+  EXPECT_TRUE(rows.empty());
+}
 }  // namespace core
 }  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <deque>
+#include <functional>
 #include <limits>
 #include <unordered_map>
 #include <unordered_set>
@@ -3750,6 +3751,256 @@ class UnaryOpsComposition : public ArithmeticOptimizerStage {
   std::unordered_set<string> fused_nodes_;
 };
 
+// Replace a connected subgraph of element-wise unary and binary ops, that all
+// produce a tensor of the same shape, with a single '_FusedElementwise' node
+// that evaluates them in one blocked pass over memory. External inputs of the
+// subgraph must have the output shape, or be scalars or rows broadcasted along
+// the innermost dimension.
+//
+// Example:
+//
+//   x  mean         x   mean  scale
+//    \  /            \    |    /
+//     Sub  scale      _FusedElementwise
+//       \  /          [Sub, Mul, Relu]
+//        Mul    =>
+//         |
+//        Relu
+//
+// Pure unary chains are left to the UnaryOpsComposition stage.
+class FuseElementwiseChains : public ArithmeticOptimizerStage {
+ public:
+  explicit FuseElementwiseChains(const GraphOptimizerContext& ctx,
+                                 const ArithmeticOptimizerContext& ctx_ext)
+      : ArithmeticOptimizerStage("FuseElementwiseChains", ctx, ctx_ext) {
+    // WARN: This should be consistent with fused_elementwise_op.cc.
+    unary_ops_ = {"Abs", "Exp", "Log", "Log1p", "Neg", "Reciprocal", "Relu",
+                  "Rsqrt", "Sigmoid", "Sqrt", "Square", "Tanh"};
+    binary_ops_ = {"Add", "AddV2", "Sub", "Mul", "Div", "RealDiv", "Maximum",
+                   "Minimum", "SquaredDifference"};
+  }
+  ~FuseElementwiseChains() override = default;
+
+  bool IsSupported(const NodeDef* node) const override {
+    return CanFuse(*node) &&
+           !ctx().node_map->NodeExists(OptimizedNodeName(*node));
+  }
+
+  absl::Status TrySimplify(NodeDef* root,
+                           string* simplified_node_name) override {
+    const DataType dtype = GetDataTypeFromAttr(*root, "T");
+
+    const OpInfo::TensorProperties* root_props;
+    TF_RETURN_IF_ERROR(GetTensorProperties(root->name(), &root_props));
+    if (!ShapeIsSymbolicallyDefined(*root_props)) return absl::OkStatus();
+    const TensorShapeProto& shape = root_props->shape();
+
+    // If the only consumer of the root can be fused with it, the fused
+    // subgraph will be built when the consumer is visited.
+    const auto& consumers = ctx().node_map->GetOutputs(root->name());
+    if (consumers.size() == 1 &&
+        CanFuseInto(**consumers.begin(), dtype, shape)) {
+      return absl::OkStatus();
+    }
+
+    // Grow the fused subgraph from the root towards its inputs. A node can be
+    // added only when all of its consumers are already in the subgraph.
+    absl::flat_hash_set<const NodeDef*> fused = {root};
+    std::deque<NodeDef*> candidates;
+    const auto add_input_candidates = [&](const NodeDef& node) {
+      for (int i = 0; i < node.input_size(); ++i) {
+        const TensorId tensor = ParseTensorName(node.input(i));
+        if (tensor.index() != 0) continue;
+        NodeDef* input = ctx().node_map->GetNode(string(tensor.node()));
+        if (input != nullptr && !fused.contains(input)) {
+          candidates.push_back(input);
+        }
+      }
+    };
+    add_input_candidates(*root);
+
+    bool changed = true;
+    while (changed && fused.size() < kMaxFusedOps) {
+      changed = false;
+      const int num_candidates = candidates.size();
+      for (int i = 0; i < num_candidates && fused.size() < kMaxFusedOps; ++i) {
+        NodeDef* candidate = candidates.front();
+        candidates.pop_front();
+        if (fused.contains(candidate) ||
+            !CanFuseInto(*candidate, dtype, shape)) {
+          continue;
+        }
+        const auto& outputs = ctx().node_map->GetOutputs(candidate->name());
+        const bool all_outputs_fused = std::all_of(
+            outputs.begin(), outputs.end(),
+            [&](const NodeDef* output) { return fused.contains(output); });
+        if (!all_outputs_fused) {
+          // Some consumers may still be added to the subgraph.
+          candidates.push_back(candidate);
+          continue;
+        }
+        fused.insert(candidate);
+        add_input_candidates(*candidate);
+        changed = true;
+      }
+    }
+
+    const bool has_binary_op =
+        std::any_of(fused.begin(), fused.end(), [this](const NodeDef* node) {
+          return binary_ops_.count(node->op()) > 0;
+        });
+    if (fused.size() < 2 || !has_binary_op) return absl::OkStatus();
+
+    // Order fused nodes so that every node comes after its fused inputs, and
+    // collect external inputs of the subgraph. Operand indices follow the
+    // '_FusedElementwise' convention: external inputs come first, followed by
+    // the results of the fused ops.
+    std::vector<const NodeDef*> program;
+    std::vector<string> external_inputs;
+    absl::flat_hash_map<string, int> operand_index;
+    bool has_full_shape_input = false;
+    bool valid = true;
+    std::function<void(const NodeDef*)> visit = [&](const NodeDef* node) {
+      for (int i = 0; i < NumNonControlInputs(*node); ++i) {
+        const string& input = node->input(i);
+        const NodeDef* input_node = ctx().node_map->GetNode(input);
+        if (fused.contains(input_node)) {
+          if (!operand_index.contains(input_node->name())) visit(input_node);
+          continue;
+        }
+        if (operand_index.contains(input)) continue;
+
+        const OpInfo::TensorProperties* input_props;
+        if (!GetTensorProperties(input, &input_props).ok()) {
+          valid = false;
+          continue;
+        }
+        const InputBroadcast broadcast =
+            GetInputBroadcast(input_props->shape(), shape);
+        if (broadcast == InputBroadcast::kUnsupported) valid = false;
+        if (broadcast == InputBroadcast::kNone) has_full_shape_input = true;
+
+        operand_index[input] = external_inputs.size();
+        external_inputs.push_back(input);
+      }
+      operand_index[node->name()] = program.size();
+      program.push_back(node);
+    };
+    visit(root);
+    if (!valid || !has_full_shape_input) return absl::OkStatus();
+
+    const int num_inputs = external_inputs.size();
+    const auto operand = [&](const string& input) -> int {
+      const NodeDef* input_node = ctx().node_map->GetNode(input);
+      if (fused.contains(input_node)) {
+        return num_inputs + operand_index.at(input_node->name());
+      }
+      return operand_index.at(input);
+    };
+
+    std::vector<string> op_names;
+    std::vector<int> op_inputs;
+    for (const NodeDef* node : program) {
+      op_names.push_back(node->op());
+      op_inputs.push_back(operand(node->input(0)));
+      op_inputs.push_back(
+          NumNonControlInputs(*node) > 1 ? operand(node->input(1)) : -1);
+    }
+
+    VLOG(2) << "Fuse element-wise ops: root=" << root->name() << " op_names=["
+            << absl::StrJoin(op_names, ", ") << "]";
+
+    for (const NodeDef* node : program) AddToFusedNodes(node->name());
+
+    NodeDef* fused_node = AddEmptyNode(OptimizedNodeName(*root));
+    fused_node->set_op("_FusedElementwise");
+    fused_node->set_device(root->device());
+    for (const string& input : external_inputs) {
+      fused_node->add_input(input);
+      ctx().node_map->AddOutput(NodeName(input), fused_node->name());
+    }
+
+    auto* attr = fused_node->mutable_attr();
+    SetAttrValue(dtype, &(*attr)["T"]);
+    SetAttrValue(num_inputs, &(*attr)["N"]);
+    SetAttrValue(op_names, &(*attr)["op_names"]);
+    SetAttrValue(op_inputs, &(*attr)["op_inputs"]);
+
+    *simplified_node_name = fused_node->name();
+    return absl::OkStatus();
+  }
+
+ private:
+  // Upper bound on the size of a fused program, to keep the per-block scratch
+  // buffers of the kernel in cache.
+  static constexpr int kMaxFusedOps = 32;
+
+  enum class InputBroadcast { kNone, kScalar, kRow, kUnsupported };
+
+  bool CanFuse(const NodeDef& node) const {
+    if (unary_ops_.count(node.op()) == 0 && binary_ops_.count(node.op()) == 0) {
+      return false;
+    }
+    const DataType dtype = GetDataTypeFromAttr(node, "T");
+    if (dtype != DT_FLOAT && dtype != DT_HALF && dtype != DT_DOUBLE) {
+      return false;
+    }
+    if (IsInPreserveSet(node) || !NodeIsOnCpu(node) ||
+        fused_nodes_.count(node.name()) > 0) {
+      return false;
+    }
+    return !(IsDrivenByControlDependency(node) ||
+             DrivesControlDependency(node));
+  }
+
+  // Returns true if `node` can be a part of the fused subgraph computing a
+  // tensor of type `dtype` and shape `shape`.
+  bool CanFuseInto(const NodeDef& node, DataType dtype,
+                   const TensorShapeProto& shape) const {
+    if (!CanFuse(node) || GetDataTypeFromAttr(node, "T") != dtype) {
+      return false;
+    }
+    const OpInfo::TensorProperties* props;
+    return GetTensorProperties(node.name(), &props).ok() &&
+           ShapesSymbolicallyEqual(props->shape(), shape);
+  }
+
+  // Classifies how an external input of shape `input` is broadcasted to the
+  // fused output of shape `output`.
+  static InputBroadcast GetInputBroadcast(const TensorShapeProto& input,
+                                          const TensorShapeProto& output) {
+    if (ShapesSymbolicallyEqual(input, output)) return InputBroadcast::kNone;
+
+    const int input_rank = Rank(input);
+    const int output_rank = Rank(output);
+    if (input_rank < 0 || input_rank > output_rank) {
+      return InputBroadcast::kUnsupported;
+    }
+    for (int d = 0; d < input_rank - 1; ++d) {
+      if (input.dim(d).size() != 1) return InputBroadcast::kUnsupported;
+    }
+    if (input_rank == 0 || input.dim(input_rank - 1).size() == 1) {
+      return InputBroadcast::kScalar;
+    }
+    const auto& inner_dim = input.dim(input_rank - 1);
+    if (IsKnown(inner_dim) &&
+        inner_dim.size() == output.dim(output_rank - 1).size()) {
+      return InputBroadcast::kRow;
+    }
+    return InputBroadcast::kUnsupported;
+  }
+
+  string OptimizedNodeName(const NodeDef& node) const {
+    return strings::StrCat(node.name(), "/fused_elementwise");
+  }
+
+  void AddToFusedNodes(const string& name) { fused_nodes_.insert(name); }
+
+  std::unordered_set<string> unary_ops_;
+  std::unordered_set<string> binary_ops_;
+  std::unordered_set<string> fused_nodes_;
+};
+
 // Replace operations of the form:
 //    x = stack((a_0, a_1, ..., a_{n-1}), axis=k)[:,...,i,...]
 // with
@@ -4403,6 +4654,8 @@ absl::Status ArithmeticOptimizer::SimplifyArithmeticOps(bool can_use_shapes) {
     pipeline.AddStage<OptimizeMaxOrMinOfMonotonicStage>(ctx, ctx_ext);
   if (options_.convert_expm1)
     pipeline.AddStage<ConvertExpm1Stage>(ctx, ctx_ext);
+  if (is_aggressive && options_.fuse_elementwise_chains && can_use_shapes)
+    pipeline.AddStage<FuseElementwiseChains>(ctx, ctx_ext);
   if (options_.unary_ops_composition)
     pipeline.AddStage<UnaryOpsComposition>(ctx, ctx_ext);
   if (options_.remove_stack_slice_same_axis)
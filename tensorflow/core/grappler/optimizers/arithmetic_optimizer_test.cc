@@ -4322,6 +4322,117 @@ TEST_F(ArithmeticOptimizerTest, UnaryOpsComposition) {
   test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
 }
 
+TEST_F(ArithmeticOptimizerTest, FuseElementwiseChains) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto x = ops::Const(s.WithOpName("x"), {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f},
+                      {2, 3});
+  auto mean = ops::Const(s.WithOpName("mean"), {1.0f, 3.0f, 2.0f}, {3});
+  auto scale = ops::Const(s.WithOpName("scale"), 2.0f);
+  Output sub = ops::Sub(s.WithOpName("sub"), x, mean);
+  Output mul = ops::Mul(s.WithOpName("mul"), sub, scale);
+  Output relu = ops::Relu(s.WithOpName("relu"), mul);
+  Output final_out = ops::Identity(s.WithOpName("final_out"), relu);
+
+  GrapplerItem item;
+  item.fetch = {"final_out"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  ASSERT_EQ(tensors_expected.size(), 1);
+
+  GraphDef output;
+  ArithmeticOptimizer optimizer(RewriterConfig::AGGRESSIVE);
+  EnableOnlyFuseElementwiseChains(&optimizer);
+  OptimizeAndPrune(&optimizer, &item, &output);
+
+  EXPECT_EQ(output.node_size(), 5);
+
+  // Check that Sub/Mul/Relu were replaced with a single op.
+  int required_node_count = 0;
+  for (int i = 0; i < output.node_size(); ++i) {
+    const NodeDef& node = output.node(i);
+    if (node.name() == "final_out") {
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "relu/fused_elementwise");
+      ++required_node_count;
+    } else if (node.name() == "relu/fused_elementwise") {
+      EXPECT_EQ(node.op(), "_FusedElementwise");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "x");
+      EXPECT_EQ(node.input(1), "mean");
+      EXPECT_EQ(node.input(2), "scale");
+
+      auto op_names = node.attr().at("op_names").list().s();
+      ASSERT_EQ(op_names.size(), 3);
+      EXPECT_EQ(op_names[0], "Sub");
+      EXPECT_EQ(op_names[1], "Mul");
+      EXPECT_EQ(op_names[2], "Relu");
+
+      auto op_inputs = node.attr().at("op_inputs").list().i();
+      ASSERT_EQ(op_inputs.size(), 6);
+      EXPECT_EQ(op_inputs[0], 0);
+      EXPECT_EQ(op_inputs[1], 1);
+      EXPECT_EQ(op_inputs[2], 3);
+      EXPECT_EQ(op_inputs[3], 2);
+      EXPECT_EQ(op_inputs[4], 4);
+      EXPECT_EQ(op_inputs[5], -1);
+      ++required_node_count;
+    }
+  }
+  EXPECT_EQ(required_node_count, 2);
+
+  auto tensors = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+}
+
+TEST_F(ArithmeticOptimizerTest, FuseElementwiseChainsSkipsSharedNodes) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto x = ops::Const(s.WithOpName("x"), {1.0f, 2.0f}, {2});
+  auto y = ops::Const(s.WithOpName("y"), {3.0f, 4.0f}, {2});
+  Output add = ops::AddV2(s.WithOpName("add"), x, y);
+  Output tanh = ops::Tanh(s.WithOpName("tanh"), add);
+  Output mul = ops::Mul(s.WithOpName("mul"), tanh, x);
+  Output out1 = ops::Identity(s.WithOpName("out1"), mul);
+  Output out2 = ops::Identity(s.WithOpName("out2"), tanh);
+
+  GrapplerItem item;
+  item.fetch = {"out1", "out2"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  ASSERT_EQ(tensors_expected.size(), 2);
+
+  GraphDef output;
+  ArithmeticOptimizer optimizer(RewriterConfig::AGGRESSIVE);
+  EnableOnlyFuseElementwiseChains(&optimizer);
+  OptimizeAndPrune(&optimizer, &item, &output);
+
+  // 'tanh' has a consumer outside of the subgraph rooted at 'mul', so it can
+  // only be fused with 'add' into a subgraph of its own.
+  NodeMap node_map(&output);
+  const NodeDef* fused_mul = node_map.GetNode("mul/fused_elementwise");
+  EXPECT_EQ(fused_mul, nullptr);
+  const NodeDef* fused_tanh = node_map.GetNode("tanh/fused_elementwise");
+  ASSERT_NE(fused_tanh, nullptr);
+  EXPECT_EQ(fused_tanh->op(), "_FusedElementwise");
+
+  auto tensors = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(tensors.size(), 2);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+  test::ExpectTensorNear<float>(tensors[1], tensors_expected[1], 1e-6);
+}
+
 TEST_F(ArithmeticOptimizerTest, RemoveStackStridedSliceSameAxis) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   auto a_in =
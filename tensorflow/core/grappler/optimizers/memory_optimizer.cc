@@ -16,8 +16,11 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 
 #include <algorithm>
+#include <functional>
+#include <numeric>
 #include <queue>
 #include <set>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -1379,6 +1382,299 @@ absl::Status FindAssignNodesToRelax(const GraphDef& graph,
   return absl::OkStatus();
 }
 
+// Only tensors of at least this size are tracked by the ordering pass: they
+// dominate the peak memory usage, and only the ops that allocate or free them
+// get extra control dependencies.
+constexpr int64_t kMinOrderedTensorBytes = 256 << 10;
+
+// Dataflow graph restricted to the large tensors tracked by the ordering pass.
+// Nodes are numbered in the baseline topological order.
+struct OrderingGraph {
+  struct Tensor {
+    int64_t bytes = 0;
+    int num_consumers = 0;
+    // Fetched tensors stay alive until the end of the step.
+    bool keep_alive = false;
+  };
+
+  std::vector<NodeDef*> nodes;
+  std::vector<std::vector<int>> fanouts;
+  std::vector<int> num_fanins;
+  // Tracked tensors produced and consumed by every node.
+  std::vector<std::vector<int>> outputs;
+  std::vector<std::vector<int>> inputs;
+  std::vector<Tensor> tensors;
+};
+
+absl::Status BuildOrderingGraph(GrapplerItem* item, OrderingGraph* g) {
+  std::vector<const NodeDef*> topo_order;
+  TF_RETURN_IF_ERROR(ComputeTopologicalOrder(item->graph, &topo_order));
+
+  GraphProperties properties(*item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(
+      /*assume_valid_feeds=*/false, /*aggressive_shape_inference=*/false,
+      /*include_tensor_values=*/false));
+
+  const int num_nodes = topo_order.size();
+  std::unordered_map<string, int> node_index;
+  g->nodes.reserve(num_nodes);
+  for (const NodeDef* node : topo_order) {
+    node_index[node->name()] = g->nodes.size();
+    g->nodes.push_back(const_cast<NodeDef*>(node));
+  }
+  g->fanouts.resize(num_nodes);
+  g->num_fanins.resize(num_nodes);
+  g->outputs.resize(num_nodes);
+  g->inputs.resize(num_nodes);
+
+  const std::unordered_set<string> nodes_to_preserve = item->NodesToPreserve();
+  std::unordered_map<string, int> tensor_index;
+  for (int i = 0; i < num_nodes; ++i) {
+    const NodeDef& node = *g->nodes[i];
+    string device;
+    string task;
+    const bool on_cpu =
+        node.device().empty() ||
+        (DeviceNameUtils::SplitDeviceName(node.device(), &task, &device) &&
+         absl::StrContains(device, DEVICE_CPU));
+    // Constants and variables are persistent, their memory is never freed.
+    if (!on_cpu || IsConstant(node) || IsVariable(node) ||
+        !properties.HasOutputProperties(node.name())) {
+      continue;
+    }
+    const auto& props = properties.GetOutputProperties(node.name());
+    for (int port = 0; port < props.size(); ++port) {
+      const OpInfo::TensorProperties& prop = props[port];
+      if (IsRefType(prop.dtype()) ||
+          !PartialTensorShape(prop.shape()).IsFullyDefined()) {
+        continue;
+      }
+      const int64_t bytes = CalculateTensorSize(prop);
+      if (bytes < kMinOrderedTensorBytes) continue;
+
+      OrderingGraph::Tensor tensor;
+      tensor.bytes = bytes;
+      tensor.keep_alive = nodes_to_preserve.count(node.name()) > 0;
+      tensor_index[strings::StrCat(node.name(), ":", port)] =
+          g->tensors.size();
+      g->outputs[i].push_back(g->tensors.size());
+      g->tensors.push_back(tensor);
+    }
+  }
+
+  for (int i = 0; i < num_nodes; ++i) {
+    std::unordered_set<int> fanins;
+    std::unordered_set<int> input_tensors;
+    for (const string& input : g->nodes[i]->input()) {
+      const TensorId tensor = ParseTensorName(input);
+      auto it = node_index.find(string(tensor.node()));
+      if (it == node_index.end()) {
+        return errors::InvalidArgument("Missing node ", tensor.node());
+      }
+      fanins.insert(it->second);
+      if (tensor.index() < 0) continue;
+      auto t = tensor_index.find(
+          strings::StrCat(tensor.node(), ":", tensor.index()));
+      if (t != tensor_index.end()) input_tensors.insert(t->second);
+    }
+    g->num_fanins[i] = fanins.size();
+    for (int fanin : fanins) g->fanouts[fanin].push_back(i);
+    for (int t : input_tensors) {
+      g->inputs[i].push_back(t);
+      ++g->tensors[t].num_consumers;
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Estimates the peak memory used by tracked tensors when the graph nodes are
+// executed one by one in the given order.
+int64_t EstimatePeakMemory(const OrderingGraph& g,
+                           const std::vector<int>& order) {
+  std::vector<int> remaining(g.tensors.size());
+  for (int t = 0; t < g.tensors.size(); ++t) {
+    remaining[t] = g.tensors[t].num_consumers;
+  }
+  const auto release = [&](int t, int64_t* live) {
+    if (remaining[t] == 0 && !g.tensors[t].keep_alive) {
+      *live -= g.tensors[t].bytes;
+    }
+  };
+
+  int64_t live = 0;
+  int64_t peak = 0;
+  for (int node : order) {
+    for (int t : g.outputs[node]) live += g.tensors[t].bytes;
+    peak = std::max(peak, live);
+    for (int t : g.inputs[node]) {
+      --remaining[t];
+      release(t, &live);
+    }
+    for (int t : g.outputs[node]) release(t, &live);
+  }
+  return peak;
+}
+
+// Computes a topological order with a greedy list scheduler that always runs
+// the ready node with the smallest net memory increase, breaking ties in favor
+// of smaller allocations and then of the baseline order.
+std::vector<int> ComputeMemoryOrder(const OrderingGraph& g) {
+  const int num_nodes = g.nodes.size();
+  std::vector<int> pending = g.num_fanins;
+  std::vector<int> remaining(g.tensors.size());
+  std::vector<std::vector<int>> consumers(g.tensors.size());
+  for (int t = 0; t < g.tensors.size(); ++t) {
+    remaining[t] = g.tensors[t].num_consumers;
+  }
+  for (int i = 0; i < num_nodes; ++i) {
+    for (int t : g.inputs[i]) consumers[t].push_back(i);
+  }
+
+  // Bytes allocated by every node, and the net memory increase of running it
+  // next. The increase only goes down, when the node becomes the last
+  // consumer of one of its inputs.
+  std::vector<int64_t> alloc(num_nodes);
+  std::vector<int64_t> delta(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    for (int t : g.outputs[i]) alloc[i] += g.tensors[t].bytes;
+    delta[i] = alloc[i];
+    for (int t : g.inputs[i]) {
+      if (remaining[t] == 1 && !g.tensors[t].keep_alive) {
+        delta[i] -= g.tensors[t].bytes;
+      }
+    }
+  }
+
+  // Ready nodes keyed by (delta, alloc, node). Entries left behind when the
+  // delta of a ready node goes down are skipped when popped.
+  using ReadyNode = std::tuple<int64_t, int64_t, int>;
+  std::priority_queue<ReadyNode, std::vector<ReadyNode>,
+                      std::greater<ReadyNode>>
+      ready;
+  for (int i = 0; i < num_nodes; ++i) {
+    if (pending[i] == 0) ready.emplace(delta[i], alloc[i], i);
+  }
+
+  std::vector<bool> scheduled(num_nodes, false);
+  std::vector<int> order;
+  order.reserve(num_nodes);
+  while (!ready.empty()) {
+    const auto [node_delta, node_alloc, node] = ready.top();
+    ready.pop();
+    if (scheduled[node] || node_delta != delta[node]) continue;
+    scheduled[node] = true;
+    order.push_back(node);
+
+    for (int t : g.inputs[node]) {
+      if (--remaining[t] != 1 || g.tensors[t].keep_alive) continue;
+      // The one consumer left now frees the tensor.
+      for (int consumer : consumers[t]) {
+        if (scheduled[consumer]) continue;
+        delta[consumer] -= g.tensors[t].bytes;
+        if (pending[consumer] == 0) {
+          ready.emplace(delta[consumer], alloc[consumer], consumer);
+        }
+      }
+    }
+    for (int fanout : g.fanouts[node]) {
+      if (--pending[fanout] == 0) {
+        ready.emplace(delta[fanout], alloc[fanout], fanout);
+      }
+    }
+  }
+  return order;
+}
+
+// Returns the peak memory usage of `item` simulated by the VirtualScheduler,
+// or -1 if it is unknown.
+int64_t SimulatePeakMemory(Cluster* cluster, const GrapplerItem& item) {
+  GraphMemory memory(item);
+  absl::Status s = memory.InferStatically(cluster->GetDevices());
+  if (!s.ok()) {
+    VLOG(1) << "Failed to infer the memory usage: " << s.message();
+    return -1;
+  }
+  return memory.GetWorstCaseMemoryUsage();
+}
+
+// Reorders the graph to lower its estimated peak memory usage. Returns true if
+// the graph was changed.
+//
+// The order is searched with an incremental estimate of the tracked tensors:
+// the list scheduler needs the memory delta of every ready node at every step,
+// which a full GraphMemory simulation can't provide at that granularity. When
+// a cluster is available and the graph has fetches, the VirtualScheduler then
+// simulates the graph before and after the rewrite through GraphMemory, and the
+// rewrite is reverted unless it lowers the simulated peak.
+bool OrderingPass(Cluster* cluster, GrapplerItem* item) {
+  for (const NodeDef& node : item->graph.node()) {
+    // Control dependencies can't cross frame boundaries.
+    if (IsControlFlow(node)) return false;
+  }
+
+  OrderingGraph g;
+  absl::Status s = BuildOrderingGraph(item, &g);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to build the ordering graph: " << s.message();
+    return false;
+  }
+  if (g.tensors.empty()) return false;
+
+  std::vector<int> baseline_order(g.nodes.size());
+  std::iota(baseline_order.begin(), baseline_order.end(), 0);
+  const std::vector<int> order = ComputeMemoryOrder(g);
+  if (order.size() != g.nodes.size()) return false;
+
+  const int64_t baseline_peak = EstimatePeakMemory(g, baseline_order);
+  const int64_t peak = EstimatePeakMemory(g, order);
+  VLOG(1) << "Estimated peak memory of tracked tensors: " << baseline_peak
+          << " bytes in the default order, " << peak
+          << " bytes in the memory-aware order";
+  if (peak >= baseline_peak) return false;
+
+  const bool simulate = cluster != nullptr && !item->fetch.empty();
+  const int64_t simulated_baseline_peak =
+      simulate ? SimulatePeakMemory(cluster, *item) : -1;
+  GraphDef baseline_graph;
+  if (simulated_baseline_peak >= 0) baseline_graph = item->graph;
+
+  // Chain the nodes that allocate or free tracked tensors in the new order,
+  // separately for every device. Other nodes keep their scheduling freedom.
+  std::unordered_map<string, NodeDef*> last_node_on_device;
+  int num_added = 0;
+  for (int i : order) {
+    if (g.outputs[i].empty() && g.inputs[i].empty()) continue;
+    NodeDef* node = g.nodes[i];
+    auto it = last_node_on_device.find(node->device());
+    if (it != last_node_on_device.end()) {
+      const string& prev = it->second->name();
+      const bool has_fanin = std::any_of(
+          node->input().begin(), node->input().end(),
+          [&prev](const string& input) { return NodeName(input) == prev; });
+      if (!has_fanin) {
+        node->add_input(AsControlDependency(prev));
+        ++num_added;
+      }
+    }
+    last_node_on_device[node->device()] = node;
+  }
+  if (num_added == 0) return false;
+
+  if (simulated_baseline_peak >= 0) {
+    const int64_t simulated_peak = SimulatePeakMemory(cluster, *item);
+    VLOG(1) << "Simulated peak memory: " << simulated_baseline_peak
+            << " bytes in the default order, " << simulated_peak
+            << " bytes in the memory-aware order";
+    if (simulated_peak < 0 || simulated_peak >= simulated_baseline_peak) {
+      item->graph.Swap(&baseline_graph);
+      return false;
+    }
+  }
+  VLOG(1) << "Added " << num_added
+          << " control dependencies to enforce the memory-aware order";
+  return true;
+}
+
 }  // namespace
 
 absl::Status MemoryOptimizer::Optimize(Cluster* cluster,
@@ -1391,7 +1687,10 @@ absl::Status MemoryOptimizer::Optimize(Cluster* cluster,
       (optimization_level_ == RewriterConfig::RECOMPUTATION_HEURISTICS ||
        optimization_level_ == RewriterConfig::HEURISTICS ||
        optimization_level_ == RewriterConfig::MANUAL);
-  if (!run_recomputation_pass && nodes_to_relax.empty() && item.fetch.empty()) {
+  bool run_ordering_pass =
+      optimization_level_ == RewriterConfig::ORDERING_HEURISTICS;
+  if (!run_recomputation_pass && !run_ordering_pass && nodes_to_relax.empty() &&
+      item.fetch.empty()) {
     return errors::Aborted("Nothing to do.");
   }
 
@@ -1404,6 +1703,14 @@ absl::Status MemoryOptimizer::Optimize(Cluster* cluster,
                                &optimized_item.graph, item);
   }
 
+  if (run_ordering_pass) {
+    GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+    // The scheduling and swapping passes below don't run at this level.
+    if (!OrderingPass(cluster, &optimized_item) && nodes_to_relax.empty()) {
+      return errors::Aborted("Nothing to do.");
+    }
+  }
+
   std::unordered_set<string> skip_list;
   // Bound the number of rewrite passes to avoid long processing times on graphs
   // that simply won't fit in memory.
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/costs/graph_memory.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/grappler_test.h"
@@ -448,6 +449,110 @@ TEST_F(MemoryOptimizerTest, AccumulationRewrites) {
   }
 }
 
+TEST_F(MemoryOptimizerTest, OrderingHeuristics) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice("/cpu:0");
+  Output a = ops::RandomNormal(s.WithOpName("a"), {512, 512}, DT_FLOAT);
+  Output b1 = ops::Relu(s.WithOpName("b1"), a);
+  Output b2 = ops::Tanh(s.WithOpName("b2"), a);
+  Output axes = ops::Const(s.WithOpName("axes"), {0, 1}, {2});
+  Output c1 = ops::Sum(s.WithOpName("c1"), b1, axes);
+  Output c2 = ops::Sum(s.WithOpName("c2"), b2, axes);
+  Output d = ops::AddV2(s.WithOpName("d"), c1, c2);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"d"};
+
+  // In the default breadth-first order both 'b1' and 'b2' are live together
+  // with 'a'. Reducing 'b1' before computing 'b2' saves one large tensor.
+  MemoryOptimizer optimizer(RewriterConfig::ORDERING_HEURISTICS);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* b2_node = node_map.GetNode("b2");
+  ASSERT_NE(b2_node, nullptr);
+  ASSERT_EQ(b2_node->input_size(), 2);
+  EXPECT_EQ(b2_node->input(0), "a");
+  EXPECT_EQ(b2_node->input(1), "^c1");
+
+  const NodeDef* b1_node = node_map.GetNode("b1");
+  ASSERT_NE(b1_node, nullptr);
+  EXPECT_EQ(b1_node->input_size(), 1);
+
+  auto tensors = EvaluateNodes(output, item.fetch);
+  EXPECT_EQ(1, tensors.size());
+}
+
+TEST_F(MemoryOptimizerTest, OrderingHeuristicsKeepsOptimalOrder) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice("/cpu:0");
+  Output a = ops::RandomNormal(s.WithOpName("a"), {512, 512}, DT_FLOAT);
+  Output b = ops::Relu(s.WithOpName("b"), a);
+  Output c = ops::Tanh(s.WithOpName("c"), b);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"c"};
+
+  MemoryOptimizer optimizer(RewriterConfig::ORDERING_HEURISTICS);
+  GraphDef output;
+  absl::Status status = optimizer.Optimize(nullptr, item, &output);
+  EXPECT_TRUE(absl::IsAborted(status)) << status;
+}
+
+TEST_F(MemoryOptimizerTest, OrderingHeuristicsWithSimulation) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice("/cpu:0");
+  Output a = ops::RandomNormal(s.WithOpName("a"), {512, 512}, DT_FLOAT);
+  Output b1 = ops::Relu(s.WithOpName("b1"), a);
+  Output b2 = ops::Tanh(s.WithOpName("b2"), a);
+  Output b3 = ops::Sigmoid(s.WithOpName("b3"), a);
+  Output axes = ops::Const(s.WithOpName("axes"), {0, 1}, {2});
+  Output c1 = ops::Sum(s.WithOpName("c1"), b1, axes);
+  Output c2 = ops::Sum(s.WithOpName("c2"), b2, axes);
+  Output c3 = ops::Sum(s.WithOpName("c3"), b3, axes);
+  Output d = ops::AddN(s.WithOpName("d"), {c1, c2, c3});
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"d"};
+
+  // The VirtualScheduler runs the node that became ready first, so it computes
+  // 'b1', 'b2' and 'b3' back to back, and they are all live together with
+  // 'a'. Reducing every branch before computing the next one frees the
+  // previous branch as the next one is allocated. With only two branches the
+  // trace shows no gain, since a tensor is freed just after its last consumer
+  // ends and the next op starts at that same time.
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+  MemoryOptimizer optimizer(RewriterConfig::ORDERING_HEURISTICS);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* b2_node = node_map.GetNode("b2");
+  ASSERT_NE(b2_node, nullptr);
+  ASSERT_EQ(b2_node->input_size(), 2);
+  EXPECT_EQ(b2_node->input(0), "a");
+  EXPECT_EQ(b2_node->input(1), "^c1");
+  const NodeDef* b3_node = node_map.GetNode("b3");
+  ASSERT_NE(b3_node, nullptr);
+  ASSERT_EQ(b3_node->input_size(), 2);
+  EXPECT_EQ(b3_node->input(0), "a");
+  EXPECT_EQ(b3_node->input(1), "^c2");
+
+  GrapplerItem optimized_item = item.WithGraph(std::move(output));
+  GraphMemory before(item);
+  TF_ASSERT_OK(before.InferStatically(cluster->GetDevices()));
+  GraphMemory after(optimized_item);
+  TF_ASSERT_OK(after.InferStatically(cluster->GetDevices()));
+  // One less large tensor is live at the peak, besides a few scalars.
+  const int64_t tensor_size = 512 * 512 * sizeof(float);
+  EXPECT_LT(after.GetWorstCaseMemoryUsage(),
+            before.GetWorstCaseMemoryUsage() - tensor_size / 2);
+
+  auto tensors = EvaluateNodes(optimized_item.graph, item.fetch);
+  EXPECT_EQ(1, tensors.size());
+}
+
 class RelaxAllocatorConstraintsTest : public GrapplerTest {};
 
 TEST_F(RelaxAllocatorConstraintsTest, SameDevice) {
@@ -0,0 +1,180 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/tensor_bundle/naming.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace {
+
+class AsyncSaveV2OpTest : public OpsTestBase {
+ protected:
+  void MakeSaveOp(int max_parallel_shards) {
+    inputs_.clear();
+    TF_ASSERT_OK(NodeDefBuilder("save", "AsyncSaveV2")
+                     .Input(FakeInput())  // prefix
+                     .Input(FakeInput())  // tensor_names
+                     .Input(FakeInput())  // shape_and_slices
+                     .Input(FakeInput({DT_FLOAT, DT_INT64, DT_FLOAT}))
+                     .Attr("max_parallel_shards", max_parallel_shards)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  void MakeWaitOp(bool blocking) {
+    inputs_.clear();
+    TF_ASSERT_OK(NodeDefBuilder("wait", "WaitForAsyncSaveV2")
+                     .Input(FakeInput())  // prefix
+                     .Attr("blocking", blocking)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  void RunSave(const string& prefix, int max_parallel_shards) {
+    MakeSaveOp(max_parallel_shards);
+    AddInputFromArray<tstring>(TensorShape({}), {prefix});
+    AddInputFromArray<tstring>(TensorShape({3}),
+                               {"weights", "step", "partitioned"});
+    AddInputFromArray<tstring>(TensorShape({3}), {"", "", "4 0,2"});
+    AddInput<float>(TensorShape({100, 10}),
+                    [](int x) -> float { return x / 10.f; });
+    AddInputFromArray<int64_t>(TensorShape({}), {42});
+    AddInputFromArray<float>(TensorShape({2}), {1.f, 2.f});
+    TF_ASSERT_OK(RunOpKernel());
+  }
+
+  void ExpectSaved(const string& prefix) {
+    BundleReader reader(Env::Default(), prefix);
+    TF_ASSERT_OK(reader.status());
+    Tensor weights;
+    TF_ASSERT_OK(reader.Lookup("weights", &weights));
+    ASSERT_EQ(TensorShape({100, 10}), weights.shape());
+    for (int i = 0; i < weights.NumElements(); ++i) {
+      EXPECT_EQ(i / 10.f, weights.flat<float>()(i));
+    }
+    Tensor step;
+    TF_ASSERT_OK(reader.Lookup("step", &step));
+    test::ExpectTensorEqual<int64_t>(step,
+                                     test::AsScalar<int64_t>(int64_t{42}));
+    Tensor partitioned(DT_FLOAT, TensorShape({2}));
+    TensorSlice slice(1);
+    TF_ASSERT_OK(TensorSlice::Parse("0,2", &slice));
+    TF_ASSERT_OK(reader.LookupSlice("partitioned", slice, &partitioned));
+    test::ExpectTensorEqual<float>(partitioned,
+                                   test::AsTensor<float>({1.f, 2.f}));
+  }
+};
+
+TEST_F(AsyncSaveV2OpTest, SingleShard) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "async_single/ckpt");
+  RunSave(prefix, 1);
+
+  MakeWaitOp(/*blocking=*/true);
+  AddInputFromArray<tstring>(TensorShape({}), {prefix});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_TRUE(GetOutput(0)->scalar<bool>()());
+
+  ExpectSaved(prefix);
+  TF_EXPECT_OK(Env::Default()->FileExists(DataFilename(prefix, 0, 1)));
+}
+
+TEST_F(AsyncSaveV2OpTest, ParallelShards) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "async_sharded/ckpt");
+  RunSave(prefix, 2);
+
+  MakeWaitOp(/*blocking=*/true);
+  AddInputFromArray<tstring>(TensorShape({}), {prefix});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_TRUE(GetOutput(0)->scalar<bool>()());
+
+  ExpectSaved(prefix);
+  TF_EXPECT_OK(Env::Default()->FileExists(DataFilename(prefix, 0, 2)));
+  TF_EXPECT_OK(Env::Default()->FileExists(DataFilename(prefix, 1, 2)));
+}
+
+TEST_F(AsyncSaveV2OpTest, InPlaceUpdateWhileSaving) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "async_in_place/ckpt");
+  RunSave(prefix, 1);
+
+  // Overwrites the weights in place, the way Assign and the Apply* ops update
+  // a reference variable, while the checkpoint is written in the background.
+  Tensor* weights = inputs_[3].tensor;
+  ASSERT_EQ(TensorShape({100, 10}), weights->shape());
+  weights->flat<float>().setConstant(-1.f);
+
+  MakeWaitOp(/*blocking=*/true);
+  AddInputFromArray<tstring>(TensorShape({}), {prefix});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_TRUE(GetOutput(0)->scalar<bool>()());
+
+  ExpectSaved(prefix);
+}
+
+TEST_F(AsyncSaveV2OpTest, PollUntilDone) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "async_poll/ckpt");
+  RunSave(prefix, 0);
+
+  MakeWaitOp(/*blocking=*/false);
+  AddInputFromArray<tstring>(TensorShape({}), {prefix});
+  bool done = false;
+  while (!done) {
+    TF_ASSERT_OK(RunOpKernel());
+    done = GetOutput(0)->scalar<bool>()();
+    if (!done) Env::Default()->SleepForMicroseconds(1000);
+  }
+  ExpectSaved(prefix);
+
+  // Nothing is pending anymore.
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_TRUE(GetOutput(0)->scalar<bool>()());
+}
+
+TEST_F(AsyncSaveV2OpTest, InvalidSlice) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "async_invalid/ckpt");
+  MakeSaveOp(0);
+  AddInputFromArray<tstring>(TensorShape({}), {prefix});
+  AddInputFromArray<tstring>(TensorShape({3}), {"a", "b", "c"});
+  AddInputFromArray<tstring>(TensorShape({3}), {"", "", "4 0,3"});
+  AddInputFromArray<float>(TensorShape({1}), {1.f});
+  AddInputFromArray<int64_t>(TensorShape({}), {1});
+  AddInputFromArray<float>(TensorShape({2}), {1.f, 2.f});
+  Status status = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+
+  // The failed op did not start a save.
+  MakeWaitOp(/*blocking=*/false);
+  AddInputFromArray<tstring>(TensorShape({}), {prefix});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_TRUE(GetOutput(0)->scalar<bool>()());
+}
+
+}  // namespace
+}  // namespace tensorflow
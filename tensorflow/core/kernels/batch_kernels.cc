@@ -65,6 +65,13 @@ constexpr char kMaxInflightBatchesAttr[] = "_max_inflight_batches";
 constexpr char kBatchesToAverageOverAttr[] = "_batches_to_average_over";
 constexpr char kFullBatchSchedulingBoostMicros[] =
     "_full_batch_scheduling_boost_micros";
+constexpr char kTargetP99LatencyMicrosAttr[] = "_target_p99_latency_micros";
+constexpr char kShapeBucketingDimensionAttr[] = "_shape_bucketing_dimension";
+constexpr char kShapeBucketBoundariesAttr[] = "_shape_bucket_boundaries";
+constexpr char kShapeBucketPaddedOutputsAttr[] = "_shape_bucket_padded_outputs";
+constexpr char kShapeBucketPaddedOutputInputsAttr[] =
+    "_shape_bucket_padded_output_inputs";
+constexpr char kEnableZeroCopyBatchingAttr[] = "_enable_zero_copy_batching";
 
 // Default thread count in the per-process batching thread pool.
 constexpr int64_t kBatchThreadPoolSize = 128;
@@ -179,7 +186,8 @@ class BatchResource : public serving::BatchResourceBase {
                   serving::MixedPriorityBatchingPolicy::
                       kLowPriorityPaddingWithMaxBatchSize,
                   enable_large_batch_splitting,
-                  /*batch_padding_policy=*/"PAD_UP", resource);
+                  /*batch_padding_policy=*/"PAD_UP",
+                  /*target_p99_latency_micros=*/0, resource);
   }
 
   static absl::Status Create(
@@ -193,6 +201,7 @@ class BatchResource : public serving::BatchResourceBase {
       const std::vector<int32>& low_priority_allowed_batch_sizes,
       serving::MixedPriorityBatchingPolicy mixed_priority_batching_policy,
       bool enable_large_batch_splitting, absl::string_view batch_padding_policy,
+      int64_t target_p99_latency_micros,
       std::unique_ptr<BatchResource>* resource) {
     BatcherT::Options batcher_options;
     batcher_options.num_batch_threads = num_batch_threads;
@@ -208,7 +217,7 @@ class BatchResource : public serving::BatchResourceBase {
             /*disable_padding=*/false, batch_padding_policy,
             low_priority_max_batch_size, low_priority_batch_timeout_micros,
             low_priority_max_enqueued_batches, low_priority_allowed_batch_sizes,
-            mixed_priority_batching_policy),
+            mixed_priority_batching_policy, target_p99_latency_micros),
         allowed_batch_sizes));
     return absl::OkStatus();
   }
@@ -317,6 +326,46 @@ BatchFunctionKernel::BatchFunctionKernel(OpKernelConstruction* c)
     has_attribute_enable_large_batch_splitting_ = true;
   }
 
+  if (c->HasAttr(kTargetP99LatencyMicrosAttr)) {
+    OP_REQUIRES_OK(c, c->GetAttr(kTargetP99LatencyMicrosAttr,
+                                 &target_p99_latency_micros_));
+    OP_REQUIRES(c, target_p99_latency_micros_ >= 0,
+                errors::InvalidArgument(kTargetP99LatencyMicrosAttr,
+                                        " must be non-negative; was ",
+                                        target_p99_latency_micros_));
+  }
+
+  if (c->HasAttr(kShapeBucketBoundariesAttr)) {
+    serving::ShapeBucketingOptions options;
+    OP_REQUIRES_OK(c,
+                   c->GetAttr(kShapeBucketBoundariesAttr, &options.boundaries));
+    if (c->HasAttr(kShapeBucketingDimensionAttr)) {
+      OP_REQUIRES_OK(
+          c, c->GetAttr(kShapeBucketingDimensionAttr, &options.dimension));
+    }
+    if (c->HasAttr(kShapeBucketPaddedOutputsAttr)) {
+      OP_REQUIRES_OK(c, c->GetAttr(kShapeBucketPaddedOutputsAttr,
+                                   &options.padded_outputs));
+    }
+    if (c->HasAttr(kShapeBucketPaddedOutputInputsAttr)) {
+      OP_REQUIRES_OK(c, c->GetAttr(kShapeBucketPaddedOutputInputsAttr,
+                                   &options.padded_output_inputs));
+    }
+    OP_REQUIRES_OK(c, serving::ValidateShapeBucketingOptions(options));
+    for (int output : options.padded_outputs) {
+      OP_REQUIRES(c, output < c->num_outputs(),
+                  errors::InvalidArgument(kShapeBucketPaddedOutputsAttr,
+                                          " lists output ", output, " of ",
+                                          c->num_outputs(), " outputs"));
+    }
+    shape_bucketing_options_ = std::move(options);
+  }
+
+  if (c->HasAttr(kEnableZeroCopyBatchingAttr)) {
+    OP_REQUIRES_OK(c, c->GetAttr(kEnableZeroCopyBatchingAttr,
+                                 &enable_zero_copy_batching_));
+  }
+
   // Helper function `SetAdaptiveBatchSchedulerOptions` calls
   // `OP_REQUIRES_OK`, which exits the current function upon error.
   // So validate status of `op-kernel-construction`.
@@ -423,6 +472,10 @@ void BatchFunctionKernel::ComputeAsync(OpKernelContext* c, DoneCallback done) {
       if (session_metadata) {
         new_resource->set_session_metadata(*session_metadata);
       }
+      if (shape_bucketing_options_.has_value()) {
+        new_resource->set_shape_bucketing_options(*shape_bucketing_options_);
+      }
+      new_resource->set_zero_copy_batching(enable_zero_copy_batching_);
       *r = new_resource.release();
       return absl::OkStatus();
     };
@@ -441,10 +494,14 @@ void BatchFunctionKernel::ComputeAsync(OpKernelContext* c, DoneCallback done) {
           low_priority_batch_timeout_micros_,
           low_priority_max_enqueued_batches_, low_priority_allowed_batch_sizes_,
           mixed_priority_batching_policy, enable_large_batch_splitting_,
-          batch_padding_policy_, &new_resource));
+          batch_padding_policy_, target_p99_latency_micros_, &new_resource));
       if (session_metadata) {
         new_resource->set_session_metadata(*session_metadata);
       }
+      if (shape_bucketing_options_.has_value()) {
+        new_resource->set_shape_bucketing_options(*shape_bucketing_options_);
+      }
+      new_resource->set_zero_copy_batching(enable_zero_copy_batching_);
       *r = new_resource.release();
       return absl::OkStatus();
     };
@@ -17,12 +17,14 @@ limitations under the License.
 #define TENSORFLOW_CORE_KERNELS_BATCH_KERNELS_H_
 
 #include <cstdint>
+#include <optional>
 #include <string>
 
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/kernels/batching_util/shape_bucketing.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
 #include "tsl/platform/types.h"
@@ -117,6 +119,13 @@ class BatchFunctionKernel : public AsyncOpKernel {
   bool enable_large_batch_splitting_ = false;
   bool has_attribute_enable_large_batch_splitting_ = false;
   bool enable_adaptive_batch_threads_ = false;
+  // If positive, the batch timeout and batch size are tuned online towards
+  // this p99 latency (non-adaptive scheduler only).
+  int64_t target_p99_latency_micros_ = 0;
+  // If set, tasks are batched per shape bucket (see ShapeBucketingOptions).
+  std::optional<serving::ShapeBucketingOptions> shape_bucketing_options_;
+  // If true, batch outputs are returned to tasks as aliasing slices.
+  bool enable_zero_copy_batching_ = false;
 
   mutex mu_;
 
@@ -0,0 +1,272 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batch_latency_controller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// The latency budget shrinks by this factor at every adjustment while the
+// observed p99 latency exceeds the target...
+constexpr double kBudgetDecrease = 0.8;
+// ... and grows back by this factor while it is below this fraction of the
+// target.
+constexpr double kBudgetIncrease = 1.05;
+constexpr double kRecoveryThreshold = 0.8;
+// The smallest fraction of the target used as the latency budget.
+constexpr double kMinBudgetScale = 0.1;
+// The observed p99 latency is only used once this many batches were recorded.
+constexpr int kMinLatencySamples = 20;
+
+}  // namespace
+
+absl::Status BatchLatencyController::ValidateOptions(const Options& options) {
+  if (options.target_p99_latency_micros <= 0) {
+    return errors::InvalidArgument(
+        "target_p99_latency_micros must be positive; was ",
+        options.target_p99_latency_micros);
+  }
+  if (options.max_batch_timeout_micros < 0) {
+    return errors::InvalidArgument(
+        "max_batch_timeout_micros must be non-negative; was ",
+        options.max_batch_timeout_micros);
+  }
+  if (options.max_batch_size < 1) {
+    return errors::InvalidArgument("max_batch_size must be positive; was ",
+                                   options.max_batch_size);
+  }
+  for (int i = 0; i < options.allowed_batch_sizes.size(); ++i) {
+    if (options.allowed_batch_sizes[i] <= 0 ||
+        (i > 0 && options.allowed_batch_sizes[i] <=
+                      options.allowed_batch_sizes[i - 1])) {
+      return errors::InvalidArgument(
+          "allowed_batch_sizes must be positive and increasing");
+    }
+  }
+  if (options.num_batch_threads < 1) {
+    return errors::InvalidArgument("num_batch_threads must be positive; was ",
+                                   options.num_batch_threads);
+  }
+  if (options.adjustment_interval_micros <= 0) {
+    return errors::InvalidArgument(
+        "adjustment_interval_micros must be positive; was ",
+        options.adjustment_interval_micros);
+  }
+  if (!(options.smoothing > 0 && options.smoothing <= 1)) {
+    return errors::InvalidArgument("smoothing must be in (0, 1]; was ",
+                                   options.smoothing);
+  }
+  if (options.latency_window_size < 1) {
+    return errors::InvalidArgument("latency_window_size must be positive; was ",
+                                   options.latency_window_size);
+  }
+  return absl::OkStatus();
+}
+
+BatchLatencyController::BatchLatencyController(const Options& options)
+    : options_(options),
+      batch_timeout_micros_(options.max_batch_timeout_micros),
+      max_batch_size_(options.max_batch_size) {
+  TF_DCHECK_OK(ValidateOptions(options_));
+  for (int32 size : options_.allowed_batch_sizes) {
+    if (size <= options_.max_batch_size) candidate_batch_sizes_.push_back(size);
+  }
+  if (options_.allowed_batch_sizes.empty()) {
+    for (int64_t size = 1; size < options_.max_batch_size; size *= 2) {
+      candidate_batch_sizes_.push_back(size);
+    }
+  }
+  if (candidate_batch_sizes_.empty() ||
+      candidate_batch_sizes_.back() < options_.max_batch_size) {
+    candidate_batch_sizes_.push_back(options_.max_batch_size);
+  }
+  latencies_micros_.reserve(options_.latency_window_size);
+}
+
+void BatchLatencyController::RecordArrival(uint64 now_micros,
+                                           int64_t task_size) {
+  mutex_lock l(mu_);
+  arrived_size_ += task_size;
+  MaybeAdjust(now_micros);
+}
+
+void BatchLatencyController::RecordBatch(int64_t batch_size,
+                                         uint64 earliest_task_start_micros,
+                                         uint64 start_micros,
+                                         uint64 end_micros) {
+  if (batch_size <= 0 || end_micros < start_micros) return;
+  mutex_lock l(mu_);
+  const double processing_micros = end_micros - start_micros;
+  auto [it, inserted] = processing_micros_.emplace(PaddedBatchSize(batch_size),
+                                                   processing_micros);
+  if (!inserted) {
+    it->second = options_.smoothing * processing_micros +
+                 (1 - options_.smoothing) * it->second;
+  }
+
+  if (end_micros >= earliest_task_start_micros) {
+    const int64_t latency_micros = end_micros - earliest_task_start_micros;
+    if (latencies_micros_.size() < options_.latency_window_size) {
+      latencies_micros_.push_back(latency_micros);
+    } else {
+      latencies_micros_[next_latency_] = latency_micros;
+    }
+    next_latency_ = (next_latency_ + 1) % options_.latency_window_size;
+  }
+  MaybeAdjust(end_micros);
+}
+
+std::optional<int64_t> BatchLatencyController::ObservedP99LatencyMicros()
+    const {
+  mutex_lock l(mu_);
+  return ObservedP99LatencyMicrosLocked();
+}
+
+std::optional<int64_t> BatchLatencyController::ObservedP99LatencyMicrosLocked()
+    const {
+  if (latencies_micros_.size() < kMinLatencySamples) return std::nullopt;
+  std::vector<int64_t> latencies = latencies_micros_;
+  const size_t index = std::ceil(0.99 * latencies.size()) - 1;
+  std::nth_element(latencies.begin(), latencies.begin() + index,
+                   latencies.end());
+  return latencies[index];
+}
+
+int64_t BatchLatencyController::PaddedBatchSize(int64_t batch_size) const {
+  auto it = absl::c_lower_bound(options_.allowed_batch_sizes, batch_size);
+  return it == options_.allowed_batch_sizes.end() ? batch_size : *it;
+}
+
+std::optional<double> BatchLatencyController::EstimateProcessingMicros(
+    int64_t batch_size) const {
+  auto upper = processing_micros_.lower_bound(batch_size);
+  if (upper != processing_micros_.end() && upper->first == batch_size) {
+    return upper->second;
+  }
+
+  if (options_.model_batch_stats != nullptr) {
+    // Only looks up sizes that have statistics, so as not to create empty
+    // entries in `model_batch_stats`.
+    if (absl::c_linear_search(options_.model_batch_stats->BatchSizes(),
+                              batch_size)) {
+      std::optional<absl::Duration> cost =
+          options_.model_batch_stats->batch_size(batch_size).tpu_cost().mean();
+      if (cost.has_value()) return absl::ToDoubleMicroseconds(*cost);
+    }
+  }
+
+  if (processing_micros_.empty()) return std::nullopt;
+  // Smaller batches are assumed to be no cheaper than the smallest observed
+  // one, and larger batches to cost proportionally more than the largest.
+  if (upper == processing_micros_.begin()) return upper->second;
+  auto lower = std::prev(upper);
+  if (upper == processing_micros_.end()) {
+    return lower->second * batch_size / lower->first;
+  }
+  const double position =
+      static_cast<double>(batch_size - lower->first) /
+      (upper->first - lower->first);
+  return lower->second + position * (upper->second - lower->second);
+}
+
+void BatchLatencyController::MaybeAdjust(uint64 now_micros) {
+  if (!last_adjustment_micros_.has_value()) {
+    last_adjustment_micros_ = now_micros;
+    return;
+  }
+  if (now_micros < *last_adjustment_micros_ +
+                       options_.adjustment_interval_micros) {
+    return;
+  }
+
+  const double rate_sample = static_cast<double>(arrived_size_) /
+                             (now_micros - *last_adjustment_micros_);
+  arrival_rate_ = arrival_rate_ < 0
+                      ? rate_sample
+                      : options_.smoothing * rate_sample +
+                            (1 - options_.smoothing) * arrival_rate_;
+  arrived_size_ = 0;
+  last_adjustment_micros_ = now_micros;
+
+  const double target = options_.target_p99_latency_micros;
+  const std::optional<int64_t> observed_p99 = ObservedP99LatencyMicrosLocked();
+  if (observed_p99.has_value()) {
+    if (*observed_p99 > target) {
+      budget_scale_ =
+          std::max(kMinBudgetScale, budget_scale_ * kBudgetDecrease);
+    } else if (*observed_p99 < kRecoveryThreshold * target) {
+      budget_scale_ = std::min(1.0, budget_scale_ * kBudgetIncrease);
+    }
+  }
+  const double budget = budget_scale_ * target;
+
+  // Picks the largest batch size that fills up and gets processed within the
+  // budget. If there is none, picks the smallest batch size that keeps up with
+  // the arrival rate, and if there is none of those either, the largest one.
+  std::optional<int64_t> largest_within_budget;
+  std::optional<int64_t> smallest_sustainable;
+  for (int64_t batch_size : candidate_batch_sizes_) {
+    std::optional<double> processing_micros =
+        EstimateProcessingMicros(batch_size);
+    // Keeps the static settings until processing times are known.
+    if (!processing_micros.has_value()) return;
+    const bool sustainable = arrival_rate_ * *processing_micros <
+                             batch_size * options_.num_batch_threads;
+    if (!sustainable) continue;
+    if (!smallest_sustainable.has_value()) smallest_sustainable = batch_size;
+    const double fill_micros = arrival_rate_ > 0
+                                   ? batch_size / arrival_rate_
+                                   : std::numeric_limits<double>::infinity();
+    if (*processing_micros + fill_micros <= budget) {
+      largest_within_budget = batch_size;
+    }
+  }
+  const int64_t batch_size = largest_within_budget.value_or(
+      smallest_sustainable.value_or(candidate_batch_sizes_.back()));
+  const double timeout_micros =
+      budget - EstimateProcessingMicros(batch_size).value();
+  const int64_t batch_timeout_micros =
+      std::clamp<int64_t>(static_cast<int64_t>(timeout_micros), 0,
+                          options_.max_batch_timeout_micros);
+
+  VLOG(2) << "Batch latency controller: arrival rate " << arrival_rate_
+          << "/us, observed p99 "
+          << (observed_p99.has_value() ? *observed_p99 : -1)
+          << "us, budget " << budget << "us -> batch size " << batch_size
+          << ", batch timeout " << batch_timeout_micros << "us";
+  max_batch_size_.store(batch_size, std::memory_order_relaxed);
+  batch_timeout_micros_.store(batch_timeout_micros, std::memory_order_relaxed);
+  if (options_.model_batch_stats != nullptr) {
+    options_.model_batch_stats->SetBatchTimeoutMicros(batch_timeout_micros);
+  }
+}
+
+}  // namespace serving
+}  // namespace tensorflow
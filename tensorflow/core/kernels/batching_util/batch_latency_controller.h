@@ -0,0 +1,170 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_LATENCY_CONTROLLER_H_
+#define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_LATENCY_CONTROLLER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "tensorflow/core/kernels/batching_util/batch_stats.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+#include "tsl/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Tunes the batch timeout and the effective maximum batch size of one batching
+// queue online, so that the 99th percentile latency of its tasks stays close to
+// a target while batches stay as large as possible.
+//
+// The controller models the latency of a batch as the time it takes to fill
+// (given the observed arrival rate), capped by the batch timeout, plus the time
+// to process a batch of that size. Processing times are tracked per (padded)
+// batch size; sizes that have not been observed yet are estimated from the
+// neighboring sizes, or from the costs in a ModelBatchStats instance. Every
+// `adjustment_interval_micros` the controller picks the largest batch size
+// whose modeled latency fits the latency budget, and sets the timeout to the
+// part of the budget left after processing. The budget itself starts at the
+// target and is scaled down while the observed p99 latency exceeds the target
+// (and back up once it has recovered), which corrects for queueing delays the
+// model does not capture.
+//
+// The controller never exceeds the static options it is given:
+// `max_batch_timeout_micros` and `max_batch_size` are upper bounds, and also
+// the settings used until enough statistics have been collected.
+//
+// Thread-safe.
+class BatchLatencyController {
+ public:
+  struct Options {
+    // The 99th percentile latency to aim for, from the time a task is enqueued
+    // until its batch has been processed. Must be positive.
+    int64_t target_p99_latency_micros = 0;
+
+    // Upper bounds, and initial values, of the controlled parameters.
+    int64_t max_batch_timeout_micros = 0;
+    int64_t max_batch_size = 1;
+
+    // If non-empty, the batch sizes the controller picks from, in increasing
+    // order. Batches are assumed to be padded up to the next allowed size.
+    std::vector<int32> allowed_batch_sizes;
+
+    // The number of batches of this queue that can be processed concurrently.
+    int num_batch_threads = 1;
+
+    // How often the controller recomputes its settings.
+    int64_t adjustment_interval_micros = 1000 * 1000;
+
+    // Weight of the newest sample in the exponentially-decaying averages of
+    // the arrival rate and of the processing times. In (0, 1].
+    double smoothing = 0.25;
+
+    // Number of recent batch latencies the observed p99 is computed from.
+    int latency_window_size = 1000;
+
+    // If set, used to estimate the processing time of batch sizes that this
+    // controller has not observed yet. Not owned.
+    ModelBatchStats* model_batch_stats = nullptr;
+  };
+
+  static absl::Status ValidateOptions(const Options& options);
+
+  // REQUIRES: ValidateOptions(options).ok()
+  explicit BatchLatencyController(const Options& options);
+
+  // Records that a task of `task_size` was enqueued at `now_micros`.
+  void RecordArrival(uint64 now_micros, int64_t task_size);
+
+  // Records that a batch of `batch_size` (before padding), whose oldest task
+  // was enqueued at `earliest_task_start_micros`, was processed from
+  // `start_micros` to `end_micros`.
+  void RecordBatch(int64_t batch_size, uint64 earliest_task_start_micros,
+                   uint64 start_micros, uint64 end_micros);
+
+  // The current batch timeout. At most `max_batch_timeout_micros`.
+  int64_t batch_timeout_micros() const {
+    return batch_timeout_micros_.load(std::memory_order_relaxed);
+  }
+
+  // The current batch size at which a batch is released without waiting for
+  // the timeout. At most `max_batch_size`.
+  int64_t max_batch_size() const {
+    return max_batch_size_.load(std::memory_order_relaxed);
+  }
+
+  // The 99th percentile of the recently recorded batch latencies, or
+  // std::nullopt if too few batches have been recorded.
+  std::optional<int64_t> ObservedP99LatencyMicros() const;
+
+ private:
+  // Recomputes the settings if `adjustment_interval_micros` has passed since
+  // the last adjustment.
+  void MaybeAdjust(uint64 now_micros) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns the estimated time to process a batch of `batch_size`, or
+  // std::nullopt if nothing is known about processing times yet.
+  std::optional<double> EstimateProcessingMicros(int64_t batch_size) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  std::optional<int64_t> ObservedP99LatencyMicrosLocked() const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Rounds `batch_size` up to the next allowed batch size.
+  int64_t PaddedBatchSize(int64_t batch_size) const;
+
+  const Options options_;
+
+  // The batch sizes considered by the controller, in increasing order.
+  std::vector<int64_t> candidate_batch_sizes_;
+
+  mutable mutex mu_;
+
+  // Time of the last adjustment, or of the first recorded event.
+  std::optional<uint64> last_adjustment_micros_ TF_GUARDED_BY(mu_);
+
+  // Total size of the tasks enqueued since the last adjustment.
+  int64_t arrived_size_ TF_GUARDED_BY(mu_) = 0;
+
+  // Averaged arrival rate, in task size units per microsecond. Negative until
+  // the first adjustment.
+  double arrival_rate_ TF_GUARDED_BY(mu_) = -1;
+
+  // Averaged processing time, keyed by padded batch size.
+  std::map<int64_t, double> processing_micros_ TF_GUARDED_BY(mu_);
+
+  // Ring buffer of the most recent batch latencies.
+  std::vector<int64_t> latencies_micros_ TF_GUARDED_BY(mu_);
+  int next_latency_ TF_GUARDED_BY(mu_) = 0;
+
+  // Fraction of the target latency used as the latency budget.
+  double budget_scale_ TF_GUARDED_BY(mu_) = 1.0;
+
+  std::atomic<int64_t> batch_timeout_micros_;
+  std::atomic<int64_t> max_batch_size_;
+
+  BatchLatencyController(const BatchLatencyController&) = delete;
+  void operator=(const BatchLatencyController&) = delete;
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_LATENCY_CONTROLLER_H_
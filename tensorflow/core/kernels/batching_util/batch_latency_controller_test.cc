@@ -0,0 +1,164 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batch_latency_controller.h"
+
+#include <optional>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "tensorflow/core/kernels/batching_util/batch_stats.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow::serving {
+namespace {
+
+BatchLatencyController::Options TestOptions() {
+  BatchLatencyController::Options options;
+  options.target_p99_latency_micros = 10000;
+  options.max_batch_timeout_micros = 20000;
+  options.max_batch_size = 64;
+  options.adjustment_interval_micros = 1000;
+  options.smoothing = 1;
+  return options;
+}
+
+// Teaches `controller` that batches of size 1 take 100us to process and
+// batches of size 64 take 1000us. The last adjustment happens at t=1100us.
+void RecordProcessingTimes(BatchLatencyController& controller) {
+  controller.RecordBatch(/*batch_size=*/1, /*earliest_task_start_micros=*/0,
+                         /*start_micros=*/0, /*end_micros=*/100);
+  controller.RecordBatch(/*batch_size=*/64, /*earliest_task_start_micros=*/100,
+                         /*start_micros=*/100, /*end_micros=*/1100);
+}
+
+TEST(BatchLatencyControllerTest, ValidateOptions) {
+  TF_EXPECT_OK(BatchLatencyController::ValidateOptions(TestOptions()));
+
+  BatchLatencyController::Options options = TestOptions();
+  options.target_p99_latency_micros = 0;
+  EXPECT_EQ(BatchLatencyController::ValidateOptions(options).code(),
+            absl::StatusCode::kInvalidArgument);
+
+  options = TestOptions();
+  options.allowed_batch_sizes = {8, 4};
+  EXPECT_EQ(BatchLatencyController::ValidateOptions(options).code(),
+            absl::StatusCode::kInvalidArgument);
+
+  options = TestOptions();
+  options.smoothing = 0;
+  EXPECT_EQ(BatchLatencyController::ValidateOptions(options).code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST(BatchLatencyControllerTest, StartsWithStaticSettings) {
+  BatchLatencyController controller(TestOptions());
+  EXPECT_EQ(controller.batch_timeout_micros(), 20000);
+  EXPECT_EQ(controller.max_batch_size(), 64);
+  EXPECT_EQ(controller.ObservedP99LatencyMicros(), std::nullopt);
+}
+
+TEST(BatchLatencyControllerTest, KeepsStaticSettingsWithoutProcessingTimes) {
+  BatchLatencyController controller(TestOptions());
+  controller.RecordArrival(/*now_micros=*/0, /*task_size=*/10);
+  controller.RecordArrival(/*now_micros=*/5000, /*task_size=*/10);
+  EXPECT_EQ(controller.batch_timeout_micros(), 20000);
+  EXPECT_EQ(controller.max_batch_size(), 64);
+}
+
+TEST(BatchLatencyControllerTest, HighArrivalRateUsesLargeBatches) {
+  BatchLatencyController controller(TestOptions());
+  RecordProcessingTimes(controller);
+
+  // One task every 20us: only batches of 16 or more keep up, and a batch of
+  // 64 fills up and gets processed within the target.
+  controller.RecordArrival(/*now_micros=*/1200, /*task_size=*/100);
+  controller.RecordArrival(/*now_micros=*/3100, /*task_size=*/0);
+  EXPECT_EQ(controller.max_batch_size(), 64);
+  EXPECT_EQ(controller.batch_timeout_micros(), 9000);
+}
+
+TEST(BatchLatencyControllerTest, LowArrivalRateUsesSmallBatches) {
+  BatchLatencyController controller(TestOptions());
+  RecordProcessingTimes(controller);
+
+  // One task every 1000us: a batch of 8 takes 8000us to fill and 200us to
+  // process, a batch of 16 would exceed the target.
+  controller.RecordArrival(/*now_micros=*/1200, /*task_size=*/2);
+  controller.RecordArrival(/*now_micros=*/3100, /*task_size=*/0);
+  EXPECT_EQ(controller.max_batch_size(), 8);
+  EXPECT_NEAR(controller.batch_timeout_micros(), 9800, 1);
+}
+
+TEST(BatchLatencyControllerTest, NeverExceedsStaticSettings) {
+  BatchLatencyController::Options options = TestOptions();
+  options.max_batch_timeout_micros = 500;
+  BatchLatencyController controller(options);
+  RecordProcessingTimes(controller);
+
+  controller.RecordArrival(/*now_micros=*/1200, /*task_size=*/2);
+  controller.RecordArrival(/*now_micros=*/3100, /*task_size=*/0);
+  EXPECT_EQ(controller.batch_timeout_micros(), 500);
+}
+
+TEST(BatchLatencyControllerTest, ShrinksBudgetWhenP99ExceedsTarget) {
+  BatchLatencyController controller(TestOptions());
+  RecordProcessingTimes(controller);
+
+  // Twenty batches of size 1 whose oldest task waited 20000us.
+  for (int i = 0; i < 20; ++i) {
+    const uint64 end_micros = 30000 + i;
+    controller.RecordBatch(/*batch_size=*/1,
+                           /*earliest_task_start_micros=*/end_micros - 20000,
+                           /*start_micros=*/end_micros - 100, end_micros);
+  }
+  EXPECT_EQ(controller.ObservedP99LatencyMicros(), 20000);
+  // Without arrivals, the smallest batch size is picked, and the timeout is
+  // the remaining budget after processing.
+  EXPECT_EQ(controller.max_batch_size(), 1);
+  EXPECT_EQ(controller.batch_timeout_micros(), 9900);
+
+  controller.RecordArrival(/*now_micros=*/31100, /*task_size=*/0);
+  EXPECT_EQ(controller.max_batch_size(), 1);
+  EXPECT_EQ(controller.batch_timeout_micros(), 7900);
+}
+
+TEST(BatchLatencyControllerTest, EstimatesProcessingTimesFromModelStats) {
+  ModelBatchStats model_batch_stats;
+  model_batch_stats.batch_size(1).tpu_cost().Register(absl::Microseconds(100));
+  model_batch_stats.batch_size(64).tpu_cost().Register(
+      absl::Microseconds(1000));
+
+  BatchLatencyController::Options options = TestOptions();
+  options.allowed_batch_sizes = {1, 64};
+  options.model_batch_stats = &model_batch_stats;
+  BatchLatencyController controller(options);
+
+  // One processed batch of size 1 is enough to start adjusting; the cost of
+  // a batch of 64 comes from `model_batch_stats`.
+  controller.RecordBatch(/*batch_size=*/1, /*earliest_task_start_micros=*/0,
+                         /*start_micros=*/0, /*end_micros=*/100);
+  controller.RecordArrival(/*now_micros=*/200, /*task_size=*/100);
+  controller.RecordArrival(/*now_micros=*/2100, /*task_size=*/0);
+  EXPECT_EQ(controller.max_batch_size(), 64);
+  EXPECT_EQ(controller.batch_timeout_micros(), 9000);
+  EXPECT_EQ(model_batch_stats.batch_timeout_micros(), 9000);
+}
+
+}  // namespace
+}  // namespace tensorflow::serving
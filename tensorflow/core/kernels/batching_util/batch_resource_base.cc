@@ -27,6 +27,7 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/fixed_array.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/functional/bind_front.h"
@@ -56,6 +57,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/batching_util/batch_stats.h"
 #include "tensorflow/core/kernels/batching_util/concat_split_util.h"
 #include "tensorflow/core/kernels/batching_util/input_split_metadata.h"
+#include "tensorflow/core/kernels/batching_util/shape_bucketing.h"
 #include "tensorflow/core/kernels/batching_util/threadsafe_status.h"
 #include "tensorflow/core/kernels/batching_util/warmup.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
@@ -298,6 +300,26 @@ int GetTotalTaskSize(
   return tasks_size;
 }
 
+// Splits `tensor` along the 0th dimension into slices of `sizes` that share its
+// buffer. Returns false, leaving `slices` empty, if any slice is not aligned
+// (downstream kernels require aligned tensors).
+bool SplitIntoAlignedSlices(const Tensor& tensor,
+                            absl::Span<const int64_t> sizes,
+                            std::vector<Tensor>* slices) {
+  slices->reserve(sizes.size());
+  int64_t position = 0;
+  for (const int64_t size : sizes) {
+    Tensor slice = tensor.Slice(position, position + size);
+    if (!slice.IsAligned()) {
+      slices->clear();
+      return false;
+    }
+    slices->push_back(std::move(slice));
+    position += size;
+  }
+  return true;
+}
+
 }  // namespace
 
 std::unique_ptr<BatchResourceBase::BatchTask>
@@ -318,6 +340,7 @@ BatchResourceBase::BatchTask::CreateSplitTask(
   task->start_time = this->start_time;
   task->request_cost = this->request_cost;
   task->forced_warmup_batch_size = this->forced_warmup_batch_size;
+  task->unpadded_bucket_sizes = this->unpadded_bucket_sizes;
 
   return task;
 }
@@ -484,9 +507,25 @@ absl::Status BatchResourceBase::RegisterInput(
     batch_components->request_cost = request_cost_accessor->GetRequestCost();
   }
 
+  string queue_name = batcher_queue_name;
+  const std::optional<string> bucket_key =
+      shape_bucketing_options_.has_value()
+          ? ShapeBucketKey(batch_components->inputs, *shape_bucketing_options_)
+          : std::nullopt;
+  if (bucket_key.has_value()) {
+    const ShapeBucketingOptions& options = *shape_bucketing_options_;
+    queue_name = absl::StrCat(batcher_queue_name, "/bucket:", *bucket_key);
+    for (Tensor& input : batch_components->inputs) {
+      batch_components->unpadded_bucket_sizes.push_back(
+          input.dims() > options.dimension ? input.dim_size(options.dimension)
+                                           : -1);
+      TF_RETURN_IF_ERROR(PadToBucket(input, options, &input));
+    }
+  }
+
   BatcherQueueT* batcher_queue;
   TF_RETURN_IF_ERROR(LookupOrCreateBatcherQueue(
-      /* queue_name= */ batcher_queue_name,
+      /* queue_name= */ queue_name,
       /* model_name= */ GetModelName(context),
       /* op_name= */ context->op_kernel().name(), /* queue= */ &batcher_queue));
 
@@ -535,11 +574,13 @@ BatchResourceBase::GetBatcherQueueOptions(
     int32_t low_priority_batch_timeout_micros,
     int32_t low_priority_max_enqueued_batches,
     const std::vector<int32>& low_priority_allowed_batch_sizes,
-    MixedPriorityBatchingPolicy mixed_priority_batching_policy) {
+    MixedPriorityBatchingPolicy mixed_priority_batching_policy,
+    int64_t target_p99_latency_micros) {
   BatcherT::QueueOptions batcher_queue_options;
   batcher_queue_options.input_batch_size_limit = max_batch_size;
   batcher_queue_options.max_enqueued_batches = max_enqueued_batches;
   batcher_queue_options.batch_timeout_micros = batch_timeout_micros;
+  batcher_queue_options.target_p99_latency_micros = target_p99_latency_micros;
   batcher_queue_options.batch_padding_policy =
       std::string(batch_padding_policy);
   if (low_priority_max_batch_size > 0) {
@@ -712,6 +753,19 @@ absl::Status BatchResourceBase::ConcatInputTensors(
   const int num_inputs = batch.task(0).inputs.size();
   concatenated_tensors->reserve(num_inputs);
 
+  // With zero-copy batching, a batch that consists of a single task and needs
+  // no padding (e.g. one full split of a large input) uses the task's inputs
+  // as they are.
+  if (zero_copy_batching_ && !just_for_warmup && padding_amount == 0 &&
+      batch.num_tasks() == 1 && unbatched_tasks.empty() &&
+      absl::c_all_of(batch.task(0).inputs,
+                     [](const Tensor& input) { return input.IsAligned(); })) {
+    for (const Tensor& input : batch.task(0).inputs) {
+      concatenated_tensors->push_back(input);
+    }
+    return absl::OkStatus();
+  }
+
   // Process each input one at a time (the typical case has just one). When
   // `just_for_warmup` is true, the real data is not added. Otherwise, the real
   // data is added to the front of each `concatenated_tensor`.
@@ -914,13 +968,20 @@ absl::Status BatchResourceBase::SplitOutputTensors(
           "; padding size: ", padding_size);
     }
 
+    // With zero-copy batching, tasks get slices that alias the batched output
+    // (which stays alive until all of them are released) instead of copies.
     std::vector<Tensor> split_tensor;
-    const absl::Status split_status = tensor::Split(
-        output_tensor, task_sizes_plus_optional_padding, &split_tensor);
-    DCHECK(split_status.ok()) << split_status;
-    if (!split_status.ok()) {
-      return errors::Internal("Tensor split operation failed: ",
-                              split_status.message());
+    if (!zero_copy_batching_ ||
+        !SplitIntoAlignedSlices(output_tensor,
+                                task_sizes_plus_optional_padding,
+                                &split_tensor)) {
+      const absl::Status split_status = tensor::Split(
+          output_tensor, task_sizes_plus_optional_padding, &split_tensor);
+      DCHECK(split_status.ok()) << split_status;
+      if (!split_status.ok()) {
+        return errors::Internal("Tensor split operation failed: ",
+                                split_status.message());
+      }
     }
     DCHECK_EQ(split_tensor.size(), task_sizes_plus_optional_padding.size());
     if (split_tensor.size() != task_sizes_plus_optional_padding.size()) {
@@ -933,6 +994,7 @@ absl::Status BatchResourceBase::SplitOutputTensors(
     // Ignore a possible final split_tensors entry containing the padding.
     for (int j = 0; j < batch->num_tasks(); ++j) {
       BatchTask& task = *(batch->mutable_task(j));
+      TF_RETURN_IF_ERROR(UnpadTaskOutput(task, i, &split_tensor[j]));
       if (task.is_partial) {
         std::vector<Tensor>& tensor_vector = (*task.output)[task.split_index];
         tensor_vector[i] = std::move(split_tensor[j]);
@@ -943,6 +1005,8 @@ absl::Status BatchResourceBase::SplitOutputTensors(
     for (int j = 0; j < unbatched_tasks.size(); ++j) {
       // The unbatched tasks are not split, so no need to handle the partial
       // case separately.
+      TF_RETURN_IF_ERROR(UnpadTaskOutput(
+          *unbatched_tasks[j], i, &split_tensor[batch->num_tasks() + j]));
       unbatched_tasks[j]->context->set_output(
           i, split_tensor[batch->num_tasks() + j]);
     }
@@ -951,6 +1015,38 @@ absl::Status BatchResourceBase::SplitOutputTensors(
   return absl::OkStatus();
 }
 
+absl::Status BatchResourceBase::UnpadTaskOutput(const BatchTask& task,
+                                                int output_index,
+                                                Tensor* output) const {
+  if (task.unpadded_bucket_sizes.empty()) return absl::OkStatus();
+  const ShapeBucketingOptions& options = *shape_bucketing_options_;
+  const auto it = absl::c_find(options.padded_outputs, output_index);
+  if (it == options.padded_outputs.end()) return absl::OkStatus();
+
+  int64_t size = -1;
+  if (options.padded_output_inputs.empty()) {
+    // ShapeBucketKey() only pads tasks with an input of the bucketed rank.
+    for (int64_t input_size : task.unpadded_bucket_sizes) {
+      if (input_size >= 0) {
+        size = input_size;
+        break;
+      }
+    }
+  } else {
+    const int input_index =
+        options.padded_output_inputs[it - options.padded_outputs.begin()];
+    if (input_index < static_cast<int>(task.unpadded_bucket_sizes.size())) {
+      size = task.unpadded_bucket_sizes[input_index];
+    }
+    if (size < 0) {
+      return errors::InvalidArgument(
+          "Padded output ", output_index, " takes its size from input ",
+          input_index, ", which has no dimension ", options.dimension);
+    }
+  }
+  return UnpadFromBucket(*output, options, size, output);
+}
+
 void BatchResourceBase::CleanUpFunctionHelper(
     BatchTask& task, const absl::Status& status) const {
   WithContext wc(task.propagated_context);
@@ -20,6 +20,7 @@ limitations under the License.
 #include <functional>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -36,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/batching_util/adaptive_shared_batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler_utils.h"
+#include "tensorflow/core/kernels/batching_util/shape_bucketing.h"
 #include "tensorflow/core/kernels/batching_util/shared_batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/threadsafe_status.h"
 #include "tensorflow/core/platform/context.h"
@@ -141,6 +143,12 @@ class BatchResourceBase : public ResourceBase {
     // batch is processed, but is not propagated to the kernel outputs.
     int forced_warmup_batch_size = 0;
 
+    // With shape bucketing, the size of every input along the bucketed
+    // dimension before it was padded to the bucket boundary, or -1 for inputs
+    // without that dimension. Empty if the task was not padded. The padded
+    // outputs are sliced back to the size of their input.
+    std::vector<int64_t> unpadded_bucket_sizes;
+
    protected:
     virtual std::unique_ptr<BatchTask> CreateDerivedTask() {
       return std::make_unique<BatchTask>();
@@ -186,6 +194,27 @@ class BatchResourceBase : public ResourceBase {
 
   const SessionMetadata& session_metadata() const { return session_metadata_; }
 
+  // Enables shape bucketing: each task is enqueued to a sub-queue of its
+  // batcher queue keyed by ShapeBucketKey(), after padding its inputs to the
+  // bucket boundary. Each sub-queue forms batches and applies the batch
+  // timeout independently. The outputs listed in
+  // ShapeBucketingOptions::padded_outputs are sliced back to the task's size.
+  // Tasks larger than the last boundary go to the batcher queue itself,
+  // unpadded. Must be called before any input is registered.
+  void set_shape_bucketing_options(ShapeBucketingOptions options) {
+    shape_bucketing_options_ = std::move(options);
+  }
+
+  // Enables zero-copy batching: the outputs of a batch are handed to its tasks
+  // as slices that alias the batched output tensors rather than as copies, and
+  // a batch made of a single unpadded task is processed on the task's own input
+  // tensors rather than on a concatenated copy. The batched outputs stay
+  // alive until every task has released its slice. Must be called before any
+  // input is registered.
+  void set_zero_copy_batching(bool zero_copy_batching) {
+    zero_copy_batching_ = zero_copy_batching;
+  }
+
   using CreateBatchTaskFn =
       std::function<StatusOr<std::unique_ptr<BatchTask>>()>;
 
@@ -221,7 +250,8 @@ class BatchResourceBase : public ResourceBase {
       int32_t low_priority_batch_timeout_micros,
       int32_t low_priority_max_enqueued_batches,
       const std::vector<int32>& low_priority_allowed_batch_sizes,
-      MixedPriorityBatchingPolicy mixed_priority_batching_policy);
+      MixedPriorityBatchingPolicy mixed_priority_batching_policy,
+      int64_t target_p99_latency_micros = 0);
 
   static AdaptiveBatcherT::QueueOptions GetAdaptiveBatcherQueueOptions(
       int32_t max_batch_size, int32_t batch_timeout_micros,
@@ -312,6 +342,11 @@ class BatchResourceBase : public ResourceBase {
       const std::vector<Tensor>& combined_outputs, BatchT* batch,
       std::vector<std::unique_ptr<BatchTask>>& unbatched_tasks) const;
 
+  // Slices the output `output_index` of `task` back to its size before shape
+  // bucketing, if it is one of the padded outputs.
+  absl::Status UnpadTaskOutput(const BatchTask& task, int output_index,
+                               Tensor* output) const;
+
   void ProcessFuncBatch(
       std::unique_ptr<BatchT> batch,
       std::vector<std::unique_ptr<BatchTask>> unbatched_tasks = {}) const;
@@ -348,6 +383,9 @@ class BatchResourceBase : public ResourceBase {
 
   SessionMetadata session_metadata_;
 
+  std::optional<ShapeBucketingOptions> shape_bucketing_options_;
+  bool zero_copy_batching_ = false;
+
   absl::Mutex outstanding_batch_mu_;
   int num_outstanding_batched_items_ TF_GUARDED_BY(outstanding_batch_mu_) = 0;
 
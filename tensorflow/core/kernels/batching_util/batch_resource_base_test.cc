@@ -18,12 +18,14 @@ limitations under the License.
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
@@ -37,12 +39,15 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler_utils.h"
 #include "tensorflow/core/kernels/batching_util/batch_stats.h"
+#include "tensorflow/core/kernels/batching_util/shape_bucketing.h"
 #include "tensorflow/core/kernels/batching_util/shared_batch_scheduler.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/monitoring/cell_reader.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/notification.h"
@@ -430,9 +435,10 @@ class BatchResourceBaseTest : public ::testing::Test {
 
     void ProcessFuncBatchImpl(
         const BatchResourceBase::BatchTask& /* last_task */,
-        absl::Span<const Tensor> /* inputs */,
+        absl::Span<const Tensor> inputs,
         std::vector<Tensor>* /* combined_outputs */,
         std::function<void(const absl::Status&)> /* done */) const override {
+      processed_inputs_.assign(inputs.begin(), inputs.end());
       process_func_batch_called_.Notify();
     }
 
@@ -440,10 +446,126 @@ class BatchResourceBaseTest : public ::testing::Test {
       return process_func_batch_called_;
     }
 
+    // The inputs of the last processed batch. Valid once
+    // process_func_batch_called() has been notified.
+    const std::vector<Tensor>& processed_inputs() const {
+      return processed_inputs_;
+    }
+
    private:
     mutable Notification process_func_batch_called_;
+    mutable std::vector<Tensor> processed_inputs_;
   };
 
+  // Like MyBatchResource, but the batch function returns one of its inputs,
+  // the first one by default, as its only output.
+  class EchoBatchResource : public MyBatchResource {
+   public:
+    using MyBatchResource::MyBatchResource;
+
+    void set_echoed_input(int index) { echoed_input_ = index; }
+
+    void ProcessFuncBatchImpl(
+        const BatchResourceBase::BatchTask& last_task,
+        absl::Span<const Tensor> inputs, std::vector<Tensor>* combined_outputs,
+        std::function<void(const absl::Status&)> done) const override {
+      combined_outputs->push_back(inputs[echoed_input_]);
+      MyBatchResource::ProcessFuncBatchImpl(last_task, inputs,
+                                            combined_outputs, nullptr);
+      done(absl::OkStatus());
+    }
+
+   private:
+    int echoed_input_ = 0;
+  };
+
+  // Like MyBatchResource, but the batch function returns logits of shape
+  // [batch size, kNumClasses], whose row b is input(b, 0, 0) + [0, 1, ...].
+  class LogitsBatchResource : public MyBatchResource {
+   public:
+    static constexpr int kNumClasses = 4;
+
+    using MyBatchResource::MyBatchResource;
+
+    void ProcessFuncBatchImpl(
+        const BatchResourceBase::BatchTask& last_task,
+        absl::Span<const Tensor> inputs, std::vector<Tensor>* combined_outputs,
+        std::function<void(const absl::Status&)> done) const override {
+      combined_outputs->push_back(Logits(inputs[0]));
+      MyBatchResource::ProcessFuncBatchImpl(last_task, inputs,
+                                            combined_outputs, nullptr);
+      done(absl::OkStatus());
+    }
+
+    static Tensor Logits(const Tensor& input) {
+      const int64_t batch_size = input.dim_size(0);
+      Tensor logits(DataType::DT_INT64, TensorShape({batch_size, kNumClasses}));
+      auto values = input.flat_outer_dims<int64_t>();
+      for (int64_t b = 0; b < batch_size; ++b) {
+        for (int c = 0; c < kNumClasses; ++c) {
+          logits.matrix<int64_t>()(b, c) = values(b, 0) + c;
+        }
+      }
+      return logits;
+    }
+  };
+
+  // The inputs and the context of a BatchFunction invocation, whose batched
+  // inputs are `input` and `second_input`.
+  struct Invocation {
+    Tensor input;
+    Tensor second_input;
+    std::vector<TensorValue> input_values;
+    OpKernelContext::Params params;
+    std::unique_ptr<OpKernelContext> context;
+    Notification done;
+  };
+
+  // Returns an invocation whose input has `shape` and holds consecutive values
+  // starting at `first_value`. The second input is the same as the first one,
+  // unless it has a `second_shape`.
+  std::unique_ptr<Invocation> MakeInvocation(
+      const TensorShape& shape, int64_t first_value,
+      std::optional<TensorShape> second_shape = std::nullopt) {
+    auto invocation = std::make_unique<Invocation>();
+    invocation->input = Tensor(DataType::DT_INT64, shape);
+    auto values = invocation->input.flat<int64_t>();
+    for (int64_t i = 0; i < values.size(); ++i) values(i) = first_value + i;
+    invocation->second_input = invocation->input;
+    if (second_shape.has_value()) {
+      invocation->second_input = Tensor(DataType::DT_INT64, *second_shape);
+      auto second_values = invocation->second_input.flat<int64_t>();
+      for (int64_t i = 0; i < second_values.size(); ++i) {
+        second_values(i) = -(first_value + i);
+      }
+    }
+    invocation->input_values = {TensorValue(&invocation->input),
+                                TensorValue(&invocation->second_input),
+                                TensorValue(&invocation->input)};
+    invocation->params.device = device_.get();
+    invocation->params.op_kernel = batch_kernel_.get();
+    invocation->params.inputs = invocation->input_values;
+    invocation->params.session_metadata = &session_metadata_;
+    invocation->context =
+        std::make_unique<OpKernelContext>(&invocation->params);
+    return invocation;
+  }
+
+  // Registers `invocation` with `resource`, notifying `invocation->done` once
+  // its outputs are set.
+  static void RegisterInvocation(BatchResourceBase* resource, int64_t guid,
+                                 Invocation* invocation) {
+    TF_CHECK_OK(resource->RegisterInput(
+        guid, invocation->context.get(),
+        /* batcher_queue_name= */ "batcher_queue_name",
+        /* create_batch_task_fn= */
+        []() -> absl::StatusOr<std::unique_ptr<BatchResourceBase::BatchTask>> {
+          return std::make_unique<BatchResourceBase::BatchTask>();
+        },
+        /* done_callback= */ [invocation] { invocation->done.Notify(); },
+        /* forced_warmup_batch_size= */ 0));
+  }
+
   BatchResourceBaseTest() {
     // The whole point of this test fixture is to create a usable batch function
     // context, context_.
@@ -622,6 +744,295 @@ TEST_F(BatchResourceBaseTest, ConfiguredBatchPaddingPolicyMetric) {
   my_batch_resource->Unref();
 }
 
+TEST_F(BatchResourceBaseTest, ZeroCopyBatchingPassesSingleTaskInputs) {
+  std::shared_ptr<SharedBatchScheduler<BatchResourceBase::BatchTask>> batcher;
+  TF_CHECK_OK(
+      SharedBatchScheduler<BatchResourceBase::BatchTask>::Create({}, &batcher));
+
+  MyBatchResource* my_batch_resource = new MyBatchResource(
+      /* has_process_batch_function */ true,
+      /* batcher= */ batcher,
+      /* batcher_queue_options */ {},
+      /* allowed_batch_sizes */ {});
+  my_batch_resource->set_zero_copy_batching(true);
+
+  TF_CHECK_OK(my_batch_resource->RegisterInput(
+      /* guid= */
+      0, /* context= */ context_.get(),
+      /* batcher_queue_name= */ "batcher_queue_name",
+      /* create_batch_task_fn= */
+      []() -> absl::StatusOr<std::unique_ptr<BatchResourceBase::BatchTask>> {
+        return std::make_unique<BatchResourceBase::BatchTask>();
+      },
+      /* done_callback= */ [] {}, /* forced_warmup_batch_size= */ 0));
+
+  ASSERT_TRUE(
+      my_batch_resource->process_func_batch_called()
+          .WaitForNotificationWithTimeout(absl::Seconds(1)));
+  // The batch consists of the only task and needs no padding, so the batch
+  // function gets the task's inputs without a copy, followed by the captured
+  // input.
+  ASSERT_EQ(my_batch_resource->processed_inputs().size(), 3);
+  for (const Tensor& input : my_batch_resource->processed_inputs()) {
+    EXPECT_TRUE(input.SharesBufferWith(input_tensor_));
+  }
+
+  // This is how we have to destroy the BatchResource.
+  my_batch_resource->Unref();
+}
+
+TEST_F(BatchResourceBaseTest, ZeroCopyBatchingAliasesOutputSlices) {
+  std::shared_ptr<SharedBatchScheduler<BatchResourceBase::BatchTask>> batcher;
+  TF_CHECK_OK(
+      SharedBatchScheduler<BatchResourceBase::BatchTask>::Create({}, &batcher));
+
+  // The batch is processed as soon as it holds both tasks.
+  EchoBatchResource* my_batch_resource = new EchoBatchResource(
+      /* has_process_batch_function */ true,
+      /* batcher= */ batcher,
+      /* batcher_queue_options */
+      MyBatchResource::BatcherT::QueueOptions{
+          .input_batch_size_limit = 8,
+          .batch_timeout_micros = 10 * 1000 * 1000,
+      },
+      /* allowed_batch_sizes */ {});
+  my_batch_resource->set_zero_copy_batching(true);
+
+  // Rows of 64 bytes keep the slice of every task aligned.
+  std::unique_ptr<Invocation> first_task =
+      MakeInvocation(TensorShape({4, 8, 1}), /*first_value=*/0);
+  std::unique_ptr<Invocation> second_task =
+      MakeInvocation(TensorShape({4, 8, 1}), /*first_value=*/100);
+  RegisterInvocation(my_batch_resource, /*guid=*/0, first_task.get());
+  RegisterInvocation(my_batch_resource, /*guid=*/1, second_task.get());
+
+  for (Invocation* invocation : {first_task.get(), second_task.get()}) {
+    ASSERT_TRUE(
+        invocation->done.WaitForNotificationWithTimeout(absl::Seconds(10)));
+    TF_ASSERT_OK(invocation->context->status());
+  }
+  const Tensor& batched_output = my_batch_resource->processed_inputs()[0];
+  ASSERT_EQ(batched_output.shape(), TensorShape({8, 8, 1}));
+  for (Invocation* invocation : {first_task.get(), second_task.get()}) {
+    const Tensor& output = *invocation->context->mutable_output(0);
+    EXPECT_TRUE(output.SharesBufferWith(batched_output));
+    test::ExpectTensorEqual<int64_t>(output, invocation->input);
+  }
+  EXPECT_NE(first_task->context->mutable_output(0)->data(),
+            second_task->context->mutable_output(0)->data());
+
+  // This is how we have to destroy the BatchResource.
+  my_batch_resource->Unref();
+}
+
+TEST_F(BatchResourceBaseTest, ZeroCopyBatchingCopiesUnalignedOutputSlices) {
+  std::shared_ptr<SharedBatchScheduler<BatchResourceBase::BatchTask>> batcher;
+  TF_CHECK_OK(
+      SharedBatchScheduler<BatchResourceBase::BatchTask>::Create({}, &batcher));
+
+  // The batch is processed as soon as it holds both tasks.
+  EchoBatchResource* my_batch_resource = new EchoBatchResource(
+      /* has_process_batch_function */ true,
+      /* batcher= */ batcher,
+      /* batcher_queue_options */
+      MyBatchResource::BatcherT::QueueOptions{
+          .input_batch_size_limit = 2,
+          .batch_timeout_micros = 10 * 1000 * 1000,
+      },
+      /* allowed_batch_sizes */ {});
+  my_batch_resource->set_zero_copy_batching(true);
+
+  // The slice of the second task starts 8 bytes into the batched output,
+  // which is not aligned, so the outputs are copied.
+  std::unique_ptr<Invocation> first_task =
+      MakeInvocation(TensorShape({1, 1, 1}), /*first_value=*/0);
+  std::unique_ptr<Invocation> second_task =
+      MakeInvocation(TensorShape({1, 1, 1}), /*first_value=*/100);
+  RegisterInvocation(my_batch_resource, /*guid=*/0, first_task.get());
+  RegisterInvocation(my_batch_resource, /*guid=*/1, second_task.get());
+
+  for (Invocation* invocation : {first_task.get(), second_task.get()}) {
+    ASSERT_TRUE(
+        invocation->done.WaitForNotificationWithTimeout(absl::Seconds(10)));
+    TF_ASSERT_OK(invocation->context->status());
+  }
+  const Tensor& batched_output = my_batch_resource->processed_inputs()[0];
+  ASSERT_EQ(batched_output.shape(), TensorShape({2, 1, 1}));
+  for (Invocation* invocation : {first_task.get(), second_task.get()}) {
+    const Tensor& output = *invocation->context->mutable_output(0);
+    EXPECT_FALSE(output.SharesBufferWith(batched_output));
+    test::ExpectTensorEqual<int64_t>(output, invocation->input);
+  }
+
+  // This is how we have to destroy the BatchResource.
+  my_batch_resource->Unref();
+}
+
+TEST_F(BatchResourceBaseTest, ShapeBucketingSlicesOutputsToTaskShapes) {
+  std::shared_ptr<SharedBatchScheduler<BatchResourceBase::BatchTask>> batcher;
+  TF_CHECK_OK(
+      SharedBatchScheduler<BatchResourceBase::BatchTask>::Create({}, &batcher));
+
+  // The batch is processed as soon as it holds both tasks.
+  EchoBatchResource* my_batch_resource = new EchoBatchResource(
+      /* has_process_batch_function */ true,
+      /* batcher= */ batcher,
+      /* batcher_queue_options */
+      MyBatchResource::BatcherT::QueueOptions{
+          .input_batch_size_limit = 8,
+          .batch_timeout_micros = 10 * 1000 * 1000,
+      },
+      /* allowed_batch_sizes */ {});
+  ShapeBucketingOptions options;
+  options.dimension = 1;
+  options.boundaries = {4, 8};
+  options.padded_outputs = {0};
+  my_batch_resource->set_shape_bucketing_options(options);
+
+  // Both tasks fall into the bucket of length 4.
+  std::unique_ptr<Invocation> short_task =
+      MakeInvocation(TensorShape({5, 2, 1}), /*first_value=*/0);
+  std::unique_ptr<Invocation> long_task =
+      MakeInvocation(TensorShape({3, 3, 1}), /*first_value=*/100);
+  RegisterInvocation(my_batch_resource, /*guid=*/0, short_task.get());
+  RegisterInvocation(my_batch_resource, /*guid=*/1, long_task.get());
+
+  for (Invocation* invocation : {short_task.get(), long_task.get()}) {
+    ASSERT_TRUE(
+        invocation->done.WaitForNotificationWithTimeout(absl::Seconds(10)));
+    TF_ASSERT_OK(invocation->context->status());
+    const Tensor* output = invocation->context->mutable_output(0);
+    ASSERT_NE(output, nullptr);
+    EXPECT_EQ(output->shape(), invocation->input.shape());
+    test::ExpectTensorEqual<int64_t>(*output, invocation->input);
+  }
+  ASSERT_FALSE(my_batch_resource->processed_inputs().empty());
+  EXPECT_EQ(my_batch_resource->processed_inputs()[0].shape(),
+            TensorShape({8, 4, 1}));
+
+  // This is how we have to destroy the BatchResource.
+  my_batch_resource->Unref();
+}
+
+TEST_F(BatchResourceBaseTest, ShapeBucketingSlicesOutputsToTheirInputSize) {
+  std::shared_ptr<SharedBatchScheduler<BatchResourceBase::BatchTask>> batcher;
+  TF_CHECK_OK(
+      SharedBatchScheduler<BatchResourceBase::BatchTask>::Create({}, &batcher));
+
+  EchoBatchResource* my_batch_resource = new EchoBatchResource(
+      /* has_process_batch_function */ true,
+      /* batcher= */ batcher,
+      /* batcher_queue_options */
+      MyBatchResource::BatcherT::QueueOptions{
+          .input_batch_size_limit = 8,
+          .batch_timeout_micros = 10 * 1000 * 1000,
+      },
+      /* allowed_batch_sizes */ {});
+  my_batch_resource->set_echoed_input(1);
+  ShapeBucketingOptions options;
+  options.dimension = 1;
+  options.boundaries = {4, 8};
+  options.padded_outputs = {0};
+  options.padded_output_inputs = {1};
+  my_batch_resource->set_shape_bucketing_options(options);
+
+  // Both tasks fall into the bucket of lengths 4 and 8, but their inputs have
+  // different lengths.
+  std::unique_ptr<Invocation> first_task =
+      MakeInvocation(TensorShape({5, 2, 1}), /*first_value=*/0,
+                     /*second_shape=*/TensorShape({5, 6, 1}));
+  std::unique_ptr<Invocation> second_task =
+      MakeInvocation(TensorShape({3, 3, 1}), /*first_value=*/100,
+                     /*second_shape=*/TensorShape({3, 7, 1}));
+  RegisterInvocation(my_batch_resource, /*guid=*/0, first_task.get());
+  RegisterInvocation(my_batch_resource, /*guid=*/1, second_task.get());
+
+  for (Invocation* invocation : {first_task.get(), second_task.get()}) {
+    ASSERT_TRUE(
+        invocation->done.WaitForNotificationWithTimeout(absl::Seconds(10)));
+    TF_ASSERT_OK(invocation->context->status());
+    test::ExpectTensorEqual<int64_t>(*invocation->context->mutable_output(0),
+                                     invocation->second_input);
+  }
+
+  // This is how we have to destroy the BatchResource.
+  my_batch_resource->Unref();
+}
+
+TEST_F(BatchResourceBaseTest, ShapeBucketingKeepsOutputsThatAreNotPadded) {
+  std::shared_ptr<SharedBatchScheduler<BatchResourceBase::BatchTask>> batcher;
+  TF_CHECK_OK(
+      SharedBatchScheduler<BatchResourceBase::BatchTask>::Create({}, &batcher));
+
+  LogitsBatchResource* my_batch_resource = new LogitsBatchResource(
+      /* has_process_batch_function */ true,
+      /* batcher= */ batcher,
+      /* batcher_queue_options */
+      MyBatchResource::BatcherT::QueueOptions{
+          .input_batch_size_limit = 8,
+          .batch_timeout_micros = 10 * 1000 * 1000,
+      },
+      /* allowed_batch_sizes */ {});
+  // The logits have as many classes as the first bucket boundary, but they are
+  // not aligned with the padded inputs.
+  ShapeBucketingOptions options;
+  options.dimension = 1;
+  options.boundaries = {LogitsBatchResource::kNumClasses, 8};
+  my_batch_resource->set_shape_bucketing_options(options);
+
+  std::unique_ptr<Invocation> short_task =
+      MakeInvocation(TensorShape({5, 2, 1}), /*first_value=*/0);
+  std::unique_ptr<Invocation> long_task =
+      MakeInvocation(TensorShape({3, 3, 1}), /*first_value=*/100);
+  RegisterInvocation(my_batch_resource, /*guid=*/0, short_task.get());
+  RegisterInvocation(my_batch_resource, /*guid=*/1, long_task.get());
+
+  for (Invocation* invocation : {short_task.get(), long_task.get()}) {
+    ASSERT_TRUE(
+        invocation->done.WaitForNotificationWithTimeout(absl::Seconds(10)));
+    TF_ASSERT_OK(invocation->context->status());
+    test::ExpectTensorEqual<int64_t>(
+        *invocation->context->mutable_output(0),
+        LogitsBatchResource::Logits(invocation->input));
+  }
+  EXPECT_EQ(my_batch_resource->processed_inputs()[0].shape(),
+            TensorShape({8, 4, 1}));
+
+  // This is how we have to destroy the BatchResource.
+  my_batch_resource->Unref();
+}
+
+TEST_F(BatchResourceBaseTest, ShapeBucketingSkipsTasksAboveLastBoundary) {
+  std::shared_ptr<SharedBatchScheduler<BatchResourceBase::BatchTask>> batcher;
+  TF_CHECK_OK(
+      SharedBatchScheduler<BatchResourceBase::BatchTask>::Create({}, &batcher));
+
+  EchoBatchResource* my_batch_resource = new EchoBatchResource(
+      /* has_process_batch_function */ true,
+      /* batcher= */ batcher,
+      /* batcher_queue_options */ {},
+      /* allowed_batch_sizes */ {});
+  ShapeBucketingOptions options;
+  options.dimension = 1;
+  options.boundaries = {4, 8};
+  my_batch_resource->set_shape_bucketing_options(options);
+
+  // Larger than the last boundary, so neither padded nor sliced.
+  std::unique_ptr<Invocation> task =
+      MakeInvocation(TensorShape({2, 9, 1}), /*first_value=*/0);
+  RegisterInvocation(my_batch_resource, /*guid=*/0, task.get());
+
+  ASSERT_TRUE(task->done.WaitForNotificationWithTimeout(absl::Seconds(10)));
+  TF_ASSERT_OK(task->context->status());
+  EXPECT_EQ(my_batch_resource->processed_inputs()[0].shape(),
+            TensorShape({2, 9, 1}));
+  test::ExpectTensorEqual<int64_t>(*task->context->mutable_output(0),
+                                   task->input);
+
+  // This is how we have to destroy the BatchResource.
+  my_batch_resource->Unref();
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
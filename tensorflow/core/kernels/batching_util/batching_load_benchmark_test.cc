@@ -0,0 +1,587 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Open-loop load benchmarks for the batching schedulers.
+//
+// Unlike basic_batch_scheduler_benchmark_test.cc, tasks are injected at the
+// times given by an arrival process (Poisson, bursty, or replayed from a trace
+// file) regardless of how many tasks are outstanding, and batches are
+// "processed" according to a synthetic cost model. Each benchmark reports the
+// task latency percentiles, the batch fill ratio (average batch size over the
+// maximum batch size) and the padding waste (fraction of the processed batch
+// size that is padding) in its label.
+//
+// The trace file given by --batching_load_trace_file has one arrival per line:
+// the arrival time in microseconds since the start of the trace, optionally
+// followed by the task size.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/device.h"
+#include "tensorflow/core/framework/device_factory.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/batching_util/adaptive_shared_batch_scheduler.h"
+#include "tensorflow/core/kernels/batching_util/batch_resource_base.h"
+#include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
+#include "tensorflow/core/kernels/batching_util/batch_scheduler_utils.h"
+#include "tensorflow/core/kernels/batching_util/shared_batch_scheduler.h"
+#include "tensorflow/core/lib/histogram/histogram.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using ::tensorflow::histogram::Histogram;
+
+// Duration of the generated (Poisson and bursty) arrival processes.
+static int load_benchmark_duration_secs = 10;
+
+// See the file comment.
+static string load_benchmark_trace_file;  // NOLINT
+
+// Multiplies the arrival times read from the trace file, e.g. 0.5 replays the
+// trace at twice its original rate.
+static float load_benchmark_trace_time_scale = 1.0;
+
+// Batching parameters shared by all benchmarks.
+constexpr int kMaxBatchSize = 64;
+constexpr int kMaxTaskSize = 4;
+constexpr int kNumBatchThreads = 4;
+constexpr int kMaxEnqueuedBatches = 1000;
+const std::vector<int32>& AllowedBatchSizes() {
+  static const auto* const kAllowedBatchSizes =
+      new std::vector<int32>{8, 16, 32, 64};
+  return *kAllowedBatchSizes;
+}
+
+enum ArrivalProcess { kPoisson = 0, kBursty = 1, kTrace = 2 };
+
+// One task injection: when, relative to the start of the benchmark, and how
+// large the task is.
+struct Arrival {
+  int64_t time_micros;
+  int task_size;
+};
+
+// Poisson arrivals at `qps` tasks per second, with uniformly distributed task
+// sizes in [1, kMaxTaskSize].
+std::vector<Arrival> PoissonArrivals(double qps, int64_t duration_micros,
+                                     uint64 seed) {
+  random::PhiloxRandom philox(seed);
+  random::SimplePhilox rng(&philox);
+  std::vector<Arrival> arrivals;
+  double time_micros = 0;
+  while (true) {
+    time_micros += -std::log(1 - rng.RandDouble()) * 1e6 / qps;
+    if (time_micros >= duration_micros) break;
+    arrivals.push_back({static_cast<int64_t>(time_micros),
+                        1 + static_cast<int>(rng.Uniform(kMaxTaskSize))});
+  }
+  return arrivals;
+}
+
+// Poisson arrivals whose rate alternates, every second, between a burst at
+// kBurstFactor times `qps` for kBurstFraction of the second and a lower rate
+// for the rest of it, so that the average rate is still `qps`.
+std::vector<Arrival> BurstyArrivals(double qps, int64_t duration_micros,
+                                    uint64 seed) {
+  constexpr int64_t kPeriodMicros = 1000 * 1000;
+  constexpr double kBurstFraction = 0.1;
+  constexpr double kBurstFactor = 5;
+  const double burst_qps = kBurstFactor * qps;
+  const double base_qps =
+      qps * (1 - kBurstFactor * kBurstFraction) / (1 - kBurstFraction);
+
+  random::PhiloxRandom philox(seed);
+  random::SimplePhilox rng(&philox);
+  std::vector<Arrival> arrivals;
+  double time_micros = 0;
+  while (true) {
+    const bool in_burst =
+        (static_cast<int64_t>(time_micros) % kPeriodMicros) <
+        kBurstFraction * kPeriodMicros;
+    time_micros += -std::log(1 - rng.RandDouble()) * 1e6 /
+                   (in_burst ? burst_qps : base_qps);
+    if (time_micros >= duration_micros) break;
+    arrivals.push_back({static_cast<int64_t>(time_micros),
+                        1 + static_cast<int>(rng.Uniform(kMaxTaskSize))});
+  }
+  return arrivals;
+}
+
+// Arrivals replayed from `path`, see the file comment.
+absl::StatusOr<std::vector<Arrival>> TraceArrivals(const string& path,
+                                                   double time_scale) {
+  std::ifstream file(path);
+  if (!file) {
+    return errors::NotFound("Could not open trace file ", path);
+  }
+  std::vector<Arrival> arrivals;
+  std::string line;
+  int line_number = 0;
+  while (std::getline(file, line)) {
+    ++line_number;
+    std::vector<absl::string_view> fields =
+        absl::StrSplit(line, ' ', absl::SkipWhitespace());
+    if (fields.empty()) continue;
+    int64_t time_micros;
+    int task_size = 1;
+    if (fields.size() > 2 || !absl::SimpleAtoi(fields[0], &time_micros) ||
+        (fields.size() == 2 && !absl::SimpleAtoi(fields[1], &task_size)) ||
+        task_size < 1 || task_size > kMaxBatchSize) {
+      return errors::InvalidArgument("Malformed line ", line_number, " in ",
+                                     path, ": ", line);
+    }
+    arrivals.push_back(
+        {static_cast<int64_t>(time_micros * time_scale), task_size});
+  }
+  std::stable_sort(arrivals.begin(), arrivals.end(),
+                   [](const Arrival& a, const Arrival& b) {
+                     return a.time_micros < b.time_micros;
+                   });
+  if (!arrivals.empty()) {
+    const int64_t first_time_micros = arrivals.front().time_micros;
+    for (Arrival& arrival : arrivals) {
+      arrival.time_micros -= first_time_micros;
+    }
+  }
+  return arrivals;
+}
+
+absl::StatusOr<std::vector<Arrival>> GetArrivals(ArrivalProcess process,
+                                                 double qps) {
+  const int64_t duration_micros =
+      static_cast<int64_t>(load_benchmark_duration_secs) * 1000 * 1000;
+  switch (process) {
+    case kPoisson:
+      return PoissonArrivals(qps, duration_micros, /*seed=*/42);
+    case kBursty:
+      return BurstyArrivals(qps, duration_micros, /*seed=*/42);
+    case kTrace:
+      if (load_benchmark_trace_file.empty()) {
+        return errors::FailedPrecondition(
+            "--batching_load_trace_file is not set");
+      }
+      return TraceArrivals(load_benchmark_trace_file,
+                           load_benchmark_trace_time_scale);
+  }
+  return errors::InvalidArgument("Unknown arrival process ", process);
+}
+
+// Calls `inject` for each of `arrivals` at its arrival time, without waiting
+// for previously injected tasks.
+void InjectArrivals(absl::Span<const Arrival> arrivals,
+                    const std::function<void(const Arrival&)>& inject) {
+  Env* env = Env::Default();
+  const int64_t start_time_micros = env->NowMicros();
+  for (const Arrival& arrival : arrivals) {
+    const int64_t injection_time_micros =
+        start_time_micros + arrival.time_micros;
+    int64_t now_micros = env->NowMicros();
+    while (now_micros < injection_time_micros) {
+      // Sleeping has a coarse granularity; spin for the last millisecond.
+      const int64_t kSleepThresholdMicros = 1000;
+      if (injection_time_micros - now_micros >= 2 * kSleepThresholdMicros) {
+        env->SleepForMicroseconds(injection_time_micros - now_micros -
+                                  kSleepThresholdMicros);
+      }
+      now_micros = env->NowMicros();
+    }
+    inject(arrival);
+  }
+}
+
+// Synthetic cost of processing a batch: a fixed overhead plus a cost per
+// example of the padded batch. The batch thread sleeps for that long, as it
+// would while waiting for an accelerator.
+struct BatchCostModel {
+  int64_t fixed_micros = 500;
+  int64_t per_example_micros = 20;
+
+  void Process(int64_t padded_batch_size) const {
+    Env::Default()->SleepForMicroseconds(
+        fixed_micros + per_example_micros * padded_batch_size);
+  }
+};
+
+// Collects the metrics reported by a benchmark.
+class LoadStats {
+ public:
+  void RecordTask(int64_t task_size, int64_t latency_micros) {
+    mutex_lock l(mu_);
+    latency_micros_.Add(latency_micros);
+    total_task_size_ += task_size;
+  }
+
+  void RecordBatch(int64_t padded_batch_size) {
+    mutex_lock l(mu_);
+    ++num_batches_;
+    total_padded_batch_size_ += padded_batch_size;
+  }
+
+  void RecordRejection() {
+    mutex_lock l(mu_);
+    ++num_rejected_;
+  }
+
+  string Report() const {
+    mutex_lock l(mu_);
+    const double fill_ratio =
+        num_batches_ == 0 ? 0
+                          : static_cast<double>(total_task_size_) /
+                                (num_batches_ * kMaxBatchSize);
+    const double padding_waste =
+        total_padded_batch_size_ == 0
+            ? 0
+            : 1 - static_cast<double>(total_task_size_) /
+                      total_padded_batch_size_;
+    return absl::StrCat(
+        "lat_p50=", latency_micros_.Percentile(50) / 1000.0,
+        "ms,lat_p99=", latency_micros_.Percentile(99) / 1000.0,
+        "ms,lat_p99.9=", latency_micros_.Percentile(99.9) / 1000.0,
+        "ms,fill=", fill_ratio, ",padding_waste=", padding_waste,
+        ",batches=", num_batches_, ",rejected=", num_rejected_);
+  }
+
+ private:
+  mutable mutex mu_;
+  Histogram latency_micros_ TF_GUARDED_BY(mu_);
+  int64_t total_task_size_ TF_GUARDED_BY(mu_) = 0;
+  int64_t num_batches_ TF_GUARDED_BY(mu_) = 0;
+  int64_t total_padded_batch_size_ TF_GUARDED_BY(mu_) = 0;
+  int64_t num_rejected_ TF_GUARDED_BY(mu_) = 0;
+};
+
+class LoadTask : public BatchTask {
+ public:
+  LoadTask(int size, absl::BlockingCounter* done)
+      : size_(size),
+        enqueue_time_micros_(Env::Default()->NowMicros()),
+        done_(done) {}
+
+  size_t size() const override { return size_; }
+
+  uint64 enqueue_time_micros() const { return enqueue_time_micros_; }
+
+  absl::BlockingCounter* done() const { return done_; }
+
+ private:
+  const int size_;
+  const uint64 enqueue_time_micros_;
+  absl::BlockingCounter* const done_;
+};
+
+// Processes a batch of LoadTasks for the SharedBatchScheduler and
+// AdaptiveSharedBatchScheduler benchmarks, which pad like BatchResourceBase.
+void ProcessLoadBatch(const BatchCostModel& cost_model, LoadStats* stats,
+                      std::unique_ptr<Batch<LoadTask>> batch) {
+  const int padded_batch_size = GetNextAllowedBatchSize(
+      batch->size(), AllowedBatchSizes(), /*disable_padding=*/false);
+  cost_model.Process(padded_batch_size);
+  const uint64 now_micros = Env::Default()->NowMicros();
+  stats->RecordBatch(padded_batch_size);
+  for (int i = 0; i < batch->num_tasks(); ++i) {
+    const LoadTask& task = batch->task(i);
+    stats->RecordTask(task.size(), now_micros - task.enqueue_time_micros());
+    task.done()->DecrementCount();
+  }
+}
+
+// Injects `arrivals` into `queue` and waits until all of them are processed.
+void RunLoad(absl::Span<const Arrival> arrivals,
+             BatchScheduler<LoadTask>* queue, LoadStats* stats) {
+  absl::BlockingCounter done(arrivals.size());
+  InjectArrivals(arrivals, [&](const Arrival& arrival) {
+    auto task = std::make_unique<LoadTask>(arrival.task_size, &done);
+    if (!queue->Schedule(&task).ok()) {
+      stats->RecordRejection();
+      done.DecrementCount();
+    }
+  });
+  done.Wait();
+}
+
+void BM_SharedBatchScheduler(::testing::benchmark::State& state) {
+  const auto process = static_cast<ArrivalProcess>(state.range(0));
+  absl::StatusOr<std::vector<Arrival>> arrivals =
+      GetArrivals(process, state.range(1));
+  if (!arrivals.ok()) {
+    state.SkipWithError(arrivals.status().ToString().c_str());
+    return;
+  }
+  const BatchCostModel cost_model;
+  LoadStats stats;
+
+  for (auto s : state) {
+    SharedBatchScheduler<LoadTask>::Options options;
+    options.num_batch_threads = kNumBatchThreads;
+    std::shared_ptr<SharedBatchScheduler<LoadTask>> scheduler;
+    TF_CHECK_OK(SharedBatchScheduler<LoadTask>::Create(options, &scheduler));
+
+    SharedBatchScheduler<LoadTask>::QueueOptions queue_options;
+    queue_options.input_batch_size_limit = kMaxBatchSize;
+    queue_options.batch_timeout_micros = state.range(2);
+    queue_options.max_enqueued_batches = kMaxEnqueuedBatches;
+    queue_options.allowed_batch_sizes = AllowedBatchSizes();
+    std::unique_ptr<BatchScheduler<LoadTask>> queue;
+    TF_CHECK_OK(scheduler->AddQueue(
+        queue_options,
+        [&](std::unique_ptr<Batch<LoadTask>> batch) {
+          ProcessLoadBatch(cost_model, &stats, std::move(batch));
+        },
+        &queue));
+
+    RunLoad(*arrivals, queue.get(), &stats);
+  }
+  state.SetLabel(stats.Report());
+}
+BENCHMARK(BM_SharedBatchScheduler)
+    ->UseRealTime()
+    ->Iterations(1)
+    ->ArgNames({"arrivals", "qps", "timeout"})
+    ->ArgsProduct({{kPoisson, kBursty, kTrace}, {1000, 5000}, {0, 1000, 5000}});
+
+void BM_AdaptiveSharedBatchScheduler(::testing::benchmark::State& state) {
+  const auto process = static_cast<ArrivalProcess>(state.range(0));
+  absl::StatusOr<std::vector<Arrival>> arrivals =
+      GetArrivals(process, state.range(1));
+  if (!arrivals.ok()) {
+    state.SkipWithError(arrivals.status().ToString().c_str());
+    return;
+  }
+  const BatchCostModel cost_model;
+  LoadStats stats;
+
+  for (auto s : state) {
+    AdaptiveSharedBatchScheduler<LoadTask>::Options options;
+    options.num_batch_threads = kNumBatchThreads;
+    std::shared_ptr<AdaptiveSharedBatchScheduler<LoadTask>> scheduler;
+    TF_CHECK_OK(
+        AdaptiveSharedBatchScheduler<LoadTask>::Create(options, &scheduler));
+
+    AdaptiveSharedBatchScheduler<LoadTask>::QueueOptions queue_options;
+    queue_options.max_batch_size = kMaxBatchSize;
+    queue_options.batch_timeout_micros = state.range(2);
+    queue_options.max_enqueued_batches = kMaxEnqueuedBatches;
+    std::unique_ptr<BatchScheduler<LoadTask>> queue;
+    TF_CHECK_OK(scheduler->AddQueue(
+        queue_options,
+        [&](std::unique_ptr<Batch<LoadTask>> batch) {
+          ProcessLoadBatch(cost_model, &stats, std::move(batch));
+        },
+        &queue));
+
+    RunLoad(*arrivals, queue.get(), &stats);
+  }
+  state.SetLabel(stats.Report());
+}
+BENCHMARK(BM_AdaptiveSharedBatchScheduler)
+    ->UseRealTime()
+    ->Iterations(1)
+    ->ArgNames({"arrivals", "qps", "timeout"})
+    ->ArgsProduct({{kPoisson, kBursty, kTrace}, {1000, 5000}, {0, 1000, 5000}});
+
+// A BatchResourceBase whose batch function applies the cost model and returns
+// its input.
+class LoadBatchResource : public BatchResourceBase {
+ public:
+  LoadBatchResource(std::shared_ptr<BatcherT> batcher,
+                    const BatcherT::QueueOptions& queue_options,
+                    const BatchCostModel& cost_model, LoadStats* stats)
+      : BatchResourceBase(/*has_process_batch_function=*/true,
+                          std::move(batcher), queue_options,
+                          AllowedBatchSizes()),
+        cost_model_(cost_model),
+        stats_(stats) {}
+
+  string DebugString() const override { return "LoadBatchResource"; }
+
+ private:
+  void ProcessFuncBatchImpl(
+      const BatchResourceBase::BatchTask& /* last_task */,
+      absl::Span<const Tensor> inputs, std::vector<Tensor>* combined_outputs,
+      std::function<void(const absl::Status&)> done) const override {
+    const int64_t padded_batch_size = inputs[0].dim_size(0);
+    cost_model_.Process(padded_batch_size);
+    stats_->RecordBatch(padded_batch_size);
+    combined_outputs->push_back(inputs[0]);
+    done(absl::OkStatus());
+  }
+
+  const BatchCostModel cost_model_;
+  LoadStats* const stats_;
+};
+
+// The state of one BatchFunction invocation. Kept alive until the end of the
+// benchmark, since the batch resource refers to the kernel context.
+struct LoadRequest {
+  Tensor input;
+  std::vector<TensorValue> inputs;
+  OpKernelContext::Params params;
+  std::unique_ptr<OpKernelContext> context;
+};
+
+void BM_BatchResourceBase(::testing::benchmark::State& state) {
+  const auto process = static_cast<ArrivalProcess>(state.range(0));
+  absl::StatusOr<std::vector<Arrival>> arrivals =
+      GetArrivals(process, state.range(1));
+  if (!arrivals.ok()) {
+    state.SkipWithError(arrivals.status().ToString().c_str());
+    return;
+  }
+  const BatchCostModel cost_model;
+  LoadStats stats;
+
+  // A BatchFunction kernel with one float input and output, to create the
+  // kernel contexts from.
+  std::unique_ptr<Device> device = DeviceFactory::NewDevice(
+      "CPU", SessionOptions{}, "/job:a/replica:0/task:0");
+  NodeDef node_def;
+  NameAttrList f;
+  f.set_name("func_to_batch");
+  TF_CHECK_OK(NodeDefBuilder("batch", "BatchFunction")
+                  .Attr("max_batch_size", kMaxBatchSize)
+                  .Attr("num_batch_threads", kNumBatchThreads)
+                  .Attr("allowed_batch_sizes", AllowedBatchSizes())
+                  .Attr("batch_timeout_micros", 0)
+                  .Attr("Tin", {DT_FLOAT})
+                  .Input(std::vector<NodeDefBuilder::NodeOut>{{"in", 0,
+                                                               DT_FLOAT}})
+                  .Attr("Tcaptured", DataTypeVector{})
+                  .Input(std::vector<NodeDefBuilder::NodeOut>{})
+                  .Attr("Tout", {DT_FLOAT})
+                  .Attr("f", f)
+                  .Finalize(&node_def));
+  absl::Status status;
+  std::unique_ptr<OpKernel> kernel =
+      CreateOpKernel(DEVICE_CPU, device.get(), device->GetAllocator({}),
+                     node_def, TF_GRAPH_DEF_VERSION, &status);
+  TF_CHECK_OK(status);
+
+  for (auto s : state) {
+    BatchResourceBase::BatcherT::Options options;
+    options.num_batch_threads = kNumBatchThreads;
+    std::shared_ptr<BatchResourceBase::BatcherT> batcher;
+    TF_CHECK_OK(BatchResourceBase::BatcherT::Create(options, &batcher));
+    auto* resource = new LoadBatchResource(
+        batcher,
+        BatchResourceBase::GetBatcherQueueOptions(
+            kNumBatchThreads, kMaxBatchSize, state.range(2),
+            kMaxEnqueuedBatches, AllowedBatchSizes(),
+            /*enable_large_batch_splitting=*/false,
+            /*disable_padding=*/false),
+        cost_model, &stats);
+
+    std::deque<LoadRequest> requests;
+    absl::BlockingCounter done(arrivals->size());
+    InjectArrivals(*arrivals, [&](const Arrival& arrival) {
+      LoadRequest& request = requests.emplace_back();
+      request.input = Tensor(DT_FLOAT, TensorShape({arrival.task_size, 16}));
+      request.input.flat<float>().setZero();
+      request.inputs = {TensorValue(&request.input)};
+      request.params.device = device.get();
+      request.params.op_kernel = kernel.get();
+      request.params.inputs = request.inputs;
+      request.context = std::make_unique<OpKernelContext>(&request.params);
+
+      const uint64 start_micros = Env::Default()->NowMicros();
+      const absl::Status status = resource->RegisterInput(
+          /*guid=*/requests.size(), request.context.get(),
+          /*batcher_queue_name=*/"load",
+          []() -> absl::StatusOr<
+                   std::unique_ptr<BatchResourceBase::BatchTask>> {
+            return std::make_unique<BatchResourceBase::BatchTask>();
+          },
+          [&stats, &done, start_micros, task_size = arrival.task_size] {
+            stats.RecordTask(task_size,
+                             Env::Default()->NowMicros() - start_micros);
+            done.DecrementCount();
+          });
+      if (!status.ok()) {
+        stats.RecordRejection();
+        done.DecrementCount();
+      }
+    });
+    done.Wait();
+    resource->Unref();
+  }
+  state.SetLabel(stats.Report());
+}
+BENCHMARK(BM_BatchResourceBase)
+    ->UseRealTime()
+    ->Iterations(1)
+    ->ArgNames({"arrivals", "qps", "timeout"})
+    ->ArgsProduct({{kPoisson, kBursty, kTrace}, {1000, 5000}, {0, 1000, 5000}});
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  const std::vector<tensorflow::Flag> flag_list = {
+      tensorflow::Flag(
+          "batching_load_duration_secs",
+          &tensorflow::serving::load_benchmark_duration_secs,
+          "Duration of the generated Poisson and bursty arrival processes."),
+      tensorflow::Flag("batching_load_trace_file",
+                       &tensorflow::serving::load_benchmark_trace_file,
+                       "Trace of arrivals to replay; one line per arrival "
+                       "with its time in microseconds and optional task "
+                       "size."),
+      tensorflow::Flag("batching_load_trace_time_scale",
+                       &tensorflow::serving::load_benchmark_trace_time_scale,
+                       "Factor applied to the arrival times of the trace.")};
+  if (!tensorflow::Flags::Parse(&argc, argv, flag_list)) {
+    std::cout << tensorflow::Flags::Usage(argv[0], flag_list);
+    return -1;
+  }
+
+  ::benchmark::Initialize(&argc, argv);
+  tensorflow::port::InitMain(argv[0], &argc, &argv);
+  ::benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,212 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/shape_bucketing.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/algorithm/container.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+template <typename T>
+void PadDimension(const Tensor& input, int dimension, int64_t size,
+                  Tensor* output) {
+  int64_t outer_size = 1;
+  for (int i = 0; i < dimension; ++i) {
+    outer_size *= input.dim_size(i);
+  }
+  int64_t inner_size = 1;
+  for (int i = dimension + 1; i < input.dims(); ++i) {
+    inner_size *= input.dim_size(i);
+  }
+  const int64_t input_size = input.dim_size(dimension);
+
+  auto input_shaped = input.shaped<T, 3>({outer_size, input_size, inner_size});
+  auto output_shaped = output->shaped<T, 3>({outer_size, size, inner_size});
+  output_shaped.setConstant(T());
+  const Eigen::DSizes<Eigen::DenseIndex, 3> offsets{0, 0, 0};
+  const Eigen::DSizes<Eigen::DenseIndex, 3> extents{
+      static_cast<Eigen::DenseIndex>(outer_size),
+      static_cast<Eigen::DenseIndex>(input_size),
+      static_cast<Eigen::DenseIndex>(inner_size)};
+  output_shaped.slice(offsets, extents) = input_shaped;
+}
+
+template <typename T>
+void SliceDimension(const Tensor& input, int dimension, int64_t size,
+                    Tensor* output) {
+  int64_t outer_size = 1;
+  for (int i = 0; i < dimension; ++i) {
+    outer_size *= input.dim_size(i);
+  }
+  int64_t inner_size = 1;
+  for (int i = dimension + 1; i < input.dims(); ++i) {
+    inner_size *= input.dim_size(i);
+  }
+  const int64_t input_size = input.dim_size(dimension);
+
+  auto input_shaped = input.shaped<T, 3>({outer_size, input_size, inner_size});
+  auto output_shaped = output->shaped<T, 3>({outer_size, size, inner_size});
+  const Eigen::DSizes<Eigen::DenseIndex, 3> offsets{0, 0, 0};
+  const Eigen::DSizes<Eigen::DenseIndex, 3> extents{
+      static_cast<Eigen::DenseIndex>(outer_size),
+      static_cast<Eigen::DenseIndex>(size),
+      static_cast<Eigen::DenseIndex>(inner_size)};
+  output_shaped = input_shaped.slice(offsets, extents);
+}
+
+}  // namespace
+
+absl::Status ValidateShapeBucketingOptions(
+    const ShapeBucketingOptions& options) {
+  if (options.dimension <= 0) {
+    return errors::InvalidArgument(
+        "Shape bucketing dimension must be positive; was ", options.dimension);
+  }
+  if (options.boundaries.empty()) {
+    return errors::InvalidArgument("Shape bucket boundaries must be non-empty");
+  }
+  for (int i = 0; i < options.boundaries.size(); ++i) {
+    if (options.boundaries[i] <= 0 ||
+        (i > 0 && options.boundaries[i] <= options.boundaries[i - 1])) {
+      return errors::InvalidArgument(
+          "Shape bucket boundaries must be positive and increasing; got [",
+          absl::StrJoin(options.boundaries, ","), "]");
+    }
+  }
+  if (!options.padded_output_inputs.empty() &&
+      options.padded_output_inputs.size() != options.padded_outputs.size()) {
+    return errors::InvalidArgument(
+        "Shape bucketing needs an input for each of the ",
+        options.padded_outputs.size(), " padded outputs; got ",
+        options.padded_output_inputs.size());
+  }
+  for (const std::vector<int>* indices :
+       {&options.padded_outputs, &options.padded_output_inputs}) {
+    if (absl::c_any_of(*indices, [](int index) { return index < 0; })) {
+      return errors::InvalidArgument(
+          "Shape bucketing indices must be non-negative; got [",
+          absl::StrJoin(*indices, ","), "]");
+    }
+  }
+  return absl::OkStatus();
+}
+
+int64_t BucketBoundary(int64_t size, const ShapeBucketingOptions& options) {
+  auto it = absl::c_lower_bound(options.boundaries, size);
+  return it == options.boundaries.end() ? size : *it;
+}
+
+std::optional<std::string> ShapeBucketKey(
+    absl::Span<const Tensor> inputs, const ShapeBucketingOptions& options) {
+  std::string key;
+  bool bucketed = false;
+  for (int i = 0; i < inputs.size(); ++i) {
+    if (i > 0) absl::StrAppend(&key, ";");
+    if (inputs[i].dims() <= options.dimension) continue;
+    const int64_t size = inputs[i].dim_size(options.dimension);
+    if (size > options.boundaries.back()) return std::nullopt;
+    absl::StrAppend(&key, BucketBoundary(size, options));
+    bucketed = true;
+  }
+  if (!bucketed) return std::nullopt;
+  return key;
+}
+
+absl::Status PadToBucket(const Tensor& input,
+                         const ShapeBucketingOptions& options, Tensor* output) {
+  if (input.dims() <= options.dimension) {
+    if (output != &input) *output = input;
+    return absl::OkStatus();
+  }
+  const int64_t size = input.dim_size(options.dimension);
+  const int64_t boundary = BucketBoundary(size, options);
+  if (boundary == size) {
+    if (output != &input) *output = input;
+    return absl::OkStatus();
+  }
+
+  TensorShape padded_shape = input.shape();
+  padded_shape.set_dim(options.dimension, boundary);
+  Tensor padded(input.dtype(), padded_shape);
+  switch (input.dtype()) {
+#define CASE(type)                                                   \
+  case DataTypeToEnum<type>::value:                                  \
+    PadDimension<type>(input, options.dimension, boundary, &padded); \
+    break;
+    TF_CALL_POD_TYPES(CASE);
+    TF_CALL_tstring(CASE);
+#undef CASE
+    default:
+      return errors::InvalidArgument(
+          "Shape bucketing does not support data type ",
+          DataTypeString(input.dtype()));
+  }
+  *output = std::move(padded);
+  return absl::OkStatus();
+}
+
+absl::Status UnpadFromBucket(const Tensor& output,
+                             const ShapeBucketingOptions& options,
+                             int64_t size, Tensor* unpadded) {
+  const int64_t padded_size = BucketBoundary(size, options);
+  if (output.dims() <= options.dimension ||
+      output.dim_size(options.dimension) != padded_size) {
+    return errors::InvalidArgument(
+        "Expected a padded output of size ", padded_size, " along dimension ",
+        options.dimension, "; got shape ", output.shape().DebugString());
+  }
+  if (size == padded_size) {
+    if (unpadded != &output) *unpadded = output;
+    return absl::OkStatus();
+  }
+
+  TensorShape shape = output.shape();
+  shape.set_dim(options.dimension, size);
+  Tensor sliced(output.dtype(), shape);
+  switch (output.dtype()) {
+#define CASE(type)                                                  \
+  case DataTypeToEnum<type>::value:                                 \
+    SliceDimension<type>(output, options.dimension, size, &sliced); \
+    break;
+    TF_CALL_POD_TYPES(CASE);
+    TF_CALL_tstring(CASE);
+#undef CASE
+    default:
+      return errors::InvalidArgument(
+          "Shape bucketing does not support data type ",
+          DataTypeString(output.dtype()));
+  }
+  *unpadded = std::move(sliced);
+  return absl::OkStatus();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,95 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_SHAPE_BUCKETING_H_
+#define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_SHAPE_BUCKETING_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/tensor.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Shape bucketing lets tasks whose inputs differ in one non-batch dimension
+// (e.g. the sequence length) be batched without padding everything to the
+// largest size: every task is assigned to a bucket keyed by its input shapes,
+// with that dimension rounded up to a bucket boundary, and only tasks of the
+// same bucket are batched together after padding to the boundary.
+struct ShapeBucketingOptions {
+  // The dimension of the input tensors whose size varies across tasks. Must be
+  // positive, since dimension 0 is the batch dimension. Inputs of lower rank
+  // are not padded.
+  int dimension = 1;
+
+  // Increasing bucket boundaries. Inputs are padded along `dimension` to the
+  // smallest boundary that is not smaller than their size. Tasks with an input
+  // larger than the last boundary are not bucketed.
+  std::vector<int64_t> boundaries;
+
+  // The outputs whose size along `dimension` is the one of an input, e.g. a
+  // per-token output of a sequence model. They keep the padded size unless
+  // listed here, in which case they are sliced back to the size of the input
+  // before padding. Outputs that only happen to have a padded size are not
+  // listed, e.g. logits with as many classes as a bucket boundary.
+  std::vector<int> padded_outputs;
+
+  // The input that each of `padded_outputs` takes its size from. If empty,
+  // they all take the size of the first input that has `dimension`.
+  std::vector<int> padded_output_inputs;
+};
+
+absl::Status ValidateShapeBucketingOptions(
+    const ShapeBucketingOptions& options);
+
+// Returns the size along `options.dimension` of the bucket an input of size
+// `size` falls into.
+int64_t BucketBoundary(int64_t size, const ShapeBucketingOptions& options);
+
+// Returns a key identifying the bucket of a task with `inputs`, made of the
+// bucket boundary of every input along `options.dimension`, so that there is a
+// bounded number of keys. Returns std::nullopt if an input is larger than the
+// last boundary, or if no input has the bucketed dimension: such tasks are not
+// padded and are batched as without bucketing. As without bucketing, the
+// inputs of tasks with equal keys can only be concatenated if their other
+// non-batch dimensions match.
+std::optional<std::string> ShapeBucketKey(absl::Span<const Tensor> inputs,
+                                          const ShapeBucketingOptions& options);
+
+// Pads `input` along `options.dimension` up to its bucket boundary, with zeros
+// (or empty strings). If no padding is needed, `output` is set to `input`
+// without copying. `output` may point to `input`.
+absl::Status PadToBucket(const Tensor& input,
+                         const ShapeBucketingOptions& options, Tensor* output);
+
+// Undoes PadToBucket() on an output of a task whose aligned input had size
+// `size` along `options.dimension`: slices `output` back from the bucket
+// boundary to `size` along that dimension. If no padding was needed,
+// `unpadded` is set to `output` without copying. Returns InvalidArgument if
+// `output` doesn't have the bucket boundary as its size along that dimension.
+// `unpadded` may point to `output`.
+absl::Status UnpadFromBucket(const Tensor& output,
+                             const ShapeBucketingOptions& options,
+                             int64_t size, Tensor* unpadded);
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_SHAPE_BUCKETING_H_
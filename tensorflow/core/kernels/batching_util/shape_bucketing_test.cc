@@ -0,0 +1,185 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/shape_bucketing.h"
+
+#include <optional>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/status/status.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+ShapeBucketingOptions TestOptions() {
+  ShapeBucketingOptions options;
+  options.dimension = 1;
+  options.boundaries = {4, 8, 16};
+  return options;
+}
+
+TEST(ShapeBucketingTest, ValidateOptions) {
+  TF_EXPECT_OK(ValidateShapeBucketingOptions(TestOptions()));
+
+  ShapeBucketingOptions options = TestOptions();
+  options.dimension = 0;
+  EXPECT_EQ(ValidateShapeBucketingOptions(options).code(),
+            absl::StatusCode::kInvalidArgument);
+
+  options = TestOptions();
+  options.boundaries = {};
+  EXPECT_EQ(ValidateShapeBucketingOptions(options).code(),
+            absl::StatusCode::kInvalidArgument);
+
+  options = TestOptions();
+  options.boundaries = {8, 4};
+  EXPECT_EQ(ValidateShapeBucketingOptions(options).code(),
+            absl::StatusCode::kInvalidArgument);
+
+  options = TestOptions();
+  options.padded_outputs = {0, 2};
+  TF_EXPECT_OK(ValidateShapeBucketingOptions(options));
+  options.padded_output_inputs = {1, 0};
+  TF_EXPECT_OK(ValidateShapeBucketingOptions(options));
+  options.padded_output_inputs = {1};
+  EXPECT_EQ(ValidateShapeBucketingOptions(options).code(),
+            absl::StatusCode::kInvalidArgument);
+  options.padded_output_inputs = {1, -1};
+  EXPECT_EQ(ValidateShapeBucketingOptions(options).code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST(ShapeBucketingTest, BucketBoundary) {
+  const ShapeBucketingOptions options = TestOptions();
+  EXPECT_EQ(BucketBoundary(1, options), 4);
+  EXPECT_EQ(BucketBoundary(4, options), 4);
+  EXPECT_EQ(BucketBoundary(5, options), 8);
+  EXPECT_EQ(BucketBoundary(16, options), 16);
+  EXPECT_EQ(BucketBoundary(17, options), 17);
+}
+
+TEST(ShapeBucketingTest, ShapeBucketKey) {
+  const ShapeBucketingOptions options = TestOptions();
+  const Tensor ids(DT_INT32, TensorShape({2, 5}));
+  const Tensor embeddings(DT_FLOAT, TensorShape({2, 6, 3}));
+  const Tensor lengths(DT_INT32, TensorShape({2}));
+
+  EXPECT_EQ(ShapeBucketKey({ids}, options), "8");
+  EXPECT_EQ(ShapeBucketKey({ids, embeddings, lengths}, options), "8;8;");
+  // Same bucket, different batch size and length.
+  EXPECT_EQ(ShapeBucketKey({Tensor(DT_INT32, TensorShape({7, 8}))}, options),
+            ShapeBucketKey({ids}, options));
+  // Only the bucketed dimension is part of the key.
+  EXPECT_EQ(
+      ShapeBucketKey({Tensor(DT_FLOAT, TensorShape({2, 6, 4}))}, options),
+      ShapeBucketKey({embeddings}, options));
+}
+
+TEST(ShapeBucketingTest, ShapeBucketKeyWithoutBucket) {
+  const ShapeBucketingOptions options = TestOptions();
+  // Larger than the last boundary.
+  EXPECT_EQ(ShapeBucketKey({Tensor(DT_INT32, TensorShape({2, 5})),
+                            Tensor(DT_INT32, TensorShape({2, 17}))},
+                           options),
+            std::nullopt);
+  // No input has the bucketed dimension.
+  EXPECT_EQ(ShapeBucketKey({Tensor(DT_INT32, TensorShape({2}))}, options),
+            std::nullopt);
+}
+
+TEST(ShapeBucketingTest, PadToBucket) {
+  const ShapeBucketingOptions options = TestOptions();
+  const Tensor input = test::AsTensor<int32>({1, 2, 3, 4, 5, 6}, {2, 3});
+
+  Tensor padded;
+  TF_ASSERT_OK(PadToBucket(input, options, &padded));
+  test::ExpectTensorEqual<int32>(
+      padded, test::AsTensor<int32>({1, 2, 3, 0, 4, 5, 6, 0}, {2, 4}));
+}
+
+TEST(ShapeBucketingTest, PadToBucketInnerDimensions) {
+  const ShapeBucketingOptions options = TestOptions();
+  const Tensor input =
+      test::AsTensor<tstring>({"a", "b", "c", "d", "e", "f"}, {1, 3, 2});
+
+  Tensor padded;
+  TF_ASSERT_OK(PadToBucket(input, options, &padded));
+  test::ExpectTensorEqual<tstring>(
+      padded,
+      test::AsTensor<tstring>({"a", "b", "c", "d", "e", "f", "", ""},
+                              {1, 4, 2}));
+}
+
+TEST(ShapeBucketingTest, PadToBucketWithoutPadding) {
+  const ShapeBucketingOptions options = TestOptions();
+  Tensor input = test::AsTensor<float>({1, 2, 3, 4}, {1, 4});
+  Tensor output;
+  TF_ASSERT_OK(PadToBucket(input, options, &output));
+  EXPECT_TRUE(output.SharesBufferWith(input));
+
+  // Lower rank than the bucketed dimension.
+  Tensor vector = test::AsTensor<float>({1, 2, 3}, {3});
+  TF_ASSERT_OK(PadToBucket(vector, options, &vector));
+  test::ExpectTensorEqual<float>(vector, test::AsTensor<float>({1, 2, 3}));
+}
+
+TEST(ShapeBucketingTest, UnpadFromBucket) {
+  const ShapeBucketingOptions options = TestOptions();
+  const Tensor output =
+      test::AsTensor<int32>({1, 2, 3, 0, 4, 5, 6, 0}, {2, 4});
+
+  Tensor unpadded;
+  TF_ASSERT_OK(UnpadFromBucket(output, options, /*size=*/3, &unpadded));
+  test::ExpectTensorEqual<int32>(
+      unpadded, test::AsTensor<int32>({1, 2, 3, 4, 5, 6}, {2, 3}));
+
+  // Outputs of unpadded inputs are kept.
+  TF_ASSERT_OK(UnpadFromBucket(output, options, /*size=*/4, &unpadded));
+  EXPECT_TRUE(unpadded.SharesBufferWith(output));
+}
+
+TEST(ShapeBucketingTest, UnpadFromBucketWithoutPaddedSize) {
+  const ShapeBucketingOptions options = TestOptions();
+  const Tensor output(DT_INT32, TensorShape({2, 4}));
+  Tensor unpadded;
+  // Inputs of size 5 are padded to 8.
+  EXPECT_EQ(UnpadFromBucket(output, options, /*size=*/5, &unpadded).code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(UnpadFromBucket(Tensor(DT_INT32, TensorShape({2})), options,
+                            /*size=*/3, &unpadded)
+                .code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST(ShapeBucketingTest, UnpadFromBucketInnerDimensions) {
+  const ShapeBucketingOptions options = TestOptions();
+  Tensor output = test::AsTensor<tstring>(
+      {"a", "b", "c", "d", "e", "f", "", ""}, {1, 4, 2});
+  TF_ASSERT_OK(UnpadFromBucket(output, options, /*size=*/3, &output));
+  test::ExpectTensorEqual<tstring>(
+      output,
+      test::AsTensor<tstring>({"a", "b", "c", "d", "e", "f"}, {1, 3, 2}));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -35,6 +35,7 @@ limitations under the License.
 #include "absl/strings/str_format.h"
 #include "absl/time/clock.h"
 #include "tensorflow/core/kernels/batching_util/batch_input_task.h"
+#include "tensorflow/core/kernels/batching_util/batch_latency_controller.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler_utils.h"
 #include "tensorflow/core/kernels/batching_util/batch_stats.h"
@@ -249,6 +250,13 @@ class SharedBatchScheduler
     // requested.
     ModelBatchStats* model_batch_stats = nullptr;
 
+    // If positive, the queue tunes its batch timeout and the batch size at
+    // which it considers a batch full online, aiming for this 99th percentile
+    // latency of its (high priority) tasks; see BatchLatencyController.
+    // `batch_timeout_micros` and the maximum execution batch size then act as
+    // upper bounds rather than fixed settings.
+    int64_t target_p99_latency_micros = 0;
+
     // If true, queue implementation would split high priority and low priority
     // inputs into two sub queues.
     bool enable_priority_queue = false;
@@ -382,9 +390,13 @@ class Queue {
   //   used are an implementation detail of PeekBatchPriority().
   using BatchPriorityKey = std::pair<int, int64_t>;
 
+  // `latency_controller`, if non-null, overrides the batch timeout and the
+  // maximum execution batch size used to decide when the open batch is
+  // schedulable.
   Queue(const typename SharedBatchScheduler<TaskType>::QueueOptions& options,
         Env* env, ProcessBatchCallback process_batch_callback,
-        SchedulableBatchCallback schedulable_batch_callback);
+        SchedulableBatchCallback schedulable_batch_callback,
+        std::unique_ptr<BatchLatencyController> latency_controller = nullptr);
 
   // Illegal to destruct unless the queue is empty.
   ~Queue();
@@ -552,6 +564,10 @@ class Queue {
   // schedulable.
   SchedulableBatchCallback schedulable_batch_callback_;
 
+  // Tunes the batch timeout and batch size if `target_p99_latency_micros` is
+  // set. Null otherwise.
+  const std::unique_ptr<BatchLatencyController> latency_controller_;
+
   mutable mutex mu_;
 
   // Whether this queue can accept new tasks. This variable is monotonic: it
@@ -729,6 +745,31 @@ absl::Status SharedBatchScheduler<TaskType>::AddQueueAfterRewritingOptions(
         options.max_execution_batch_size);
   }
 
+  if (options.target_p99_latency_micros < 0) {
+    return errors::InvalidArgument(
+        "target_p99_latency_micros must be non-negative; was ",
+        options.target_p99_latency_micros);
+  }
+
+  std::unique_ptr<BatchLatencyController> latency_controller;
+  if (options.target_p99_latency_micros > 0) {
+    BatchLatencyController::Options controller_options;
+    controller_options.target_p99_latency_micros =
+        options.target_p99_latency_micros;
+    controller_options.max_batch_timeout_micros = options.batch_timeout_micros;
+    controller_options.max_batch_size =
+        options.enable_large_batch_splitting
+            ? options.max_execution_batch_size
+            : options.input_batch_size_limit;
+    controller_options.allowed_batch_sizes = options.allowed_batch_sizes;
+    controller_options.num_batch_threads = options_.num_batch_threads;
+    controller_options.model_batch_stats = options.model_batch_stats;
+    TF_RETURN_IF_ERROR(
+        BatchLatencyController::ValidateOptions(controller_options));
+    latency_controller =
+        std::make_unique<BatchLatencyController>(controller_options);
+  }
+
   auto schedulable_batch_callback = [this] {
     mutex_lock l(mu_);
     schedulable_batch_cv_.notify_one();
@@ -736,7 +777,7 @@ absl::Status SharedBatchScheduler<TaskType>::AddQueueAfterRewritingOptions(
   auto internal_queue =
       std::unique_ptr<internal::Queue<TaskType>>(new internal::Queue<TaskType>(
           options, options_.env, process_batch_callback,
-          schedulable_batch_callback));
+          schedulable_batch_callback, std::move(latency_controller)));
   auto handle = std::unique_ptr<BatchScheduler<TaskType>>(
       new internal::QueueHandle<TaskType>(this->shared_from_this(),
                                           internal_queue.get()));
@@ -867,12 +908,14 @@ template <typename TaskType>
 Queue<TaskType>::Queue(
     const typename SharedBatchScheduler<TaskType>::QueueOptions& options,
     Env* env, ProcessBatchCallback process_batch_callback,
-    SchedulableBatchCallback schedulable_batch_callback)
+    SchedulableBatchCallback schedulable_batch_callback,
+    std::unique_ptr<BatchLatencyController> latency_controller)
     : options_(options),
       env_(env),
       max_execution_batch_size_(GetMaxExecutionBatchSize(options_)),
       process_batch_callback_(process_batch_callback),
-      schedulable_batch_callback_(schedulable_batch_callback) {
+      schedulable_batch_callback_(schedulable_batch_callback),
+      latency_controller_(std::move(latency_controller)) {
   // Set the higher 32 bits of traceme_context_id_counter_ to be the creation
   // time of the queue. This prevents the batches in different queues to have
   // the same traceme_context_id_counter_.
@@ -1050,7 +1093,11 @@ absl::Status Queue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
       TF_RETURN_IF_ERROR(ValidateLowPriorityTaskQueueCapacity(**task));
       low_priority_tasks_.AddTask(std::move(*task), env_->NowMicros());
     } else {
+      const size_t task_size = (*task)->size();
       TF_RETURN_IF_ERROR(ScheduleWithoutOrEagerSplitImpl(task));
+      if (latency_controller_ != nullptr) {
+        latency_controller_->RecordArrival(env_->NowMicros(), task_size);
+      }
     }
 
     // Check if the batch queue has a schedulable batch and mark it schedulable
@@ -1315,6 +1362,11 @@ void Queue<TaskType>::ProcessBatch(
       tsl::profiler::ContextType::kSharedBatchScheduler,
       batch->traceme_context_id());
 
+  const int64_t batch_size = batch->size();
+  const std::optional<uint64> earliest_task_start_time_micros =
+      batch->EarliestTaskStartTime();
+  const uint64 start_time_micros = env_->NowMicros();
+
   if (std::holds_alternative<ProcessBatchCallbackWithoutPaddingTasks>(
           process_batch_callback_)) {
     std::get<ProcessBatchCallbackWithoutPaddingTasks>(process_batch_callback_)(
@@ -1324,6 +1376,13 @@ void Queue<TaskType>::ProcessBatch(
         std::move(batch), std::move(padding_task));
   }
 
+  if (latency_controller_ != nullptr &&
+      earliest_task_start_time_micros.has_value()) {
+    latency_controller_->RecordBatch(
+        batch_size, *earliest_task_start_time_micros, start_time_micros,
+        env_->NowMicros());
+  }
+
   {
     mutex_lock l(mu_);
     --num_batches_being_processed_;
@@ -1413,6 +1472,15 @@ Queue<TaskType>::PeekBatchPriorityImpl() const {
   size_t effective_batch_size = open_batch->size();
   uint64 effective_start_time_micros = open_batch_start_time_micros_;
   int64_t effective_batch_timeout_micros = options_.batch_timeout_micros;
+  size_t effective_max_batch_size = max_execution_batch_size();
+  if (latency_controller_ != nullptr) {
+    effective_batch_timeout_micros =
+        std::min(effective_batch_timeout_micros,
+                 latency_controller_->batch_timeout_micros());
+    effective_max_batch_size =
+        std::min<size_t>(effective_max_batch_size,
+                         latency_controller_->max_batch_size());
+  }
   if (effective_batch_size == 0) {
     // open_batch_start_time_micros_ is not valid for an empty batch.
     effective_start_time_micros = env_->NowMicros();
@@ -1441,7 +1509,7 @@ Queue<TaskType>::PeekBatchPriorityImpl() const {
   }
 
   bool schedulable = closed_ ||
-                     effective_batch_size >= max_execution_batch_size() ||
+                     effective_batch_size >= effective_max_batch_size ||
                      env_->NowMicros() >= effective_start_time_micros +
                                               effective_batch_timeout_micros;
 
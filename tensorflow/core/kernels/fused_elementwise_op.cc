@@ -0,0 +1,353 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/strings/str_join.h"
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/cwise_ops.h"
+#include "tensorflow/core/kernels/cwise_ops_common.h"
+
+namespace tensorflow {
+
+// Number of elements evaluated by every op of the fused program before moving
+// on to the next block. All intermediate blocks of a program with a dozen ops
+// stay resident in L1/L2, so intermediate results never reach main memory.
+static constexpr int64_t kFusedElementwiseBlockSize = 1024;
+
+// Element-wise functions supported by the _FusedElementwise kernel. The list
+// of supported ops must be consistent with the FuseElementwiseChains stage of
+// the ArithmeticOptimizer.
+template <typename T>
+struct FusedElementwiseFunctions {
+  using ConstBlock = typename TTypes<T>::ConstFlat;
+  using Block = typename TTypes<T>::Flat;
+
+  using UnaryFn = void (*)(const ConstBlock&, Block*);
+  using BinaryFn = void (*)(const ConstBlock&, const ConstBlock&, Block*);
+
+  struct Registration {
+    UnaryFn unary_fn = nullptr;
+    BinaryFn binary_fn = nullptr;
+    int cost = 0;
+  };
+
+  static const std::unordered_map<string, Registration>& Get() {
+    static const auto* fns = new std::unordered_map<string, Registration>({
+        Unary<functor::abs<T>>("Abs"),
+        Unary<functor::exp<T>>("Exp"),
+        Unary<functor::log<T>>("Log"),
+        Unary<functor::log1p<T>>("Log1p"),
+        Unary<functor::neg<T>>("Neg"),
+        Unary<functor::inverse<T>>("Reciprocal"),
+        Unary<functor::rsqrt<T>>("Rsqrt"),
+        Unary<functor::sigmoid<T>>("Sigmoid"),
+        Unary<functor::sqrt<T>>("Sqrt"),
+        Unary<functor::square<T>>("Square"),
+        Unary<functor::tanh<T>>("Tanh"),
+        {"Relu",
+         {&ComputeRelu, nullptr,
+          Eigen::internal::functor_traits<
+              Eigen::internal::scalar_max_op<T>>::Cost}},
+        Binary<functor::add<T>>("Add"),
+        Binary<functor::add<T>>("AddV2"),
+        Binary<functor::sub<T>>("Sub"),
+        Binary<functor::mul<T>>("Mul"),
+        Binary<functor::div<T>>("Div"),
+        Binary<functor::div<T>>("RealDiv"),
+        Binary<functor::maximum<T>>("Maximum"),
+        Binary<functor::minimum<T>>("Minimum"),
+        Binary<functor::squared_difference<T>>("SquaredDifference"),
+    });
+    return *fns;
+  }
+
+ private:
+  template <typename Functor>
+  static void ComputeUnary(const ConstBlock& in, Block* out) {
+    *out = in.unaryExpr(typename Functor::func());
+  }
+
+  template <typename Functor>
+  static void ComputeBinary(const ConstBlock& x, const ConstBlock& y,
+                            Block* out) {
+    *out = x.binaryExpr(y, typename Functor::func());
+  }
+
+  static void ComputeRelu(const ConstBlock& in, Block* out) {
+    *out = in.cwiseMax(static_cast<T>(0));
+  }
+
+  template <typename Functor>
+  static std::pair<const string, Registration> Unary(const string& name) {
+    return {name,
+            {&ComputeUnary<Functor>, nullptr,
+             Eigen::internal::functor_traits<typename Functor::func>::Cost}};
+  }
+
+  template <typename Functor>
+  static std::pair<const string, Registration> Binary(const string& name) {
+    return {name,
+            {nullptr, &ComputeBinary<Functor>,
+             Eigen::internal::functor_traits<typename Functor::func>::Cost}};
+  }
+};
+
+// Evaluates a fused program of element-wise ops in a single blocked pass over
+// memory: every block of the output is computed by running the whole program
+// on a block-sized slice of the inputs, with intermediate results kept in
+// per-shard scratch buffers.
+template <typename T>
+class FusedElementwiseOp : public OpKernel {
+ public:
+  using Functions = FusedElementwiseFunctions<T>;
+  using ConstBlock = typename Functions::ConstBlock;
+  using Block = typename Functions::Block;
+
+  explicit FusedElementwiseOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    std::vector<string> op_names;
+    std::vector<int> op_inputs;
+    OP_REQUIRES_OK(context, context->GetAttr("op_names", &op_names));
+    OP_REQUIRES_OK(context, context->GetAttr("op_inputs", &op_inputs));
+
+    const int num_inputs = context->num_inputs();
+    OP_REQUIRES(context, !op_names.empty(),
+                errors::InvalidArgument(
+                    "Fused element-wise program must have at least one op"));
+    OP_REQUIRES(context, op_inputs.size() == 2 * op_names.size(),
+                errors::InvalidArgument(
+                    "Expected two operands per op, got ", op_inputs.size(),
+                    " operands for ", op_names.size(), " ops"));
+
+    const auto& fns = Functions::Get();
+    for (int i = 0; i < op_names.size(); ++i) {
+      auto it = fns.find(op_names[i]);
+      OP_REQUIRES(context, it != fns.end(),
+                  errors::InvalidArgument(
+                      "Do not have a compute function registered for op: ",
+                      op_names[i]));
+
+      Instruction instr;
+      instr.reg = &it->second;
+      instr.operands[0] = op_inputs[2 * i];
+      instr.operands[1] = op_inputs[2 * i + 1];
+
+      const int num_operands = instr.reg->binary_fn != nullptr ? 2 : 1;
+      for (int k = 0; k < 2; ++k) {
+        const int operand = instr.operands[k];
+        if (k >= num_operands) {
+          OP_REQUIRES(context, operand == -1,
+                      errors::InvalidArgument("Unary op ", op_names[i],
+                                              " must have -1 as its second "
+                                              "operand, got ",
+                                              operand));
+          continue;
+        }
+        OP_REQUIRES(context, operand >= 0 && operand < num_inputs + i,
+                    errors::InvalidArgument(
+                        "Operand ", k, " of op #", i, " (", op_names[i],
+                        ") must refer to an input or to a preceding op, got ",
+                        operand));
+      }
+      cost_ += instr.reg->cost;
+      program_.push_back(instr);
+    }
+
+    VLOG(2) << "Fused element-wise program: [" << absl::StrJoin(op_names, ", ")
+            << "]; cost=" << cost_;
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const int num_inputs = ctx->num_inputs();
+
+    // The output has the shape of the largest input; all other inputs must be
+    // scalars or rows broadcasted along the innermost dimension.
+    int full_input = 0;
+    for (int i = 1; i < num_inputs; ++i) {
+      const Tensor& in = ctx->input(i);
+      const Tensor& full = ctx->input(full_input);
+      if (in.NumElements() > full.NumElements() ||
+          (in.NumElements() == full.NumElements() && in.dims() > full.dims())) {
+        full_input = i;
+      }
+    }
+    const TensorShape& out_shape = ctx->input(full_input).shape();
+    const int64_t inner_dim =
+        out_shape.dims() > 0 ? out_shape.dim_size(out_shape.dims() - 1) : 1;
+
+    std::vector<InputKind> kinds(num_inputs);
+    std::vector<int> forwardable;
+    for (int i = 0; i < num_inputs; ++i) {
+      const Tensor& in = ctx->input(i);
+      if (in.shape() == out_shape) {
+        kinds[i] = InputKind::kFull;
+        forwardable.push_back(i);
+      } else if (in.NumElements() == 1 && in.dims() <= out_shape.dims()) {
+        kinds[i] = InputKind::kScalar;
+      } else if (IsInnerBroadcast(in.shape(), out_shape)) {
+        kinds[i] = InputKind::kRow;
+      } else {
+        OP_REQUIRES(ctx, false,
+                    errors::InvalidArgument(
+                        "Input ", i, " of shape ", in.shape().DebugString(),
+                        " is not compatible with the fused output shape ",
+                        out_shape.DebugString()));
+      }
+    }
+
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->forward_input_or_allocate_output(
+                            forwardable, 0, out_shape, &out));
+    const int64_t num_elements = out_shape.num_elements();
+    if (num_elements == 0) return;
+
+    T* out_data = out->flat<T>().data();
+    const int num_ops = program_.size();
+
+    auto compute_fn = [&](int64_t begin, int64_t end) {
+      // Blocks are mapped as aligned Eigen tensors, so every buffer in the
+      // scratch space must start at a multiple of the packet size.
+      const int64_t block_size =
+          AlignBlockSize(std::min(kFusedElementwiseBlockSize, end - begin));
+
+      // Scratch space for the intermediate results and the broadcasted inputs
+      // of a single block. The last op writes straight into the output.
+      Eigen::Tensor<T, 1, Eigen::RowMajor, Eigen::DenseIndex> scratch(
+          (num_ops - 1 + num_inputs) * block_size);
+      auto op_buffer = [&](int op) { return scratch.data() + op * block_size; };
+      auto input_buffer = [&](int input) {
+        return scratch.data() + (num_ops - 1 + input) * block_size;
+      };
+
+      for (int i = 0; i < num_inputs; ++i) {
+        if (kinds[i] == InputKind::kScalar) {
+          std::fill_n(input_buffer(i), block_size,
+                      ctx->input(i).flat<T>()(0));
+        }
+      }
+
+      for (int64_t offset = begin; offset < end; offset += block_size) {
+        const int64_t len = std::min(block_size, end - offset);
+
+        for (int i = 0; i < num_inputs; ++i) {
+          if (kinds[i] == InputKind::kRow) {
+            TileRow(ctx->input(i).flat<T>().data(), inner_dim,
+                    offset, len, input_buffer(i));
+          }
+        }
+
+        auto operand_data = [&](int operand) -> const T* {
+          if (operand >= num_inputs) return op_buffer(operand - num_inputs);
+          if (kinds[operand] == InputKind::kFull) {
+            return ctx->input(operand).flat<T>().data() + offset;
+          }
+          return input_buffer(operand);
+        };
+
+        for (int op = 0; op < num_ops; ++op) {
+          const Instruction& instr = program_[op];
+          Block result(op == num_ops - 1 ? out_data + offset : op_buffer(op),
+                       len);
+          ConstBlock x(operand_data(instr.operands[0]), len);
+          if (instr.reg->binary_fn != nullptr) {
+            ConstBlock y(operand_data(instr.operands[1]), len);
+            instr.reg->binary_fn(x, y, &result);
+          } else {
+            instr.reg->unary_fn(x, &result);
+          }
+        }
+      }
+    };
+
+    const CPUDevice& device = ctx->eigen_device<CPUDevice>();
+    const int kOverheadCycles = num_ops * 10;
+    Eigen::TensorOpCost cost(/*bytes_loaded=*/sizeof(T) * num_inputs,
+                             /*bytes_stored=*/sizeof(T),
+                             kOverheadCycles + cost_);
+    device.parallelFor(num_elements, cost, AlignBlockSize,
+                       std::move(compute_fn));
+  }
+
+ private:
+  enum class InputKind { kFull, kScalar, kRow };
+
+  struct Instruction {
+    const typename Functions::Registration* reg = nullptr;
+    int operands[2] = {-1, -1};
+  };
+
+  using Packet = typename Eigen::internal::packet_traits<T>::type;
+  static constexpr int kPacketSize =
+      Eigen::internal::unpacket_traits<Packet>::size;
+
+  static inline int64_t AlignBlockSize(int64_t block_size) {
+    return (block_size + kPacketSize - 1) & ~(kPacketSize - 1);
+  }
+
+  // Returns true if `shape` is a row that is broadcasted along all but the
+  // innermost dimension of `out_shape`, e.g. [C] or [1, 1, C] for [N, H, C].
+  static bool IsInnerBroadcast(const TensorShape& shape,
+                               const TensorShape& out_shape) {
+    if (shape.dims() == 0 || shape.dims() > out_shape.dims()) return false;
+    if (shape.dim_size(shape.dims() - 1) !=
+        out_shape.dim_size(out_shape.dims() - 1)) {
+      return false;
+    }
+    for (int d = 0; d < shape.dims() - 1; ++d) {
+      if (shape.dim_size(d) != 1) return false;
+    }
+    return true;
+  }
+
+  // Copies elements [offset, offset + len) of `row` tiled to infinity into
+  // `dst`.
+  static void TileRow(const T* row, int64_t row_size, int64_t offset,
+                      int64_t len, T* dst) {
+    int64_t col = offset % row_size;
+    while (len > 0) {
+      const int64_t n = std::min(len, row_size - col);
+      std::copy_n(row + col, n, dst);
+      dst += n;
+      len -= n;
+      col = 0;
+    }
+  }
+
+  std::vector<Instruction> program_;
+  int cost_ = 0;
+};
+
+#define REGISTER_CPU(T)                                                    \
+  REGISTER_KERNEL_BUILDER(                                                 \
+      Name("_FusedElementwise").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedElementwiseOp<T>);
+
+REGISTER_CPU(float);
+REGISTER_CPU(Eigen::half);
+REGISTER_CPU(double);
+
+#undef REGISTER_CPU
+
+}  // namespace tensorflow
@@ -0,0 +1,126 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class FusedElementwiseOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(int num_inputs, const std::vector<string>& op_names,
+              const std::vector<int>& op_inputs) {
+    TF_ASSERT_OK(NodeDefBuilder("fused_elementwise", "_FusedElementwise")
+                     .Input(FakeInput(num_inputs, DT_FLOAT))
+                     .Attr("T", DT_FLOAT)
+                     .Attr("op_names", op_names)
+                     .Attr("op_inputs", op_inputs)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(FusedElementwiseOpTest, UnaryAndBinaryChain) {
+  // tanh(x * y) + x
+  MakeOp(2, {"Mul", "Tanh", "AddV2"}, {0, 1, 2, -1, 3, 0});
+  AddInputFromArray<float>(TensorShape({4}), {1, 2, 3, 4});
+  AddInputFromArray<float>(TensorShape({4}), {0.5, 0.25, -0.1, 0});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({4}));
+  test::FillValues<float>(&expected, {std::tanh(0.5f) + 1, std::tanh(0.5f) + 2,
+                                      std::tanh(-0.3f) + 3, 4});
+  test::ExpectClose(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, ScalarAndRowBroadcast) {
+  // relu((x - mean) * scale)
+  MakeOp(3, {"Sub", "Mul", "Relu"}, {0, 1, 3, 2, 4, -1});
+  AddInputFromArray<float>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  AddInputFromArray<float>(TensorShape({3}), {1, 3, 2});
+  AddInputFromArray<float>(TensorShape({}), {2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 3}));
+  test::FillValues<float>(&expected, {0, 0, 2, 6, 4, 8});
+  test::ExpectClose(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, LargeInputSpansManyBlocks) {
+  // (x + b)^2 with a row broadcast that does not divide the block size.
+  MakeOp(2, {"AddV2", "Square"}, {0, 1, 2, -1});
+  const int rows = 1000, cols = 7;
+  std::vector<float> x(rows * cols), b(cols), y(rows * cols);
+  for (int i = 0; i < cols; ++i) b[i] = i;
+  for (int i = 0; i < rows * cols; ++i) {
+    x[i] = i % 13;
+    y[i] = (x[i] + b[i % cols]) * (x[i] + b[i % cols]);
+  }
+  AddInputFromArray<float>(TensorShape({rows, cols}), x);
+  AddInputFromArray<float>(TensorShape({1, cols}), b);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({rows, cols}));
+  test::FillValues<float>(&expected, y);
+  test::ExpectClose(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, SizeNotMultipleOfPacketSize) {
+  // exp(x * s) - x, with scratch buffers for the intermediate results and the
+  // broadcasted scalar of a block whose size is not a multiple of a packet.
+  MakeOp(2, {"Mul", "Exp", "Sub"}, {0, 1, 2, -1, 3, 0});
+  const int size = 1031;
+  std::vector<float> x(size), y(size);
+  for (int i = 0; i < size; ++i) {
+    x[i] = (i % 11) * 0.1f;
+    y[i] = std::exp(x[i] * 0.5f) - x[i];
+  }
+  AddInputFromArray<float>(TensorShape({size}), x);
+  AddInputFromArray<float>(TensorShape({}), {0.5});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({size}));
+  test::FillValues<float>(&expected, y);
+  test::ExpectClose(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, RejectsInvalidProgram) {
+  TF_ASSERT_OK(NodeDefBuilder("fused_elementwise", "_FusedElementwise")
+                   .Input(FakeInput(1, DT_FLOAT))
+                   .Attr("T", DT_FLOAT)
+                   .Attr("op_names", {"Tanh", "Mul"})
+                   .Attr("op_inputs", {0, -1, 1, 2})
+                   .Finalize(node_def()));
+  EXPECT_FALSE(InitOp().ok());
+}
+
+TEST_F(FusedElementwiseOpTest, RejectsIncompatibleShapes) {
+  MakeOp(2, {"Mul"}, {0, 1});
+  AddInputFromArray<float>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  AddInputFromArray<float>(TensorShape({2, 1}), {1, 2});
+  EXPECT_FALSE(RunOpKernel().ok());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -475,6 +475,7 @@ class AssignVariableOp : public OpKernel {
     } else {
       *variable->tensor() = value;
     }
+    variable->MarkAllRowsDirty();
     variable->is_initialized = true;
   }
 
@@ -628,6 +629,7 @@ class AssignUpdateVariableOp : public OpKernel {
     functor::DenseUpdate<Device, T, Op> update_functor;
     update_functor(context->eigen_device<Device>(), var_tensor->flat<T>(),
                    value.flat<T>());
+    variable->MarkAllRowsDirty();
   }
 };
 
@@ -1185,6 +1187,12 @@ class ResourceScatterUpdateOp : public OpKernel {
     if (N > 0) {
       OP_REQUIRES_OK(
           c, DoScatter<Device, T, Index, op>(c, params, indices, updates, N));
+      if (isCPUDevice<Device>()) {
+        v->MarkRowsDirty(indices);
+      } else {
+        // The indices are in device memory.
+        v->MarkAllRowsDirty();
+      }
     }
   }
 };
@@ -15,23 +15,37 @@ limitations under the License.
 
 // See docs in ../ops/io_ops.cc.
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstring>
+#include <functional>
 #include <limits>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/resource_var.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/checkpoint_callback_manager.h"
 #include "tensorflow/core/kernels/save_restore_tensor.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"  // IWYU pragma: keep
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
@@ -90,6 +104,47 @@ void ValidateInputs(bool is_save_op, OpKernelContext* context,
   }
 }
 
+// Parses the non-empty slice spec "shape_spec" of "tensor" into the shape of
+// the full tensor and the slice that "tensor" holds.
+Status ParseSliceToSave(const string& shape_spec, const Tensor& tensor,
+                        TensorShape* shape, TensorSlice* slice) {
+  TensorShape slice_shape;
+  TF_RETURN_IF_ERROR(
+      checkpoint::ParseShapeAndSlice(shape_spec, shape, slice, &slice_shape));
+  if (!slice_shape.IsSameSize(tensor.shape())) {
+    return errors::InvalidArgument(
+        "Slice in shape_and_slice specification does not match the shape of "
+        "the tensor to  save: ",
+        shape_spec, ", tensor: ", tensor.shape().DebugString());
+  }
+  return absl::OkStatus();
+}
+
+// Adds "tensor" to "writer" under "tensor_name", as a slice of a larger tensor
+// if "shape_spec" is non-empty.
+Status AddTensorToBundle(const string& tensor_name, const string& shape_spec,
+                         const Tensor& tensor, BundleWriter* writer) {
+  if (shape_spec.empty()) return writer->Add(tensor_name, tensor);
+  TensorShape shape;
+  TensorSlice slice(tensor.dims());
+  TF_RETURN_IF_ERROR(ParseSliceToSave(shape_spec, tensor, &shape, &slice));
+  return writer->AddSlice(tensor_name, shape, slice, tensor);
+}
+
+Status GetCheckpointCallbackManager(
+    ResourceMgr* resource_manager,
+    checkpoint::CheckpointCallbackManager** checkpoint_callback_manager) {
+  return resource_manager
+      ->LookupOrCreate<checkpoint::CheckpointCallbackManager>(
+          resource_manager->default_container(),
+          std::string(checkpoint::kCheckpointCallbackManagerResourceName),
+          checkpoint_callback_manager,
+          [](checkpoint::CheckpointCallbackManager** out) {
+            *out = new checkpoint::CheckpointCallbackManager();
+            return absl::OkStatus();
+          });
+}
+
 }  // namespace
 
 // Saves a list of named tensors using the tensor bundle library.
@@ -120,26 +175,9 @@ class SaveV2 : public OpKernel {
       const Tensor& tensor = context->input(i + kFixedInputs);
       VLOG(2) << "Starting save of " << tensor_name;
 
-      if (!shape_and_slices_flat(i).empty()) {
-        const string& shape_spec = shape_and_slices_flat(i);
-        TensorShape shape;
-        TensorSlice slice(tensor.dims());
-        TensorShape slice_shape;
-
-        OP_REQUIRES_OK(context, checkpoint::ParseShapeAndSlice(
-                                    shape_spec, &shape, &slice, &slice_shape));
-        OP_REQUIRES(context, slice_shape.IsSameSize(tensor.shape()),
-                    errors::InvalidArgument("Slice in shape_and_slice "
-                                            "specification does not match the "
-                                            "shape of the tensor to  save: ",
-                                            shape_spec, ", tensor: ",
-                                            tensor.shape().DebugString()));
-
-        OP_REQUIRES_OK(context,
-                       writer.AddSlice(tensor_name, shape, slice, tensor));
-      } else {
-        OP_REQUIRES_OK(context, writer.Add(tensor_name, tensor));
-      }
+      OP_REQUIRES_OK(context,
+                     AddTensorToBundle(tensor_name, shape_and_slices_flat(i),
+                                       tensor, &writer));
 
       if (VLOG_IS_ON(5)) {
         if (tensor.dtype() == DT_FLOAT) {
@@ -166,18 +204,9 @@ class SaveV2 : public OpKernel {
     ResourceMgr* resource_manager = context->resource_manager();
     if (resource_manager != nullptr) {
       checkpoint::CheckpointCallbackManager* checkpoint_callback_manager;
-      OP_REQUIRES_OK(
-          context,
-          resource_manager
-              ->LookupOrCreate<checkpoint::CheckpointCallbackManager>(
-                  resource_manager->default_container(),
-                  std::string(
-                      checkpoint::kCheckpointCallbackManagerResourceName),
-                  &checkpoint_callback_manager,
-                  [](checkpoint::CheckpointCallbackManager** out) {
-                    *out = new checkpoint::CheckpointCallbackManager();
-                    return absl::OkStatus();
-                  }));
+      OP_REQUIRES_OK(context,
+                     GetCheckpointCallbackManager(
+                         resource_manager, &checkpoint_callback_manager));
       checkpoint_callback_manager->Save(prefix_string);
       checkpoint_callback_manager->Unref();
     }
@@ -185,6 +214,517 @@ class SaveV2 : public OpKernel {
 };
 REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
 
+namespace {
+
+constexpr char kAsyncSaveManagerResourceName[] = "AsyncSaveManager";
+
+// Tracks the checkpoints that AsyncSaveV2 writes in the background, keyed by
+// prefix, and owns the thread pool that writes them.
+class AsyncSaveManager : public ResourceBase {
+ public:
+  AsyncSaveManager()
+      : pool_(Env::Default(), "async_save_v2", port::MaxParallelism()) {}
+
+  std::string DebugString() const override { return "AsyncSaveManager"; }
+
+  thread::ThreadPool* pool() { return &pool_; }
+
+  // Registers a save of "prefix".  Fails if one is already in flight.
+  Status Start(const string& prefix) {
+    mutex_lock l(mu_);
+    auto it = saves_.find(prefix);
+    if (it != saves_.end()) {
+      if (!it->second.done) {
+        return errors::FailedPrecondition(
+            "An asynchronous save to ", prefix,
+            " is still in progress; wait for it before saving again.");
+      }
+      if (!it->second.status.ok()) {
+        LOG(WARNING) << "Dropping the unobserved error of the previous "
+                     << "asynchronous save to " << prefix << ": "
+                     << it->second.status;
+      }
+      saves_.erase(it);
+    }
+    saves_[prefix];
+    return absl::OkStatus();
+  }
+
+  // Records the result of the save of "prefix" and notifies its waiters.  The
+  // result is kept until it is observed by Wait() or Poll().
+  void Finish(const string& prefix, const Status& status) {
+    std::vector<std::function<void(const Status&)>> waiters;
+    {
+      mutex_lock l(mu_);
+      PendingSave& save = saves_[prefix];
+      save.done = true;
+      save.status = status;
+      waiters.swap(save.waiters);
+      if (!waiters.empty()) saves_.erase(prefix);
+    }
+    for (const auto& waiter : waiters) waiter(status);
+  }
+
+  // Calls "done" with the result of the save of "prefix" once it completes,
+  // or immediately with OK if no save of "prefix" is pending.
+  void Wait(const string& prefix, std::function<void(const Status&)> done) {
+    Status status;
+    {
+      mutex_lock l(mu_);
+      auto it = saves_.find(prefix);
+      if (it != saves_.end()) {
+        if (!it->second.done) {
+          it->second.waiters.push_back(std::move(done));
+          return;
+        }
+        status = it->second.status;
+        saves_.erase(it);
+      }
+    }
+    done(status);
+  }
+
+  // Returns false if the save of "prefix" is still in progress.  Otherwise
+  // returns true and sets "status" to its result.
+  bool Poll(const string& prefix, Status* status) {
+    mutex_lock l(mu_);
+    auto it = saves_.find(prefix);
+    if (it == saves_.end()) {
+      *status = absl::OkStatus();
+      return true;
+    }
+    if (!it->second.done) return false;
+    *status = it->second.status;
+    saves_.erase(it);
+    return true;
+  }
+
+ private:
+  struct PendingSave {
+    bool done = false;
+    Status status;
+    std::vector<std::function<void(const Status&)>> waiters;
+  };
+
+  mutex mu_;
+  absl::flat_hash_map<string, PendingSave> saves_ TF_GUARDED_BY(mu_);
+  // Declared last so that it is destroyed, and waits for the pending saves to
+  // finish, before the state they update.
+  thread::ThreadPool pool_;
+};
+
+Status GetAsyncSaveManager(OpKernelContext* context,
+                           AsyncSaveManager** manager) {
+  ResourceMgr* resource_manager = context->resource_manager();
+  if (resource_manager == nullptr) {
+    return errors::Internal("No resource manager for asynchronous saves.");
+  }
+  return resource_manager->LookupOrCreate<AsyncSaveManager>(
+      resource_manager->default_container(), kAsyncSaveManagerResourceName,
+      manager, [](AsyncSaveManager** out) {
+        *out = new AsyncSaveManager();
+        return absl::OkStatus();
+      });
+}
+
+// The state of one AsyncSaveV2, shared by the tasks that write its shards.
+struct AsyncSave {
+  AsyncSaveManager* manager = nullptr;  // Not owned.
+  checkpoint::CheckpointCallbackManager* callback_manager = nullptr;  // Owned.
+  string prefix;
+  std::vector<string> tensor_names;
+  std::vector<string> shape_and_slices;
+  std::vector<Tensor> tensors;
+  // The indices of the tensors written by each shard, and the temporary
+  // prefix that each shard is written to.  A single shard is written to
+  // "prefix" directly.
+  std::vector<std::vector<int>> shards;
+  std::vector<string> shard_prefixes;
+
+  std::atomic<int> pending_shards{0};
+  mutex mu;
+  Status status TF_GUARDED_BY(mu);
+
+  ~AsyncSave() {
+    if (callback_manager != nullptr) callback_manager->Unref();
+  }
+
+  void WriteShard(int shard) {
+    Env* env = Env::Default();
+    BundleWriter writer(env, shard_prefixes[shard]);
+    Status s = writer.status();
+    for (int i : shards[shard]) {
+      if (!s.ok()) break;
+      VLOG(2) << "Starting asynchronous save of " << tensor_names[i];
+      s = AddTensorToBundle(tensor_names[i], shape_and_slices[i], tensors[i],
+                            &writer);
+      // Releases the snapshot as soon as it has been written.
+      tensors[i] = Tensor();
+    }
+    if (s.ok()) s = writer.Finish();
+    {
+      mutex_lock l(mu);
+      status.Update(s);
+    }
+    if (pending_shards.fetch_sub(1) == 1) Complete();
+  }
+
+  // Runs once all shards have been written.
+  void Complete() {
+    Env* env = Env::Default();
+    Status s;
+    {
+      mutex_lock l(mu);
+      s = status;
+    }
+    if (s.ok() && shards.size() > 1) {
+      std::vector<tstring> prefixes(shard_prefixes.begin(),
+                                    shard_prefixes.end());
+      s = MergeBundles(env, prefixes, prefix);
+    }
+    if (!s.ok() && shards.size() > 1) {
+      // Best effort: removes the files of the shards that were written.
+      for (const string& shard_prefix : shard_prefixes) {
+        env->DeleteFile(MetaFilename(shard_prefix)).IgnoreError();
+        env->DeleteFile(DataFilename(shard_prefix, 0, 1)).IgnoreError();
+      }
+    }
+    if (s.ok()) {
+      VLOG(1) << "Done asynchronous BundleWriter, prefix_string: " << prefix;
+      if (callback_manager != nullptr) callback_manager->Save(prefix);
+    }
+    manager->Finish(prefix, s);
+  }
+};
+
+}  // namespace
+
+// Snapshots a list of named tensors and saves them with the tensor bundle
+// library on a background thread pool.
+class AsyncSaveV2 : public OpKernel {
+ public:
+  explicit AsyncSaveV2(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("max_parallel_shards",
+                                             &max_parallel_shards_));
+    OP_REQUIRES_OK(context, context->GetAttr("deep_copy", &deep_copy_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& prefix = context->input(0);
+    const Tensor& tensor_names = context->input(1);
+    const Tensor& shape_and_slices = context->input(2);
+    ValidateInputs(true /* is save op */, context, prefix, tensor_names,
+                   shape_and_slices);
+    if (!context->status().ok()) return;
+
+    const int kFixedInputs = 3;  // Prefix, tensor names, shape_and_slices.
+    const int num_tensors = static_cast<int>(tensor_names.NumElements());
+    const auto& tensor_names_flat = tensor_names.flat<tstring>();
+    const auto& shape_and_slices_flat = shape_and_slices.flat<tstring>();
+
+    auto save = std::make_shared<AsyncSave>();
+    save->prefix = prefix.scalar<tstring>()();
+    save->tensor_names.reserve(num_tensors);
+    save->shape_and_slices.reserve(num_tensors);
+    save->tensors.reserve(num_tensors);
+    for (int i = 0; i < num_tensors; ++i) {
+      const Tensor& tensor = context->input(i + kFixedInputs);
+      const string& shape_spec = shape_and_slices_flat(i);
+      if (!shape_spec.empty()) {
+        // Validates the slice now so that the error is reported by this op.
+        TensorShape shape;
+        TensorSlice slice(tensor.dims());
+        OP_REQUIRES_OK(context,
+                       ParseSliceToSave(shape_spec, tensor, &shape, &slice));
+      }
+      save->tensor_names.push_back(tensor_names_flat(i));
+      save->shape_and_slices.push_back(shape_spec);
+      save->tensors.push_back(deep_copy_ ? tensor::DeepCopy(tensor) : tensor);
+    }
+
+    AsyncSaveManager* manager;
+    OP_REQUIRES_OK(context, GetAsyncSaveManager(context, &manager));
+    core::ScopedUnref unref_manager(manager);
+    save->manager = manager;
+    ResourceMgr* resource_manager = context->resource_manager();
+    OP_REQUIRES_OK(context, GetCheckpointCallbackManager(
+                                resource_manager, &save->callback_manager));
+
+    PartitionIntoShards(manager->pool()->NumThreads(), save.get());
+    OP_REQUIRES_OK(context, manager->Start(save->prefix));
+    VLOG(1) << "Asynchronous BundleWriter, prefix_string: " << save->prefix
+            << ", shards: " << save->shards.size();
+
+    const int num_shards = save->shards.size();
+    save->pending_shards = num_shards;
+    for (int shard = 0; shard < num_shards; ++shard) {
+      manager->pool()->Schedule([save, shard]() { save->WriteShard(shard); });
+    }
+  }
+
+ private:
+  // Assigns the tensors to at most "max_parallel_shards_" shards of roughly
+  // equal size, largest tensors first.
+  void PartitionIntoShards(int num_threads, AsyncSave* save) const {
+    const int num_tensors = save->tensors.size();
+    int num_shards =
+        max_parallel_shards_ > 0 ? max_parallel_shards_ : num_threads;
+    num_shards = std::max(1, std::min(num_shards, num_tensors));
+
+    std::vector<int> order(num_tensors);
+    for (int i = 0; i < num_tensors; ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [save](int a, int b) {
+      return save->tensors[a].TotalBytes() > save->tensors[b].TotalBytes();
+    });
+    save->shards.resize(num_shards);
+    std::vector<int64_t> shard_bytes(num_shards, 0);
+    for (int i : order) {
+      const int shard =
+          std::min_element(shard_bytes.begin(), shard_bytes.end()) -
+          shard_bytes.begin();
+      save->shards[shard].push_back(i);
+      shard_bytes[shard] += save->tensors[i].TotalBytes();
+    }
+
+    if (num_shards == 1) {
+      save->shard_prefixes.push_back(save->prefix);
+      return;
+    }
+    for (int shard = 0; shard < num_shards; ++shard) {
+      save->shard_prefixes.push_back(strings::Printf(
+          "%s_async_part-%05d", save->prefix.c_str(), shard));
+    }
+  }
+
+  int max_parallel_shards_;
+  bool deep_copy_;
+};
+REGISTER_KERNEL_BUILDER(Name("AsyncSaveV2").Device(DEVICE_CPU), AsyncSaveV2);
+
+// Waits for, or polls, the completion of an AsyncSaveV2.
+class WaitForAsyncSaveV2 : public AsyncOpKernel {
+ public:
+  explicit WaitForAsyncSaveV2(OpKernelConstruction* context)
+      : AsyncOpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("blocking", &blocking_));
+  }
+
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
+    const Tensor& prefix = context->input(0);
+    OP_REQUIRES_ASYNC(
+        context, TensorShapeUtils::IsScalar(prefix.shape()),
+        errors::InvalidArgument("Input prefix should be a scalar tensor, got ",
+                                prefix.shape().DebugString(), " instead."),
+        done);
+    const string prefix_string = prefix.scalar<tstring>()();
+
+    Tensor* output;
+    OP_REQUIRES_OK_ASYNC(
+        context, context->allocate_output(0, TensorShape({}), &output), done);
+
+    AsyncSaveManager* manager;
+    OP_REQUIRES_OK_ASYNC(context, GetAsyncSaveManager(context, &manager),
+                         done);
+    core::ScopedUnref unref_manager(manager);
+
+    if (!blocking_) {
+      Status status;
+      output->scalar<bool>()() = manager->Poll(prefix_string, &status);
+      context->SetStatus(status);
+      done();
+      return;
+    }
+    manager->Wait(prefix_string,
+                  [context, output, done = std::move(done)](const Status& s) {
+                    output->scalar<bool>()() = true;
+                    context->SetStatus(s);
+                    done();
+                  });
+  }
+
+ private:
+  bool blocking_;
+};
+REGISTER_KERNEL_BUILDER(Name("WaitForAsyncSaveV2").Device(DEVICE_CPU),
+                        WaitForAsyncSaveV2);
+
+// Saves resource variables, writing only the rows that changed since the
+// previous save for variables that track dirty rows.
+class SaveVariableDeltas : public OpKernel {
+ public:
+  explicit SaveVariableDeltas(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("base", &base_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& prefix = context->input(0);
+    const Tensor& tensor_names = context->input(1);
+    OP_REQUIRES(
+        context, TensorShapeUtils::IsScalar(prefix.shape()),
+        errors::InvalidArgument("Input prefix should be a scalar tensor, got ",
+                                prefix.shape().DebugString(), " instead."));
+    const int num_tensors = context->num_inputs() - 2;
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(tensor_names.shape()) &&
+                    tensor_names.NumElements() == num_tensors,
+                errors::InvalidArgument("Expected ", num_tensors,
+                                        " tensor names, got shape ",
+                                        tensor_names.shape().DebugString()));
+    const string& prefix_string = prefix.scalar<tstring>()();
+    const auto& tensor_names_flat = tensor_names.flat<tstring>();
+
+    // Variables whose dirty rows were reset.  If the save fails, they are
+    // marked fully dirty so that the next delta does not miss any row.
+    std::vector<core::RefCountPtr<Var>> saved;
+    auto mark_all_dirty_on_failure = gtl::MakeCleanup([context, &saved] {
+      if (context->status().ok()) return;
+      for (const auto& var : saved) var->MarkAllRowsDirty();
+    });
+
+    BundleWriter writer(Env::Default(), prefix_string);
+    OP_REQUIRES_OK(context, writer.status());
+    int64_t num_delta_rows = 0;
+    for (int i = 0; i < num_tensors; ++i) {
+      const string& tensor_name = tensor_names_flat(i);
+      core::RefCountPtr<Var> var;
+      OP_REQUIRES_OK(context,
+                     LookupResource(context, HandleFromInput(context, i + 2),
+                                    &var));
+      Tensor value;
+      TensorShape shape;
+      std::vector<int64_t> rows;
+      bool all_rows = true;
+      {
+        // Excludes the sparse updates, which may hold a shared lock, while
+        // the dirty rows and their values are captured.
+        mutex_lock l(*var->mu());
+        OP_REQUIRES(context, var->is_initialized,
+                    errors::FailedPrecondition(
+                        "Attempting to save uninitialized variable ",
+                        tensor_name));
+        const Tensor& tensor = *var->tensor();
+        shape = tensor.shape();
+        if (base_ || !var->tracks_dirty_rows()) {
+          var->StartDirtyRowTracking();
+        } else {
+          var->TakeDirtyRows(&rows, &all_rows);
+        }
+        var->Ref();
+        saved.emplace_back(var.get());
+        if (all_rows || tensor.dims() == 0 ||
+            !DataTypeCanUseMemcpy(tensor.dtype())) {
+          all_rows = true;
+          value = tensor::DeepCopy(tensor);
+        } else {
+          OP_REQUIRES_OK(context, GatherRows(context, tensor, rows, &value));
+        }
+      }
+      if (all_rows) {
+        OP_REQUIRES_OK(context, writer.Add(tensor_name, value));
+      } else {
+        OP_REQUIRES_OK(context,
+                       writer.AddRows(tensor_name, shape, rows, value));
+        num_delta_rows += rows.size();
+      }
+    }
+    OP_REQUIRES_OK(context, writer.Finish());
+    VLOG(1) << "Saved " << num_tensors << " variables to " << prefix_string
+            << ", " << num_delta_rows << " rows as deltas";
+  }
+
+ private:
+  // Copies the rows "rows" of "tensor" into "out".
+  static Status GatherRows(OpKernelContext* context, const Tensor& tensor,
+                           const std::vector<int64_t>& rows, Tensor* out) {
+    TensorShape shape = tensor.shape();
+    const int64_t num_rows = shape.dim_size(0);
+    TF_RETURN_IF_ERROR(shape.SetDimWithStatus(0, rows.size()));
+    TF_RETURN_IF_ERROR(context->allocate_temp(tensor.dtype(), shape, out));
+    if (rows.empty()) return absl::OkStatus();
+    const size_t row_bytes = tensor.TotalBytes() / num_rows;
+    const char* src = tensor.tensor_data().data();
+    char* dst = const_cast<char*>(out->tensor_data().data());
+    for (size_t i = 0; i < rows.size(); ++i) {
+      std::memcpy(dst + i * row_bytes, src + rows[i] * row_bytes, row_bytes);
+    }
+    return absl::OkStatus();
+  }
+
+  bool base_;
+};
+REGISTER_KERNEL_BUILDER(Name("SaveVariableDeltas").Device(DEVICE_CPU),
+                        SaveVariableDeltas);
+
+// Restores tensors from a base checkpoint and the delta checkpoints written
+// after it by SaveVariableDeltas.
+class RestoreWithDeltas : public OpKernel {
+ public:
+  explicit RestoreWithDeltas(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("dtypes", &dtypes_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& prefixes = context->input(0);
+    const Tensor& tensor_names = context->input(1);
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(prefixes.shape()) &&
+                    prefixes.NumElements() > 0,
+                errors::InvalidArgument(
+                    "Input prefixes should be a non-empty 1-D tensor, got ",
+                    prefixes.shape().DebugString(), " instead."));
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(tensor_names.shape()) &&
+                    tensor_names.NumElements() == dtypes_.size(),
+                errors::InvalidArgument("Expected ", dtypes_.size(),
+                                        " tensor names, got shape ",
+                                        tensor_names.shape().DebugString()));
+
+    std::vector<std::unique_ptr<BundleReader>> readers;
+    std::vector<BundleReader*> chain;
+    for (const tstring& prefix : prefixes.flat<tstring>()) {
+      readers.push_back(
+          std::make_unique<BundleReader>(Env::Default(), prefix));
+      OP_REQUIRES_OK(context, readers.back()->status());
+      chain.push_back(readers.back().get());
+    }
+
+    const auto& tensor_names_flat = tensor_names.flat<tstring>();
+    const int num_tensors = dtypes_.size();
+    for (int i = 0; i < num_tensors; ++i) {
+      const string& tensor_name = tensor_names_flat(i);
+      // Every entry in the chain records the full shape of the tensor.
+      BundleReader* found = nullptr;
+      for (BundleReader* reader : chain) {
+        if (reader->Contains(tensor_name)) found = reader;
+      }
+      OP_REQUIRES(context, found != nullptr,
+                  errors::NotFound("Key ", tensor_name,
+                                   " not found in any checkpoint of the "
+                                   "chain"));
+      DataType dtype;
+      TensorShape shape;
+      OP_REQUIRES_OK(context,
+                     found->LookupDtypeAndShape(tensor_name, &dtype, &shape));
+      OP_REQUIRES(context, dtype == dtypes_[i],
+                  errors::InvalidArgument(
+                      "tensor_names[", i, "] is stored with dtype ",
+                      DataTypeString(dtype), " but ",
+                      DataTypeString(dtypes_[i]), " was requested"));
+      Tensor* restored;
+      OP_REQUIRES_OK(context, context->allocate_output(i, shape, &restored));
+      OP_REQUIRES_OK(context,
+                     LookupInBundleChain(chain, tensor_name, restored));
+    }
+  }
+
+ private:
+  std::vector<DataType> dtypes_;
+};
+REGISTER_KERNEL_BUILDER(Name("RestoreWithDeltas").Device(DEVICE_CPU),
+                        RestoreWithDeltas);
+
 // Restores a list of named tensors from a tensor bundle (V2 checkpoint format).
 class RestoreV2 : public OpKernel {
  public:
@@ -235,18 +775,9 @@ class RestoreV2 : public OpKernel {
     ResourceMgr* resource_manager = context->resource_manager();
     if (resource_manager != nullptr) {
       checkpoint::CheckpointCallbackManager* checkpoint_callback_manager;
-      OP_REQUIRES_OK(
-          context,
-          resource_manager
-              ->LookupOrCreate<checkpoint::CheckpointCallbackManager>(
-                  resource_manager->default_container(),
-                  std::string(
-                      checkpoint::kCheckpointCallbackManagerResourceName),
-                  &checkpoint_callback_manager,
-                  [](checkpoint::CheckpointCallbackManager** out) {
-                    *out = new checkpoint::CheckpointCallbackManager();
-                    return absl::OkStatus();
-                  }));
+      OP_REQUIRES_OK(context,
+                     GetCheckpointCallbackManager(
+                         resource_manager, &checkpoint_callback_manager));
       checkpoint_callback_manager->Restore(prefix_string);
       checkpoint_callback_manager->Unref();
     }
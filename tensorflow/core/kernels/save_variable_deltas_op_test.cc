@@ -0,0 +1,132 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/resource_var.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace {
+
+class SaveVariableDeltasOpTest : public OpsTestBase {
+ protected:
+  void MakeSaveOp() {
+    inputs_.clear();
+    TF_ASSERT_OK(NodeDefBuilder("save", "SaveVariableDeltas")
+                     .Input(FakeInput())  // prefix
+                     .Input(FakeInput())  // tensor_names
+                     .Input(FakeInput(2, DT_RESOURCE))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  void MakeRestoreOp() {
+    inputs_.clear();
+    TF_ASSERT_OK(NodeDefBuilder("restore", "RestoreWithDeltas")
+                     .Input(FakeInput())  // prefixes
+                     .Input(FakeInput())  // tensor_names
+                     .Attr("dtypes", {DT_FLOAT, DT_FLOAT})
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  Var* NewVar(const Tensor& value) {
+    Var* var = new Var(value.dtype());
+    *var->tensor() = value;
+    var->is_initialized = true;
+    return var;
+  }
+
+  void RunSave(const string& prefix) {
+    mutable_input(0).tensor->scalar<tstring>()() = prefix;
+    TF_ASSERT_OK(RunOpKernel());
+  }
+};
+
+TEST_F(SaveVariableDeltasOpTest, SaveAndRestoreChain) {
+  const string dir = io::JoinPath(testing::TmpDir(), "variable_deltas");
+  const std::vector<string> prefixes = {io::JoinPath(dir, "base"),
+                                        io::JoinPath(dir, "delta_1"),
+                                        io::JoinPath(dir, "delta_2")};
+  // Not owned; the resource manager holds them.
+  Var* emb = NewVar(test::AsTensor<float>({0, 1, 2, 3, 4, 5, 6, 7},
+                                          TensorShape({4, 2})));
+  Var* bias = NewVar(test::AsTensor<float>({1, 2}));
+
+  MakeSaveOp();
+  AddInputFromArray<tstring>(TensorShape({}), {""});
+  AddInputFromArray<tstring>(TensorShape({2}), {"emb", "bias"});
+  AddResourceInput<Var>("", "emb", emb);
+  AddResourceInput<Var>("", "bias", bias);
+  RunSave(prefixes[0]);
+  EXPECT_TRUE(emb->tracks_dirty_rows());
+
+  // A sparse update of rows 1 and 3 of "emb".
+  emb->tensor()->matrix<float>()(1, 0) = 10;
+  emb->tensor()->matrix<float>()(3, 1) = 30;
+  emb->MarkRowsDirty(test::AsTensor<int64_t>({3, 1}));
+  RunSave(prefixes[1]);
+
+  // A dense update of "bias" and a sparse update of row 0 of "emb".
+  *bias->tensor() = test::AsTensor<float>({5, 6});
+  bias->MarkAllRowsDirty();
+  emb->tensor()->matrix<float>()(0, 0) = -1;
+  emb->MarkRowsDirty(test::AsTensor<int32>({0}));
+  RunSave(prefixes[2]);
+
+  {
+    BundleReader delta(Env::Default(), prefixes[1]);
+    TF_ASSERT_OK(delta.status());
+    bool is_row_delta;
+    std::vector<int64_t> rows;
+    Tensor values;
+    TF_ASSERT_OK(delta.LookupRows("emb", &is_row_delta, &rows, &values));
+    EXPECT_TRUE(is_row_delta);
+    EXPECT_EQ(rows, std::vector<int64_t>({1, 3}));
+    // "bias" was not written to since the base and is saved as an empty delta.
+    TF_ASSERT_OK(delta.LookupRows("bias", &is_row_delta, &rows, &values));
+    EXPECT_TRUE(is_row_delta);
+    EXPECT_TRUE(rows.empty());
+  }
+
+  MakeRestoreOp();
+  AddInputFromArray<tstring>(TensorShape({3}),
+                             {prefixes[0], prefixes[1], prefixes[2]});
+  AddInputFromArray<tstring>(TensorShape({2}), {"emb", "bias"});
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<float>(
+      *GetOutput(0), test::AsTensor<float>({-1, 1, 10, 3, 4, 5, 6, 30},
+                                           TensorShape({4, 2})));
+  test::ExpectTensorEqual<float>(*GetOutput(1),
+                                 test::AsTensor<float>({5, 6}));
+}
+
+}  // namespace
+}  // namespace tensorflow
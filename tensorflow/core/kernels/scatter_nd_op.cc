@@ -304,6 +304,8 @@ class ScatterNdUpdateOp : public ScatterOpBase<Device> {
       OP_REQUIRES_OK(c, EnsureSparseVariableAccess<Device, T>(c, v.get()));
       mutex_lock m(*v->mu());
       DoCompute(c);
+      // Rows written through N-d indices are not tracked individually.
+      if (c->status().ok()) v->MarkAllRowsDirty();
     } else if (use_exclusive_lock_) {
       // If we're here, it means the input type is a ref.
       DCHECK(IsRefType(c->input_dtype(0)));
@@ -128,6 +128,20 @@ class VariableInputLockHolder {
     }
   }
 
+  // Records that a sparse update wrote the rows in `indices` of the resource
+  // variables whose mutexes are held (see Var::MarkRowsDirty). Indices in
+  // device memory cannot be read here, so all rows are recorded instead.
+  template <typename Device>
+  void MarkRowsDirty(const Tensor& indices) {
+    for (Var* var : vars_) {
+      if (std::is_same<Device, Eigen::ThreadPoolDevice>::value) {
+        var->MarkRowsDirty(indices);
+      } else {
+        var->MarkAllRowsDirty();
+      }
+    }
+  }
+
  private:
   std::vector<Var*> vars_;
   // NOTE: Use a `std::unique_ptr` instead of moving in a vector directly,
@@ -289,6 +303,7 @@ absl::Status GetInputTensorFromVariable(OpKernelContext* ctx, int input,
     var->mu()->assert_held();
     TF_RETURN_IF_ERROR(PrepareToUpdateVariable<Device, T>(
         ctx, var->tensor(), var->copy_on_read_mode.load()));
+    var->MarkAllRowsDirty();
     *out = *var->tensor();
     return absl::OkStatus();
   }
@@ -1198,6 +1198,7 @@ class SparseApplyAdadeltaOp : public OpKernel {
     auto locks = MaybeLockVariableInputMutexesInOrder<Device, T>(
         ctx, use_exclusive_lock_, sparse, {0, 1, 2});
     DoCompute(ctx);
+    if (ctx->status().ok()) locks.MarkRowsDirty<Device>(ctx->input(7));
   }
 
   void DoCompute(OpKernelContext* ctx) {
@@ -1545,6 +1546,7 @@ class SparseApplyProximalGradientDescentOp : public OpKernel {
       }
     }
 
+    locks.MarkRowsDirty<Device>(indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -1948,6 +1950,7 @@ class SparseApplyAdagradOp : public OpKernel {
                  lr.scalar<T>(), lr.scalar<T>(), grad.flat_outer_dims<T>(),
                  indices.vec<Tindex>(), inner_dim, update_slots_));
 
+    locks.MarkRowsDirty<Device>(indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -2081,6 +2084,7 @@ class SparseApplyAdagradV2Op : public OpKernel {
                  lr.scalar<T>(), epsilon.scalar<T>(), grad.flat_outer_dims<T>(),
                  indices.vec<Tindex>(), inner_dim, update_slots_));
 
+    locks.MarkRowsDirty<Device>(indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -2229,6 +2233,7 @@ class SparseApplyProximalAdagradOp : public OpKernel {
                  lr.scalar<T>(), l1.scalar<T>(), l2.scalar<T>(),
                  grad.flat_outer_dims<T>(), indices.vec<Tindex>(), inner_dim));
 
+    locks.MarkRowsDirty<Device>(indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -2558,6 +2563,7 @@ class SparseApplyAdagradDAOp : public OpKernel {
       }
     }
 
+    locks.MarkRowsDirty<Device>(indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -2931,6 +2937,7 @@ class SparseApplyFtrlOp : public OpKernel {
                  lr_power.scalar<T>(), grad.flat_outer_dims<T>(), indices_vec,
                  inner_dim, multiply_linear_by_lr_));
 
+    locks.MarkRowsDirty<Device>(indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -3251,6 +3258,7 @@ class SparseApplyMomentumOp : public OpKernel {
       }
     }
 
+    locks.MarkRowsDirty<Device>(indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -3454,6 +3462,7 @@ class SparseApplyKerasMomentumOp : public OpKernel {
             "indices", SliceDebugString(indices.shape(), bad_i), " = ",
             indices_flat(bad_i), " is not in [0, ", var.dim_size(0), ")"));
 
+    locks.MarkRowsDirty<Device>(indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -4292,6 +4301,7 @@ class SparseApplyRMSPropOp : public OpKernel {
       }
     }
 
+    locks.MarkRowsDirty<Device>(indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -4434,6 +4444,7 @@ class SparseApplyCenteredRMSPropOp : public OpKernel {
       }
     }
 
+    locks.MarkRowsDirty<Device>(indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
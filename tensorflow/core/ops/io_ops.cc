@@ -83,6 +83,74 @@ REGISTER_OP("SaveV2")
       return absl::OkStatus();
     });
 
+REGISTER_OP("AsyncSaveV2")
+    .Input("prefix: string")
+    .Input("tensor_names: string")
+    .Input("shape_and_slices: string")
+    .Input("tensors: dtypes")
+    .Attr("dtypes: list(type)")
+    .Attr("max_parallel_shards: int >= 0 = 0")
+    .Attr("deep_copy: bool = true")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      ShapeHandle s;
+      DimensionHandle unused_dim;
+
+      // Validate prefix.
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+
+      // Validate tensor_names and shapes_and_slices.
+      for (int i = 1; i <= 2; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 1, &s));
+        TF_RETURN_IF_ERROR(
+            c->WithValue(c->Dim(s, 0), c->num_inputs() - 3, &unused_dim));
+      }
+      return absl::OkStatus();
+    });
+
+REGISTER_OP("WaitForAsyncSaveV2")
+    .Input("prefix: string")
+    .Output("done: bool")
+    .Attr("blocking: bool = true")
+    .SetIsStateful()
+    .SetShapeFn(ScalarInputsAndOutputs);
+
+REGISTER_OP("SaveVariableDeltas")
+    .Input("prefix: string")
+    .Input("tensor_names: string")
+    .Input("resources: N * resource")
+    .Attr("N: int >= 1")
+    .Attr("base: bool = false")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      ShapeHandle s;
+      DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &s));
+      TF_RETURN_IF_ERROR(
+          c->WithValue(c->Dim(s, 0), c->num_inputs() - 2, &unused_dim));
+      return absl::OkStatus();
+    });
+
+REGISTER_OP("RestoreWithDeltas")
+    .Input("prefixes: string")
+    .Input("tensor_names: string")
+    .Output("tensors: dtypes")
+    .Attr("dtypes: list(type)")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      ShapeHandle s;
+      DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &s));
+      TF_RETURN_IF_ERROR(
+          c->WithValue(c->Dim(s, 0), c->num_outputs(), &unused_dim));
+      return UnknownShape(c);
+    });
+
 REGISTER_OP("RestoreV2")
     .Input("prefix: string")
     .Input("tensor_names: string")
@@ -352,6 +352,36 @@ REGISTER_OP("_UnaryOpsComposition")
 expected to create these operators.
 )doc");
 
+REGISTER_OP("_FusedElementwise")
+    .Input("inputs: N * T")
+    .Output("y: T")
+    .Attr("N: int >= 1")
+    .Attr("T: {float, half, double}")
+    .Attr("op_names: list(string)")
+    .Attr("op_inputs: list(int)")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle out = c->input(0);
+      for (int i = 1; i < c->num_inputs(); ++i) {
+        TF_RETURN_IF_ERROR(BroadcastBinaryOpOutputShapeFnHelper(
+            c, out, c->input(i), /*incompatible_shape_error=*/true, &out));
+      }
+      c->set_output(0, out);
+      return absl::OkStatus();
+    })
+    .Doc(R"doc(
+Evaluates a connected subgraph of element-wise ops in a single pass.
+
+`op_names[i]` is the i-th op of the fused program, and `op_inputs[2*i]`,
+`op_inputs[2*i+1]` are its operands: values in `[0, N)` refer to `inputs`,
+values `N + j` refer to the result of op `j < i`, and `-1` marks the unused
+operand of a unary op. The result of the last op is the output. Inputs must
+either match the output shape, be scalars, or be broadcast along the innermost
+dimension.
+
+*NOTE*: Do not invoke this operator directly in Python. Graph rewrite pass is
+expected to create these operators.
+)doc");
+
 #undef UNARY
 #undef UNARY_REAL
 #undef UNARY_COMPLEX
@@ -18,7 +18,9 @@ limitations under the License.
 #include <sys/stat.h>
 
 #include <memory>
+#include <vector>
 
+#include "absl/types/span.h"
 #include "xla/tsl/lib/core/status_test_util.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
@@ -92,6 +94,42 @@ TEST_F(DefaultEnvTest, IncompleteReadOutOfRange) {
   EXPECT_EQ(input, result);
 }
 
+TEST_F(DefaultEnvTest, ReadBatch) {
+  const string filename = io::JoinPath(BaseDir(), "read_batch");
+  const int length = 1 << 20;
+  const string input = CreateTestFile(env_, filename, length);
+  std::unique_ptr<RandomAccessFile> f;
+  TF_EXPECT_OK(env_->NewRandomAccessFile(filename, &f));
+
+  // More reads than an io_uring keeps in flight, the last one past EOF.
+  const int num_requests = 200;
+  std::vector<string> scratch(num_requests);
+  std::vector<RandomAccessFile::ReadRequest> requests(num_requests);
+  for (int i = 0; i < num_requests; ++i) {
+    requests[i].offset = (i * 7919) % (length - 5000);
+    requests[i].n = 1 + i * 20;
+    scratch[i].resize(requests[i].n);
+    requests[i].scratch = scratch[i].data();
+  }
+  requests.back().offset = length - 10;
+  requests.back().n = 20;
+  scratch.back().resize(20);
+  requests.back().scratch = scratch.back().data();
+
+  absl::Status status;
+  f->ReadBatch(absl::MakeSpan(requests),
+               [&](const absl::Status& s) { status = s; });
+  EXPECT_EQ(error::OUT_OF_RANGE, status.code());
+
+  for (int i = 0; i + 1 < num_requests; ++i) {
+    TF_EXPECT_OK(requests[i].status);
+    EXPECT_EQ(input.substr(requests[i].offset, requests[i].n),
+              requests[i].result);
+  }
+  EXPECT_EQ(error::OUT_OF_RANGE, requests.back().status.code());
+  EXPECT_EQ(input.substr(length - 10), requests.back().result);
+}
+
 TEST_F(DefaultEnvTest, ReadFileToString) {
   for (const int length : {0, 1, 1212, 2553, 4928, 8196, 9000, (1 << 20) - 1,
                            1 << 20, (1 << 20) + 1, (256 << 20) + 100}) {
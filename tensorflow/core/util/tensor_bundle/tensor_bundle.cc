@@ -15,15 +15,20 @@ limitations under the License.
 
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
+#include <zlib.h>
+
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "absl/base/call_once.h"
 #include "absl/synchronization/mutex.h"
 #include "xla/tsl/lib/io/buffered_file.h"
 #include "xla/tsl/util/byte_swap_array.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
@@ -47,6 +52,7 @@ limitations under the License.
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/stringprintf.h"
 #include "tensorflow/core/platform/tstring.h"
@@ -81,6 +87,9 @@ const int64_t kLargeTensorThreshold = static_cast<int64_t>(1) << 32;
 const int kMaxFileReadThreads = 8;
 // Minimum size of a file section handled by each thread.
 const int64_t kMinSectionSize = static_cast<int64_t>(1) << 31;
+// Minimum number of uncompressed bytes read from a compressed tensor before its
+// blocks are decompressed by multiple threads.
+const int64_t kMinParallelDecompressBytes = static_cast<int64_t>(64) << 20;
 
 namespace {
 
@@ -223,6 +232,33 @@ Status ReadVariantTensor(io::InputBuffer* buffered_file, Tensor* ret,
   return absl::OkStatus();
 }
 
+// A read-only TensorBuffer aliasing a section of a memory-mapped data file. It
+// keeps the whole mapping alive while referenced.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)),
+        region_(std::move(region)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+
+  TensorBuffer* root_buffer() override { return this; }
+
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(static_cast<int64_t>(size_));
+    proto->set_allocator_name("mmap");
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const size_t size_;
+};
+
 char* GetBackingBuffer(const Tensor& val) {
   CHECK(DataTypeCanUseMemcpy(val.dtype())) << val.dtype();
   return const_cast<char*>(val.tensor_data().data());
@@ -255,6 +291,72 @@ Status WriteTensor(const Tensor& val, tsl::BufferedWritableFile* out,
   return out->Append(StringPiece(buf, *bytes_written));
 }
 
+// Compresses one block of tensor bytes with "codec" into "output".
+Status CompressBlock(BlockCompressionProto::Codec codec, StringPiece input,
+                     string* output) {
+  switch (codec) {
+    case BlockCompressionProto::SNAPPY:
+      if (!port::Snappy_Compress(input.data(), input.size(), output)) {
+        return errors::Unimplemented(
+            "Snappy compression is not supported on this platform");
+      }
+      return absl::OkStatus();
+    case BlockCompressionProto::ZLIB: {
+      uLongf compressed_size = compressBound(input.size());
+      output->resize(compressed_size);
+      const int ret = compress2(reinterpret_cast<Bytef*>(&(*output)[0]),
+                                &compressed_size,
+                                reinterpret_cast<const Bytef*>(input.data()),
+                                input.size(), Z_DEFAULT_COMPRESSION);
+      if (ret != Z_OK) {
+        return errors::Internal("zlib compression failed with error ", ret);
+      }
+      output->resize(compressed_size);
+      return absl::OkStatus();
+    }
+    default:
+      return errors::InvalidArgument(
+          "Unsupported tensor bundle compression codec ",
+          BlockCompressionProto::Codec_Name(codec));
+  }
+}
+
+// Decompresses one block of tensor bytes into the "output_size" bytes at
+// "output".
+Status UncompressBlock(BlockCompressionProto::Codec codec, StringPiece input,
+                       char* output, size_t output_size) {
+  switch (codec) {
+    case BlockCompressionProto::SNAPPY: {
+      size_t uncompressed_size;
+      if (!port::Snappy_GetUncompressedLength(input.data(), input.size(),
+                                              &uncompressed_size) ||
+          uncompressed_size != output_size ||
+          !port::Snappy_Uncompress(input.data(), input.size(), output)) {
+        return errors::DataLoss("Corrupted snappy block of ", input.size(),
+                                " bytes, expected ", output_size,
+                                " uncompressed bytes");
+      }
+      return absl::OkStatus();
+    }
+    case BlockCompressionProto::ZLIB: {
+      uLongf uncompressed_size = output_size;
+      const int ret = uncompress(reinterpret_cast<Bytef*>(output),
+                                 &uncompressed_size,
+                                 reinterpret_cast<const Bytef*>(input.data()),
+                                 input.size());
+      if (ret != Z_OK || uncompressed_size != output_size) {
+        return errors::DataLoss("Corrupted zlib block of ", input.size(),
+                                " bytes, expected ", output_size,
+                                " uncompressed bytes (error ", ret, ")");
+      }
+      return absl::OkStatus();
+    }
+    default:
+      return errors::DataLoss("Unsupported tensor bundle compression codec ",
+                              static_cast<int>(codec));
+  }
+}
+
 // Serializes string tensor "val".  "bytes_written" is treated in the same
 // fashion as WriteTensor().
 //
@@ -380,6 +482,41 @@ bool IsFullSlice(const TensorSlice& slice_spec,
   }
 }
 
+// Returns the range [*begin, *end) of dimension "d" of "full_shape" covered by
+// "slice".
+void SliceExtent(const TensorShape& full_shape, const TensorSlice& slice, int d,
+                 int64_t* begin, int64_t* end) {
+  if (slice.IsFullAt(d)) {
+    *begin = 0;
+    *end = full_shape.dim_size(d);
+  } else {
+    *begin = slice.start(d);
+    *end = slice.end(d);
+  }
+}
+
+// Returns true iff "a" and "b" both cover all of "full_shape" except along
+// dimension 0, in which case [*row_begin, *row_end) are the rows they share.
+// The bytes of these rows are then contiguous in both slices.
+bool IntersectRows(const TensorShape& full_shape, const TensorSlice& a,
+                   const TensorSlice& b, int64_t* row_begin,
+                   int64_t* row_end) {
+  if (full_shape.dims() == 0) return false;
+  for (int d = 1; d < full_shape.dims(); ++d) {
+    for (const TensorSlice* slice : {&a, &b}) {
+      int64_t begin, end;
+      SliceExtent(full_shape, *slice, d, &begin, &end);
+      if (begin != 0 || end != full_shape.dim_size(d)) return false;
+    }
+  }
+  int64_t a_begin, a_end, b_begin, b_end;
+  SliceExtent(full_shape, a, 0, &a_begin, &a_end);
+  SliceExtent(full_shape, b, 0, &b_begin, &b_end);
+  *row_begin = std::max(a_begin, b_begin);
+  *row_end = std::min(a_end, b_end);
+  return true;
+}
+
 Status CorruptFileError(const Status& in_status, const string& filename,
                         const string& detail) {
   if (in_status.ok()) {
@@ -468,17 +605,19 @@ Status BundleWriter::Add(StringPiece key, const Tensor& val) {
   entry->set_shard_id(0);
   entry->set_offset(size_);
 
+  if (val.dtype() != DT_STRING && val.dtype() != DT_VARIANT) {
+    status_ = WriteTensorData(val, entry);
+    return status_;
+  }
+
   // Updates the data file.
   size_t data_bytes_written = 0;
   uint32 crc32c = 0;
   out_->reset_crc32();
   if (val.dtype() == DT_STRING) {
     status_ = WriteStringTensor(val, out_.get(), &data_bytes_written, &crc32c);
-  } else if (val.dtype() == DT_VARIANT) {
-    status_ = WriteVariantTensor(val, out_.get(), &data_bytes_written, &crc32c);
   } else {
-    status_ = WriteTensor(val, out_.get(), &data_bytes_written);
-    crc32c = out_->crc32();
+    status_ = WriteVariantTensor(val, out_.get(), &data_bytes_written, &crc32c);
   }
 
   if (status_.ok()) {
@@ -531,6 +670,114 @@ Status BundleWriter::AddSlice(StringPiece full_tensor_key,
   return status_;
 }
 
+Status BundleWriter::AddRows(StringPiece key,
+                             const TensorShape& full_tensor_shape,
+                             absl::Span<const int64_t> row_indices,
+                             const Tensor& rows) {
+  if (!status_.ok()) return status_;
+  CHECK_NE(key, kHeaderEntryKey);
+  const string key_string(key);
+  if (entries_.find(key_string) != entries_.end()) {
+    status_ = errors::InvalidArgument("Adding duplicate key: ", key);
+    return status_;
+  }
+  if (!DataTypeCanUseMemcpy(rows.dtype())) {
+    return errors::Unimplemented("Saving rows of ", key, " with dtype ",
+                                 DataTypeString(rows.dtype()),
+                                 " is not supported");
+  }
+  TensorShape expected_shape = full_tensor_shape;
+  if (expected_shape.dims() == 0) {
+    return errors::InvalidArgument("Cannot save rows of scalar ", key);
+  }
+  expected_shape.set_dim(0, row_indices.size());
+  if (rows.shape() != expected_shape) {
+    return errors::InvalidArgument(
+        "Rows of ", key, " have shape ", rows.shape().DebugString(),
+        " but expected ", expected_shape.DebugString());
+  }
+
+  BundleEntryProto entry;
+  entry.set_dtype(rows.dtype());
+  full_tensor_shape.AsProto(entry.mutable_shape());
+  RowDeltaProto* row_delta = entry.mutable_row_delta();
+  for (size_t i = 0; i < row_indices.size(); ++i) {
+    const int64_t row = row_indices[i];
+    if (row < 0 || row >= full_tensor_shape.dim_size(0) ||
+        (i > 0 && row <= row_indices[i - 1])) {
+      return errors::InvalidArgument(
+          "Row indices of ", key,
+          " must be strictly increasing and less than ",
+          full_tensor_shape.dim_size(0), ", got ", row, " at position ", i);
+    }
+    if (i > 0 && row == row_indices[i - 1] + 1) {
+      const int last = row_delta->row_counts_size() - 1;
+      row_delta->set_row_counts(last, row_delta->row_counts(last) + 1);
+    } else {
+      row_delta->add_row_starts(row);
+      row_delta->add_row_counts(1);
+    }
+  }
+  status_ = WriteTensorData(rows, &entry);
+  if (status_.ok()) entries_[key_string] = std::move(entry);
+  return status_;
+}
+
+Status BundleWriter::WriteTensorData(const Tensor& val,
+                                     BundleEntryProto* entry) {
+  entry->set_shard_id(0);
+  entry->set_offset(size_);
+  const StringPiece data(GetBackingBuffer(val), val.TotalBytes());
+
+  if (options_.compression != BlockCompressionProto::NONE &&
+      DataTypeCanUseMemcpy(val.dtype()) &&
+      static_cast<int64_t>(data.size()) >= options_.min_compression_bytes) {
+    if (options_.compression_block_size <= 0) {
+      return errors::InvalidArgument("Invalid compression block size ",
+                                     options_.compression_block_size);
+    }
+    const size_t block_size = options_.compression_block_size;
+    std::vector<string> blocks;
+    blocks.reserve((data.size() + block_size - 1) / block_size);
+    size_t compressed_bytes = 0;
+    for (size_t pos = 0; pos < data.size(); pos += block_size) {
+      blocks.emplace_back();
+      TF_RETURN_IF_ERROR(CompressBlock(options_.compression,
+                                       data.substr(pos, block_size),
+                                       &blocks.back()));
+      compressed_bytes += blocks.back().size();
+    }
+
+    // Only keeps the compressed blocks if they save space.
+    if (compressed_bytes < data.size()) {
+      BlockCompressionProto* compression = entry->mutable_compression();
+      compression->set_codec(options_.compression);
+      compression->set_block_size(block_size);
+      for (const string& block : blocks) {
+        TF_RETURN_IF_ERROR(out_->Append(block));
+        compression->add_compressed_sizes(block.size());
+        compression->add_block_crc32c(
+            crc32c::Mask(crc32c::Value(block.data(), block.size())));
+      }
+      VLOG(1) << "Appended " << compressed_bytes << " compressed bytes for "
+              << data.size() << " tensor bytes";
+      entry->set_size(compressed_bytes);
+      entry->set_crc32c(
+          crc32c::Mask(crc32c::Value(data.data(), data.size())));
+      size_ += compressed_bytes;
+      return PadAlignment(out_.get(), options_.data_alignment, &size_);
+    }
+  }
+
+  size_t data_bytes_written = 0;
+  out_->reset_crc32();
+  TF_RETURN_IF_ERROR(WriteTensor(val, out_.get(), &data_bytes_written));
+  entry->set_size(data_bytes_written);
+  entry->set_crc32c(crc32c::Mask(out_->crc32()));
+  size_ += data_bytes_written;
+  return PadAlignment(out_.get(), options_.data_alignment, &size_);
+}
+
 // TODO(zongheng): on metadata write failure or !status_.ok(), consider removing
 // the orphaned data file.
 Status BundleWriter::Finish() {
@@ -785,7 +1032,9 @@ BundleReader::BundleReader(Env* env, StringPiece prefix, Options options)
       iter_(nullptr),
       need_to_swap_bytes_(false),
       enable_multi_threading_for_testing_(
-          options.enable_multi_threading_for_testing) {
+          options.enable_multi_threading_for_testing),
+      use_mmap_(options.use_mmap),
+      verify_mmap_checksums_(options.verify_mmap_checksums) {
   if (cache_ == nullptr) {
     // Make a cache for use just by this BundleReader.
     owned_cache_ = std::make_unique<BundleCache>(env);
@@ -877,16 +1126,93 @@ Status BundleReader::GetBundleEntryProto(StringPiece key,
   return absl::OkStatus();
 }
 
+Status BundleReader::GetMappedValue(const BundleEntryProto& entry, Tensor* val,
+                                    bool* mapped) {
+  *mapped = false;
+  const TensorShape shape(entry.shape());
+  const int64_t expected_size =
+      shape.num_elements() * DataTypeSize(entry.dtype());
+  if (entry.size() != expected_size) {
+    return errors::DataLoss("Invalid size in bundle entry: key ", key(),
+                            "; stored size ", entry.size(),
+                            "; expected size ", expected_size);
+  }
+  if (entry.size() == 0) return absl::OkStatus();
+
+  auto it = mapped_data_.find(entry.shard_id());
+  if (it == mapped_data_.end()) {
+    const string filename =
+        DataFilename(prefix_, entry.shard_id(), num_shards_);
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    Status s = env_->NewReadOnlyMemoryRegionFromFile(filename, &region);
+    if (!s.ok()) {
+      VLOG(1) << "Failed to memory-map " << filename
+              << ", falling back to copying tensors: " << s;
+    }
+    it = mapped_data_.emplace(entry.shard_id(), std::move(region)).first;
+  }
+  const std::shared_ptr<ReadOnlyMemoryRegion>& region = it->second;
+  if (region == nullptr) return absl::OkStatus();
+
+  if (entry.offset() < 0 ||
+      static_cast<uint64>(entry.offset() + entry.size()) > region->length()) {
+    return errors::DataLoss("TensorBundle at ", prefix_, " shard ",
+                            entry.shard_id(), ": tensor ", key(), " at offset ",
+                            entry.offset(), " (", entry.size(),
+                            " bytes) is out of bounds of the data file (",
+                            region->length(), " bytes)");
+  }
+  const char* data = static_cast<const char*>(region->data()) + entry.offset();
+  if (reinterpret_cast<uintptr_t>(data) % EIGEN_MAX_ALIGN_BYTES != 0) {
+    VLOG(2) << "Tensor " << key() << " is not aligned in the data file, "
+            << "copying it instead of memory-mapping";
+    return absl::OkStatus();
+  }
+
+  if (verify_mmap_checksums_) {
+    const uint32 actual_crc32c = crc32c::Value(data, entry.size());
+    if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+      return errors::DataLoss(
+          "TensorBundle at ", prefix_, " shard ", entry.shard_id(), " (",
+          entry.size(), " bytes): Checksum does not match: stored ",
+          strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+          " vs. calculated on the mapped bytes ", actual_crc32c);
+    }
+  }
+
+  MappedTensorBuffer* buf = new MappedTensorBuffer(region, data, entry.size());
+  *val = Tensor(entry.dtype(), shape, buf);
+  buf->Unref();
+  *mapped = true;
+  return absl::OkStatus();
+}
+
 Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
+  if (entry.has_row_delta()) {
+    return errors::FailedPrecondition(
+        "Tensor ", key(), " in ", prefix_,
+        " only holds the rows that changed since an earlier checkpoint; read "
+        "it together with that checkpoint using LookupInBundleChain()");
+  }
+  // Only tensors the caller did not pre-allocate can alias the mapped file.
+  if (use_mmap_ && val->NumElements() == 0 &&
+      DataTypeCanUseMemcpy(entry.dtype()) && !need_to_swap_bytes_ &&
+      !entry.has_compression()) {
+    bool mapped = false;
+    TF_RETURN_IF_ERROR(GetMappedValue(entry, val, &mapped));
+    if (mapped) return absl::OkStatus();
+  }
+
   Tensor* ret = val;
   const TensorShape stored_shape(TensorShape(entry.shape()));
   if (val->NumElements() == 0) {
     ret = new Tensor(entry.dtype(), stored_shape);
   }
 
-  // Validates the "size" field.
+  // Validates the "size" field.  ReadCompressedRange() validates the sizes of
+  // compressed tensors.
   if (entry.dtype() != DT_STRING && entry.dtype() != DT_VARIANT) {
-    if (entry.size() != ret->TotalBytes()) {
+    if (!entry.has_compression() && entry.size() != ret->TotalBytes()) {
       return errors::DataLoss("Invalid size in bundle entry: key ", key(),
                               "; stored size ", entry.size(),
                               "; expected size ", ret->TotalBytes());
@@ -923,7 +1249,11 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
   if (DataTypeCanUseMemcpy(entry.dtype())) {
     char* backing_buffer = const_cast<char*>((ret->tensor_data().data()));
     size_t unused_bytes_read;
-    if (entry.size() > kBufferSize || enable_multi_threading_for_testing_) {
+    if (entry.has_compression()) {
+      TF_RETURN_IF_ERROR(
+          ReadCompressedRange(entry, 0, ret->TotalBytes(), backing_buffer));
+    } else if (entry.size() > kBufferSize ||
+               enable_multi_threading_for_testing_) {
       StringPiece sp;
       if (!enable_multi_threading_for_testing_ &&
           entry.size() < kLargeTensorThreshold) {
@@ -983,7 +1313,7 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
     }
     // Note that we compute the checksum *before* byte-swapping. The checksum
     // should be on the bytes in the order they appear in the file.
-    actual_crc32c = crc32c::Value(backing_buffer, entry.size());
+    actual_crc32c = crc32c::Value(backing_buffer, ret->TotalBytes());
     if (need_to_swap_bytes_) {
       TF_RETURN_IF_ERROR(ByteSwapTensor(ret));
     }
@@ -1019,6 +1349,128 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
   return absl::OkStatus();
 }
 
+Status BundleReader::ReadCompressedRange(const BundleEntryProto& entry,
+                                         int64_t begin, int64_t end,
+                                         char* dest) {
+  if (!DataTypeCanUseMemcpy(entry.dtype())) {
+    return errors::DataLoss("Invalid compressed bundle entry: key ", key(),
+                            " has dtype ", DataTypeString(entry.dtype()));
+  }
+  const BlockCompressionProto& compression = entry.compression();
+  const int64_t total_bytes = TensorShape(entry.shape()).num_elements() *
+                              DataTypeSize(entry.dtype());
+  const int64_t block_size = compression.block_size();
+  const int num_blocks = compression.compressed_sizes_size();
+  if (block_size <= 0 ||
+      num_blocks != (total_bytes + block_size - 1) / block_size ||
+      compression.block_crc32c_size() != num_blocks) {
+    return errors::DataLoss("Invalid compression in bundle entry: key ", key(),
+                            "; ", num_blocks, " blocks of ", block_size,
+                            " bytes for a tensor of ", total_bytes, " bytes");
+  }
+  if (begin < 0 || end > total_bytes) {
+    return errors::InvalidArgument("Cannot read bytes [", begin, ", ", end,
+                                   ") of tensor ", key(), " of ", total_bytes,
+                                   " bytes");
+  }
+
+  // Offsets of the stored blocks, relative to the start of the tensor.
+  std::vector<int64_t> block_offsets(num_blocks + 1, 0);
+  for (int i = 0; i < num_blocks; ++i) {
+    if (compression.compressed_sizes(i) < 0) {
+      return errors::DataLoss("Invalid size of compressed block ", i,
+                              " of tensor ", key(), ": ",
+                              compression.compressed_sizes(i));
+    }
+    block_offsets[i + 1] = block_offsets[i] + compression.compressed_sizes(i);
+  }
+  if (block_offsets[num_blocks] != entry.size()) {
+    return errors::DataLoss("Invalid size in bundle entry: key ", key(),
+                            "; stored size ", entry.size(),
+                            "; size of compressed blocks ",
+                            block_offsets[num_blocks]);
+  }
+  if (begin >= end) return absl::OkStatus();
+
+  // Reads the stored bytes of all the blocks overlapping [begin, end) at once.
+  const int first_block = begin / block_size;
+  const int last_block = (end - 1) / block_size;
+  const int64_t read_offset = block_offsets[first_block];
+  const int64_t read_size = block_offsets[last_block + 1] - read_offset;
+  RandomAccessFile* file = nullptr;
+  TF_RETURN_IF_ERROR(cache_->GetFile(
+      DataFilename(prefix_, entry.shard_id(), num_shards_), &file));
+  std::unique_ptr<char[]> scratch(new char[read_size]);
+  StringPiece stored;
+  TF_RETURN_IF_ERROR(
+      file->Read(entry.offset() + read_offset, read_size, &stored,
+                 scratch.get()));
+  if (stored.size() != read_size) {
+    return errors::DataLoss("Requested ", read_size, " bytes of tensor ",
+                            key(), " but read ", stored.size(), " bytes");
+  }
+
+  auto read_block = [&](int i) -> Status {
+    const StringPiece block = stored.substr(block_offsets[i] - read_offset,
+                                            compression.compressed_sizes(i));
+    const uint32 actual_crc32c = crc32c::Value(block.data(), block.size());
+    if (crc32c::Unmask(compression.block_crc32c(i)) != actual_crc32c) {
+      return errors::DataLoss(
+          "TensorBundle at ", prefix_, " shard ", entry.shard_id(),
+          ": Checksum of compressed block ", i, " of tensor ", key(),
+          " does not match: stored ",
+          strings::Printf("%08u", crc32c::Unmask(compression.block_crc32c(i))),
+          " vs. calculated on the restored bytes ", actual_crc32c);
+    }
+    const int64_t block_begin = i * block_size;
+    const int64_t block_end = std::min(block_begin + block_size, total_bytes);
+    const int64_t copy_begin = std::max(begin, block_begin);
+    const int64_t copy_end = std::min(end, block_end);
+    char* out = dest + (copy_begin - begin);
+    if (copy_begin == block_begin && copy_end == block_end) {
+      return UncompressBlock(compression.codec(), block, out,
+                             block_end - block_begin);
+    }
+    // Only part of this block is needed.
+    std::unique_ptr<char[]> buf(new char[block_end - block_begin]);
+    TF_RETURN_IF_ERROR(UncompressBlock(compression.codec(), block, buf.get(),
+                                       block_end - block_begin));
+    memcpy(out, buf.get() + (copy_begin - block_begin), copy_end - copy_begin);
+    return absl::OkStatus();
+  };
+
+  const int num_blocks_to_read = last_block - first_block + 1;
+  int num_threads = 1;
+  if (num_blocks_to_read > 1 && (end - begin >= kMinParallelDecompressBytes ||
+                                 enable_multi_threading_for_testing_)) {
+    num_threads = std::min(num_blocks_to_read, kMaxFileReadThreads);
+  }
+  if (num_threads == 1) {
+    for (int i = first_block; i <= last_block; ++i) {
+      TF_RETURN_IF_ERROR(read_block(i));
+    }
+    return absl::OkStatus();
+  }
+
+  std::vector<Status> statuses(num_threads);
+  {
+    thread::ThreadPool decompress_pool(Env::Default(), "decompress_tensor",
+                                       num_threads);
+    for (int t = 0; t < num_threads; ++t) {
+      decompress_pool.Schedule([&, t]() {
+        for (int i = first_block + t; i <= last_block && statuses[t].ok();
+             i += num_threads) {
+          statuses[t] = read_block(i);
+        }
+      });
+    }
+  }  // Waits for the blocks to be decompressed.
+  for (const auto& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+  return absl::OkStatus();
+}
+
 Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
@@ -1071,6 +1523,104 @@ Status BundleReader::LookupSlice(StringPiece full_tensor_key,
   return GetSliceValue(full_tensor_key, entry, slice_spec, val);
 }
 
+Status BundleReader::LookupRows(StringPiece key, bool* is_row_delta,
+                                std::vector<int64_t>* row_indices,
+                                Tensor* rows) {
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  *is_row_delta = entry.has_row_delta();
+  if (!*is_row_delta) return absl::OkStatus();
+
+  const RowDeltaProto& row_delta = entry.row_delta();
+  if (row_delta.row_starts_size() != row_delta.row_counts_size()) {
+    return errors::DataLoss("Invalid row delta for ", key, ": ",
+                            row_delta.ShortDebugString());
+  }
+  TensorShape shape(entry.shape());
+  if (shape.dims() == 0) {
+    return errors::DataLoss("Invalid row delta for scalar ", key);
+  }
+  row_indices->clear();
+  for (int i = 0; i < row_delta.row_starts_size(); ++i) {
+    const int64_t start = row_delta.row_starts(i);
+    const int64_t count = row_delta.row_counts(i);
+    if (start < 0 || count < 0 || start + count > shape.dim_size(0)) {
+      return errors::DataLoss("Invalid row delta for ", key, ": ",
+                              row_delta.ShortDebugString());
+    }
+    for (int64_t row = start; row < start + count; ++row) {
+      row_indices->push_back(row);
+    }
+  }
+
+  // Reads the rows as a dense tensor of shape [num_rows] + shape[1:].
+  TF_RETURN_IF_ERROR(shape.SetDimWithStatus(0, row_indices->size()));
+  entry.clear_row_delta();
+  shape.AsProto(entry.mutable_shape());
+  *rows = Tensor();
+  return GetValue(entry, rows);
+}
+
+Status LookupInBundleChain(absl::Span<BundleReader* const> readers,
+                           StringPiece key, Tensor* val) {
+  // Finds the last full tensor in the chain, collecting the deltas after it.
+  struct RowDelta {
+    std::vector<int64_t> row_indices;
+    Tensor rows;
+  };
+  std::vector<RowDelta> deltas;
+  int base = -1;
+  for (int i = static_cast<int>(readers.size()) - 1; i >= 0; --i) {
+    if (!readers[i]->Contains(key)) continue;
+    RowDelta delta;
+    bool is_row_delta;
+    TF_RETURN_IF_ERROR(readers[i]->LookupRows(key, &is_row_delta,
+                                              &delta.row_indices, &delta.rows));
+    if (!is_row_delta) {
+      base = i;
+      break;
+    }
+    deltas.push_back(std::move(delta));
+  }
+  if (base < 0) {
+    return errors::NotFound("No full value of ", key,
+                            " in the chain of ", readers.size(),
+                            " checkpoints");
+  }
+  if (deltas.empty()) return readers[base]->Lookup(key, val);
+
+  // Allocates "val" up front so that it does not alias a read-only mapping.
+  DataType dtype;
+  TensorShape shape;
+  TF_RETURN_IF_ERROR(readers[base]->LookupDtypeAndShape(key, &dtype, &shape));
+  if (val->NumElements() == 0) *val = Tensor(dtype, shape);
+  TF_RETURN_IF_ERROR(readers[base]->Lookup(key, val));
+
+  const int64_t num_rows = shape.dims() > 0 ? shape.dim_size(0) : 0;
+  const size_t row_bytes = num_rows > 0 ? val->TotalBytes() / num_rows : 0;
+  char* data = const_cast<char*>(val->tensor_data().data());
+  for (auto it = deltas.rbegin(); it != deltas.rend(); ++it) {
+    const Tensor& rows = it->rows;
+    TensorShape expected_shape = shape;
+    if (expected_shape.dims() > 0) {
+      expected_shape.set_dim(0, it->row_indices.size());
+    }
+    if (rows.dtype() != dtype || rows.shape() != expected_shape) {
+      return errors::DataLoss(
+          "Delta of ", key, " with dtype ", DataTypeString(rows.dtype()),
+          " and shape ", rows.shape().DebugString(),
+          " does not match its base tensor with dtype ", DataTypeString(dtype),
+          " and shape ", shape.DebugString());
+    }
+    const char* row_data = rows.tensor_data().data();
+    for (size_t i = 0; i < it->row_indices.size(); ++i) {
+      std::memcpy(data + it->row_indices[i] * row_bytes,
+                  row_data + i * row_bytes, row_bytes);
+    }
+  }
+  return absl::OkStatus();
+}
+
 Status BundleReader::GetSliceValue(StringPiece full_tensor_key,
                                    const BundleEntryProto& full_tensor_entry,
                                    const TensorSlice& slice_spec, Tensor* val) {
@@ -1149,6 +1699,28 @@ Status BundleReader::GetSliceValue(StringPiece full_tensor_key,
       return status_;
     }
 
+    // Compressed slices that only differ from "slice_spec" along dimension 0
+    // are read by decompressing only the blocks that hold the shared rows.
+    int64_t row_begin, row_end;
+    if (stored_slice_entry.has_compression() && !need_to_swap_bytes_ &&
+        IntersectRows(full_shape, stored_slice, slice_spec, &row_begin,
+                      &row_end)) {
+      int64_t row_bytes = DataTypeSize(stored_slice_entry.dtype());
+      for (int d = 1; d < full_shape.dims(); ++d) {
+        row_bytes *= full_shape.dim_size(d);
+      }
+      int64_t stored_begin, spec_begin, unused_end;
+      SliceExtent(full_shape, stored_slice, 0, &stored_begin, &unused_end);
+      SliceExtent(full_shape, slice_spec, 0, &spec_begin, &unused_end);
+      char* dest = const_cast<char*>(val->tensor_data().data()) +
+                   (row_begin - spec_begin) * row_bytes;
+      status_ = ReadCompressedRange(
+          stored_slice_entry, (row_begin - stored_begin) * row_bytes,
+          (row_end - stored_begin) * row_bytes, dest);
+      if (!status_.ok()) return status_;
+      continue;
+    }
+
     Tensor stored_slice_tensor(stored_slice_entry.dtype(), stored_slice_shape);
     status_ = GetValue(stored_slice_entry, &stored_slice_tensor);
     if (!status_.ok()) return status_;
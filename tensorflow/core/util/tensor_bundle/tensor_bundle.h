@@ -119,6 +119,16 @@ class BundleWriter {
     // Alignment, in bytes, for tensor data.
     // Must be >= 1. The default size of 1 densely packs tensors.
     int data_alignment{1};
+
+    // Codec used to compress the data bytes of tensors of memcpy-able dtypes.
+    // Tensors are compressed in blocks of "compression_block_size"
+    // uncompressed bytes, so that readers can decompress only the blocks
+    // they need (see BundleReader::LookupSlice()).  Tensors smaller than
+    // "min_compression_bytes", and tensors that do not shrink, are stored
+    // uncompressed.
+    BlockCompressionProto::Codec compression{BlockCompressionProto::NONE};
+    int64_t compression_block_size{1 << 20};
+    int64_t min_compression_bytes{4096};
   };
   BundleWriter(Env* env, absl::string_view prefix,
                const Options& options = Options());
@@ -147,6 +157,17 @@ class BundleWriter {
                   const TensorShape& full_tensor_shape,
                   const TensorSlice& slice_spec, const Tensor& slice_tensor);
 
+  // Delta checkpoints support.
+  // Adds the rows "row_indices" (along dimension 0) of a tensor of shape
+  // "full_tensor_shape" under key "key".  "rows" holds the values of these
+  // rows, in order, and "row_indices" must be strictly increasing.  Readers
+  // see such an entry as a delta on top of an earlier checkpoint of the same
+  // tensor; see LookupInBundleChain().
+  //
+  // Only dtypes that can be memcpy'd are supported.
+  Status AddRows(absl::string_view key, const TensorShape& full_tensor_shape,
+                 absl::Span<const int64_t> row_indices, const Tensor& rows);
+
   // Finishes the writer and flushes.
   Status Finish() TF_MUST_USE_RESULT;
 
@@ -164,6 +185,10 @@ class BundleWriter {
   std::map<std::string, BundleEntryProto> entries_;
   Status status_;
 
+  // Writes the data bytes of the non-string tensor "val" for "entry", either
+  // compressed or raw, and fills in its offset, size and checksums.
+  Status WriteTensorData(const Tensor& val, BundleEntryProto* entry);
+
   BundleWriter(const BundleWriter&) = delete;
   void operator=(const BundleWriter&) = delete;
 };
@@ -212,6 +237,19 @@ class BundleReader {
 
     // For tests only.
     bool enable_multi_threading_for_testing = false;
+
+    // If true, restores tensors of memcpy-able types as read-only views into
+    // memory-mapped data files instead of copying them into freshly allocated
+    // buffers, so that all readers of a bundle share its data through the page
+    // cache. Tensors must be aligned to EIGEN_MAX_ALIGN_BYTES in the data file
+    // (see BundleWriter::Options::data_alignment); misaligned tensors, bundles
+    // of a different endianness and file systems that do not support memory
+    // mapping fall back to copying. Restored tensors must not be mutated.
+    bool use_mmap = false;
+
+    // If false, checksums of memory-mapped tensors are not verified, so that
+    // restoring a tensor does not page in its data.
+    bool verify_mmap_checksums = true;
   };
   BundleReader(Env* env, absl::string_view prefix, Options options);
 
@@ -261,6 +299,10 @@ class BundleReader {
   // tensor keyed by "key" does not exist in this bundle.
   //
   // Validates the stored crc32c checksum against the restored bytes.
+  //
+  // If the reader was created with Options::use_mmap and "val" is empty, it
+  // may be set to a read-only tensor that aliases the memory-mapped data file.
+  // Pre-allocated tensors are always filled in place.
   // REQUIRES: status().ok()
   Status Lookup(absl::string_view key, Tensor* val) TF_MUST_USE_RESULT;
 
@@ -291,6 +333,14 @@ class BundleReader {
                      const TensorSlice& slice_spec,
                      Tensor* val) TF_MUST_USE_RESULT;
 
+  // Looks up the rows added by BundleWriter::AddRows() under "key" into
+  // "row_indices" and "rows".  If "key" holds a full tensor instead, sets
+  // "is_row_delta" to false and leaves "row_indices" and "rows" untouched.
+  // REQUIRES: status().ok()
+  Status LookupRows(absl::string_view key, bool* is_row_delta,
+                    std::vector<int64_t>* row_indices,
+                    Tensor* rows) TF_MUST_USE_RESULT;
+
   // Seeks to the first position in the bundle whose key is no less than "key".
   // REQUIRES: status().ok()
   void Seek(absl::string_view key) { return iter_->Seek(key); }
@@ -322,6 +372,18 @@ class BundleReader {
   Status GetValue(const BundleEntryProto& entry,
                   Tensor* val) TF_MUST_USE_RESULT;
 
+  // Tries to make "val" alias the tensor data described by "entry" in the
+  // memory-mapped data file. Sets "mapped" to false, and leaves "val"
+  // untouched, if the tensor has to be copied instead.
+  Status GetMappedValue(const BundleEntryProto& entry, Tensor* val,
+                        bool* mapped) TF_MUST_USE_RESULT;
+
+  // Reads the uncompressed bytes [begin, end) of the compressed tensor
+  // described by "entry" into "dest", decompressing only the blocks that
+  // overlap that range.  Verifies the checksum of every block read.
+  Status ReadCompressedRange(const BundleEntryProto& entry, int64_t begin,
+                             int64_t end, char* dest) TF_MUST_USE_RESULT;
+
   // Reads the slice described by "slice_spec".  The corresponding full tensor
   // has key "ful_tensor_key" and metadata proto "full_tensor_entry".
   // REQUIRES: full_tensor_entry.slices_size() > 0
@@ -344,6 +406,11 @@ class BundleReader {
   // Owned InputBuffer objects. cache_ owns the underlying RandomAccessFiles.
   std::unordered_map<int32_t, io::InputBuffer*> data_;
 
+  // Memory-mapped data files, shared with the tensors that alias them. A null
+  // region marks a data file that could not be mapped.
+  std::unordered_map<int32_t, std::shared_ptr<ReadOnlyMemoryRegion>>
+      mapped_data_;
+
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
   std::unordered_map<std::string, checkpoint::TensorSliceSet*> tensor_slices_;
@@ -360,6 +427,9 @@ class BundleReader {
 
   bool enable_multi_threading_for_testing_ = false;
 
+  bool use_mmap_ = false;
+  bool verify_mmap_checksums_ = true;
+
   BundleReader(const BundleReader&) = delete;
   void operator=(const BundleReader&) = delete;
 };
@@ -390,6 +460,17 @@ Status BundleReader::SortForSequentialAccess(
   return absl::OkStatus();
 }
 
+// Reads the tensor "key" from a chain of checkpoints: a base checkpoint
+// followed by delta checkpoints in the order they were written.  The value is
+// the last full tensor stored in the chain, with the rows of all later deltas
+// written by BundleWriter::AddRows() applied in order.  Checkpoints that do not
+// contain "key" are skipped.  Usage for "val" follows the comment of
+// BundleReader::Lookup().
+//
+// REQUIRES: status().ok() for all "readers"
+Status LookupInBundleChain(absl::Span<BundleReader* const> readers,
+                           absl::string_view key, Tensor* val);
+
 // BundleCache provides cached opening of files.
 // Used internally by BundleReader.
 // Safe for concurrent uses by multiple threads and BundleReaders.
@@ -1270,6 +1270,264 @@ TEST_F(TensorBundleAlignmentTest, AlignmentTest) {
   }
 }
 
+TEST(TensorBundleTest, MemoryMappedRestore) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = 64;
+    BundleWriter writer(Env::Default(), Prefix("mmap"), opts);
+    TF_EXPECT_OK(writer.Add("floats", Constant_100x100<float>(1.5f)));
+    TF_EXPECT_OK(writer.Add("ints", Constant_2x3<int64_t>(7)));
+    TF_EXPECT_OK(
+        writer.Add("strings", test::AsTensor<tstring>({"hello", "world"})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  BundleReader::Options options;
+  options.use_mmap = true;
+  BundleReader reader(Env::Default(), Prefix("mmap"), options);
+  TF_ASSERT_OK(reader.status());
+  Expect<float>(&reader, "floats", Constant_100x100<float>(1.5f));
+  Expect<int64_t>(&reader, "ints", Constant_2x3<int64_t>(7));
+  Expect<tstring>(&reader, "strings",
+                  test::AsTensor<tstring>({"hello", "world"}));
+
+  // Both lookups alias the same bytes of the mapped data file.
+  Tensor first;
+  Tensor second;
+  TF_ASSERT_OK(reader.Lookup("floats", &first));
+  TF_ASSERT_OK(reader.Lookup("floats", &second));
+  EXPECT_EQ(first.tensor_data().data(), second.tensor_data().data());
+  test::ExpectTensorEqual<float>(first, Constant_100x100<float>(1.5f));
+}
+
+TEST(TensorBundleTest, MemoryMappedRestoreFallsBackToCopy) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = 1;
+    BundleWriter writer(Env::Default(), Prefix("mmap_unaligned"), opts);
+    TF_EXPECT_OK(writer.Add("a", Constant(true, TensorShape({3}))));
+    TF_EXPECT_OK(writer.Add("b", Constant_2x3<float>(2.f)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  BundleReader::Options options;
+  options.use_mmap = true;
+  BundleReader reader(Env::Default(), Prefix("mmap_unaligned"), options);
+  TF_ASSERT_OK(reader.status());
+  // "b" starts at byte 3 of the data file and is copied instead of mapped.
+  Tensor val;
+  TF_ASSERT_OK(reader.Lookup("b", &val));
+  test::ExpectTensorEqual<float>(val, Constant_2x3<float>(2.f));
+  Expect<bool>(&reader, "a", Constant(true, TensorShape({3})));
+}
+
+TEST(TensorBundleTest, MemoryMappedRestoreChecksum) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = 64;
+    BundleWriter writer(Env::Default(), Prefix("mmap_corrupt"), opts);
+    TF_EXPECT_OK(writer.Add("foo", Constant_2x3(1.f)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  const string datafile = DataFilename(Prefix("mmap_corrupt"), 0, 1);
+  string data;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), datafile, &data));
+  data[0] = ~data[0];
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), datafile, data));
+
+  BundleReader::Options options;
+  options.use_mmap = true;
+  {
+    BundleReader reader(Env::Default(), Prefix("mmap_corrupt"), options);
+    TF_ASSERT_OK(reader.status());
+    Tensor val;
+    Status status = reader.Lookup("foo", &val);
+    EXPECT_TRUE(errors::IsDataLoss(status));
+    EXPECT_TRUE(
+        absl::StrContains(status.ToString(), "Checksum does not match"));
+  }
+  options.verify_mmap_checksums = false;
+  {
+    BundleReader reader(Env::Default(), Prefix("mmap_corrupt"), options);
+    TF_ASSERT_OK(reader.status());
+    Tensor val;
+    TF_EXPECT_OK(reader.Lookup("foo", &val));
+  }
+}
+
+TEST(TensorBundleTest, RowDeltaChain) {
+  const TensorShape shape({5, 2});
+  {
+    BundleWriter writer(Env::Default(), Prefix("delta_base"));
+    TF_EXPECT_OK(writer.Add("emb", test::AsTensor<float>(
+                                       {0, 1, 2, 3, 4, 5, 6, 7, 8, 9}, shape)));
+    TF_EXPECT_OK(writer.Add("bias", test::AsTensor<float>({1, 2})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleWriter writer(Env::Default(), Prefix("delta_1"));
+    TF_EXPECT_OK(writer.AddRows("emb", shape, {1, 3},
+                                test::AsTensor<float>({12, 13, 16, 17},
+                                                      TensorShape({2, 2}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    BundleWriter writer(Env::Default(), Prefix("delta_2"));
+    TF_EXPECT_OK(writer.AddRows("emb", shape, {3, 4},
+                                test::AsTensor<float>({26, 27, 28, 29},
+                                                      TensorShape({2, 2}))));
+    TF_EXPECT_OK(writer.Add("bias", test::AsTensor<float>({3, 4})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  BundleReader base(Env::Default(), Prefix("delta_base"));
+  BundleReader delta_1(Env::Default(), Prefix("delta_1"));
+  BundleReader delta_2(Env::Default(), Prefix("delta_2"));
+  TF_ASSERT_OK(base.status());
+  TF_ASSERT_OK(delta_1.status());
+  TF_ASSERT_OK(delta_2.status());
+
+  // A delta cannot be read on its own.
+  Tensor val;
+  EXPECT_TRUE(errors::IsFailedPrecondition(delta_1.Lookup("emb", &val)));
+  bool is_row_delta;
+  std::vector<int64_t> row_indices;
+  TF_ASSERT_OK(delta_1.LookupRows("emb", &is_row_delta, &row_indices, &val));
+  EXPECT_TRUE(is_row_delta);
+  EXPECT_EQ(row_indices, std::vector<int64_t>({1, 3}));
+  test::ExpectTensorEqual<float>(
+      val, test::AsTensor<float>({12, 13, 16, 17}, TensorShape({2, 2})));
+
+  std::vector<BundleReader*> chain = {&base, &delta_1, &delta_2};
+  Tensor emb;
+  TF_ASSERT_OK(LookupInBundleChain(chain, "emb", &emb));
+  test::ExpectTensorEqual<float>(
+      emb, test::AsTensor<float>({0, 1, 12, 13, 4, 5, 26, 27, 28, 29}, shape));
+  Tensor bias;
+  TF_ASSERT_OK(LookupInBundleChain(chain, "bias", &bias));
+  test::ExpectTensorEqual<float>(bias, test::AsTensor<float>({3, 4}));
+
+  // Without its base, the delta chain has no full value of "emb".
+  std::vector<BundleReader*> deltas_only = {&delta_1, &delta_2};
+  EXPECT_TRUE(
+      errors::IsNotFound(LookupInBundleChain(deltas_only, "emb", &emb)));
+}
+
+TEST(TensorBundleTest, RowDeltaInvalidRows) {
+  BundleWriter writer(Env::Default(), Prefix("delta_invalid"));
+  const Tensor rows = Constant_2x3<float>(1.f);
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      writer.AddRows("unsorted", TensorShape({4, 3}), {2, 1}, rows)));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      writer.AddRows("out_of_range", TensorShape({4, 3}), {1, 4}, rows)));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      writer.AddRows("bad_shape", TensorShape({4, 2}), {0, 1}, rows)));
+  TF_EXPECT_OK(writer.AddRows("ok", TensorShape({4, 3}), {0, 3}, rows));
+  TF_EXPECT_OK(writer.Finish());
+}
+
+// Returns a {num_rows, 100} float tensor whose row i holds the value i.
+Tensor RowIndexTensor(int num_rows, int first_row = 0) {
+  Tensor t(DT_FLOAT, TensorShape({num_rows, 100}));
+  auto m = t.matrix<float>();
+  for (int i = 0; i < num_rows; ++i) {
+    for (int j = 0; j < 100; ++j) m(i, j) = first_row + i;
+  }
+  return t;
+}
+
+BundleEntryProto GetEntry(BundleReader* reader, const string& key) {
+  BundleEntryProto entry;
+  reader->Seek(key);
+  EXPECT_TRUE(reader->Valid() && reader->key() == key);
+  EXPECT_TRUE(
+      entry.ParseFromArray(reader->value().data(), reader->value().size()));
+  return entry;
+}
+
+TEST(TensorBundleTest, CompressedTensors) {
+  for (BlockCompressionProto::Codec codec :
+       {BlockCompressionProto::SNAPPY, BlockCompressionProto::ZLIB}) {
+    const string prefix =
+        Prefix(strings::StrCat("compressed_", static_cast<int>(codec)));
+    const Tensor dense = RowIndexTensor(100);
+    {
+      BundleWriter::Options opts;
+      opts.compression = codec;
+      opts.compression_block_size = 4096;
+      BundleWriter writer(Env::Default(), prefix, opts);
+      TF_EXPECT_OK(writer.Add("dense", dense));
+      TF_EXPECT_OK(writer.Add("small", Constant_2x3<float>(1.f)));
+      TF_EXPECT_OK(
+          writer.Add("strings", test::AsTensor<tstring>({"hello", "world"})));
+      TF_EXPECT_OK(writer.AddSlice("part", TensorShape({100, 100}),
+                                   TensorSlice::ParseOrDie("0,50:-"),
+                                   RowIndexTensor(50)));
+      TF_EXPECT_OK(writer.AddSlice("part", TensorShape({100, 100}),
+                                   TensorSlice::ParseOrDie("50,50:-"),
+                                   RowIndexTensor(50, 50)));
+      TF_ASSERT_OK(writer.Finish());
+    }
+    for (bool multi_threaded : {false, true}) {
+      BundleReader reader(Env::Default(), prefix, multi_threaded);
+      TF_ASSERT_OK(reader.status());
+
+      const BundleEntryProto entry = GetEntry(&reader, "dense");
+      EXPECT_EQ(entry.compression().codec(), codec);
+      EXPECT_EQ(entry.compression().compressed_sizes_size(), 10);
+      EXPECT_LT(entry.size(), dense.TotalBytes());
+      EXPECT_FALSE(GetEntry(&reader, "small").has_compression());
+      EXPECT_FALSE(GetEntry(&reader, "strings").has_compression());
+
+      Expect<float>(&reader, "dense", dense);
+      Expect<float>(&reader, "small", Constant_2x3<float>(1.f));
+      Expect<tstring>(&reader, "strings",
+                      test::AsTensor<tstring>({"hello", "world"}));
+      Expect<float>(&reader, "part", dense);
+
+      // Reads rows spanning a block boundary of "dense", and rows spanning
+      // both stored slices of "part".
+      for (const char* key : {"dense", "part"}) {
+        Tensor val(DT_FLOAT, TensorShape({30, 100}));
+        TF_ASSERT_OK(
+            reader.LookupSlice(key, TensorSlice::ParseOrDie("35,30:-"), &val));
+        test::ExpectTensorEqual<float>(val, RowIndexTensor(30, 35));
+      }
+    }
+  }
+}
+
+TEST(TensorBundleTest, CompressedTensorChecksum) {
+  const Tensor dense = RowIndexTensor(100);
+  {
+    BundleWriter::Options opts;
+    opts.compression = BlockCompressionProto::ZLIB;
+    opts.compression_block_size = 4096;
+    BundleWriter writer(Env::Default(), Prefix("compressed_corrupt"), opts);
+    TF_EXPECT_OK(writer.Add("dense", dense));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  const string datafile = DataFilename(Prefix("compressed_corrupt"), 0, 1);
+  string data;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), datafile, &data));
+  data[data.size() - 1] = ~data[data.size() - 1];
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), datafile, data));
+
+  BundleReader reader(Env::Default(), Prefix("compressed_corrupt"));
+  TF_ASSERT_OK(reader.status());
+  // Rows in the first block can still be read.
+  Tensor rows(DT_FLOAT, TensorShape({2, 100}));
+  TF_ASSERT_OK(
+      reader.LookupSlice("dense", TensorSlice::ParseOrDie("0,2:-"), &rows));
+  test::ExpectTensorEqual<float>(rows, RowIndexTensor(2));
+
+  Tensor val(DT_FLOAT, dense.shape());
+  Status status = reader.Lookup("dense", &val);
+  EXPECT_TRUE(errors::IsDataLoss(status));
+  EXPECT_TRUE(absl::StrContains(status.ToString(),
+                                "Checksum of compressed block 9"));
+}
+
 static void BM_BundleAlignment(::testing::benchmark::State& state) {
   {
     const int alignment = state.range(0);
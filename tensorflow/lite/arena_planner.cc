@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstdint>
+#include <initializer_list>
 #include <limits>
 #include <memory>
 #include <utility>
@@ -37,19 +38,28 @@ constexpr int32_t kScalarTensorBytes = 4;
 ArenaPlanner::ArenaPlanner(TfLiteContext* context,
                            std::unique_ptr<GraphInfo> graph_info,
                            bool preserve_all_tensors, int tensor_alignment,
-                           int subgraph_index)
+                           int subgraph_index, int plan_cache_size,
+                           ScratchArenaPool* scratch_arena_pool)
     : context_(context),
       graph_info_(std::move(graph_info)),
       arena_(kDefaultArenaAlignment, subgraph_index),
       has_nonpersistent_memory_(false),
       persistent_arena_(kDefaultArenaAlignment, subgraph_index),
+      scratch_arena_pool_(scratch_arena_pool),
+      private_arena_(kDefaultArenaAlignment, subgraph_index),
       preserve_all_tensors_(preserve_all_tensors),
       tensor_alignment_(tensor_alignment),
-      last_active_node_(kLastActiveNodeUndefined) {}
+      last_active_node_(kLastActiveNodeUndefined),
+      plan_cache_size_(plan_cache_size) {}
 
 ArenaPlanner::~ArenaPlanner() {
+  if (leased_buffer_ != nullptr) {
+    arena_.SetExternalBuffer(nullptr);
+    scratch_arena_pool_->Return(std::move(leased_buffer_));
+  }
   arena_.ReleaseBuffer();
   persistent_arena_.ReleaseBuffer();
+  private_arena_.ReleaseBuffer();
 }
 
 std::intptr_t ArenaPlanner::BasePointer(TfLiteAllocationType type) {
@@ -65,6 +75,7 @@ std::intptr_t ArenaPlanner::BasePointer(TfLiteAllocationType type) {
 TfLiteStatus ArenaPlanner::ResetAllocations() {
   TF_LITE_ENSURE_STATUS(arena_.ClearPlan());
   TF_LITE_ENSURE_STATUS(persistent_arena_.ClearPlan());
+  TF_LITE_ENSURE_STATUS(private_arena_.ClearPlan());
   allocs_.clear();
   allocs_.resize(graph_info_->num_tensors());
   // NOMUTANTS -- Setting last_active_node_ to kLastActiveNodeUndefined causes
@@ -85,10 +96,20 @@ TfLiteStatus ArenaPlanner::ResetAllocationsAfter(int node) {
       }
     }
   }
-  if (last_active_node_ > node) {
-    arena_.CalculateActiveAllocs(allocs_, node);
+  if (scratch_arena_pool_ == nullptr) {
+    if (last_active_node_ > node) {
+      arena_.CalculateActiveAllocs(allocs_, node);
+    } else {
+      arena_.PurgeAfter(node);
+    }
+  } else if (last_active_node_ > node) {
+    arena_.CalculateActiveAllocs(GetArenaAllocs(/*private_arena=*/false),
+                                 node);
+    private_arena_.CalculateActiveAllocs(
+        GetArenaAllocs(/*private_arena=*/true), node);
   } else {
     arena_.PurgeAfter(node);
+    private_arena_.PurgeAfter(node);
   }
   last_active_node_ = node;
   return kTfLiteOk;
@@ -144,6 +165,15 @@ bool ArenaPlanner::InputTensorCanBeShared(const TfLiteTensor& input_tensor,
   if (preserve_all_tensors_) {
     return false;
   }
+  // The readers of the input could run concurrently with the writers of the
+  // output.
+  if (graph_info_->node_dependencies() != nullptr) {
+    return false;
+  }
+  // Both tensors must be allocated in the same arena.
+  if (InPrivateArena(input_id) || InPrivateArena(output_id)) {
+    return false;
+  }
 
   return true;
 }
@@ -215,6 +245,20 @@ TfLiteStatus ArenaPlanner::PlanAllocations() {
   // Keeps track of references to each tensor.
   refcounts_.assign(num_tensors, 0);
 
+  in_private_arena_.clear();
+  if (scratch_arena_pool_ != nullptr) {
+    in_private_arena_.assign(num_tensors, false);
+    for (const std::vector<int>* tensor_indices :
+         {&graph_info_->inputs(), &graph_info_->outputs(),
+          &graph_info_->variables()}) {
+      for (int tensor_index : *tensor_indices) {
+        if (tensor_index != kTfLiteOptionalTensor) {
+          in_private_arena_[tensor_index] = true;
+        }
+      }
+    }
+  }
+
   auto allocate = [this](int node, int tensor) -> TfLiteStatus {
     if (alloc_node_[tensor] != kNodeNotAssigned) {
       // Tensor has already been allocated.
@@ -333,9 +377,61 @@ TfLiteStatus ArenaPlanner::PlanAllocations() {
   }
   // Note that graph outputs will never be scheduled for deallocation. We
   // could do that here for completeness, but it won't have any effect.
+
+  last_concurrent_node_.clear();
+  if (const auto* dependencies = graph_info_->node_dependencies()) {
+    TF_LITE_ENSURE_EQ(context_, dependencies->size(),
+                      graph_info_->num_execution_nodes());
+    PlanForConcurrentExecution(*dependencies);
+  }
   return kTfLiteOk;
 }
 
+void ArenaPlanner::PlanForConcurrentExecution(
+    const std::vector<std::vector<int>>& dependencies) {
+  // Bitsets of the nodes that depend on each node, directly or indirectly.
+  // Since nodes only depend on nodes before them, they are computed from the
+  // last node to the first.
+  const int num_nodes = static_cast<int>(dependencies.size());
+  const int num_words = (num_nodes + 63) / 64;
+  std::vector<std::vector<uint64_t>> dependents(
+      num_nodes, std::vector<uint64_t>(num_words, 0));
+  for (int i = num_nodes - 1; i >= 0; --i) {
+    for (int dependency : dependencies[i]) {
+      std::vector<uint64_t>& bits = dependents[dependency];
+      bits[i / 64] |= uint64_t{1} << (i % 64);
+      for (int w = 0; w < num_words; ++w) {
+        bits[w] |= dependents[i][w];
+      }
+    }
+  }
+  last_concurrent_node_.resize(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) {
+    int32_t last = num_nodes - 1;
+    while (last > i && (dependents[i][last / 64] >> (last % 64)) & 1) {
+      --last;
+    }
+    last_concurrent_node_[i] = last;
+  }
+
+  // A tensor may only be deallocated once the nodes that may run concurrently
+  // with any of its users are started, since the nodes started later depend on
+  // all its users.
+  for (int i = 0; i < num_nodes; ++i) {
+    const TfLiteNode& node = graph_info_->node(i);
+    for (const TfLiteIntArray* tensors : {node.inputs, node.outputs}) {
+      for (int j = 0; j < tensors->size; ++j) {
+        const int tensor_index = tensors->data[j];
+        if (tensor_index != kTfLiteOptionalTensor &&
+            dealloc_node_[tensor_index] != kNodeNotAssigned) {
+          dealloc_node_[tensor_index] =
+              std::max(dealloc_node_[tensor_index], last_concurrent_node_[i]);
+        }
+      }
+    }
+  }
+}
+
 TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
   // Grow the size of `allocs_` if necessary. This allows allocating temporary
   // tensors in op's `prepare` function.
@@ -344,6 +440,9 @@ TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
   alloc_node_.resize(num_tensors, kNodeNotAssigned);
   dealloc_node_.resize(num_tensors, kNodeNotAssigned);
   allocs_.resize(num_tensors);
+  if (scratch_arena_pool_ != nullptr) {
+    in_private_arena_.resize(num_tensors, false);
+  }
   // Set allocation and deallocation for temporary tensors.
   const int num_execution_nodes = graph_info_->num_execution_nodes();
   for (size_t i = first_node;
@@ -355,19 +454,39 @@ TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
       alloc_node_[tensor_index] = i;
       nodes_to_tensors_[i].insert(tensor_index);
       if (!preserve_all_tensors_) {
-        dealloc_node_[tensor_index] = i;
+        dealloc_node_[tensor_index] =
+            last_concurrent_node_.empty() ? i : last_concurrent_node_[i];
       }
     }
   }
 
+  // Plans of the whole graph made after ResetAllocations() may be cached.
+  const bool plans_whole_graph =
+      plan_cache_size_ > 0 && first_node == 0 &&
+      last_active_node_ == kLastActiveNodeUndefined &&
+      last_node + 1 >= num_execution_nodes;
+  std::vector<int> plan_key;
+  bool plan_restored = false;
+  if (plans_whole_graph) {
+    plan_key = GetPlanCacheKey();
+    plan_restored = RestoreCachedPlan(plan_key);
+  }
+
   std::vector<int32_t> tensors_allocated;
-  TF_LITE_ENSURE_STATUS(
-      CalculateAllocations(first_node, last_node, &tensors_allocated));
+  if (plan_restored) {
+    last_active_node_ = last_node;
+  } else {
+    TF_LITE_ENSURE_STATUS(
+        CalculateAllocations(first_node, last_node, &tensors_allocated));
+    if (plans_whole_graph) {
+      CachePlan(std::move(plan_key));
+    }
+  }
   bool arena_reallocated = false;
   TF_LITE_ENSURE_STATUS(Commit(&arena_reallocated));
 
   TfLiteTensor* tensors = graph_info_->tensors();
-  if (arena_reallocated) {
+  if (arena_reallocated || plan_restored) {
     for (int i = 0; i < static_cast<int>(num_tensors); ++i) {
       TF_LITE_ENSURE_STATUS(ResolveTensorAllocation(i, tensors));
     }
@@ -378,12 +497,19 @@ TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
     }
   }
 
+  // Outside of Invoke, the scratch memory is only needed to resolve the
+  // allocations.
+  if (!scratch_memory_acquired_) {
+    ReturnScratchArena();
+  }
   return kTfLiteOk;
 }
 
 TfLiteStatus ArenaPlanner::ReleaseNonPersistentMemory() {
   // Clear non-persistent arena's buffer.
+  ReturnScratchArena();
   TF_LITE_ENSURE_STATUS(arena_.ReleaseBuffer());
+  TF_LITE_ENSURE_STATUS(private_arena_.ReleaseBuffer());
   has_nonpersistent_memory_ = false;
   // Set data pointers for all non-persistent tensors to nullptr.
   TfLiteTensor* tensors = graph_info_->tensors();
@@ -399,7 +525,10 @@ TfLiteStatus ArenaPlanner::ReleaseNonPersistentMemory() {
 TfLiteStatus ArenaPlanner::AcquireNonPersistentMemory() {
   // First commit arena_ to allocate underlying buffer.
   bool reallocated;
-  TF_LITE_ENSURE_STATUS(arena_.Commit(&reallocated));
+  if (scratch_arena_pool_ == nullptr || scratch_memory_acquired_) {
+    TF_LITE_ENSURE_STATUS(CommitScratchArena(&reallocated));
+  }
+  TF_LITE_ENSURE_STATUS(private_arena_.Commit(&reallocated));
   has_nonpersistent_memory_ = true;
   // Resolve allocations for all tensors not on the persistent arena.
   TfLiteTensor* tensors = graph_info_->tensors();
@@ -416,29 +545,108 @@ bool ArenaPlanner::HasNonPersistentMemory() {
   return has_nonpersistent_memory_;
 }
 
+TfLiteStatus ArenaPlanner::AcquireScratchMemory() {
+  if (scratch_arena_pool_ == nullptr || !has_nonpersistent_memory_) {
+    return kTfLiteOk;
+  }
+  scratch_memory_acquired_ = true;
+  bool reallocated;
+  TF_LITE_ENSURE_STATUS(CommitScratchArena(&reallocated));
+  TfLiteTensor* tensors = graph_info_->tensors();
+  for (int i = 0; i < static_cast<int>(graph_info_->num_tensors()); ++i) {
+    if (tensors[i].allocation_type == kTfLiteArenaRw && !InPrivateArena(i)) {
+      TF_LITE_ENSURE_STATUS(ResolveTensorAllocation(i, tensors));
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus ArenaPlanner::ReleaseScratchMemory() {
+  scratch_memory_acquired_ = false;
+  ReturnScratchArena();
+  return kTfLiteOk;
+}
+
 void ArenaPlanner::DumpDebugInfo(const std::vector<int>& execution_plan) const {
   arena_.DumpDebugInfo("kTfLiteArenaRw Dump:", execution_plan);
   persistent_arena_.DumpDebugInfo("kTfLiteArenaRwPersistent Dump:",
                                   execution_plan);
+  if (scratch_arena_pool_ != nullptr) {
+    private_arena_.DumpDebugInfo("kTfLiteArenaRw Private Dump:",
+                                 execution_plan);
+  }
 }
 
 void ArenaPlanner::GetAllocInfo(size_t* arena_size,
                                 size_t* arena_persist_size) const {
-  *arena_size = arena_.GetBufferSize();
+  // The buffer leased from the pool, if any, is not counted.
+  *arena_size = arena_.GetBufferSize() + private_arena_.GetBufferSize();
   *arena_persist_size = persistent_arena_.GetBufferSize();
 }
 
 TfLiteStatus ArenaPlanner::Commit(bool* reallocated) {
   bool arena_reallocated, persistent_arena_reallocated;
-  TF_LITE_ENSURE_STATUS(arena_.Commit(&arena_reallocated));
+  TF_LITE_ENSURE_STATUS(CommitScratchArena(&arena_reallocated));
   has_nonpersistent_memory_ = true;
   TF_LITE_ENSURE_STATUS(
       persistent_arena_.Commit(&persistent_arena_reallocated));
   *reallocated = arena_reallocated;
   *reallocated |= persistent_arena_reallocated;
+  if (scratch_arena_pool_ != nullptr) {
+    bool private_arena_reallocated;
+    TF_LITE_ENSURE_STATUS(private_arena_.Commit(&private_arena_reallocated));
+    *reallocated |= private_arena_reallocated;
+  }
   return kTfLiteOk;
 }
 
+TfLiteStatus ArenaPlanner::CommitScratchArena(bool* reallocated) {
+  if (scratch_arena_pool_ == nullptr || leased_buffer_ != nullptr) {
+    return arena_.Commit(reallocated);
+  }
+  leased_buffer_ = scratch_arena_pool_->Lease(
+      kDefaultArenaAlignment, arena_.GetRequiredBufferSize());
+  arena_.SetExternalBuffer(leased_buffer_.get());
+  TF_LITE_ENSURE_STATUS(arena_.Commit(reallocated));
+  // The buffer is usually not the one the tensors were resolved in.
+  *reallocated = true;
+  return kTfLiteOk;
+}
+
+void ArenaPlanner::ReturnScratchArena() {
+  if (leased_buffer_ == nullptr) {
+    return;
+  }
+  arena_.SetExternalBuffer(nullptr);
+  scratch_arena_pool_->Return(std::move(leased_buffer_));
+  leased_buffer_.reset();
+  TfLiteTensor* tensors = graph_info_->tensors();
+  for (int i = 0; i < static_cast<int>(graph_info_->num_tensors()); ++i) {
+    if (tensors[i].allocation_type == kTfLiteArenaRw && !InPrivateArena(i)) {
+      tensors[i].data.raw = nullptr;
+    }
+  }
+}
+
+bool ArenaPlanner::InPrivateArena(int tensor_index) const {
+  return scratch_arena_pool_ != nullptr && tensor_index >= 0 &&
+         tensor_index < static_cast<int>(in_private_arena_.size()) &&
+         in_private_arena_[tensor_index];
+}
+
+std::vector<ArenaAllocWithUsageInterval> ArenaPlanner::GetArenaAllocs(
+    bool private_arena) const {
+  const TfLiteTensor* tensors = graph_info_->tensors();
+  std::vector<ArenaAllocWithUsageInterval> allocs;
+  for (int i = 0; i < static_cast<int>(allocs_.size()); ++i) {
+    if (tensors[i].allocation_type == kTfLiteArenaRw &&
+        InPrivateArena(i) == private_arena) {
+      allocs.push_back(allocs_[i]);
+    }
+  }
+  return allocs;
+}
+
 void ArenaPlanner::CreateTensorAllocationVector(
     std::vector<int32_t>* tensors_to_allocate) {
   const TfLiteTensor* tensors = this->graph_info_->tensors();
@@ -511,11 +719,13 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(
   }
   if (first_node < last_active_node_) {
     arena_.ResetAllocs();
+    private_arena_.ResetAllocs();
     last_active_node_ = first_node;
   } else {
     // NOMUTANTS -- This function has no impact on the results, it only makes
     // exection faster.
     arena_.PurgeActiveAllocs(first_node);
+    private_arena_.PurgeActiveAllocs(first_node);
   }
   CreateTensorAllocationVector(tensors_allocated);
   // Vector of ids of already allocated tensors, ordered by offset.
@@ -541,10 +751,12 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(
       }
     }
     if (tensor.allocation_type == kTfLiteArenaRw) {
-      TF_LITE_ENSURE_STATUS(
-          arena_.Allocate(context_, tensor_alignment_, tensor.bytes,
-                          tensor_index, alloc_node_[tensor_index],
-                          dealloc_node_[tensor_index], &allocs_[tensor_index]));
+      TF_LITE_ENSURE_STATUS(ArenaOf(tensor_index)
+                                .Allocate(context_, tensor_alignment_,
+                                          tensor.bytes, tensor_index,
+                                          alloc_node_[tensor_index],
+                                          dealloc_node_[tensor_index],
+                                          &allocs_[tensor_index]));
     }
     // Check allocs_[].size to prevent from reallocation of persistent tensors.
     // Only allocate ArenaRwPersistent tensors which own their buffer.
@@ -563,6 +775,91 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(
   return kTfLiteOk;
 }
 
+std::vector<int> ArenaPlanner::GetPlanCacheKey() const {
+  const TfLiteTensor* tensors = graph_info_->tensors();
+  std::vector<int> key;
+  for (int tensor_index : graph_info_->inputs()) {
+    if (tensor_index == kTfLiteOptionalTensor) {
+      key.push_back(-1);
+      continue;
+    }
+    const TfLiteIntArray* dims = tensors[tensor_index].dims;
+    if (dims == nullptr) {
+      key.push_back(-1);
+      continue;
+    }
+    key.push_back(dims->size);
+    key.insert(key.end(), dims->data, dims->data + dims->size);
+  }
+  return key;
+}
+
+bool ArenaPlanner::RestoreCachedPlan(const std::vector<int>& key) {
+  auto it = std::find_if(
+      plan_cache_.begin(), plan_cache_.end(),
+      [&key](const CachedPlan& plan) { return plan.key == key; });
+  if (it == plan_cache_.end()) {
+    return false;
+  }
+  // The input shapes usually determine the sizes of all the tensors, but ops
+  // may also size their outputs and temporaries from the input values.
+  const TfLiteTensor* tensors = graph_info_->tensors();
+  const size_t num_tensors = graph_info_->num_tensors();
+  if (it->tensors.size() != num_tensors) {
+    return false;
+  }
+  for (size_t i = 0; i < num_tensors; ++i) {
+    if (tensors[i].allocation_type != it->tensors[i].first ||
+        tensors[i].bytes != it->tensors[i].second) {
+      return false;
+    }
+  }
+  std::rotate(it, it + 1, plan_cache_.end());
+  const CachedPlan& plan = plan_cache_.back();
+
+  allocs_ = plan.allocs;
+  actual_tensor_id_ = plan.actual_tensor_id;
+  std::vector<ArenaAllocWithUsageInterval> arena_allocs;
+  std::vector<ArenaAllocWithUsageInterval> private_allocs;
+  std::vector<ArenaAllocWithUsageInterval> persistent_allocs;
+  for (size_t i = 0; i < num_tensors; ++i) {
+    if (tensors[i].allocation_type == kTfLiteArenaRw) {
+      (InPrivateArena(i) ? private_allocs : arena_allocs).push_back(allocs_[i]);
+    } else if (tensors[i].allocation_type == kTfLiteArenaRwPersistent) {
+      persistent_allocs.push_back(allocs_[i]);
+    }
+  }
+  arena_.RestoreAllocs(arena_allocs);
+  private_arena_.RestoreAllocs(private_allocs);
+  persistent_arena_.RestoreAllocs(persistent_allocs);
+  ++num_plan_cache_hits_;
+  return true;
+}
+
+void ArenaPlanner::CachePlan(std::vector<int> key) {
+  // Drop a plan for the same input shapes but different tensor sizes.
+  plan_cache_.erase(
+      std::remove_if(
+          plan_cache_.begin(), plan_cache_.end(),
+          [&key](const CachedPlan& plan) { return plan.key == key; }),
+      plan_cache_.end());
+  if (plan_cache_.size() >= static_cast<size_t>(plan_cache_size_)) {
+    plan_cache_.erase(plan_cache_.begin());
+  }
+
+  const TfLiteTensor* tensors = graph_info_->tensors();
+  const size_t num_tensors = graph_info_->num_tensors();
+  CachedPlan plan;
+  plan.key = std::move(key);
+  plan.tensors.reserve(num_tensors);
+  for (size_t i = 0; i < num_tensors; ++i) {
+    plan.tensors.emplace_back(tensors[i].allocation_type, tensors[i].bytes);
+  }
+  plan.allocs = allocs_;
+  plan.actual_tensor_id = actual_tensor_id_;
+  plan_cache_.push_back(std::move(plan));
+}
+
 bool AreTensorsAllocatedInSameArena(int32_t root_tensor_index,
                                     int32_t tensor_index,
                                     const TfLiteTensor* tensors) {
@@ -597,11 +894,17 @@ TfLiteStatus ArenaPlanner::ResolveTensorAllocation(int32_t tensor_index,
   }
 
   if (tensor.allocation_type == kTfLiteArenaRw) {
+    // Without a leased buffer, the tensors of `arena_` have no memory.
+    if (scratch_arena_pool_ != nullptr && leased_buffer_ == nullptr &&
+        !InPrivateArena(tensor_index)) {
+      tensor.data.raw = nullptr;
+      return kTfLiteOk;
+    }
     // Skip resolution if the size of the tensor is zero, leaving it as a
     // nullptr.
     if (allocs_[tensor_index].size != 0) {
-      return arena_.ResolveAlloc(context_, allocs_[tensor_index],
-                                 &tensor.data.raw);
+      return ArenaOf(tensor_index)
+          .ResolveAlloc(context_, allocs_[tensor_index], &tensor.data.raw);
     }
   }
   if (tensor.allocation_type == kTfLiteArenaRwPersistent) {
@@ -20,6 +20,7 @@ limitations under the License.
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/lite/core/c/common.h"
@@ -45,15 +46,30 @@ constexpr const int kDefaultArenaAlignment = 64;
 // execution. Since dynamic tensors don't have sizes until after the
 // corresponding operation is executed, this class supports incremental
 // planning.
+//
+// If the nodes may be executed concurrently, see
+// GraphInfo::node_dependencies(), a tensor only shares memory with the
+// tensors of nodes that start after all the users of the tensor finished.
+//
+// If a ScratchArenaPool is given, the intermediate and temporary tensors are
+// allocated in a buffer leased from the pool between AcquireScratchMemory()
+// and ReleaseScratchMemory(), while the graph inputs, outputs and variables
+// are allocated in an arena of their own, so that they keep their data.
 class ArenaPlanner : public MemoryPlanner {
  public:
   // Ownership of 'context' is not taken and it must remain util the
   // ArenaPlanner is destroyed. The inputs to the graph will not share
   // memory with any other tensor, effectively preserving them until the end
   // of inference.
+  // If `plan_cache_size` is positive, the allocation plans of the whole graph
+  // for up to that many distinct shapes of the graph inputs are kept, and
+  // restored when the tensors have the same sizes again instead of being
+  // recalculated.
+  // If `scratch_arena_pool` is not null, it must outlive the ArenaPlanner.
   ArenaPlanner(TfLiteContext* context, std::unique_ptr<GraphInfo> graph_info,
                bool preserve_all_tensors, int tensor_alignment,
-               int subgraph_index = 0);
+               int subgraph_index = 0, int plan_cache_size = 0,
+               ScratchArenaPool* scratch_arena_pool = nullptr);
   ~ArenaPlanner() override;
   ArenaPlanner(const ArenaPlanner&) = delete;
   ArenaPlanner& operator=(const ArenaPlanner&) = delete;
@@ -65,6 +81,8 @@ class ArenaPlanner : public MemoryPlanner {
   TfLiteStatus ReleaseNonPersistentMemory() override;
   TfLiteStatus AcquireNonPersistentMemory() override;
   bool HasNonPersistentMemory() override;
+  TfLiteStatus AcquireScratchMemory() override;
+  TfLiteStatus ReleaseScratchMemory() override;
   void DumpDebugInfo(const std::vector<int>& execution_plan) const override;
   void GetAllocInfo(size_t* arena_size,
                     size_t* arena_persist_size) const override;
@@ -72,7 +90,21 @@ class ArenaPlanner : public MemoryPlanner {
   // Returns the base arena location for a given allocation type.
   std::intptr_t BasePointer(TfLiteAllocationType type);
 
+  // Returns the number of allocation plans restored from the plan cache.
+  int num_plan_cache_hits() const { return num_plan_cache_hits_; }
+
  private:
+  // The allocation plan of the whole graph for one shape of the graph inputs.
+  struct CachedPlan {
+    // See GetPlanCacheKey().
+    std::vector<int> key;
+    // Allocation type and size of each tensor when the plan was calculated.
+    std::vector<std::pair<TfLiteAllocationType, size_t>> tensors;
+    std::vector<ArenaAllocWithUsageInterval> allocs;
+    // NOLINTNEXTLINE - absl::flat_hash_map increases binary size by 106kB.
+    std::unordered_map<int32_t, int32_t> actual_tensor_id;
+  };
+
   // Check whether the input tensor's memory may be shared the output tensor.
   // tensor_changed: true if the output tensor modifies the tensor data. For
   // example, `Reshape` doesn't modify data but Add does.
@@ -87,6 +119,28 @@ class ArenaPlanner : public MemoryPlanner {
   // tensors.
   TfLiteStatus Commit(bool* arena_reallocated);
 
+  // Commits `arena_`, in a buffer leased from `scratch_arena_pool_` if there
+  // is one and no buffer is leased yet.
+  TfLiteStatus CommitScratchArena(bool* arena_reallocated);
+
+  // Gives the leased buffer, if any, back to `scratch_arena_pool_`, and clears
+  // the data pointers of the tensors allocated in it.
+  void ReturnScratchArena();
+
+  // Returns true if the kTfLiteArenaRw tensor is allocated in
+  // `private_arena_` instead of `arena_`.
+  bool InPrivateArena(int tensor_index) const;
+
+  // Returns the arena a kTfLiteArenaRw tensor is allocated in.
+  SimpleMemoryArena& ArenaOf(int tensor_index) {
+    return InPrivateArena(tensor_index) ? private_arena_ : arena_;
+  }
+
+  // Returns the allocs of the kTfLiteArenaRw tensors in `private_arena_`, or
+  // in `arena_`.
+  std::vector<ArenaAllocWithUsageInterval> GetArenaAllocs(
+      bool private_arena) const;
+
   // Sorts tensors_to_allocate` using by the following ordering:
   // - Tensors that have lifespan through the whole model inference time go
   // first;
@@ -120,6 +174,23 @@ class ArenaPlanner : public MemoryPlanner {
   // Return the index of the tensor owing `tensor_index's` buffer.
   int FindSharedTensor(int tensor_index);
 
+  // Computes `last_concurrent_node_` from the node dependencies, and extends
+  // the lifetime of the tensors accordingly.
+  void PlanForConcurrentExecution(
+      const std::vector<std::vector<int>>& dependencies);
+
+  // Returns the shapes of the graph inputs, as the rank followed by the
+  // dimensions of each input.
+  std::vector<int> GetPlanCacheKey() const;
+
+  // Restores the cached plan for `key` if the sizes of all the tensors are
+  // the same as when it was calculated. Returns false if there is none.
+  bool RestoreCachedPlan(const std::vector<int>& key);
+
+  // Adds the current plan to the cache, evicting the least recently used plan
+  // if the cache is full.
+  void CachePlan(std::vector<int> key);
+
   TfLiteContext* context_;
   std::unique_ptr<GraphInfo> graph_info_;
 
@@ -148,6 +219,19 @@ class ArenaPlanner : public MemoryPlanner {
   // declared as kTfLiteArenaRwPersistent.
   SimpleMemoryArena persistent_arena_;
 
+  // Pool `arena_` leases its buffer from, or nullptr if it owns it.
+  ScratchArenaPool* scratch_arena_pool_;
+  std::unique_ptr<ResizableAlignedBuffer> leased_buffer_;
+  // True between AcquireScratchMemory() and ReleaseScratchMemory().
+  bool scratch_memory_acquired_ = false;
+
+  // With `scratch_arena_pool_`, the kTfLiteArenaRw tensors that must keep
+  // their data between invocations, i.e. the graph inputs, outputs and
+  // variables, are allocated in this arena instead, as flagged by
+  // `in_private_arena_`.
+  SimpleMemoryArena private_arena_;
+  std::vector<bool> in_private_arena_;
+
   // If true, then no overlapping of memory areas is done, meaning intermediate
   // tensors and temporary tensors can be queried after running.
   // (modulo running delegates)
@@ -166,6 +250,19 @@ class ArenaPlanner : public MemoryPlanner {
 
   // Store number of references to each tensor.
   std::vector<int> refcounts_;
+
+  // When nodes may be executed concurrently, the last node in the execution
+  // plan that may still run once each node started, i.e. that does not depend
+  // on it directly or indirectly. Empty if nodes are executed in order.
+  std::vector<int32_t> last_concurrent_node_;
+
+  // Maximum number of plans in `plan_cache_`, zero if plans are not cached.
+  int plan_cache_size_;
+
+  // Plans of the whole graph, the most recently used last.
+  std::vector<CachedPlan> plan_cache_;
+
+  int num_plan_cache_hits_ = 0;
 };
 
 }  // namespace tflite
@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/lite/c/c_api_types.h"
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/graph_info.h"
+#include "tensorflow/lite/util.h"
 
 namespace tflite {
 
@@ -148,6 +149,14 @@ class TestGraph {
     variables_ = variables;
   }
 
+  const std::vector<std::vector<int>>* node_dependencies() {
+    return node_dependencies_.empty() ? nullptr : &node_dependencies_;
+  }
+
+  void SetNodeDependencies(const std::vector<std::vector<int>>& dependencies) {
+    node_dependencies_ = dependencies;
+  }
+
   void Swap(TestGraph* other) {
     std::swap(nodes_, other->nodes_);
     std::swap(tensors_, other->tensors_);
@@ -163,6 +172,7 @@ class TestGraph {
   std::vector<int> inputs_;
   std::vector<int> outputs_;
   std::vector<int> variables_;
+  std::vector<std::vector<int>> node_dependencies_;
 };
 
 // The GraphInfo for a TestGraph.
@@ -189,6 +199,9 @@ class TestGraphInfo : public GraphInfo {
   const std::vector<int>& variables() const override {
     return graph_->variables();
   }
+  const std::vector<std::vector<int>>* node_dependencies() const override {
+    return graph_->node_dependencies();
+  }
 
  private:
   TestGraph* graph_;
@@ -208,12 +221,15 @@ void ReportError(TfLiteContext* context, const char* format, ...) {
 
 class ArenaPlannerTest : public ::testing::Test {
  protected:
-  void SetGraph(TestGraph* graph, bool preserve_all_tensors = false) {
+  void SetGraph(TestGraph* graph, bool preserve_all_tensors = false,
+                int plan_cache_size = 0,
+                ScratchArenaPool* scratch_arena_pool = nullptr) {
     graph_ = graph;
     context_.ReportError = ReportError;
     planner_ = std::make_unique<ArenaPlanner>(
         &context_, std::unique_ptr<GraphInfo>(new TestGraphInfo(graph)),
-        preserve_all_tensors, kTensorAlignment);
+        preserve_all_tensors, kTensorAlignment, /*subgraph_index=*/0,
+        plan_cache_size, scratch_arena_pool);
     CHECK(planner_->ResetAllocations() == kTfLiteOk);
     CHECK(planner_->PlanAllocations() == kTfLiteOk);
   }
@@ -966,6 +982,170 @@ TEST_F(ArenaPlannerTest, ModifiedGraph_DeallocateNonPersistentArena) {
   EXPECT_EQ(GetOffset(3), GetOffsetAfter(1));
 }
 
+TEST_F(ArenaPlannerTest, PlanCacheRestoresPlansOfPreviousInputShapes) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4, 5}, {3}, {}}      // Third op
+                  },
+                  {3});
+  std::vector<TfLiteTensor>& tensors = *graph.tensors();
+  IntArrayUniquePtr small_dims = BuildTfLiteArray({1, 3});
+  IntArrayUniquePtr large_dims = BuildTfLiteArray({5, 3});
+  // Resizes the inputs and scales the sizes of all the tensors with the batch.
+  auto resize = [&tensors](TfLiteIntArray* dims) {
+    for (int i = 0; i < tensors.size(); ++i) {
+      tensors[i].bytes = dims->data[0] * (i + 1) * 3;
+    }
+    tensors[0].dims = dims;
+    tensors[1].dims = dims;
+  };
+  auto offsets = [this, &tensors]() {
+    std::vector<std::ptrdiff_t> offsets;
+    for (int i = 0; i < tensors.size(); ++i) {
+      offsets.push_back(GetOffset(i));
+    }
+    return offsets;
+  };
+
+  resize(small_dims.get());
+  SetGraph(&graph, /*preserve_all_tensors=*/false, /*plan_cache_size=*/2);
+  Execute(0, graph.nodes().size() - 1);
+  const std::vector<std::ptrdiff_t> small_offsets = offsets();
+
+  resize(large_dims.get());
+  ResetAllocations();
+  Execute(0, graph.nodes().size() - 1);
+  const std::vector<std::ptrdiff_t> large_offsets = offsets();
+  EXPECT_NE(small_offsets, large_offsets);
+  EXPECT_EQ(planner_->num_plan_cache_hits(), 0);
+
+  resize(small_dims.get());
+  ResetAllocations();
+  Execute(0, graph.nodes().size() - 1);
+  EXPECT_EQ(planner_->num_plan_cache_hits(), 1);
+  EXPECT_EQ(offsets(), small_offsets);
+
+  resize(large_dims.get());
+  ResetAllocations();
+  Execute(0, graph.nodes().size() - 1);
+  EXPECT_EQ(planner_->num_plan_cache_hits(), 2);
+  EXPECT_EQ(offsets(), large_offsets);
+
+  // The same input shapes with a different tensor size are planned again.
+  tensors[4].bytes *= 2;
+  ResetAllocations();
+  Execute(0, graph.nodes().size() - 1);
+  EXPECT_EQ(planner_->num_plan_cache_hits(), 2);
+
+  // Plans are not cached for partial executions.
+  resize(small_dims.get());
+  ResetAllocations();
+  Execute(0, 0);
+  Execute(1, graph.nodes().size() - 1);
+  EXPECT_EQ(planner_->num_plan_cache_hits(), 2);
+}
+
+TEST_F(ArenaPlannerTest, ConcurrentNodesDoNotShareMemory) {
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {}},     // First op
+                      {{1}, {2}, {6}},    // Second op
+                      {{0}, {3}, {7}},    // Third op
+                      {{3}, {4}, {}},     // Fourth op
+                      {{2, 4}, {5}, {}},  // Fifth op
+                  },
+                  {5});
+  // The second and fourth ops depend on the first and third ops
+  // respectively, so they may be executed concurrently with the other ones.
+  graph.SetNodeDependencies({{}, {0}, {}, {2}, {1, 3}});
+  SetGraph(&graph);
+  Execute(0, graph.nodes().size() - 1);
+
+  auto overlap = [this](int a, int b) {
+    return GetOffset(a) < GetOffsetAfter(b) && GetOffset(b) < GetOffsetAfter(a);
+  };
+  // The tensors of each branch are live while the other branch is executed.
+  for (int a : {1, 2, 6}) {
+    for (int b : {3, 4, 7}) {
+      EXPECT_FALSE(overlap(a, b)) << a << " and " << b;
+    }
+  }
+  // Inputs are not shared with outputs in place.
+  EXPECT_FALSE(overlap(1, 2));
+  EXPECT_FALSE(overlap(3, 4));
+}
+
+TEST_F(ArenaPlannerTest, ScratchArenaPoolSharesIntermediateTensors) {
+  ScratchArenaPool pool;
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},      // First op
+                      {{2, 0}, {4, 5}, {6}},  // Second op
+                      {{4, 5}, {3}, {}}       // Third op
+                  },
+                  {3});
+  TestGraph other_graph({0, 1},
+                        {
+                            /* in, out, tmp */
+                            {{0, 1}, {2}, {}},      // First op
+                            {{2, 0}, {4, 5}, {6}},  // Second op
+                            {{4, 5}, {3}, {}}       // Third op
+                        },
+                        {3});
+  SetGraph(&graph, /*preserve_all_tensors=*/false, /*plan_cache_size=*/0,
+           &pool);
+  Execute(0, graph.nodes().size() - 1);
+  TfLiteContext other_context;
+  other_context.ReportError = ReportError;
+  ArenaPlanner other_planner(
+      &other_context,
+      std::unique_ptr<GraphInfo>(new TestGraphInfo(&other_graph)),
+      /*preserve_all_tensors=*/false, kTensorAlignment, /*subgraph_index=*/0,
+      /*plan_cache_size=*/0, &pool);
+  ASSERT_EQ(other_planner.PlanAllocations(), kTfLiteOk);
+  ASSERT_EQ(other_planner.ExecuteAllocations(0, other_graph.nodes().size() - 1),
+            kTfLiteOk);
+
+  // Outside of invocations, only the inputs and outputs have memory.
+  std::vector<TfLiteTensor>& tensors = *graph.tensors();
+  std::vector<TfLiteTensor>& other_tensors = *other_graph.tensors();
+  for (int i : {0, 1, 3}) {
+    EXPECT_FALSE(IsUnallocated(i));
+  }
+  for (int i : {2, 4, 5, 6}) {
+    EXPECT_TRUE(IsUnallocated(i));
+    EXPECT_EQ(other_tensors[i].data.raw, nullptr);
+  }
+  EXPECT_EQ(pool.num_unused_buffers(), 1);
+
+  // Planners invoked one after the other use the same buffer.
+  tensors[0].data.raw[0] = 42;
+  ASSERT_EQ(planner_->AcquireScratchMemory(), kTfLiteOk);
+  EXPECT_EQ(pool.num_unused_buffers(), 0);
+  for (int i : {2, 4, 5, 6}) {
+    EXPECT_FALSE(IsUnallocated(i));
+  }
+  char* const scratch = tensors[2].data.raw;
+  ASSERT_EQ(planner_->ReleaseScratchMemory(), kTfLiteOk);
+  EXPECT_TRUE(IsUnallocated(2));
+  EXPECT_EQ(tensors[0].data.raw[0], 42);
+  ASSERT_EQ(other_planner.AcquireScratchMemory(), kTfLiteOk);
+  EXPECT_EQ(other_tensors[2].data.raw, scratch);
+
+  // Planners invoked at the same time use different buffers.
+  ASSERT_EQ(planner_->AcquireScratchMemory(), kTfLiteOk);
+  EXPECT_NE(tensors[2].data.raw, scratch);
+  EXPECT_FALSE(IsUnallocated(2));
+  ASSERT_EQ(planner_->ReleaseScratchMemory(), kTfLiteOk);
+  ASSERT_EQ(other_planner.ReleaseScratchMemory(), kTfLiteOk);
+  EXPECT_EQ(pool.num_unused_buffers(), 2);
+}
+
 TEST_F(ArenaPlannerTest, ComplexGraph) {
   TestGraph graph({0},
                   {
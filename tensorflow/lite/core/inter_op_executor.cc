@@ -0,0 +1,140 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/core/inter_op_executor.h"
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+
+namespace tflite {
+
+InterOpExecutor::InterOpExecutor(int num_threads) {
+  for (int i = 1; i < num_threads; ++i) {
+    threads_.emplace_back([this, i] { ThreadLoop(i); });
+  }
+}
+
+InterOpExecutor::~InterOpExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+  }
+  cond_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+TfLiteStatus InterOpExecutor::Run(
+    const std::vector<std::vector<int>>& dependencies,
+    const NodeFunction& run_node, const std::vector<bool>& run_on_caller) {
+  const int num_nodes = static_cast<int>(dependencies.size());
+  std::unique_lock<std::mutex> lock(mutex_);
+  run_node_ = &run_node;
+  run_on_caller_ = &run_on_caller;
+  dependents_.assign(num_nodes, {});
+  num_pending_dependencies_.assign(num_nodes, 0);
+  ready_nodes_.clear();
+  caller_ready_nodes_.clear();
+  for (int i = 0; i < num_nodes; ++i) {
+    num_pending_dependencies_[i] = static_cast<int>(dependencies[i].size());
+    for (int dependency : dependencies[i]) {
+      dependents_[dependency].push_back(i);
+    }
+    if (dependencies[i].empty()) {
+      AddReadyNode(i);
+    }
+  }
+  num_remaining_ = num_nodes;
+  num_running_ = 0;
+  status_ = kTfLiteOk;
+  ++run_id_;
+  cond_.notify_all();
+
+  ExecuteNodes(/*thread_index=*/0, &lock);
+  // The other threads may still hold a reference to `run_node`.
+  cond_.wait(lock, [this] { return num_active_threads_ == 0; });
+  run_node_ = nullptr;
+  run_on_caller_ = nullptr;
+  return status_;
+}
+
+void InterOpExecutor::AddReadyNode(int node) {
+  if (node < static_cast<int>(run_on_caller_->size()) &&
+      (*run_on_caller_)[node]) {
+    caller_ready_nodes_.push_back(node);
+  } else {
+    ready_nodes_.push_back(node);
+  }
+}
+
+void InterOpExecutor::ThreadLoop(int thread_index) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  // Runs may start before the thread, which then joins the latest one.
+  int64_t last_run_id = 0;
+  while (true) {
+    cond_.wait(lock, [&] { return shutdown_ || run_id_ != last_run_id; });
+    if (shutdown_) return;
+    last_run_id = run_id_;
+    ExecuteNodes(thread_index, &lock);
+  }
+}
+
+void InterOpExecutor::ExecuteNodes(int thread_index,
+                                   std::unique_lock<std::mutex>* lock) {
+  ++num_active_threads_;
+  while (true) {
+    cond_.wait(*lock, [this, thread_index] {
+      return HasReadyNode(thread_index) || RunFinished();
+    });
+    if (RunFinished()) break;
+    // The calling thread executes first the nodes no other thread can.
+    std::deque<int>& nodes =
+        thread_index == 0 && !caller_ready_nodes_.empty() ? caller_ready_nodes_
+                                                          : ready_nodes_;
+    const int node = nodes.front();
+    nodes.pop_front();
+    ++num_running_;
+    lock->unlock();
+    const TfLiteStatus status = (*run_node_)(node, thread_index);
+    lock->lock();
+    --num_running_;
+    --num_remaining_;
+    if (status != kTfLiteOk) {
+      if (status_ == kTfLiteOk) status_ = status;
+      ready_nodes_.clear();
+      caller_ready_nodes_.clear();
+    } else if (status_ == kTfLiteOk) {
+      for (int dependent : dependents_[node]) {
+        if (--num_pending_dependencies_[dependent] == 0) {
+          AddReadyNode(dependent);
+        }
+      }
+    }
+    if (!ready_nodes_.empty() || !caller_ready_nodes_.empty() ||
+        RunFinished()) {
+      cond_.notify_all();
+    }
+  }
+  --num_active_threads_;
+  if (num_active_threads_ == 0) {
+    cond_.notify_all();
+  }
+}
+
+}  // namespace tflite
@@ -0,0 +1,101 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_CORE_INTER_OP_EXECUTOR_H_
+#define TENSORFLOW_LITE_CORE_INTER_OP_EXECUTOR_H_
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+
+namespace tflite {
+
+// Executes the nodes of a graph concurrently on a fixed set of threads, in any
+// order that respects the dependencies between them.
+//
+// The thread calling Run() executes nodes too, so that a single thread only
+// has to wait for the nodes executed by the other ones.
+class InterOpExecutor {
+ public:
+  // Called to execute `node` on the thread with the given index, which is 0
+  // for the thread calling Run().
+  using NodeFunction =
+      std::function<TfLiteStatus(int node, int thread_index)>;
+
+  // `num_threads` includes the thread calling Run(), so that `num_threads - 1`
+  // threads are started.
+  explicit InterOpExecutor(int num_threads);
+  ~InterOpExecutor();
+
+  InterOpExecutor(const InterOpExecutor&) = delete;
+  InterOpExecutor& operator=(const InterOpExecutor&) = delete;
+
+  int num_threads() const { return static_cast<int>(threads_.size()) + 1; }
+
+  // Executes `run_node` for all the nodes, where `dependencies[i]` holds the
+  // nodes that must have finished before node `i` starts, and returns once
+  // they have all finished. The nodes `i` for which `run_on_caller[i]` is true
+  // are only executed by the thread calling Run(). If a node fails, the nodes
+  // that were not started yet are skipped, and the status of the first
+  // failure is returned.
+  // Must not be called concurrently.
+  TfLiteStatus Run(const std::vector<std::vector<int>>& dependencies,
+                   const NodeFunction& run_node,
+                   const std::vector<bool>& run_on_caller = {});
+
+ private:
+  void ThreadLoop(int thread_index);
+  // Executes ready nodes until all the nodes of the current run finished.
+  void ExecuteNodes(int thread_index, std::unique_lock<std::mutex>* lock);
+  // Adds `node`, whose dependencies all finished, to the ready nodes.
+  void AddReadyNode(int node);
+  bool HasReadyNode(int thread_index) const {
+    return !ready_nodes_.empty() ||
+           (thread_index == 0 && !caller_ready_nodes_.empty());
+  }
+  bool RunFinished() const {
+    return num_remaining_ == 0 || (status_ != kTfLiteOk && num_running_ == 0);
+  }
+
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  // Incremented by every Run(), to wake up the threads.
+  int64_t run_id_ = 0;
+  bool shutdown_ = false;
+  // The state of the current run.
+  const NodeFunction* run_node_ = nullptr;
+  std::vector<std::vector<int>> dependents_;
+  std::vector<int> num_pending_dependencies_;
+  const std::vector<bool>* run_on_caller_ = nullptr;
+  std::deque<int> ready_nodes_;
+  // The ready nodes that must be executed by the thread calling Run().
+  std::deque<int> caller_ready_nodes_;
+  int num_remaining_ = 0;
+  int num_running_ = 0;
+  // Number of threads in ExecuteNodes().
+  int num_active_threads_ = 0;
+  TfLiteStatus status_ = kTfLiteOk;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_CORE_INTER_OP_EXECUTOR_H_
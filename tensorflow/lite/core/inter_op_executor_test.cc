@@ -0,0 +1,143 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/core/inter_op_executor.h"
+
+#include <atomic>
+#include <mutex>  // NOLINT(build/c++11)
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/c/common.h"
+
+namespace tflite {
+namespace {
+
+TEST(InterOpExecutorTest, RunsNodesAfterTheirDependencies) {
+  InterOpExecutor executor(/*num_threads=*/4);
+  EXPECT_EQ(executor.num_threads(), 4);
+  // Two branches 1 -> 3 and 2 -> 4 between nodes 0 and 5.
+  const std::vector<std::vector<int>> dependencies = {{},  {0}, {0},
+                                                      {1}, {2}, {3, 4}};
+  for (int run = 0; run < 10; ++run) {
+    std::mutex mutex;
+    std::vector<int> order;
+    ASSERT_EQ(executor.Run(dependencies,
+                           [&](int node, int thread_index) {
+                             EXPECT_GE(thread_index, 0);
+                             EXPECT_LT(thread_index, 4);
+                             std::lock_guard<std::mutex> lock(mutex);
+                             order.push_back(node);
+                             return kTfLiteOk;
+                           }),
+              kTfLiteOk);
+    ASSERT_EQ(order.size(), dependencies.size());
+    std::vector<int> position(order.size());
+    for (size_t i = 0; i < order.size(); ++i) position[order[i]] = i;
+    for (size_t node = 0; node < dependencies.size(); ++node) {
+      for (int dependency : dependencies[node]) {
+        EXPECT_LT(position[dependency], position[node]);
+      }
+    }
+  }
+}
+
+TEST(InterOpExecutorTest, RunsIndependentNodesConcurrently) {
+  InterOpExecutor executor(/*num_threads=*/2);
+  // The two nodes wait for each other, which only finishes if they are run
+  // on different threads.
+  std::atomic<int> num_started(0);
+  std::mutex mutex;
+  std::set<int> thread_indices;
+  EXPECT_EQ(executor.Run({{}, {}},
+                         [&](int node, int thread_index) {
+                           ++num_started;
+                           while (num_started < 2) {
+                           }
+                           std::lock_guard<std::mutex> lock(mutex);
+                           thread_indices.insert(thread_index);
+                           return kTfLiteOk;
+                         }),
+            kTfLiteOk);
+  EXPECT_EQ(thread_indices, (std::set<int>{0, 1}));
+}
+
+TEST(InterOpExecutorTest, RunsNodesOnCallerThread) {
+  InterOpExecutor executor(/*num_threads=*/4);
+  // Nodes 1 and 3 must run on the calling thread, even though the other
+  // threads are idle when they are ready.
+  const std::vector<std::vector<int>> dependencies = {{}, {}, {}, {0, 1, 2}};
+  const std::vector<bool> run_on_caller = {false, true, false, true};
+  for (int run = 0; run < 10; ++run) {
+    std::atomic<int> num_run(0);
+    EXPECT_EQ(executor.Run(
+                  dependencies,
+                  [&](int node, int thread_index) {
+                    if (run_on_caller[node]) EXPECT_EQ(thread_index, 0);
+                    ++num_run;
+                    return kTfLiteOk;
+                  },
+                  run_on_caller),
+              kTfLiteOk);
+    EXPECT_EQ(num_run, 4);
+  }
+}
+
+TEST(InterOpExecutorTest, SingleThreadRunsNodesInOrder) {
+  InterOpExecutor executor(/*num_threads=*/1);
+  std::vector<int> order;
+  EXPECT_EQ(executor.Run({{}, {0}, {1}},
+                         [&](int node, int thread_index) {
+                           EXPECT_EQ(thread_index, 0);
+                           order.push_back(node);
+                           return kTfLiteOk;
+                         }),
+            kTfLiteOk);
+  EXPECT_EQ(order, (std::vector<int>{0, 1, 2}));
+}
+
+TEST(InterOpExecutorTest, SkipsNodesAfterAFailure) {
+  InterOpExecutor executor(/*num_threads=*/3);
+  std::atomic<int> num_run(0);
+  EXPECT_EQ(executor.Run({{}, {0}, {1}},
+                         [&](int node, int thread_index) {
+                           ++num_run;
+                           return node == 1 ? kTfLiteError : kTfLiteOk;
+                         }),
+            kTfLiteError);
+  EXPECT_EQ(num_run, 2);
+
+  // The executor can still be used after a failure.
+  num_run = 0;
+  EXPECT_EQ(executor.Run({{}, {0}, {1}},
+                         [&](int node, int thread_index) {
+                           ++num_run;
+                           return kTfLiteOk;
+                         }),
+            kTfLiteOk);
+  EXPECT_EQ(num_run, 3);
+}
+
+TEST(InterOpExecutorTest, EmptyGraph) {
+  InterOpExecutor executor(/*num_threads=*/2);
+  EXPECT_EQ(executor.Run({},
+                         [](int node, int thread_index) {
+                           return kTfLiteError;
+                         }),
+            kTfLiteOk);
+}
+
+}  // namespace
+}  // namespace tflite
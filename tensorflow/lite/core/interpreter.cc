@@ -316,6 +316,7 @@ TfLiteStatus Interpreter::SetNumThreads(int num_threads) {
   num_threads = num_threads == 0 ? 1 : num_threads;
   for (auto& subgraph : subgraphs_) {
     subgraph->context()->recommended_num_threads = num_threads;
+    subgraph->UpdateInterOpCpuBackendContexts();
   }
 
   for (int i = 0; i < kTfLiteMaxExternalContexts; ++i) {
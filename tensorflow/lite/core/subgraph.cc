@@ -40,8 +40,10 @@ limitations under the License.
 #include "tensorflow/lite/core/api/tensor_utils.h"
 #include "tensorflow/lite/core/c/c_api_types.h"
 #include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/inter_op_executor.h"
 #include "tensorflow/lite/experimental/resource/initialization_status.h"
 #include "tensorflow/lite/experimental/resource/resource_base.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
 #include "tensorflow/lite/graph_info.h"
 #include "tensorflow/lite/logger.h"
 #include "tensorflow/lite/memory_planner.h"
@@ -193,6 +195,10 @@ TfLiteStatus VerifyCustomAllocationForTensor(
   return kTfLiteOk;
 }
 
+// The CPU backend context of the kernels invoked by the current thread, if it
+// is an inter-op thread other than the one calling Invoke().
+thread_local TfLiteExternalContext* inter_op_cpu_backend_context = nullptr;
+
 }  // namespace
 
 // A trivial implementation of GraphInfo around the Interpreter.
@@ -202,7 +208,10 @@ TfLiteStatus VerifyCustomAllocationForTensor(
 // indices.
 class InterpreterInfo : public GraphInfo {
  public:
-  explicit InterpreterInfo(Subgraph* subgraph) : subgraph_(subgraph) {}
+  explicit InterpreterInfo(
+      Subgraph* subgraph,
+      const std::vector<std::vector<int>>* node_dependencies = nullptr)
+      : subgraph_(subgraph), node_dependencies_(node_dependencies) {}
 
   size_t num_tensors() const override { return subgraph_->tensors_size(); }
 
@@ -244,8 +253,16 @@ class InterpreterInfo : public GraphInfo {
     return subgraph_->variables();
   }
 
+  const std::vector<std::vector<int>>* node_dependencies() const override {
+    if (node_dependencies_ == nullptr || node_dependencies_->empty()) {
+      return nullptr;
+    }
+    return node_dependencies_;
+  }
+
  public:
   Subgraph* subgraph_;
+  const std::vector<std::vector<int>>* node_dependencies_;
 };
 
 Subgraph::Subgraph(ErrorReporter* error_reporter,
@@ -618,6 +635,9 @@ TfLiteStatus Subgraph::ReplaceNodeSubsetsWithDelegateKernels(
 
 TfLiteExternalContext* Subgraph::GetExternalContext(
     TfLiteExternalContextType type) {
+  if (type == kTfLiteCpuBackendContext && inter_op_cpu_backend_context) {
+    return inter_op_cpu_backend_context;
+  }
   if (static_cast<int>(type) >= 0 && type < kTfLiteMaxExternalContexts) {
     return external_contexts_[type];
   }
@@ -1563,8 +1583,10 @@ TfLiteStatus Subgraph::PrepareOpsAndTensors() {
 #else
     memory_planner_ = std::make_unique<ArenaPlanner>(
         &context_, CreateGraphInfo(), ShouldPreserveAllTensors(),
-        kDefaultTensorAlignment, subgraph_index_);
+        kDefaultTensorAlignment, subgraph_index_, MemoryPlanCacheSize(),
+        GetScratchArenaPool());
 #endif
+    UpdateNodeDependencies();
     memory_planner_->PlanAllocations();
   }
 
@@ -1618,7 +1640,19 @@ TfLiteStatus Subgraph::RemoveUnusedInputs() {
 }
 
 TfLiteStatus Subgraph::Invoke() {
+  // The memory of the intermediate tensors may only be held during Invoke.
+  const bool holds_scratch_memory =
+      memory_planner_ != nullptr && state_ != kStateUninvokable;
+  if (holds_scratch_memory &&
+      memory_planner_->AcquireScratchMemory() != kTfLiteOk) {
+    ReportError("Failed to acquire the memory of the intermediate tensors.");
+    return kTfLiteError;
+  }
   auto status = InvokeImpl();
+  if (holds_scratch_memory &&
+      memory_planner_->ReleaseScratchMemory() != kTfLiteOk) {
+    status = kTfLiteError;
+  }
   telemetry::TelemetryReportEvent(&context_, "Invoke", status);
   return status;
 }
@@ -1636,6 +1670,9 @@ TfLiteStatus Subgraph::InvokeImpl() {
     ReportError("Non-persistent memory is not available.");
     return kTfLiteError;
   }
+  if (CanInvokeNodesConcurrently()) {
+    return InvokeNodesConcurrently();
+  }
   TFLITE_SCOPED_TAGGED_DEFAULT_PROFILE(profiler_.get(), "Invoke");
 #ifdef TF_LITE_TENSORFLOW_PROFILER
   tensorflow::profiler::TraceMe* trace_subgraph =
@@ -1676,52 +1713,12 @@ TfLiteStatus Subgraph::InvokeImpl() {
     TFLITE_SCOPED_TAGGED_OPERATOR_PROFILE(
         profile_op ? profiler_.get() : nullptr, op_name, node_index);
 
-    for (int i = 0; i < node.inputs->size; ++i) {
-      int tensor_index = node.inputs->data[i];
-      if (tensor_index == kTfLiteOptionalTensor) {
-        continue;
-      }
-      TfLiteTensor* tensor = &tensors_[tensor_index];
-      if (tensor->delegate && tensor->delegate != node.delegate &&
-          tensor->data_is_stale) {
-        TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
-      }
-      if (tensor->data.raw == nullptr && tensor->bytes > 0) {
-        if (registration.builtin_code == kTfLiteBuiltinReshape && i == 1 &&
-            tensor->dims->size != 1) {
-          // In general, having a tensor here with no buffer will be an error.
-          // However, for the reshape operator, the second input tensor is
-          // sometimes only used for the shape, not for the data. Thus, null
-          // buffer is ok in this situation.
-          // The situation where null buffer is not ok for reshape operator is
-          // only when there are 2 inputs given to the node and the one
-          // corresponding to the shape (i == 1) is a vector that contains all
-          // dimensions. See `GetOutputShape()` function in
-          // `tensorflow/lite/kernels/reshape.cc`
-          continue;
-        } else {
-          // In all other cases, we need to return an error as otherwise we will
-          // trigger a null pointer dereference (likely).
-          ReportError("Input tensor %d lacks data", tensor_index);
-          return kTfLiteError;
-        }
-      }
-    }
+    TF_LITE_ENSURE_STATUS(EnsureNodeInputsAreReadable(node, registration));
     // Allocate dynamic tensors which memory is required to be allocated
     // before executing the node.
     MayAllocateOpOutput(&node);
 
-    if (check_cancelled_func_ != nullptr &&
-        check_cancelled_func_(cancellation_data_)) {
-      ReportError("Client requested cancel during Invoke()");
-      return kTfLiteError;
-    }
-
-    if (continue_invocation_ && !continue_invocation_->test_and_set()) {
-      // `Cancel` is called and cancellation flag is flipped.
-      ReportError("Client requested cancel during Invoke()");
-      return kTfLiteCancelled;
-    }
+    TF_LITE_ENSURE_STATUS(CheckInvocationCancelled());
 
     EnsureTensorsVectorCapacity();
     tensor_resized_since_op_invoke_ = false;
@@ -1763,6 +1760,131 @@ TfLiteStatus Subgraph::InvokeImpl() {
   return status;
 }
 
+TfLiteStatus Subgraph::EnsureNodeInputsAreReadable(
+    const TfLiteNode& node, const TfLiteRegistration& registration) {
+  for (int i = 0; i < node.inputs->size; ++i) {
+    int tensor_index = node.inputs->data[i];
+    if (tensor_index == kTfLiteOptionalTensor) {
+      continue;
+    }
+    TfLiteTensor* tensor = &tensors_[tensor_index];
+    if (tensor->delegate && tensor->delegate != node.delegate &&
+        tensor->data_is_stale) {
+      TF_LITE_ENSURE_STATUS(EnsureTensorDataIsReadable(tensor_index));
+    }
+    if (tensor->data.raw == nullptr && tensor->bytes > 0) {
+      if (registration.builtin_code == kTfLiteBuiltinReshape && i == 1 &&
+          tensor->dims->size != 1) {
+        // In general, having a tensor here with no buffer will be an error.
+        // However, for the reshape operator, the second input tensor is
+        // sometimes only used for the shape, not for the data. Thus, null
+        // buffer is ok in this situation.
+        // The situation where null buffer is not ok for reshape operator is
+        // only when there are 2 inputs given to the node and the one
+        // corresponding to the shape (i == 1) is a vector that contains all
+        // dimensions. See `GetOutputShape()` function in
+        // `tensorflow/lite/kernels/reshape.cc`
+        continue;
+      } else {
+        // In all other cases, we need to return an error as otherwise we will
+        // trigger a null pointer dereference (likely).
+        ReportError("Input tensor %d lacks data", tensor_index);
+        return kTfLiteError;
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus Subgraph::CheckInvocationCancelled() {
+  if (check_cancelled_func_ != nullptr &&
+      check_cancelled_func_(cancellation_data_)) {
+    ReportError("Client requested cancel during Invoke()");
+    return kTfLiteError;
+  }
+
+  if (continue_invocation_ && !continue_invocation_->test_and_set()) {
+    // `Cancel` is called and cancellation flag is flipped.
+    ReportError("Client requested cancel during Invoke()");
+    return kTfLiteCancelled;
+  }
+  return kTfLiteOk;
+}
+
+void Subgraph::UpdateNodeDependencies() {
+  node_dependencies_.clear();
+  node_must_run_alone_.clear();
+  node_dependencies_plan_.clear();
+  const int num_threads = NumInterOpThreads();
+  if (num_threads <= 1) return;
+  node_dependencies_ = GetNodeDependencies(
+      CreateGraphInfo().get(), control_edges_, &node_must_run_alone_);
+  node_dependencies_plan_ = execution_plan_;
+  if (inter_op_executor_ && inter_op_executor_->num_threads() == num_threads) {
+    return;
+  }
+  inter_op_executor_ = std::make_unique<InterOpExecutor>(num_threads);
+  inter_op_cpu_backend_contexts_.clear();
+  for (int i = 1; i < num_threads; ++i) {
+    inter_op_cpu_backend_contexts_.push_back(
+        std::make_unique<ExternalCpuBackendContext>());
+  }
+  UpdateInterOpCpuBackendContexts();
+}
+
+void Subgraph::UpdateInterOpCpuBackendContexts() {
+  if (!inter_op_executor_) return;
+  // The intra-op threads of the interpreter are shared by the kernels of the
+  // threads other than the calling one.
+  const int num_intra_op_threads = std::max(
+      1, context_.recommended_num_threads / inter_op_executor_->num_threads());
+  for (auto& cpu_backend_context : inter_op_cpu_backend_contexts_) {
+    cpu_backend_context->set_max_num_threads(num_intra_op_threads);
+  }
+}
+
+bool Subgraph::CanInvokeNodesConcurrently() const {
+  // The profiler and the release of dynamic tensors expect the nodes to be
+  // invoked in order, and a node resizing a dynamic tensor requires the
+  // following ones to be prepared again before they are invoked.
+  return inter_op_executor_ && !profiler_ && !has_dynamic_tensors_ &&
+         next_execution_plan_index_to_prepare_ ==
+             static_cast<int>(execution_plan_.size()) &&
+         node_dependencies_plan_ == execution_plan_;
+}
+
+TfLiteStatus Subgraph::InvokeNodesConcurrently() {
+  auto run_node = [this](int execution_plan_index, int thread_index) {
+    int node_index = execution_plan_[execution_plan_index];
+    TfLiteNode& node = nodes_and_registration_[node_index].first;
+    const TfLiteRegistration& registration =
+        nodes_and_registration_[node_index].second;
+    TF_LITE_ENSURE_STATUS(EnsureNodeInputsAreReadable(node, registration));
+    TF_LITE_ENSURE_STATUS(CheckInvocationCancelled());
+
+    ExternalCpuBackendContext* cpu_backend_context = nullptr;
+    if (thread_index > 0) {
+      cpu_backend_context =
+          inter_op_cpu_backend_contexts_[thread_index - 1].get();
+    }
+    TfLiteExternalContext* saved_context = inter_op_cpu_backend_context;
+    inter_op_cpu_backend_context = cpu_backend_context;
+    TfLiteStatus status = OpInvoke(registration, &node);
+    inter_op_cpu_backend_context = saved_context;
+    if (status != kTfLiteOk) {
+      auto err = ReportOpError(&context_, node, registration, node_index,
+                               "failed to invoke");
+      return status == kTfLiteCancelled ? status : err;
+    }
+    return kTfLiteOk;
+  };
+  EnsureTensorsVectorCapacity();
+  // Nodes that must run alone, e.g. delegated nodes, may rely on state of the
+  // calling thread.
+  return inter_op_executor_->Run(node_dependencies_, run_node,
+                                 node_must_run_alone_);
+}
+
 TfLiteStatus Subgraph::ResizeTensor(TfLiteContext* context,
                                     TfLiteTensor* tensor,
                                     TfLiteIntArray* new_size) {
@@ -2251,6 +2373,7 @@ void Subgraph::EnsureTensorsVectorCapacity() {
 TfLiteStatus Subgraph::EnsureMemoryAllocations() {
   if (memory_planner_) {
     state_ = kStateUninvokable;
+    UpdateNodeDependencies();
     TF_LITE_ENSURE_OK(&context_, memory_planner_->PlanAllocations());
   }
   TF_LITE_ENSURE_OK(&context_, AllocateTensors());
@@ -2439,7 +2562,8 @@ void Subgraph::GetMemoryAllocInfo(SubgraphAllocInfo* alloc_info) const {
 }
 
 std::unique_ptr<GraphInfo> Subgraph::CreateGraphInfo() {
-  return std::unique_ptr<GraphInfo>(new InterpreterInfo(this));
+  return std::unique_ptr<GraphInfo>(
+      new InterpreterInfo(this, &node_dependencies_));
 }
 
 void Subgraph::InitializeTensorReleaseMap() {
@@ -36,9 +36,11 @@ limitations under the License.
 #include "tensorflow/lite/core/api/op_resolver.h"
 #include "tensorflow/lite/core/api/profiler.h"
 #include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/inter_op_executor.h"
 #include "tensorflow/lite/core/macros.h"
 #include "tensorflow/lite/experimental/resource/initialization_status.h"
 #include "tensorflow/lite/experimental/resource/resource_base.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
 #include "tensorflow/lite/graph_info.h"
 #include "tensorflow/lite/interpreter_options.h"
 #include "tensorflow/lite/memory_planner.h"
@@ -482,6 +484,29 @@ class Subgraph {
     return (options_ && (options_->GetDynamicAllocationForLargeTensors() > 0));
   }
 
+  // WARNING: This is an experimental API and subject to change.
+  // Number of memory plans kept by the memory planner for distinct input
+  // shapes, zero if they are not cached.
+  int MemoryPlanCacheSize() const {
+    return options_ ? options_->GetMemoryPlanCacheSize() : 0;
+  }
+
+  // WARNING: This is an experimental API and subject to change.
+  // Number of threads executing the independent nodes of the subgraph
+  // concurrently, 1 if the nodes are executed in order.
+  int NumInterOpThreads() const {
+    return options_ ? options_->GetNumInterOpThreads() : 1;
+  }
+
+  // WARNING: This is an experimental API and subject to change.
+  // Pool the memory of the intermediate tensors is leased from while the
+  // subgraph is invoked, nullptr if the memory planner owns it.
+  ScratchArenaPool* GetScratchArenaPool() const {
+    return options_ && !ShouldPreserveAllTensors()
+               ? options_->GetScratchArenaPool()
+               : nullptr;
+  }
+
   // WARNING: This is an experimental API and subject to change.
   // Remove unused inputs of the subgraph. It checks usage of inputs and mark it
   // as kTfLiteOptionalTensor if the input is not used in graph execution.
@@ -728,6 +753,33 @@ class Subgraph {
   // Does not report invoke status through profiler.
   TfLiteStatus InvokeImpl();
 
+  // Computes the dependencies between the nodes of the execution plan, which
+  // are used to plan the memory of nodes executed concurrently, when more
+  // than one inter-op thread is requested.
+  void UpdateNodeDependencies();
+
+  // Returns true if the nodes of the execution plan can be executed
+  // concurrently by InvokeNodesConcurrently().
+  bool CanInvokeNodesConcurrently() const;
+
+  // Invokes the nodes of the execution plan on the inter-op threads, in any
+  // order that respects `node_dependencies_`.
+  TfLiteStatus InvokeNodesConcurrently();
+
+  // Divides the recommended number of threads of the context among the CPU
+  // backend contexts of the inter-op threads. Called when they are created
+  // and when the recommended number of threads changes.
+  void UpdateInterOpCpuBackendContexts();
+
+  // Makes the data of the inputs of `node` readable by its kernel, and
+  // reports an error if an input has no data.
+  TfLiteStatus EnsureNodeInputsAreReadable(
+      const TfLiteNode& node, const TfLiteRegistration& registration);
+
+  // Returns an error status if the client requested the current invocation
+  // to be cancelled.
+  TfLiteStatus CheckInvocationCancelled();
+
   // Allow a delegate to look at the graph and modify the graph to handle
   // parts of the graph themselves. After this is called, the graph may
   // contain new nodes that replace 1 more nodes.
@@ -1088,6 +1140,20 @@ class Subgraph {
 
   std::unique_ptr<MemoryPlanner> memory_planner_;
 
+  // The nodes each node of `node_dependencies_plan_` depends on, by execution
+  // plan index, and whether it must run alone on the thread calling Invoke().
+  // Empty unless the nodes may be executed concurrently.
+  std::vector<std::vector<int>> node_dependencies_;
+  std::vector<bool> node_must_run_alone_;
+  std::vector<int> node_dependencies_plan_;
+
+  // Executes the nodes concurrently, if more than one inter-op thread is
+  // requested, with a CPU backend context for each thread other than the
+  // calling one, whose kernels use the context of the interpreter.
+  std::unique_ptr<InterOpExecutor> inter_op_executor_;
+  std::vector<std::unique_ptr<ExternalCpuBackendContext>>
+      inter_op_cpu_backend_contexts_;
+
   // Maps tensor index to custom allocation for all applicable tensors.
   std::map<int, TfLiteCustomAllocation> custom_allocations_;
 
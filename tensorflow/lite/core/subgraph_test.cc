@@ -27,6 +27,7 @@ limitations under the License.
 #include "absl/log/check.h"
 #include "tensorflow/lite/c/c_api_types.h"
 #include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/simple_memory_arena.h"
 #include "tensorflow/lite/stderr_reporter.h"
 #include "tensorflow/lite/util.h"
 
@@ -124,6 +125,85 @@ TEST(MarkSubgraphAsDelegationSkippable, MarkSubgraphAsDelegationSkippable) {
   ASSERT_TRUE(subgraphs[1]->IsDelegationSkippable());
 }
 
+TEST(InterOpThreads, InvokesIndependentNodesConcurrently) {
+  Interpreter interpreter;
+  InterpreterOptions options;
+  options.SetNumInterOpThreads(2);
+  ASSERT_EQ(interpreter.ApplyOptions(&options), kTfLiteOk);
+  auto& subgraph = interpreter.primary_subgraph();
+  ASSERT_EQ(subgraph.NumInterOpThreads(), 2);
+  subgraph.AddTensors(5);
+  subgraph.SetInputs({0, 1});
+  subgraph.SetOutputs({3, 4});
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ(subgraph.SetTensorParametersReadWrite(i, kTfLiteFloat32, "", {3},
+                                                    TfLiteQuantization()),
+              kTfLiteOk);
+  }
+  // The second input is negated while the first one is negated twice.
+  TfLiteRegistration* neg_op = tflite::ops::builtin::Register_NEG();
+  subgraph.AddNodeWithParameters({0}, {2}, {}, nullptr, 0, nullptr, neg_op);
+  subgraph.AddNodeWithParameters({2}, {3}, {}, nullptr, 0, nullptr, neg_op);
+  subgraph.AddNodeWithParameters({1}, {4}, {}, nullptr, 0, nullptr, neg_op);
+  ASSERT_EQ(subgraph.AllocateTensors(), kTfLiteOk);
+
+  for (int invocation = 0; invocation < 3; ++invocation) {
+    float* input0 = subgraph.tensor(0)->data.f;
+    float* input1 = subgraph.tensor(1)->data.f;
+    for (int i = 0; i < 3; ++i) {
+      input0[i] = invocation + i;
+      input1[i] = invocation - i;
+    }
+    ASSERT_EQ(subgraph.Invoke(), kTfLiteOk);
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_EQ(subgraph.tensor(3)->data.f[i], input0[i]);
+      EXPECT_EQ(subgraph.tensor(4)->data.f[i], -input1[i]);
+    }
+  }
+}
+
+TEST(ScratchArenaPool, InterpretersShareIntermediateTensorMemory) {
+  ScratchArenaPool pool;
+  InterpreterOptions options;
+  options.SetScratchArenaPool(&pool);
+  Interpreter interpreters[2];
+  for (Interpreter& interpreter : interpreters) {
+    ASSERT_EQ(interpreter.ApplyOptions(&options), kTfLiteOk);
+    auto& subgraph = interpreter.primary_subgraph();
+    ASSERT_EQ(subgraph.GetScratchArenaPool(), &pool);
+    subgraph.AddTensors(3);
+    subgraph.SetInputs({0});
+    subgraph.SetOutputs({2});
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_EQ(subgraph.SetTensorParametersReadWrite(
+                    i, kTfLiteFloat32, "", {3}, TfLiteQuantization()),
+                kTfLiteOk);
+    }
+    TfLiteRegistration* neg_op = tflite::ops::builtin::Register_NEG();
+    subgraph.AddNodeWithParameters({0}, {1}, {}, nullptr, 0, nullptr, neg_op);
+    subgraph.AddNodeWithParameters({1}, {2}, {}, nullptr, 0, nullptr, neg_op);
+    ASSERT_EQ(subgraph.AllocateTensors(), kTfLiteOk);
+  }
+
+  for (int invocation = 0; invocation < 3; ++invocation) {
+    for (Interpreter& interpreter : interpreters) {
+      auto& subgraph = interpreter.primary_subgraph();
+      float* input = subgraph.tensor(0)->data.f;
+      for (int i = 0; i < 3; ++i) {
+        input[i] = invocation + i;
+      }
+      ASSERT_EQ(subgraph.Invoke(), kTfLiteOk);
+      for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(subgraph.tensor(2)->data.f[i], input[i]);
+      }
+      // The intermediate tensor only has memory during Invoke.
+      EXPECT_EQ(subgraph.tensor(1)->data.raw, nullptr);
+    }
+  }
+  // The interpreters were invoked one at a time.
+  EXPECT_EQ(pool.num_unused_buffers(), 1);
+}
+
 // Helper to get the minimal buffer size to allocate for a buffer of given
 // shape.
 size_t BytesFor(const TfLiteType type, const int* const data,
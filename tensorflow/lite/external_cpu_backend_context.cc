@@ -22,10 +22,14 @@ namespace {
 TfLiteStatus RefreshExternalCpuBackendContext(TfLiteContext* context) {
   auto* const external_context = static_cast<ExternalCpuBackendContext*>(
       context->GetExternalContext(context, kTfLiteCpuBackendContext));
-  if (external_context && external_context->internal_backend_context() &&
-      context->recommended_num_threads != -1) {
-    external_context->internal_backend_context()->SetMaxNumThreads(
-        context->recommended_num_threads);
+  if (external_context && external_context->internal_backend_context()) {
+    const int max_num_threads = external_context->max_num_threads() != -1
+                                    ? external_context->max_num_threads()
+                                    : context->recommended_num_threads;
+    if (max_num_threads != -1) {
+      external_context->internal_backend_context()->SetMaxNumThreads(
+          max_num_threads);
+    }
   }
   return kTfLiteOk;
 }
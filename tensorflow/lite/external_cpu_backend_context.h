@@ -92,9 +92,22 @@ class ExternalCpuBackendContext : public TfLiteExternalContext {
     return internal_backend_context_.get();
   }
 
+  // Sets the maximum number of threads of the internal backend context, now if
+  // it exists and when it is created or refreshed otherwise, instead of the
+  // recommended number of threads of the TfLiteContext. -1 restores the latter.
+  void set_max_num_threads(int max_num_threads) {
+    max_num_threads_ = max_num_threads;
+    if (internal_backend_context_ && max_num_threads_ != -1) {
+      internal_backend_context_->SetMaxNumThreads(max_num_threads_);
+    }
+  }
+
+  int max_num_threads() const { return max_num_threads_; }
+
  private:
   // Note the actual internal backend context object is lazily initialized.
   std::unique_ptr<TfLiteInternalBackendContext> internal_backend_context_;
+  int max_num_threads_ = -1;
 
   ExternalCpuBackendContext(const ExternalCpuBackendContext&) = delete;
   ExternalCpuBackendContext& operator=(const ExternalCpuBackendContext&) =
@@ -15,8 +15,10 @@ limitations under the License.
 #include "tensorflow/lite/graph_info.h"
 
 #include <algorithm>
+#include <initializer_list>
 #include <vector>
 
+#include "tensorflow/lite/builtin_ops.h"
 #include "tensorflow/lite/context_util.h"
 #include "tensorflow/lite/core/c/common.h"
 
@@ -260,8 +262,121 @@ class PartitionGraphIntoIndependentNodeSubsetsImpl {
 };
 // LINT.ThenChange(//tensorflow/lite/delegates/utils.h)
 
+bool IsOpaqueTensorType(TfLiteType type) {
+  return type == kTfLiteResource || type == kTfLiteVariant;
+}
+
+// Returns true if the node at `index` in the execution plan must not run
+// concurrently with any other node.
+bool MustRunAlone(GraphInfo* info, int index) {
+  const TfLiteNode& node = info->node(index);
+  const TfLiteRegistration& registration = info->registration(index);
+  if (node.might_have_side_effect || node.delegate != nullptr ||
+      registration.custom_name != nullptr) {
+    return true;
+  }
+  switch (registration.builtin_code) {
+    case kTfLiteBuiltinCallOnce:
+    case kTfLiteBuiltinIf:
+    case kTfLiteBuiltinWhile:
+    case kTfLiteBuiltinStablehloCase:
+    case kTfLiteBuiltinStablehloComposite:
+    case kTfLiteBuiltinStablehloWhile:
+      return true;
+    default:
+      break;
+  }
+  for (const TfLiteIntArray* tensors : {node.inputs, node.outputs}) {
+    for (int tensor_index : TfLiteIntArrayView(tensors)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      const TfLiteTensor* tensor = info->tensor(tensor_index);
+      if (IsOpaqueTensorType(tensor->type) || tensor->delegate != nullptr) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 }  // namespace
 
+std::vector<std::vector<int>> GetNodeDependencies(
+    GraphInfo* info, const ControlEdges* control_edges,
+    std::vector<bool>* must_run_alone) {
+  const int num_nodes = static_cast<int>(info->num_execution_nodes());
+  std::vector<std::vector<int>> dependencies(num_nodes);
+  if (must_run_alone != nullptr) {
+    must_run_alone->assign(num_nodes, false);
+  }
+  if (control_edges != nullptr) {
+    // Control edges are between node indices rather than execution plan
+    // indices.
+    const int num_total_nodes = static_cast<int>(info->num_total_nodes());
+    std::vector<int> plan_index(num_total_nodes, -1);
+    for (int i = 0; i < num_nodes; ++i) {
+      plan_index[info->node_index(i)] = i;
+    }
+    for (const auto& [from, to] : *control_edges) {
+      if (from < 0 || to < 0 || from >= num_total_nodes ||
+          to >= num_total_nodes) {
+        continue;
+      }
+      if (plan_index[from] != -1 && plan_index[from] < plan_index[to]) {
+        dependencies[plan_index[to]].push_back(plan_index[from]);
+      }
+    }
+  }
+  // The last node that wrote each tensor, or used each variable tensor.
+  std::vector<int> last_writer(info->num_tensors(), -1);
+  // The last node that must run alone, and the nodes started after it.
+  int last_barrier = -1;
+  std::vector<int> nodes_since_barrier;
+  for (int i = 0; i < num_nodes; ++i) {
+    const TfLiteNode& node = info->node(i);
+    std::vector<int>& node_dependencies = dependencies[i];
+    if (MustRunAlone(info, i)) {
+      if (must_run_alone != nullptr) {
+        (*must_run_alone)[i] = true;
+      }
+      node_dependencies.insert(node_dependencies.end(),
+                               nodes_since_barrier.begin(),
+                               nodes_since_barrier.end());
+      if (last_barrier != -1) {
+        node_dependencies.push_back(last_barrier);
+      }
+      nodes_since_barrier.clear();
+      last_barrier = i;
+    } else {
+      for (const TfLiteIntArray* tensors : {node.inputs, node.outputs}) {
+        for (int tensor_index : TfLiteIntArrayView(tensors)) {
+          if (tensor_index != kTfLiteOptionalTensor &&
+              last_writer[tensor_index] != -1) {
+            node_dependencies.push_back(last_writer[tensor_index]);
+          }
+        }
+      }
+      if (last_barrier != -1) {
+        node_dependencies.push_back(last_barrier);
+      }
+      nodes_since_barrier.push_back(i);
+    }
+    Uniquefy(&node_dependencies);
+    for (int tensor_index : TfLiteIntArrayView(node.outputs)) {
+      if (tensor_index != kTfLiteOptionalTensor) {
+        last_writer[tensor_index] = i;
+      }
+    }
+    // Variable tensors are updated by the nodes that take them as inputs.
+    for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+      if (tensor_index != kTfLiteOptionalTensor &&
+          info->tensor(tensor_index)->is_variable) {
+        last_writer[tensor_index] = i;
+      }
+    }
+  }
+  return dependencies;
+}
+
 TfLiteStatus PartitionGraphIntoIndependentNodeSubsets(
     const GraphInfo* info, const TfLiteIntArray* nodes_to_partition,
     std::vector<NodeSubset>* node_subsets, bool greedily,
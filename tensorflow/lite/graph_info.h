@@ -70,6 +70,13 @@ class GraphInfo {
 
   // Returns the indices of the variable tensors.
   virtual const std::vector<int>& variables() const = 0;
+
+  // Returns the dependencies between the nodes of the execution plan, as
+  // returned by GetNodeDependencies(), if the nodes may be executed
+  // concurrently, or nullptr if they are executed in order.
+  virtual const std::vector<std::vector<int>>* node_dependencies() const {
+    return nullptr;
+  }
 };
 
 // Represents a subset of nodes in a TensorFlow Lite graph.
@@ -156,6 +163,23 @@ TfLiteStatus PartitionGraphIntoIndependentNodeSubsets(
     std::vector<NodeSubset>* node_subsets, bool greedily,
     const ControlEdges* control_edges = nullptr);
 
+// Returns, for each node of the execution plan of `info`, the nodes that must
+// have finished before it starts when nodes are executed concurrently rather
+// than in the order of the execution plan. Nodes are identified by their index
+// in the execution plan and only depend on nodes before them.
+//
+// A node depends on the nodes that produce its inputs, on the previous node
+// that uses one of its variable tensors, and on the nodes it has a control
+// edge from in `control_edges`, if any. A node that might have side effects
+// beyond writing its outputs, i.e. a delegated node, a custom op, a control
+// flow op, an op on resources or variants, or an op on tensors with a delegate
+// buffer handle, depends on all the nodes before it, and all the nodes after
+// it depend on it. Such nodes are flagged in `must_run_alone`, if not null, as
+// they must also be executed on the thread calling Invoke().
+std::vector<std::vector<int>> GetNodeDependencies(
+    GraphInfo* info, const ControlEdges* control_edges = nullptr,
+    std::vector<bool>* must_run_alone = nullptr);
+
 }  // namespace tflite
 
 #endif  // TENSORFLOW_LITE_GRAPH_INFO_H_
@@ -693,5 +693,58 @@ TEST(PartitionTest, ComplexNonGreedily) {
                                 })));
 }
 
+//
+// [0]-->(0)-->[1]-->(1)-->[2]-->(3)-->[4]
+//          \                  /
+//           \-->[3]-->(2)---/
+//
+TEST(NodeDependenciesTest, IndependentBranches) {
+  SimpleTestGraph graph(/*inputs=*/{0}, /*outputs=*/{4},
+                        /*nodes=*/
+                        {
+                            {{0}, {1}, false},
+                            {{1}, {2}, false},
+                            {{0}, {3}, false},
+                            {{2, 3}, {4}, false},
+                        });
+  EXPECT_EQ(GetNodeDependencies(&graph),
+            (std::vector<std::vector<int>>{{}, {0}, {}, {1, 2}}));
+}
+
+// Nodes that might have side effects wait for all the previous nodes, and
+// the following nodes wait for them.
+TEST(NodeDependenciesTest, SideEffectsAreBarriers) {
+  SimpleTestGraph graph(/*inputs=*/{0}, /*outputs=*/{3, 4},
+                        /*nodes=*/
+                        {
+                            {{0}, {1}, false},
+                            {{0}, {2}, false},
+                            {{0}, {}, /*might_have_side_effect=*/true},
+                            {{1}, {3}, false},
+                            {{2}, {4}, false},
+                        });
+  std::vector<bool> must_run_alone;
+  EXPECT_EQ(GetNodeDependencies(&graph, /*control_edges=*/nullptr,
+                                &must_run_alone),
+            (std::vector<std::vector<int>>{{}, {}, {0, 1}, {0, 2}, {1, 2}}));
+  EXPECT_EQ(must_run_alone,
+            (std::vector<bool>{false, false, true, false, false}));
+}
+
+TEST(NodeDependenciesTest, WithControlEdges) {
+  const ControlEdges control_edges = {{0, 2}, {3, 1}};
+  SimpleTestGraph graph(/*inputs=*/{0}, /*outputs=*/{1, 2, 3},
+                        /*nodes=*/
+                        {
+                            {{0}, {1}, false},
+                            {{0}, {2}, false},
+                            {{0}, {3}, false},
+                        });
+  // The edge from node 3 to node 1 is ignored as node 3 is not executed
+  // before node 1.
+  EXPECT_EQ(GetNodeDependencies(&graph, &control_edges),
+            (std::vector<std::vector<int>>{{}, {}, {0}}));
+}
+
 }  // namespace
 }  // namespace tflite
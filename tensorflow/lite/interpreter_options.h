@@ -21,6 +21,8 @@ limitations under the License.
 
 namespace tflite {
 
+class ScratchArenaPool;
+
 /// Options class for `Interpreter`.
 /// WARNING: This is an experimental API and subject to change.
 class InterpreterOptions {
@@ -103,12 +105,74 @@ class InterpreterOptions {
     return experimental_cache_constant_cast_op_;
   }
 
+  /// Keeps the memory plans of up to `value` distinct shapes of the model
+  /// inputs, so that going back to input shapes seen before reuses their
+  /// tensor arena offsets instead of recomputing them in `AllocateTensors`.
+  /// This helps models that are resized among a few input shapes, e.g. batch
+  /// sizes, at the cost of the memory used by the cached plans. It is disabled
+  /// by default, and must be set before the tensors are first allocated.
+  /// WARNING: This is an experimental API and subject to change.
+  void SetMemoryPlanCacheSize(int value) {
+    experimental_memory_plan_cache_size_ = value;
+  }
+
+  /// Returns the number of cached memory plans, zero if the cache is disabled.
+  /// WARNING: This is an experimental API and subject to change.
+  int GetMemoryPlanCacheSize() const {
+    return experimental_memory_plan_cache_size_;
+  }
+
+  /// Executes the independent nodes of the model concurrently on `value`
+  /// threads, including the thread calling `Invoke`, instead of executing all
+  /// the nodes in order on the calling thread. The threads other than the
+  /// calling one each use their own CPU backend context, with the number of
+  /// threads of the interpreter divided among them. Nodes that might have side
+  /// effects, e.g. delegated nodes and custom ops, are executed alone. Models
+  /// with dynamic tensors and profiled invocations are still executed in
+  /// order. It is disabled by default, and must be set before the tensors are
+  /// first allocated.
+  /// WARNING: This is an experimental API and subject to change.
+  void SetNumInterOpThreads(int value) {
+    experimental_num_inter_op_threads_ = value;
+  }
+
+  /// Returns the number of threads executing the nodes of the model, 1 if they
+  /// are executed in order.
+  /// WARNING: This is an experimental API and subject to change.
+  int GetNumInterOpThreads() const {
+    return experimental_num_inter_op_threads_;
+  }
+
+  /// Shares the memory of the intermediate tensors with the other interpreters
+  /// using `pool`, which must outlive the interpreter. Each invocation leases
+  /// a buffer from the pool and gives it back when it returns, so a process
+  /// running many interpreters, few at a time, only holds as many buffers as
+  /// interpreters are invoked at the same time. The inputs, outputs and
+  /// variables of the model keep their own memory, but the data of the other
+  /// tensors is lost after `Invoke`, as after `ReleaseNonPersistentMemory`.
+  /// It has no effect with the simple memory planner or when all the tensors
+  /// are preserved, and must be set before the tensors are first allocated.
+  /// WARNING: This is an experimental API and subject to change.
+  void SetScratchArenaPool(ScratchArenaPool* pool) {
+    experimental_scratch_arena_pool_ = pool;
+  }
+
+  /// Returns the pool the memory of the intermediate tensors is leased from,
+  /// nullptr if the interpreter owns it.
+  /// WARNING: This is an experimental API and subject to change.
+  ScratchArenaPool* GetScratchArenaPool() const {
+    return experimental_scratch_arena_pool_;
+  }
+
  private:
   bool experimental_preserve_all_tensors_ = false;
   bool experimental_ensure_dynamic_tensors_are_released_ = false;
   int experimental_optimize_memory_for_large_tensors_ = 0;
   bool experimental_disable_delegate_clustering_ = false;
   bool experimental_cache_constant_cast_op_ = false;
+  int experimental_memory_plan_cache_size_ = 0;
+  int experimental_num_inter_op_threads_ = 1;
+  ScratchArenaPool* experimental_scratch_arena_pool_ = nullptr;
 };
 
 }  // namespace tflite
@@ -62,6 +62,13 @@ class MemoryPlanner {
   // Returns true if the non-persistent memory is available.
   virtual bool HasNonPersistentMemory() = 0;
 
+  // Called before and after the graph is invoked. Planners that only hold the
+  // memory of the intermediate tensors while the graph runs, e.g. because it
+  // is shared with other graphs, acquire and release it here. The data of the
+  // intermediate tensors is lost after ReleaseScratchMemory().
+  virtual TfLiteStatus AcquireScratchMemory() { return kTfLiteOk; }
+  virtual TfLiteStatus ReleaseScratchMemory() { return kTfLiteOk; }
+
   // Dumps the memory planning information against the specified op node
   // execution plan (i.e. `execution_plan`) for the purpose of debugging.
   virtual void DumpDebugInfo(const std::vector<int>& execution_plan) const = 0;
@@ -0,0 +1,339 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/perf_event_profiler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iterator>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "tensorflow/lite/core/api/profiler.h"
+
+namespace tflite {
+namespace profiling {
+
+namespace {
+
+constexpr uint32_t kIgnoredEventHandle = ~static_cast<uint32_t>(0);
+
+enum Counter {
+  kCycles,
+  kInstructions,
+  kLlcMisses,
+  kBranchMisses,
+  kNumCounters
+};
+
+bool IsOpEvent(Profiler::EventType event_type) {
+  return event_type == Profiler::EventType::OPERATOR_INVOKE_EVENT ||
+         event_type == Profiler::EventType::DELEGATE_OPERATOR_INVOKE_EVENT ||
+         event_type ==
+             Profiler::EventType::DELEGATE_PROFILED_OPERATOR_INVOKE_EVENT;
+}
+
+HardwareCounters Difference(const HardwareCounters& end,
+                            const HardwareCounters& begin) {
+  HardwareCounters difference;
+  difference.cycles = end.cycles - begin.cycles;
+  difference.instructions = end.instructions - begin.instructions;
+  difference.llc_misses = end.llc_misses - begin.llc_misses;
+  difference.branch_misses = end.branch_misses - begin.branch_misses;
+  return difference;
+}
+
+// Returns the id of the calling thread, which the counters are opened for.
+int64_t GetThreadId() {
+#ifdef __linux__
+  return syscall(SYS_gettid);
+#else
+  return 0;
+#endif
+}
+
+double Ratio(uint64_t numerator, uint64_t denominator, double scale = 1.0) {
+  return denominator == 0 ? 0.0 : scale * numerator / denominator;
+}
+
+}  // namespace
+
+HardwareCounters& HardwareCounters::operator+=(const HardwareCounters& other) {
+  cycles += other.cycles;
+  instructions += other.instructions;
+  llc_misses += other.llc_misses;
+  branch_misses += other.branch_misses;
+  return *this;
+}
+
+// The counters of one thread, read together as a perf event group led by the
+// cycle counter. Counters that the CPU doesn't provide are left out and read
+// as 0.
+class PerfEventProfiler::ThreadCounters {
+ public:
+  ThreadCounters() {
+#ifdef __linux__
+    static constexpr uint64_t kConfigs[kNumCounters] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for (int counter = 0; counter < kNumCounters; ++counter) {
+      perf_event_attr attr = {};
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = kConfigs[counter];
+      attr.read_format = PERF_FORMAT_GROUP;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      const int fd = syscall(SYS_perf_event_open, &attr, /*pid=*/0,
+                             /*cpu=*/-1, /*group_fd=*/group_fd_, /*flags=*/0);
+      if (fd < 0) {
+        // Without cycles, there is no group to add the other counters to.
+        if (counter == kCycles) return;
+        continue;
+      }
+      if (counter == kCycles) group_fd_ = fd;
+      fds_.push_back(fd);
+      counters_.push_back(static_cast<Counter>(counter));
+    }
+#endif
+  }
+
+  ~ThreadCounters() {
+#ifdef __linux__
+    for (int fd : fds_) close(fd);
+#endif
+  }
+
+  bool ok() const { return group_fd_ >= 0; }
+
+  // The handles of the events of the thread that have begun but not ended,
+  // innermost last.
+  std::vector<uint32_t>& open_events() { return open_events_; }
+
+  bool Read(HardwareCounters* values) const {
+#ifdef __linux__
+    // The number of counters followed by their values, in the order in which
+    // they were added to the group.
+    uint64_t buffer[kNumCounters + 1];
+    const ssize_t size = read(group_fd_, buffer, sizeof(buffer));
+    if (size < static_cast<ssize_t>(sizeof(uint64_t)) ||
+        buffer[0] != counters_.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < counters_.size(); ++i) {
+      switch (counters_[i]) {
+        case kCycles:
+          values->cycles = buffer[i + 1];
+          break;
+        case kInstructions:
+          values->instructions = buffer[i + 1];
+          break;
+        case kLlcMisses:
+          values->llc_misses = buffer[i + 1];
+          break;
+        case kBranchMisses:
+          values->branch_misses = buffer[i + 1];
+          break;
+        default:
+          break;
+      }
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+ private:
+  int group_fd_ = -1;
+  std::vector<int> fds_;
+  std::vector<Counter> counters_;
+  std::vector<uint32_t> open_events_;
+};
+
+PerfEventProfiler::PerfEventProfiler() = default;
+
+PerfEventProfiler::~PerfEventProfiler() = default;
+
+bool PerfEventProfiler::IsSupported() {
+  ThreadCounters counters;
+  HardwareCounters values;
+  return counters.ok() && counters.Read(&values);
+}
+
+PerfEventProfiler::ThreadCounters* PerfEventProfiler::GetThreadCounters() {
+  std::unique_ptr<ThreadCounters>& counters =
+      thread_counters_[GetThreadId()];
+  if (!counters) counters = std::make_unique<ThreadCounters>();
+  return counters->ok() ? counters.get() : nullptr;
+}
+
+uint32_t PerfEventProfiler::BeginEvent(const char* tag, EventType event_type,
+                                       int64_t event_metadata1,
+                                       int64_t event_metadata2) {
+  if (!IsOpEvent(event_type)) return kIgnoredEventHandle;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!enabled_) return kIgnoredEventHandle;
+  ThreadCounters* thread_counters = GetThreadCounters();
+  if (thread_counters == nullptr) return kIgnoredEventHandle;
+
+  uint32_t handle;
+  if (free_handles_.empty()) {
+    handle = pending_events_.size();
+    pending_events_.emplace_back();
+  } else {
+    handle = free_handles_.back();
+    free_handles_.pop_back();
+  }
+  PendingEvent& event = pending_events_[handle];
+  event.tag = tag;
+  event.event_type = event_type;
+  event.node_index = event_metadata1;
+  event.subgraph_index = event_metadata2;
+  event.thread_counters = thread_counters;
+  std::vector<uint32_t>& open_events = thread_counters->open_events();
+  event.parent_handle =
+      open_events.empty() ? kIgnoredEventHandle : open_events.back();
+  event.nested = HardwareCounters();
+  // Read last so that the bookkeeping above is not counted.
+  if (!thread_counters->Read(&event.begin)) {
+    free_handles_.push_back(handle);
+    return kIgnoredEventHandle;
+  }
+  open_events.push_back(handle);
+  return handle;
+}
+
+void PerfEventProfiler::EndEvent(uint32_t event_handle) {
+  if (event_handle == kIgnoredEventHandle) return;
+  HardwareCounters end;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (event_handle >= pending_events_.size()) return;
+  const PendingEvent& event = pending_events_[event_handle];
+  free_handles_.push_back(event_handle);
+  std::vector<uint32_t>& open_events = event.thread_counters->open_events();
+  auto open_event =
+      std::find(open_events.rbegin(), open_events.rend(), event_handle);
+  if (open_event != open_events.rend()) {
+    // Events that end after the one they are nested in are not subtracted
+    // from it, as its handle may be reused.
+    for (auto inner = open_events.rbegin(); inner != open_event; ++inner) {
+      if (pending_events_[*inner].parent_handle == event_handle) {
+        pending_events_[*inner].parent_handle = kIgnoredEventHandle;
+      }
+    }
+    open_events.erase(std::next(open_event).base());
+  }
+  if (!event.thread_counters->Read(&end)) return;
+  const HardwareCounters counters = Difference(end, event.begin);
+  if (event.parent_handle != kIgnoredEventHandle) {
+    pending_events_[event.parent_handle].nested += counters;
+  }
+  if (!enabled_) return;
+
+  OpHardwareCounters& op = op_counters_[OpKey(
+      event.subgraph_index, event.node_index, event.event_type, event.tag)];
+  if (op.num_invocations == 0) {
+    op.tag = event.tag;
+    op.event_type = event.event_type;
+    op.node_index = event.node_index;
+    op.subgraph_index = event.subgraph_index;
+  }
+  ++op.num_invocations;
+  op.counters += Difference(counters, event.nested);
+}
+
+void PerfEventProfiler::StartProfiling() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  enabled_ = true;
+}
+
+void PerfEventProfiler::StopProfiling() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  enabled_ = false;
+}
+
+void PerfEventProfiler::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  op_counters_.clear();
+}
+
+std::vector<OpHardwareCounters> PerfEventProfiler::GetOpCounters() const {
+  std::vector<OpHardwareCounters> ops;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ops.reserve(op_counters_.size());
+    for (const auto& key_and_op : op_counters_) {
+      ops.push_back(key_and_op.second);
+    }
+  }
+  std::stable_sort(ops.begin(), ops.end(),
+                   [](const OpHardwareCounters& a,
+                      const OpHardwareCounters& b) {
+                     return a.counters.cycles > b.counters.cycles;
+                   });
+  return ops;
+}
+
+std::string PerfEventProfiler::GetSummary() const {
+  const std::vector<OpHardwareCounters> ops = GetOpCounters();
+  HardwareCounters total;
+  for (const OpHardwareCounters& op : ops) total += op.counters;
+
+  std::stringstream stream;
+  stream << "Operator-wise hardware counters (calling thread only):\n"
+         << std::left << std::setw(24) << "[op]" << std::right
+         << std::setw(10) << "[node]" << std::setw(10) << "[count]"
+         << std::setw(14) << "[avg cycles]" << std::setw(10) << "[%]"
+         << std::setw(10) << "[IPC]" << std::setw(14) << "[LLC MPKI]"
+         << std::setw(14) << "[branch MPKI]" << "\n";
+  stream << std::fixed << std::setprecision(2);
+  for (const OpHardwareCounters& op : ops) {
+    const HardwareCounters& counters = op.counters;
+    stream << std::left << std::setw(24) << op.tag << std::right
+           << std::setw(10) << op.node_index << std::setw(10)
+           << op.num_invocations << std::setw(14)
+           << counters.cycles / op.num_invocations << std::setw(9)
+           << Ratio(counters.cycles, total.cycles, 100.0) << "%"
+           << std::setw(10) << Ratio(counters.instructions, counters.cycles)
+           << std::setw(14)
+           << Ratio(counters.llc_misses, counters.instructions, 1000.0)
+           << std::setw(14)
+           << Ratio(counters.branch_misses, counters.instructions, 1000.0)
+           << "\n";
+  }
+  stream << "Total: " << total.cycles << " cycles, " << total.instructions
+         << " instructions, " << total.llc_misses << " LLC misses, "
+         << total.branch_misses << " branch misses.\n";
+  return stream.str();
+}
+
+std::unique_ptr<PerfEventProfiler> MaybeCreatePerfEventProfiler() {
+  if (!PerfEventProfiler::IsSupported()) return nullptr;
+  return std::make_unique<PerfEventProfiler>();
+}
+
+}  // namespace profiling
+}  // namespace tflite
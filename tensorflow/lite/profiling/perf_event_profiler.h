@@ -0,0 +1,130 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_PROFILING_PERF_EVENT_PROFILER_H_
+#define TENSORFLOW_LITE_PROFILING_PERF_EVENT_PROFILER_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "tensorflow/lite/core/api/profiler.h"
+
+namespace tflite {
+namespace profiling {
+
+// The hardware events counted by the PerfEventProfiler.
+struct HardwareCounters {
+  uint64_t cycles = 0;
+  uint64_t instructions = 0;
+  // Last level cache misses.
+  uint64_t llc_misses = 0;
+  uint64_t branch_misses = 0;
+
+  HardwareCounters& operator+=(const HardwareCounters& other);
+};
+
+// The hardware counters accumulated over the invocations of an op. They are
+// exclusive of the ops nested in it on the same thread, e.g. the delegated ops
+// of a delegate kernel or the ops of the subgraphs of a control flow op, so
+// that the counters of all the ops add up to the total.
+struct OpHardwareCounters {
+  std::string tag;
+  Profiler::EventType event_type;
+  // The index of the node, and of its subgraph for OPERATOR_INVOKE_EVENTs.
+  int64_t node_index;
+  int64_t subgraph_index;
+  int64_t num_invocations = 0;
+  HardwareCounters counters;
+};
+
+// Counts CPU cycles, instructions, last level cache misses and branch misses
+// per op invocation with the Linux perf_event_open() interface, which tells
+// whether an op is bound by compute or by memory.
+//
+// The counters of a thread are opened when it first invokes an op, and only
+// count the events of that thread: the work done on the worker threads of a
+// multi-threaded kernel is not counted. Events in the kernel are not counted
+// either, so that no privileges are needed.
+class PerfEventProfiler : public tflite::Profiler {
+ public:
+  PerfEventProfiler();
+  ~PerfEventProfiler() override;
+
+  // Returns whether the hardware counters can be read on this system, e.g.
+  // false if not on Linux, or if the PMU is not exposed to a virtual machine.
+  static bool IsSupported();
+
+  uint32_t BeginEvent(const char* tag, EventType event_type,
+                      int64_t event_metadata1,
+                      int64_t event_metadata2) override;
+
+  void EndEvent(uint32_t event_handle) override;
+
+  void StartProfiling();
+  void StopProfiling();
+  void Reset();
+
+  // Returns the counters of the ops invoked while profiling, with the most
+  // cycles first.
+  std::vector<OpHardwareCounters> GetOpCounters() const;
+
+  // Returns a table of the op counters, with the derived instructions per
+  // cycle and misses per thousand instructions.
+  std::string GetSummary() const;
+
+ private:
+  class ThreadCounters;
+
+  struct PendingEvent {
+    const char* tag;
+    EventType event_type;
+    int64_t node_index;
+    int64_t subgraph_index;
+    ThreadCounters* thread_counters;
+    // The event this one is nested in on its thread, if any.
+    uint32_t parent_handle;
+    HardwareCounters begin;
+    // The counters of the events nested in this one.
+    HardwareCounters nested;
+  };
+
+  using OpKey = std::tuple<int64_t, int64_t, EventType, std::string>;
+
+  // Returns the counters of the calling thread, opening them if needed, or
+  // nullptr if they can't be opened.
+  ThreadCounters* GetThreadCounters();
+
+  mutable std::mutex mutex_;
+  bool enabled_ = false;
+  // The counters of each thread, by thread id.
+  std::map<int64_t, std::unique_ptr<ThreadCounters>> thread_counters_;
+  // Events that have begun but not ended, indexed by their handle.
+  std::vector<PendingEvent> pending_events_;
+  std::vector<uint32_t> free_handles_;
+  std::map<OpKey, OpHardwareCounters> op_counters_;
+};
+
+// Creates a PerfEventProfiler, or returns nullptr if hardware counters are not
+// supported.
+std::unique_ptr<PerfEventProfiler> MaybeCreatePerfEventProfiler();
+
+}  // namespace profiling
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_PROFILING_PERF_EVENT_PROFILER_H_
@@ -0,0 +1,138 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/perf_event_profiler.h"
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/api/profiler.h"
+
+namespace tflite {
+namespace profiling {
+
+namespace {
+
+// Does some work that can't be optimized away.
+int Work(int n) {
+  volatile int sum = 0;
+  for (int i = 0; i < n; ++i) sum = sum + i;
+  return sum;
+}
+
+class PerfEventProfilerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    profiler_ = MaybeCreatePerfEventProfiler();
+    if (!profiler_) {
+      GTEST_SKIP() << "Hardware counters are not supported.";
+    }
+  }
+
+  std::unique_ptr<PerfEventProfiler> profiler_;
+};
+
+TEST_F(PerfEventProfilerTest, CountsOpInvocations) {
+  profiler_->StartProfiling();
+  for (int i = 0; i < 3; ++i) {
+    TFLITE_SCOPED_TAGGED_OPERATOR_PROFILE(profiler_.get(), "ADD", 1);
+    Work(10000);
+  }
+  {
+    TFLITE_SCOPED_TAGGED_OPERATOR_PROFILE(profiler_.get(), "MUL", 2);
+    Work(100000);
+  }
+  profiler_->StopProfiling();
+
+  const std::vector<OpHardwareCounters> ops = profiler_->GetOpCounters();
+  ASSERT_EQ(ops.size(), 2);
+  // The op with the most cycles comes first.
+  EXPECT_EQ(ops[0].tag, "MUL");
+  EXPECT_EQ(ops[0].node_index, 2);
+  EXPECT_EQ(ops[0].num_invocations, 1);
+  EXPECT_EQ(ops[1].tag, "ADD");
+  EXPECT_EQ(ops[1].node_index, 1);
+  EXPECT_EQ(ops[1].num_invocations, 3);
+  for (const OpHardwareCounters& op : ops) {
+    EXPECT_EQ(op.event_type, Profiler::EventType::OPERATOR_INVOKE_EVENT);
+    EXPECT_GT(op.counters.cycles, 0);
+  }
+
+  const std::string summary = profiler_->GetSummary();
+  EXPECT_NE(summary.find("ADD"), std::string::npos);
+  EXPECT_NE(summary.find("MUL"), std::string::npos);
+
+  profiler_->Reset();
+  EXPECT_TRUE(profiler_->GetOpCounters().empty());
+}
+
+TEST_F(PerfEventProfilerTest, CountsNestedOpsOnce) {
+  profiler_->StartProfiling();
+  {
+    // A control flow op invoking an op of its body subgraph.
+    TFLITE_SCOPED_TAGGED_OPERATOR_PROFILE(profiler_.get(), "WHILE", 0);
+    Work(1000);
+    {
+      TFLITE_SCOPED_TAGGED_OPERATOR_PROFILE(profiler_.get(), "ADD", 1);
+      Work(1000000);
+    }
+  }
+  profiler_->StopProfiling();
+
+  const std::vector<OpHardwareCounters> ops = profiler_->GetOpCounters();
+  ASSERT_EQ(ops.size(), 2);
+  // The WHILE op is not attributed the work of the nested ADD op.
+  EXPECT_EQ(ops[0].tag, "ADD");
+  EXPECT_EQ(ops[1].tag, "WHILE");
+  EXPECT_LT(ops[1].counters.instructions, ops[0].counters.instructions / 10);
+}
+
+TEST_F(PerfEventProfilerTest, IgnoresEventsWhenNotProfiling) {
+  {
+    TFLITE_SCOPED_TAGGED_OPERATOR_PROFILE(profiler_.get(), "ADD", 1);
+    Work(1000);
+  }
+  EXPECT_TRUE(profiler_->GetOpCounters().empty());
+}
+
+TEST_F(PerfEventProfilerTest, IgnoresNonOpEvents) {
+  profiler_->StartProfiling();
+  {
+    TFLITE_SCOPED_TAGGED_DEFAULT_PROFILE(profiler_.get(), "Invoke");
+    Work(1000);
+  }
+  profiler_->StopProfiling();
+  EXPECT_TRUE(profiler_->GetOpCounters().empty());
+}
+
+TEST_F(PerfEventProfilerTest, CountsOpsOnSeveralThreads) {
+  profiler_->StartProfiling();
+  std::vector<std::thread> threads;
+  for (int node = 0; node < 4; ++node) {
+    threads.emplace_back([this, node]() {
+      TFLITE_SCOPED_TAGGED_OPERATOR_PROFILE(profiler_.get(), "CONV_2D", node);
+      Work(10000);
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  profiler_->StopProfiling();
+  EXPECT_EQ(profiler_->GetOpCounters().size(), 4);
+}
+
+}  // namespace
+}  // namespace profiling
+}  // namespace tflite
@@ -21,7 +21,10 @@ limitations under the License.
 #include <cstdlib>
 #include <cstring>
 #include <limits>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/lite/core/c/common.h"
@@ -187,6 +190,44 @@ void ResizableAlignedBuffer::Release() {
   data_size_ = 0;
 }
 
+std::unique_ptr<ResizableAlignedBuffer> ScratchArenaPool::Lease(
+    size_t alignment, size_t size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto best = unused_buffers_.end();
+  for (auto it = unused_buffers_.begin(); it != unused_buffers_.end(); ++it) {
+    if ((*it)->GetAlignment() != alignment) continue;
+    if (best == unused_buffers_.end()) {
+      best = it;
+      continue;
+    }
+    const size_t best_size = (*best)->GetSize();
+    const size_t it_size = (*it)->GetSize();
+    const bool fits = it_size >= size;
+    const bool best_fits = best_size >= size;
+    if (fits ? !best_fits || it_size < best_size
+             : !best_fits && it_size > best_size) {
+      best = it;
+    }
+  }
+  if (best == unused_buffers_.end()) {
+    return std::make_unique<ResizableAlignedBuffer>(alignment,
+                                                    /*subgraph_index=*/0);
+  }
+  std::unique_ptr<ResizableAlignedBuffer> buffer = std::move(*best);
+  unused_buffers_.erase(best);
+  return buffer;
+}
+
+void ScratchArenaPool::Return(std::unique_ptr<ResizableAlignedBuffer> buffer) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  unused_buffers_.push_back(std::move(buffer));
+}
+
+int ScratchArenaPool::num_unused_buffers() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return static_cast<int>(unused_buffers_.size());
+}
+
 void SimpleMemoryArena::PurgeAfter(int32_t node) {
   for (int i = 0; i < active_allocs_.size(); ++i) {
     if (active_allocs_[i].first_node > node) {
@@ -284,11 +325,23 @@ TfLiteStatus SimpleMemoryArena::Allocate(
   return kTfLiteOk;
 }
 
+void SimpleMemoryArena::RestoreAllocs(
+    const std::vector<ArenaAllocWithUsageInterval>& allocs) {
+  active_allocs_.clear();
+  for (const auto& alloc : allocs) {
+    // Zero-sized allocs are never active, see Allocate().
+    if (alloc.size == 0) continue;
+    high_water_mark_ = std::max(high_water_mark_, alloc.offset + alloc.size);
+    active_allocs_.push_back(alloc);
+  }
+  std::sort(active_allocs_.begin(), active_allocs_.end());
+}
+
 TfLiteStatus SimpleMemoryArena::Commit(bool* arena_reallocated) {
   // Resize the arena to the high water mark (calculated by Allocate), retaining
   // old contents and alignment in the process. Since Alloc pointers are offset
   // based, they will remain valid in the new memory block.
-  *arena_reallocated = underlying_buffer_.Resize(high_water_mark_);
+  *arena_reallocated = buffer().Resize(high_water_mark_);
   committed_ = true;
   return kTfLiteOk;
 }
@@ -299,11 +352,11 @@ TfLiteStatus SimpleMemoryArena::ResolveAlloc(
   TF_LITE_ENSURE(context, committed_);
   TF_LITE_ENSURE(context, output_ptr != nullptr);
   TF_LITE_ENSURE(context,
-                 underlying_buffer_.GetSize() >= (alloc.offset + alloc.size));
+                 buffer().GetSize() >= (alloc.offset + alloc.size));
   if (alloc.size == 0) {
     *output_ptr = nullptr;
   } else {
-    *output_ptr = underlying_buffer_.GetPtr() + alloc.offset;
+    *output_ptr = buffer().GetPtr() + alloc.offset;
   }
   return kTfLiteOk;
 }
@@ -329,7 +382,7 @@ TFLITE_ATTRIBUTE_WEAK void DumpArenaInfo(
 
 void SimpleMemoryArena::DumpDebugInfo(
     const std::string& name, const std::vector<int>& execution_plan) const {
-  tflite::DumpArenaInfo(name, execution_plan, underlying_buffer_.GetSize(),
+  tflite::DumpArenaInfo(name, execution_plan, buffer().GetSize(),
                         active_allocs_);
 }
 
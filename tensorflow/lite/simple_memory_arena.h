@@ -17,6 +17,8 @@ limitations under the License.
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <vector>
 
@@ -100,6 +102,31 @@ class ResizableAlignedBuffer {
   int subgraph_index_;
 };
 
+// A pool of buffers shared by the arenas of many interpreters, which only need
+// a buffer while they are invoked. The pool holds at most as many buffers as
+// interpreters were invoked at the same time. It is thread-safe.
+class ScratchArenaPool {
+ public:
+  ScratchArenaPool() = default;
+  ScratchArenaPool(const ScratchArenaPool&) = delete;
+  ScratchArenaPool& operator=(const ScratchArenaPool&) = delete;
+
+  // Takes the smallest unused buffer with the given alignment that holds
+  // `size` bytes, or the largest one if none does, so that buffers are
+  // resized as little as possible. Creates a buffer if none is unused.
+  std::unique_ptr<ResizableAlignedBuffer> Lease(size_t alignment, size_t size);
+
+  // Gives back a buffer taken by Lease().
+  void Return(std::unique_ptr<ResizableAlignedBuffer> buffer);
+
+  // Returns the number of unused buffers.
+  int num_unused_buffers() const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<ResizableAlignedBuffer>> unused_buffers_;
+};
+
 // This small class is responsible for allocating, deallocating and reusing
 // dynamic memory from a common underlying buffer. The arena can be used in
 // scenarios when the pattern of memory allocations and deallocations is
@@ -142,6 +169,12 @@ class SimpleMemoryArena {
                         int32_t tensor, int32_t first_node, int32_t last_node,
                         ArenaAllocWithUsageInterval* new_alloc);
 
+  // Replaces the active allocs with `allocs`, which were computed by earlier
+  // calls to Allocate(), and grows the high water mark so that Commit()
+  // reserves enough memory for them. This restores a previous allocation plan
+  // without searching the gaps between the allocs again.
+  void RestoreAllocs(const std::vector<ArenaAllocWithUsageInterval>& allocs);
+
   TfLiteStatus Commit(bool* arena_reallocated);
 
   TfLiteStatus ResolveAlloc(TfLiteContext* context,
@@ -158,10 +191,22 @@ class SimpleMemoryArena {
   // again until Commit() is called & tensor allocations are resolved.
   TfLiteStatus ReleaseBuffer();
 
-  size_t GetBufferSize() const { return underlying_buffer_.GetSize(); }
+  // Makes the arena use `buffer`, which it does not own, instead of its own
+  // buffer until it is called again. nullptr switches back to its own buffer.
+  // The allocation plan is kept, but the arena must be committed and the
+  // allocations resolved again.
+  void SetExternalBuffer(ResizableAlignedBuffer* buffer) {
+    external_buffer_ = buffer;
+    committed_ = false;
+  }
+
+  // Returns the size of the buffer needed by the allocations.
+  size_t GetRequiredBufferSize() const { return high_water_mark_; }
+
+  size_t GetBufferSize() const { return buffer().GetSize(); }
 
   std::intptr_t BasePointer() const {
-    return reinterpret_cast<std::intptr_t>(underlying_buffer_.GetPtr());
+    return reinterpret_cast<std::intptr_t>(buffer().GetPtr());
   }
 
   // Dumps the memory allocation information of this memory arena (which could
@@ -182,9 +227,17 @@ class SimpleMemoryArena {
                      const std::vector<int>& execution_plan) const;
 
  private:
+  const ResizableAlignedBuffer& buffer() const {
+    return external_buffer_ != nullptr ? *external_buffer_ : underlying_buffer_;
+  }
+  ResizableAlignedBuffer& buffer() {
+    return external_buffer_ != nullptr ? *external_buffer_ : underlying_buffer_;
+  }
+
   bool committed_;
   size_t high_water_mark_;
   ResizableAlignedBuffer underlying_buffer_;
+  ResizableAlignedBuffer* external_buffer_ = nullptr;
   std::vector<ArenaAllocWithUsageInterval> active_allocs_;
 };
 
@@ -14,6 +14,10 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/simple_memory_arena.h"
 
+#include <cstdint>
+#include <memory>
+#include <utility>
+
 #include <gtest/gtest.h>
 #include "tensorflow/lite/core/c/common.h"
 
@@ -367,6 +371,67 @@ TEST_P(BufferAndPlanClearingTest, TestClearBufferAndClearPlan) {
   EXPECT_NE(resolved_ptr, nullptr);
 }
 
+TEST(SimpleMemoryArenaTest, ExternalBuffer) {
+  TfLiteContext context;
+  context.ReportError = ReportError;
+  SimpleMemoryArena arena(64);
+  ArenaAllocWithUsageInterval alloc;
+  ASSERT_EQ(arena.Allocate(&context, 32, 2047, 0, 0, 1, &alloc), kTfLiteOk);
+  EXPECT_EQ(arena.GetRequiredBufferSize(), 2047);
+
+  ResizableAlignedBuffer buffer(64, /*subgraph_index=*/0);
+  arena.SetExternalBuffer(&buffer);
+  bool reallocated = false;
+  ASSERT_EQ(arena.Commit(&reallocated), kTfLiteOk);
+  EXPECT_TRUE(reallocated);
+  EXPECT_EQ(buffer.GetSize(), 2047);
+  char* resolved_ptr = nullptr;
+  ASSERT_EQ(arena.ResolveAlloc(&context, alloc, &resolved_ptr), kTfLiteOk);
+  EXPECT_EQ(resolved_ptr, buffer.GetPtr());
+  EXPECT_EQ(arena.BasePointer(), reinterpret_cast<std::intptr_t>(resolved_ptr));
+
+  // Releasing the arena's own buffer leaves the external one alone.
+  ASSERT_EQ(arena.ReleaseBuffer(), kTfLiteOk);
+  EXPECT_NE(buffer.GetPtr(), nullptr);
+
+  // The arena must be committed again after switching buffers.
+  arena.SetExternalBuffer(nullptr);
+  ASSERT_NE(arena.ResolveAlloc(&context, alloc, &resolved_ptr), kTfLiteOk);
+  ASSERT_EQ(arena.Commit(&reallocated), kTfLiteOk);
+  ASSERT_EQ(arena.ResolveAlloc(&context, alloc, &resolved_ptr), kTfLiteOk);
+  EXPECT_NE(resolved_ptr, buffer.GetPtr());
+}
+
+TEST(ScratchArenaPoolTest, LeasesTheSmallestBufferThatFits) {
+  ScratchArenaPool pool;
+  std::unique_ptr<ResizableAlignedBuffer> small = pool.Lease(64, 100);
+  std::unique_ptr<ResizableAlignedBuffer> large = pool.Lease(64, 1000);
+  std::unique_ptr<ResizableAlignedBuffer> other_alignment = pool.Lease(32, 100);
+  EXPECT_NE(small, nullptr);
+  EXPECT_NE(small, large);
+  EXPECT_EQ(other_alignment->GetAlignment(), 32);
+  small->Resize(100);
+  large->Resize(1000);
+  ResizableAlignedBuffer* const small_ptr = small.get();
+  ResizableAlignedBuffer* const large_ptr = large.get();
+  pool.Return(std::move(large));
+  pool.Return(std::move(small));
+  pool.Return(std::move(other_alignment));
+  EXPECT_EQ(pool.num_unused_buffers(), 3);
+
+  std::unique_ptr<ResizableAlignedBuffer> buffer = pool.Lease(64, 50);
+  EXPECT_EQ(buffer.get(), small_ptr);
+  pool.Return(std::move(buffer));
+  buffer = pool.Lease(64, 500);
+  EXPECT_EQ(buffer.get(), large_ptr);
+  pool.Return(std::move(buffer));
+  // Without a buffer large enough, the largest one is leased.
+  buffer = pool.Lease(64, 5000);
+  EXPECT_EQ(buffer.get(), large_ptr);
+  EXPECT_EQ(pool.num_unused_buffers(), 2);
+  pool.Return(std::move(buffer));
+}
+
 INSTANTIATE_TEST_SUITE_P(BufferAndPlanClearingTest, BufferAndPlanClearingTest,
                          ::testing::Values(true, false));
 
@@ -566,6 +566,50 @@ TEST(BenchmarkTest, MaxDurationWorks) {
   benchmark.Run();
 }
 
+class NumRunsTestListener : public BenchmarkListener {
+ public:
+  explicit NumRunsTestListener(int64_t min_num_runs)
+      : min_num_runs_(min_num_runs) {}
+
+  void OnBenchmarkEnd(const BenchmarkResults& results) override {
+    EXPECT_GE(results.inference_time_us().count(), min_num_runs_);
+  }
+
+ private:
+  int64_t min_num_runs_;
+};
+
+TEST(BenchmarkTest, RunsConcurrentInterpreters) {
+  ASSERT_THAT(g_fp32_model_path, testing::NotNull());
+  BenchmarkParams params = BenchmarkTfLiteModel::DefaultParams();
+  InitializeParams(params, /*num_runs=*/10, /*min_secs=*/0.0f,
+                   /*max_secs=*/150.0f);
+  params.Set<int32_t>("num_interpreters", 3);
+  TestBenchmark benchmark(std::move(params));
+  NumRunsTestListener listener(/*min_num_runs=*/10);
+  benchmark.AddListener(&listener);
+  EXPECT_EQ(benchmark.Run(), kTfLiteOk);
+}
+
+TEST(BenchmarkTest, RunsConcurrentInterpretersAtTargetQps) {
+  ASSERT_THAT(g_fp32_model_path, testing::NotNull());
+  TestBenchmark benchmark(CreateFp32Params());
+  ScopedCommandlineArgs scoped_argv({"--num_interpreters=2",
+                                     "--share_model=false", "--num_runs=5",
+                                     "--min_secs=0", "--target_qps=100"});
+  NumRunsTestListener listener(/*min_num_runs=*/5);
+  benchmark.AddListener(&listener);
+  EXPECT_EQ(benchmark.Run(scoped_argv.argc(), scoped_argv.argv()), kTfLiteOk);
+}
+
+TEST(BenchmarkTest, RunWithInvalidNumInterpreters) {
+  ASSERT_THAT(g_fp32_model_path, testing::NotNull());
+  TestBenchmark benchmark(CreateFp32Params());
+  ScopedCommandlineArgs scoped_argv({"--num_interpreters=0"});
+  EXPECT_EQ(benchmark.Run(scoped_argv.argc(), scoped_argv.argv()),
+            kTfLiteError);
+}
+
 TEST(BenchmarkTest, ParametersArePopulatedWhenInputShapeIsNotSpecified) {
   ASSERT_THAT(g_fp32_model_path, testing::NotNull());
 
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/lite/tools/benchmark/benchmark_tflite_model.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdarg>
 #include <cstdint>
 #include <cstdlib>
@@ -28,6 +29,7 @@ limitations under the License.
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <thread>  // NOLINT(build/c++11)
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -52,7 +54,9 @@ limitations under the License.
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
 #include "tensorflow/lite/op_resolver.h"
 #include "tensorflow/lite/optional_debug_tools.h"
+#include "tensorflow/lite/profiling/time.h"
 #include "tensorflow/lite/profiling/model_runtime_info.h"
+#include "tensorflow/lite/profiling/perf_event_profiler.h"
 #include "tensorflow/lite/profiling/profile_summary_formatter.h"
 #include "tensorflow/lite/string_util.h"
 #include "tensorflow/lite/tools/benchmark/benchmark_params.h"
@@ -155,6 +159,30 @@ void RuyProfileListener::OnBenchmarkEnd(const BenchmarkResults& results) {
   ruy_profile_ = nullptr;
 }
 
+// Logs the hardware counters of the ops invoked by the regular runs.
+class HardwareCounterListener : public BenchmarkListener {
+ public:
+  HardwareCounterListener(
+      Interpreter* interpreter,
+      std::unique_ptr<profiling::PerfEventProfiler> profiler)
+      : profiler_(std::move(profiler)) {
+    interpreter->AddProfiler(profiler_.get());
+  }
+
+  void OnSingleRunStart(RunType run_type) override {
+    if (run_type == REGULAR) profiler_->StartProfiling();
+  }
+
+  void OnSingleRunEnd() override { profiler_->StopProfiling(); }
+
+  void OnBenchmarkEnd(const BenchmarkResults& results) override {
+    TFLITE_LOG(INFO) << profiler_->GetSummary();
+  }
+
+ private:
+  std::unique_ptr<profiling::PerfEventProfiler> profiler_;
+};
+
 class InterpreterStatePrinter : public BenchmarkListener {
  public:
   explicit InterpreterStatePrinter(Interpreter* interpreter)
@@ -584,6 +612,8 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
   default_params.AddParam(
       "enable_op_profiling",
       BenchmarkParam::Create<bool>(kOpProfilingEnabledDefault));
+  default_params.AddParam("enable_op_hardware_counters",
+                          BenchmarkParam::Create<bool>(false));
   default_params.AddParam(
       "op_profiling_output_mode",
       BenchmarkParam::Create<std::string>(kOpProfilingOutputModeStdout));
@@ -611,6 +641,10 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
                           BenchmarkParam::Create<bool>(false));
   default_params.AddParam("enable_builtin_cast_constant_cache",
                           BenchmarkParam::Create<bool>(false));
+  default_params.AddParam("num_interpreters",
+                          BenchmarkParam::Create<int32_t>(1));
+  default_params.AddParam("share_model", BenchmarkParam::Create<bool>(true));
+  default_params.AddParam("target_qps", BenchmarkParam::Create<float>(-1.0f));
   default_params.AddParam("output_filepath",
                           BenchmarkParam::Create<std::string>(""));
   default_params.AddParam("output_proto_filepath",
@@ -643,6 +677,8 @@ void BenchmarkTfLiteModel::CleanUp() {
 BenchmarkTfLiteModel::~BenchmarkTfLiteModel() {
   CleanUp();
 
+  concurrent_interpreters_.clear();
+
   // Release the pointer to the interpreter_runner_ before the interpreter is
   // destroyed.
   interpreter_runner_.reset();
@@ -680,6 +716,11 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
       CreateFlag<bool>("require_full_delegation", &params_,
                        "require delegate to run the entire graph"),
       CreateFlag<bool>("enable_op_profiling", &params_, "enable op profiling"),
+      CreateFlag<bool>(
+          "enable_op_hardware_counters", &params_,
+          "Count the CPU cycles, instructions, last level cache misses and "
+          "branch misses of each op with perf_event_open(), Linux only. Only "
+          "the thread invoking an op is counted."),
       CreateFlag<std::string>(
           "op_profiling_output_mode", &params_,
           "Output mode for op profiling results. Supported values are: "
@@ -720,6 +761,23 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
           "enable_builtin_cast_constant_cache", &params_,
           "Cache the output of the builtin cast operation when its input "
           "is a constant tensor."),
+      CreateFlag<int32_t>(
+          "num_interpreters", &params_,
+          "The number of interpreters of the model that are invoked "
+          "concurrently, each on its own thread, during the regular runs. "
+          "The reported latencies are those of the individual requests. "
+          "When the XNNPACK delegate is used with "
+          "--xnnpack_weight_cache_file_path, all the interpreters share the "
+          "packed weights of the cache file."),
+      CreateFlag<bool>("share_model", &params_,
+                       "Whether the concurrent interpreters share the model "
+                       "buffer, or each use a copy of it."),
+      CreateFlag<float>(
+          "target_qps", &params_,
+          "The rate, in requests per second, at which requests are sent to "
+          "the concurrent interpreters. Latencies include the time a request "
+          "waits for an interpreter. If not positive, each interpreter runs "
+          "the next request as soon as it is done with the previous one."),
       CreateFlag<std::string>(
           "output_filepath", &params_,
           "File path to export outputs layer as binary data."),
@@ -779,6 +837,8 @@ void BenchmarkTfLiteModel::LogParams() {
                       "Require full delegation", verbose);
   LOG_BENCHMARK_PARAM(bool, "enable_op_profiling", "Enable op profiling",
                       verbose);
+  LOG_BENCHMARK_PARAM(bool, "enable_op_hardware_counters",
+                      "Enable op hardware counters", verbose);
   LOG_BENCHMARK_PARAM(std::string, "op_profiling_output_mode",
                       "Op profiling output mode.", verbose);
   LOG_BENCHMARK_PARAM(std::string, "op_profiling_output_file",
@@ -806,6 +866,12 @@ void BenchmarkTfLiteModel::LogParams() {
                       "Disable delegate clustering", verbose);
   LOG_BENCHMARK_PARAM(bool, "enable_builtin_cast_constant_cache",
                       "Constant CAST output cache", verbose);
+  LOG_BENCHMARK_PARAM(int32_t, "num_interpreters",
+                      "Number of concurrent interpreters", verbose);
+  LOG_BENCHMARK_PARAM(bool, "share_model",
+                      "Share the model between interpreters", verbose);
+  LOG_BENCHMARK_PARAM(float, "target_qps", "Target requests per second",
+                      verbose);
   LOG_BENCHMARK_PARAM(std::string, "output_filepath",
                       "File path to export outputs layer to", verbose);
   LOG_BENCHMARK_PARAM(std::string, "output_proto_filepath",
@@ -833,6 +899,11 @@ TfLiteStatus BenchmarkTfLiteModel::ValidateParams() {
     return kTfLiteError;
   }
 
+  if (params_.Get<int32_t>("num_interpreters") < 1) {
+    TFLITE_LOG(ERROR) << "--num_interpreters should be at least 1.";
+    return kTfLiteError;
+  }
+
   if (params_.Get<bool>("enable_op_profiling")) {
     bool found =
         std::find(std::begin(kOpProfilingOutputModes),
@@ -994,11 +1065,16 @@ TfLiteStatus BenchmarkTfLiteModel::PrepareInputData() {
 }
 
 TfLiteStatus BenchmarkTfLiteModel::ResetInputsAndOutputs() {
-  const std::vector<int>& runner_inputs = interpreter_runner_->inputs();
+  return SetInputs(interpreter_runner_.get());
+}
+
+TfLiteStatus BenchmarkTfLiteModel::SetInputs(
+    BenchmarkInterpreterRunner* runner) {
+  const std::vector<int>& runner_inputs = runner->inputs();
   // Set the values of the input tensors from inputs_data_.
   for (int j = 0; j < runner_inputs.size(); ++j) {
     int i = runner_inputs[j];
-    TfLiteTensor* t = interpreter_runner_->tensor(i);
+    TfLiteTensor* t = runner->tensor(i);
     if (t->type == kTfLiteString) {
       if (inputs_data_[j].data) {
         static_cast<DynamicBuffer*>(inputs_data_[j].data.get())
@@ -1022,6 +1098,13 @@ TfLiteStatus BenchmarkTfLiteModel::ResetInputsAndOutputs() {
 }
 
 TfLiteStatus BenchmarkTfLiteModel::InitInterpreter() {
+  return CreateInterpreter(*model_, &interpreter_, &external_context_);
+}
+
+TfLiteStatus BenchmarkTfLiteModel::CreateInterpreter(
+    const tflite::FlatBufferModel& model,
+    std::unique_ptr<tflite::Interpreter>* interpreter,
+    std::unique_ptr<tflite::ExternalCpuBackendContext>* external_context) {
   auto resolver = GetOpResolver();
   const int32_t num_threads = params_.Get<int32_t>("num_threads");
   const bool use_caching = params_.Get<bool>("use_caching");
@@ -1036,28 +1119,29 @@ TfLiteStatus BenchmarkTfLiteModel::InitInterpreter() {
   options.SetCacheConstantCastOp(
       params_.Get<bool>("enable_builtin_cast_constant_cache"));
 
-  tflite::InterpreterBuilder builder(*model_, *resolver, &options);
+  tflite::InterpreterBuilder builder(model, *resolver, &options);
   if (builder.SetNumThreads(num_threads) != kTfLiteOk) {
     TFLITE_LOG(ERROR) << "Failed to set thread number";
     return kTfLiteError;
   }
 
-  builder(&interpreter_);
-  if (!interpreter_) {
+  builder(interpreter);
+  if (!*interpreter) {
     TFLITE_LOG(ERROR) << "Failed to initialize the interpreter";
     return kTfLiteError;
   }
   // Manually enable caching behavior in TF Lite interpreter.
   if (use_caching) {
-    external_context_ = std::make_unique<tflite::ExternalCpuBackendContext>();
+    *external_context = std::make_unique<tflite::ExternalCpuBackendContext>();
     std::unique_ptr<tflite::CpuBackendContext> cpu_backend_context(
         new tflite::CpuBackendContext());
     cpu_backend_context->SetUseCaching(true);
     cpu_backend_context->SetMaxNumThreads(num_threads);
-    external_context_->set_internal_backend_context(
-        std::move(cpu_backend_context));
-    interpreter_->SetExternalContext(kTfLiteCpuBackendContext,
-                                     external_context_.get());
+    (*external_context)
+        ->set_internal_backend_context(std::move(cpu_backend_context));
+    (*interpreter)
+        ->SetExternalContext(kTfLiteCpuBackendContext,
+                             external_context->get());
   }
 
   return kTfLiteOk;
@@ -1098,6 +1182,18 @@ TfLiteStatus BenchmarkTfLiteModel::Init() {
   }
 
   AddOwnedListener(MayCreateProfilingListener());
+  if (params_.Get<bool>("enable_op_hardware_counters")) {
+    std::unique_ptr<profiling::PerfEventProfiler> profiler =
+        profiling::MaybeCreatePerfEventProfiler();
+    if (profiler) {
+      AddOwnedListener(
+          std::unique_ptr<BenchmarkListener>(new HardwareCounterListener(
+              interpreter_.get(), std::move(profiler))));
+    } else {
+      TFLITE_LOG(WARN) << "Hardware counters are not supported, ignoring "
+                          "--enable_op_hardware_counters.";
+    }
+  }
   AddOwnedListener(std::unique_ptr<BenchmarkListener>(
       new InterpreterStatePrinter(interpreter_.get())));
 
@@ -1245,9 +1341,172 @@ TfLiteStatus BenchmarkTfLiteModel::Init() {
   AddOwnedListener(std::unique_ptr<BenchmarkListener>(
       new OutputSaver(interpreter_runner_.get())));
 
+  concurrent_interpreters_.clear();
+  for (int i = 1; i < params_.Get<int32_t>("num_interpreters"); ++i) {
+    auto instance = std::make_unique<ConcurrentInterpreter>();
+    TF_LITE_ENSURE_STATUS(InitConcurrentInterpreter(instance.get()));
+    concurrent_interpreters_.push_back(std::move(instance));
+  }
+
+  return kTfLiteOk;
+}
+
+TfLiteStatus BenchmarkTfLiteModel::InitConcurrentInterpreter(
+    ConcurrentInterpreter* instance) {
+  if (params_.Get<bool>("share_model")) {
+    instance->model = tflite::FlatBufferModel::BuildFromBuffer(
+        reinterpret_cast<const char*>(model_->allocation()->base()),
+        model_->allocation()->bytes());
+  } else {
+    const size_t size = model_->allocation()->bytes();
+    instance->model_buffer.reset(new char[size]);
+    std::memcpy(instance->model_buffer.get(), model_->allocation()->base(),
+                size);
+    instance->model = tflite::FlatBufferModel::BuildFromBuffer(
+        instance->model_buffer.get(), size);
+  }
+  if (!instance->model) {
+    TFLITE_LOG(ERROR) << "Failed to build the model of a concurrent "
+                         "interpreter";
+    return kTfLiteError;
+  }
+  TF_LITE_ENSURE_STATUS(CreateInterpreter(
+      *instance->model, &instance->interpreter, &instance->external_context));
+  instance->interpreter->SetAllowFp16PrecisionForFp32(
+      params_.Get<bool>("allow_fp16"));
+
+  std::pair<TfLiteStatus, std::unique_ptr<BenchmarkInterpreterRunner>>
+      status_and_runner = BenchmarkInterpreterRunner::Create(
+          instance->interpreter.get(),
+          params_.Get<std::string>("signature_to_run_for"));
+  TF_LITE_ENSURE_STATUS(status_and_runner.first);
+  instance->runner = std::move(status_and_runner.second);
+
+  const std::vector<int>& runner_inputs = instance->runner->inputs();
+  for (int j = 0; j < inputs_.size(); ++j) {
+    int i = runner_inputs[j];
+    if (instance->runner->tensor(i)->type != kTfLiteString) {
+      instance->runner->ResizeInputTensor(i, inputs_[j].shape);
+    }
+  }
+
+  // Each interpreter gets its own delegate instances, which are destroyed
+  // after the interpreter.
+  tools::ProvidedDelegateList delegate_providers(&params_);
+  for (auto& created_delegate : delegate_providers.CreateAllRankedDelegates()) {
+    TfLiteDelegate* delegate = created_delegate.delegate.get();
+    instance->delegates.emplace_back(std::move(created_delegate.delegate));
+    if (instance->interpreter->ModifyGraphWithDelegate(delegate) !=
+        kTfLiteOk) {
+      TFLITE_LOG(ERROR) << "Failed to apply "
+                        << created_delegate.provider->GetName()
+                        << " delegate to a concurrent interpreter.";
+      return kTfLiteError;
+    }
+  }
+
+  if (instance->runner->AllocateTensors() != kTfLiteOk) {
+    TFLITE_LOG(ERROR) << "Failed to allocate tensors of a concurrent "
+                         "interpreter!";
+    return kTfLiteError;
+  }
   return kTfLiteOk;
 }
 
+tensorflow::StatWithPercentiles<int64_t> BenchmarkTfLiteModel::Run(
+    int min_num_times, float min_secs, float max_secs, RunType run_type,
+    TfLiteStatus* invoke_status) {
+  if (run_type != REGULAR || concurrent_interpreters_.empty()) {
+    return BenchmarkModel::Run(min_num_times, min_secs, max_secs, run_type,
+                               invoke_status);
+  }
+  return RunConcurrently(min_num_times, min_secs, max_secs, invoke_status);
+}
+
+tensorflow::StatWithPercentiles<int64_t> BenchmarkTfLiteModel::RunConcurrently(
+    int min_num_times, float min_secs, float max_secs,
+    TfLiteStatus* invoke_status) {
+  std::vector<BenchmarkInterpreterRunner*> runners = {
+      interpreter_runner_.get()};
+  for (const auto& instance : concurrent_interpreters_) {
+    runners.push_back(instance->runner.get());
+  }
+  const float target_qps = params_.Get<float>("target_qps");
+  TFLITE_LOG(INFO) << "Running benchmark with " << runners.size()
+                   << " concurrent interpreters for at least " << min_num_times
+                   << " requests and at least " << min_secs << " seconds but"
+                   << " terminate if exceeding " << max_secs << " seconds.";
+  *invoke_status = kTfLiteOk;
+  // Only the first interpreter was used by the warmup runs.
+  for (int i = 0; i < runners.size(); ++i) {
+    if (SetInputs(runners[i]) != kTfLiteOk ||
+        (i > 0 && runners[i]->Invoke() != kTfLiteOk)) {
+      *invoke_status = kTfLiteError;
+      return tensorflow::StatWithPercentiles<int64_t>();
+    }
+  }
+
+  const int64_t start_us = profiling::time::NowMicros();
+  const int64_t min_finish_us = start_us + static_cast<int64_t>(min_secs * 1e6);
+  const int64_t max_finish_us = start_us + static_cast<int64_t>(max_secs * 1e6);
+  std::atomic<int64_t> next_request(0);
+  std::atomic<bool> failed(false);
+  std::vector<std::vector<int64_t>> latencies_us(runners.size());
+  std::vector<std::thread> threads;
+  for (int i = 0; i < runners.size(); ++i) {
+    threads.emplace_back([&, i]() {
+      while (!failed) {
+        const int64_t request = next_request++;
+        // With a target rate, requests arrive on a fixed schedule whether or
+        // not an interpreter is free, and the time they wait is part of their
+        // latency.
+        int64_t arrival_us = profiling::time::NowMicros();
+        if (target_qps > 0) {
+          arrival_us = start_us + static_cast<int64_t>(request * 1e6 /
+                                                       target_qps);
+          if (arrival_us > max_finish_us) break;
+          const int64_t now_us = profiling::time::NowMicros();
+          if (arrival_us > now_us) {
+            profiling::time::SleepForMicros(arrival_us - now_us);
+          }
+        }
+        if ((request >= min_num_times && arrival_us >= min_finish_us) ||
+            arrival_us > max_finish_us) {
+          break;
+        }
+        if (runners[i]->Invoke() != kTfLiteOk) {
+          failed = true;
+          break;
+        }
+        const int64_t end_us = profiling::time::NowMicros();
+        latencies_us[i].push_back(end_us - arrival_us);
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  const int64_t end_us = profiling::time::NowMicros();
+
+  tensorflow::StatWithPercentiles<int64_t> run_stats;
+  for (const std::vector<int64_t>& latencies : latencies_us) {
+    for (int64_t latency_us : latencies) run_stats.UpdateStat(latency_us);
+  }
+  if (failed) *invoke_status = kTfLiteError;
+
+  const double elapsed_secs = (end_us - start_us) * 1e-6;
+  TFLITE_LOG(INFO) << "Ran " << run_stats.count() << " requests on "
+                   << runners.size() << " interpreters in " << elapsed_secs
+                   << " seconds: "
+                   << (elapsed_secs > 0 ? run_stats.count() / elapsed_secs : 0)
+                   << " requests per second, request latency p50="
+                   << run_stats.percentile(50)
+                   << " p90=" << run_stats.percentile(90)
+                   << " p99=" << run_stats.percentile(99) << " (us)";
+  std::stringstream stream;
+  run_stats.OutputToStream(&stream);
+  TFLITE_LOG(INFO) << stream.str() << std::endl;
+  return run_stats;
+}
+
 TfLiteStatus BenchmarkTfLiteModel::LoadModel() {
   std::string fd_or_graph_path = params_.Get<std::string>("graph");
   model_loader_ = tools::CreateModelLoaderFromPath(fd_or_graph_path);
@@ -161,6 +161,8 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   explicit BenchmarkTfLiteModel(BenchmarkParams params = DefaultParams());
   ~BenchmarkTfLiteModel() override;
 
+  using BenchmarkModel::Run;
+
   std::vector<Flag> GetFlags() override;
   void LogParams() override;
   TfLiteStatus ValidateParams() override;
@@ -175,6 +177,13 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
 
   int64_t MayGetModelFileSize() override;
 
+  // With --num_interpreters greater than one, the regular runs invoke all the
+  // interpreters concurrently, and the returned statistics are the latencies
+  // of the individual requests.
+  tensorflow::StatWithPercentiles<int64_t> Run(
+      int min_num_times, float min_secs, float max_secs, RunType run_type,
+      TfLiteStatus* invoke_status) override;
+
   virtual TfLiteStatus LoadModel();
 
   // Allow subclasses to create a customized Op resolver during init.
@@ -183,6 +192,12 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   // Allow subclass to initialize a customized tflite interpreter.
   virtual TfLiteStatus InitInterpreter();
 
+  // Builds an interpreter of `model` with the options given by the params.
+  TfLiteStatus CreateInterpreter(
+      const tflite::FlatBufferModel& model,
+      std::unique_ptr<tflite::Interpreter>* interpreter,
+      std::unique_ptr<tflite::ExternalCpuBackendContext>* external_context);
+
   // Create a BenchmarkListener that's specifically for TFLite profiling if
   // necessary.
   virtual std::unique_ptr<BenchmarkListener> MayCreateProfilingListener() const;
@@ -192,6 +207,9 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   utils::InputTensorData LoadInputTensorData(
       const TfLiteTensor& t, const std::string& input_file_path);
 
+  // Sets the values of the input tensors of `runner` from `inputs_data_`.
+  TfLiteStatus SetInputs(BenchmarkInterpreterRunner* runner);
+
   std::vector<InputLayerInfo> inputs_;
   std::vector<utils::InputTensorData> inputs_data_;
   std::unique_ptr<tflite::FlatBufferModel> model_;
@@ -200,6 +218,23 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   std::unique_ptr<tflite::ExternalCpuBackendContext> external_context_;
 
  private:
+  // An interpreter invoked concurrently with `interpreter_`, with its own
+  // copy of the model unless --share_model is set, and its own delegates.
+  struct ConcurrentInterpreter {
+    std::unique_ptr<char[]> model_buffer;
+    std::unique_ptr<tflite::FlatBufferModel> model;
+    std::unique_ptr<tflite::ExternalCpuBackendContext> external_context;
+    std::vector<Interpreter::TfLiteDelegatePtr> delegates;
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    std::unique_ptr<BenchmarkInterpreterRunner> runner;
+  };
+
+  TfLiteStatus InitConcurrentInterpreter(ConcurrentInterpreter* instance);
+
+  tensorflow::StatWithPercentiles<int64_t> RunConcurrently(
+      int min_num_times, float min_secs, float max_secs,
+      TfLiteStatus* invoke_status);
+
   utils::InputTensorData CreateRandomTensorData(
       const TfLiteTensor& t, const InputLayerInfo* layer_info);
 
@@ -215,6 +250,7 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   // Always TFLITE_LOG the benchmark result.
   BenchmarkLoggingListener log_output_;
   std::unique_ptr<tools::ModelLoader> model_loader_;
+  std::vector<std::unique_ptr<ConcurrentInterpreter>> concurrent_interpreters_;
 };
 
 }  // namespace benchmark
@@ -102,6 +102,7 @@ def all_reduce_v2(t,
                   timeout=0,
                   ordering_token=None,
                   max_subdivs_per_device=-1,
+                  residual_id='',
                   name=None):
   """Reduces tensors collectively, across devices.
 
@@ -132,6 +133,11 @@ def all_reduce_v2(t,
       parallelize processing of each per-device tensor. Setting to -1 disables
       subdivision and reverts to previous behavior of not sub-dividing tensor.
       Setting to 0 uses sytem defaults.
+    residual_id: a string identifying the reduced tensor across steps, e.g. a
+      variable name, when `communication_hint` is `ring_bf16` or `ring_int8`.
+      The compression error of a step is added back in the next step with the
+      same `residual_id`. If empty, `instance_key` identifies the tensor.
+      Reductions that run concurrently must have different ids.
     name: name of the Op.
 
   Returns:
@@ -154,6 +160,7 @@ def all_reduce_v2(t,
       is_stateless=False,
       ordering_token=ordering_token,
       max_subdivs_per_device=max_subdivs_per_device,
+      residual_id=residual_id,
       name=name)
 
 
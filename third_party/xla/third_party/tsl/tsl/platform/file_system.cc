@@ -504,4 +504,16 @@ std::string FileSystem::DecodeTransaction(const TransactionToken* token) {
   return "No Transaction";
 }
 
+void RandomAccessFile::ReadBatch(
+    absl::Span<ReadRequest> requests,
+    std::function<void(const absl::Status&)> done) const {
+  absl::Status status;
+  for (ReadRequest& request : requests) {
+    request.status =
+        Read(request.offset, request.n, &request.result, request.scratch);
+    status.Update(request.status);
+  }
+  done(status);
+}
+
 }  // namespace tsl
@@ -25,6 +25,7 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/types/span.h"
 #include "tsl/platform/cord.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/file_statistics.h"
@@ -793,6 +794,32 @@ class RandomAccessFile {
   }
 #endif
 
+  /// \brief A read of `n` bytes from `offset` into `scratch[0..n-1]`, issued
+  /// by ReadBatch(). `result` and `status` are set as by Read().
+  struct ReadRequest {
+    uint64 offset = 0;
+    size_t n = 0;
+    char* scratch = nullptr;
+    absl::string_view result;
+    absl::Status status;
+  };
+
+  /// \brief Reads all of `requests`, then calls `done` with the first non-OK
+  /// status of the requests, or OK.
+  ///
+  /// Each request is read as if by Read(), and its `result` and `status` are
+  /// set when `done` is called. `done` may be called in another thread, or
+  /// before ReadBatch() returns, and `requests` and their scratch buffers must
+  /// be live until it is called.
+  ///
+  /// The default implementation calls Read() for each request in turn.
+  /// Filesystems that can keep several reads in flight should override it, so
+  /// that a single thread can issue many scattered reads.
+  ///
+  /// Safe for concurrent use by multiple threads.
+  virtual void ReadBatch(absl::Span<ReadRequest> requests,
+                         std::function<void(const absl::Status&)> done) const;
+
  private:
   RandomAccessFile(const RandomAccessFile&) = delete;
   void operator=(const RandomAccessFile&) = delete;
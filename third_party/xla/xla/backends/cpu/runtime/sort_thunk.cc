@@ -15,8 +15,11 @@ limitations under the License.
 
 #include "xla/backends/cpu/runtime/sort_thunk.h"
 
+#define EIGEN_USE_THREADS
+
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -41,6 +44,8 @@ limitations under the License.
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/types/span.h"
+#include "unsupported/Eigen/CXX11/Tensor"
+#include "xla/backends/cpu/runtime/concurrency.h"
 #include "xla/backends/cpu/runtime/function_library.h"
 #include "xla/backends/cpu/runtime/thunk.h"
 #include "xla/layout_util.h"
@@ -138,6 +143,11 @@ namespace {
 // The size of the largest element we support (std::complex<double>).
 static constexpr size_t kMaxElementSize = 16;
 
+// The minimum number of elements sorted by a task of a parallel sort. Smaller
+// sorts run in the caller thread, as scheduling tasks would cost more than it
+// saves.
+static constexpr int64_t kMinParallelSortElementsPerTask = 32 * 1024;
+
 // Forward declare reference type defined below.
 template <size_t n>
 struct Ref;
@@ -491,29 +501,39 @@ static SortDims GetSortDims(const Shape& shape, int64_t dimension) {
                   num_iterations};
 }
 
+// Sorts `size` elements starting at `begin` or, if `merge_point` is positive,
+// merges the sorted runs that start at `begin` and `begin + merge_point`.
+template <class Iterator, class Compare>
+static void SortOrMerge(Iterator begin, int64_t size, int64_t merge_point,
+                        bool is_stable, Compare compare) {
+  if (merge_point > 0) {
+    std::inplace_merge(begin, begin + merge_point, begin + size, compare);
+  } else if (is_stable) {
+    std::stable_sort(begin, begin + size, compare);
+  } else {
+    std::sort(begin, begin + size, compare);
+  }
+}
+
 template <class Iterator, class NativeT>
 static void Sort1DArrInplace(int64_t sort_dims_size, int64_t offset,
-                             Iterator begin, bool is_stable,
+                             int64_t merge_point, Iterator begin,
+                             bool is_stable,
                              SortThunk::SortDirection direction) {
   if (direction == SortThunk::SortDirection::kAscending) {
-    if (is_stable) {
-      std::stable_sort(begin, begin + sort_dims_size, std::less<NativeT>());
-    } else {
-      std::sort(begin, begin + sort_dims_size, std::less<NativeT>());
-    }
+    SortOrMerge(begin, sort_dims_size, merge_point, is_stable,
+                std::less<NativeT>());
   } else {
-    if (is_stable) {
-      std::stable_sort(begin, begin + sort_dims_size, std::greater<NativeT>());
-    } else {
-      std::sort(begin, begin + sort_dims_size, std::greater<NativeT>());
-    }
-  };
+    SortOrMerge(begin, sort_dims_size, merge_point, is_stable,
+                std::greater<NativeT>());
+  }
 }
 
 // The most efficient way to sort a single buffer is to use the builtin
 // comparator functions.
 template <PrimitiveType Type>
 static void Sort1DArrInplace(const SortDims& sort_dims, int64_t offset,
+                             int64_t merge_point,
                              absl::Span<se::DeviceMemoryBase> data,
                              bool is_stable,
                              SortThunk::SortDirection direction) {
@@ -522,19 +542,22 @@ static void Sort1DArrInplace(const SortDims& sort_dims, int64_t offset,
   NativeT* begin = reinterpret_cast<NativeT*>(data[0].opaque()) + offset;
 
   if (sort_dims.inner_dim_size == 1) {
-    Sort1DArrInplace<NativeT*, NativeT>(sort_dims.sort_dim_size, offset, begin,
-                                        is_stable, direction);
+    Sort1DArrInplace<NativeT*, NativeT>(sort_dims.sort_dim_size, offset,
+                                        merge_point, begin, is_stable,
+                                        direction);
   } else {
     using Iterator = SortIterator<NativeT, NativeT&, NativeT*>;
     Iterator begin_iter(begin, /*stride=*/sort_dims.inner_dim_size);
     Sort1DArrInplace<Iterator, NativeT>(sort_dims.sort_dim_size, offset,
-                                        begin_iter, is_stable, direction);
+                                        merge_point, begin_iter, is_stable,
+                                        direction);
   }
 }
 
 // Sorts `n` buffers in place.
 template <size_t n>
 static void SortInplace(const SortDims& sort_dims, int64_t offset,
+                        int64_t merge_point,
                         absl::Span<se::DeviceMemoryBase> data,
                         absl::Span<const Shape> shapes, bool is_stable,
                         SortThunk::LessThan* less_than) {
@@ -559,14 +582,11 @@ static void SortInplace(const SortDims& sort_dims, int64_t offset,
   SortIterator<Value<n>, Ref<n>, Ptr<n>> begin(
       Ptr<n>(ptr, ptr_sizes),
       /*stride=*/sort_dims.inner_dim_size);
-  if (is_stable) {
-    std::stable_sort(begin, begin + sort_dims.sort_dim_size, compare);
-  } else {
-    std::sort(begin, begin + sort_dims.sort_dim_size, compare);
-  }
+  SortOrMerge(begin, sort_dims.sort_dim_size, merge_point, is_stable, compare);
 }
 
 static void DSortInplace(const SortDims& sort_dims, int64_t offset,
+                         int64_t merge_point,
                          absl::Span<se::DeviceMemoryBase> data,
                          absl::Span<const Shape> shapes, bool is_stable,
                          SortThunk::LessThan* less_than, size_t n) {
@@ -590,146 +610,250 @@ static void DSortInplace(const SortDims& sort_dims, int64_t offset,
 
   SortIterator<DValue, DRef, DPtr> begin(DPtr(ptr, ptr_sizes),
                                          /*stride=*/sort_dims.inner_dim_size);
-  if (is_stable) {
-    std::stable_sort(begin, begin + sort_dims.sort_dim_size, compare);
-  } else {
-    std::sort(begin, begin + sort_dims.sort_dim_size, compare);
-  }
+  SortOrMerge(begin, sort_dims.sort_dim_size, merge_point, is_stable, compare);
 }
 
-// Sorts `data` of the given `shape` along the `dimension` inplace.
-static absl::Status SortInplace(
-    absl::Span<se::DeviceMemoryBase> data, absl::Span<const Shape> shapes,
-    int64_t dimension, bool is_stable, SortThunk::LessThan* less_than,
-    std::optional<SortThunk::SortDirection> direction) {
-  // All inputs have the same dimensions and layout, so we can use the first
-  // shape to get the sort dimensions.
-  SortDims sort_dims = GetSortDims(shapes[0], dimension);
+// Sorts the 1-dimensional slice of `data` that starts at `offset` inplace or,
+// if `merge_point` is positive, merges its two sorted runs.
+static void SortSlice(const SortDims& sort_dims, int64_t offset,
+                      int64_t merge_point,
+                      absl::Span<se::DeviceMemoryBase> data,
+                      absl::Span<const Shape> shapes, bool is_stable,
+                      SortThunk::LessThan* less_than,
+                      std::optional<SortThunk::SortDirection> direction) {
+  auto sort = [&](auto num_inputs) {
+    SortInplace<decltype(num_inputs)::value>(sort_dims, offset, merge_point,
+                                             data, shapes, is_stable,
+                                             less_than);
+  };
+
+  auto dsort = [&](size_t num_inputs) {
+    DSortInplace(sort_dims, offset, merge_point, data, shapes, is_stable,
+                 less_than, num_inputs);
+  };
+
+  // Sorts array using builtin comparator functor
+  auto builtin_sort = [&](PrimitiveType type,
+                          SortThunk::SortDirection direction) {
+    primitive_util::ArrayTypeSwitch<void>(
+        [&](auto cst_type) {
+          if constexpr ((primitive_util::IsFloatingPointType(cst_type) ||
+                         primitive_util::IsIntegralType(cst_type)) &&
+                        primitive_util::BitWidth(cst_type) >= 8) {
+            Sort1DArrInplace<cst_type>(sort_dims, offset, merge_point, data,
+                                       is_stable, direction);
+          } else {
+            sort(std::integral_constant<size_t, 1>{});
+          }
+        },
+        type);
+  };
 
-  // Iterate over all the 1-dimensional slices of the buffers and sort them.
-  for (int64_t i = 0; i < sort_dims.num_iterations; ++i) {
+  // use "sort" for statically known number of sorted inputs (expected to be
+  // faster) and "dsort" for dynamically known number of sorted inputs.
+  // for 100 elements stable sort is 1.5 times faster than stable dsort.
+  // for 100 elements unstable sort is 2.47 times faster than unstable dsort.
+  switch (data.size()) {
+    case 1:
+      DCHECK_EQ(shapes.size(), 1);
+      if (direction.has_value()) {
+        builtin_sort(shapes[0].element_type(), *direction);
+      } else {
+        sort(std::integral_constant<size_t, 1>{});
+      }
+      break;
+    case 2:
+      sort(std::integral_constant<size_t, 2>{});
+      break;
+    case 3:
+      sort(std::integral_constant<size_t, 3>{});
+      break;
+    case 4:
+      sort(std::integral_constant<size_t, 4>{});
+      break;
+    case 5:
+      sort(std::integral_constant<size_t, 5>{});
+      break;
+    case 6:
+      sort(std::integral_constant<size_t, 6>{});
+      break;
+    case 7:
+      sort(std::integral_constant<size_t, 7>{});
+      break;
+    case 8:
+      sort(std::integral_constant<size_t, 8>{});
+      break;
+    case 9:
+      sort(std::integral_constant<size_t, 9>{});
+      break;
+    case 10:
+      sort(std::integral_constant<size_t, 10>{});
+      break;
+    case 11:
+      sort(std::integral_constant<size_t, 11>{});
+      break;
+    case 12:
+      sort(std::integral_constant<size_t, 12>{});
+      break;
+    case 13:
+      sort(std::integral_constant<size_t, 13>{});
+      break;
+    case 14:
+      sort(std::integral_constant<size_t, 14>{});
+      break;
+    case 15:
+      sort(std::integral_constant<size_t, 15>{});
+      break;
+    case 16:
+      sort(std::integral_constant<size_t, 16>{});
+      break;
+    case 17:
+      sort(std::integral_constant<size_t, 17>{});
+      break;
+    case 18:
+      sort(std::integral_constant<size_t, 18>{});
+      break;
+    case 19:
+      sort(std::integral_constant<size_t, 19>{});
+      break;
+    case 20:
+      sort(std::integral_constant<size_t, 20>{});
+      break;
+    case 21:
+      sort(std::integral_constant<size_t, 21>{});
+      break;
+    case 22:
+      sort(std::integral_constant<size_t, 22>{});
+      break;
+    case 23:
+      sort(std::integral_constant<size_t, 23>{});
+      break;
+    case 24:
+      sort(std::integral_constant<size_t, 24>{});
+      break;
+    case 25:
+      sort(std::integral_constant<size_t, 25>{});
+      break;
+    default:
+      dsort(data.size());
+      break;
+  }
+}
+
+// Sorts the 1-dimensional slices of `data` in the [start, end) range inplace.
+static void SortSlices(const SortDims& sort_dims, int64_t start, int64_t end,
+                       absl::Span<se::DeviceMemoryBase> data,
+                       absl::Span<const Shape> shapes, bool is_stable,
+                       SortThunk::LessThan* less_than,
+                       std::optional<SortThunk::SortDirection> direction) {
+  for (int64_t i = start; i < end; ++i) {
     int64_t inner_idx = i % sort_dims.inner_dim_size;
     int64_t offset = inner_idx + (i - inner_idx) * sort_dims.sort_dim_size;
+    SortSlice(sort_dims, offset, /*merge_point=*/0, data, shapes, is_stable,
+              less_than, direction);
+  }
+}
 
-    auto sort = [&](auto num_inputs) {
-      SortInplace<decltype(num_inputs)::value>(sort_dims, offset, data, shapes,
-                                               is_stable, less_than);
-    };
+// Returns the number of tasks that sort `sort_dims` in the intra-op thread
+// pool, or 1 if the sort should run in the caller thread.
+static int64_t GetNumSortTasks(
+    const SortDims& sort_dims,
+    const Eigen::ThreadPoolDevice* intra_op_threadpool) {
+  if (intra_op_threadpool == nullptr) return 1;
+
+  int64_t num_elements = sort_dims.num_iterations * sort_dims.sort_dim_size;
+  int64_t num_tasks =
+      std::min<int64_t>(intra_op_threadpool->numThreads(),
+                        num_elements / kMinParallelSortElementsPerTask);
+  if (sort_dims.num_iterations > 1) {
+    num_tasks = std::min(num_tasks, sort_dims.num_iterations);
+  }
+  return std::max<int64_t>(num_tasks, 1);
+}
 
-    auto dsort = [&](size_t num_inputs) {
-      DSortInplace(sort_dims, offset, data, shapes, is_stable, less_than,
-                   num_inputs);
-    };
+namespace {
+
+// A sort running in the intra-op thread pool. The tasks of each step share the
+// state, and the last one to finish starts the next step or, after the last
+// step, makes `event` available.
+struct ParallelSort {
+  absl::InlinedVector<se::DeviceMemoryBase, 8> data;
+  absl::InlinedVector<Shape, 8> shapes;
+  SortDims sort_dims;
+  bool is_stable;
+  SortThunk::LessThan* less_than;
+  std::optional<SortThunk::SortDirection> direction;
+
+  const Eigen::ThreadPoolDevice* intra_op_threadpool;
+  int64_t num_tasks;
+
+  // The number of tasks of the current step that have not finished yet.
+  std::atomic<int64_t> pending_tasks;
+  tsl::AsyncValueRef<SortThunk::ExecuteEvent> event;
+};
 
-    // Sorts array using builtin comparator functor
-    auto builtin_sort = [&](PrimitiveType type,
-                            SortThunk::SortDirection direction) {
-      primitive_util::ArrayTypeSwitch<void>(
-          [&](auto cst_type) {
-            if constexpr ((primitive_util::IsFloatingPointType(cst_type) ||
-                           primitive_util::IsIntegralType(cst_type)) &&
-                          primitive_util::BitWidth(cst_type) >= 8) {
-              Sort1DArrInplace<cst_type>(sort_dims, offset, data, is_stable,
-                                         direction);
-            } else {
-              sort(std::integral_constant<size_t, 1>{});
-            }
-          },
-          type);
+}  // namespace
+
+// Sorts the independent slices of the buffers in `num_tasks` parallel tasks,
+// each sorting a block of consecutive slices.
+static void SortSlicesInParallel(std::shared_ptr<ParallelSort> sort) {
+  sort->pending_tasks.store(sort->num_tasks, std::memory_order_relaxed);
+  ScheduleAll(sort->intra_op_threadpool, sort->num_tasks, [sort](int64_t task) {
+    int64_t num_iterations = sort->sort_dims.num_iterations;
+    SortSlices(sort->sort_dims, task * num_iterations / sort->num_tasks,
+               (task + 1) * num_iterations / sort->num_tasks,
+               absl::MakeSpan(sort->data), sort->shapes, sort->is_stable,
+               sort->less_than, sort->direction);
+    if (sort->pending_tasks.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      sort->event.SetStateConcrete();
+    }
+  });
+}
+
+// Runs a step of the merge sort of a single slice split into `num_tasks`
+// chunks. The first step (`width` is 0) sorts each chunk, and the following
+// steps merge pairs of adjacent sorted runs of `width` chunks, until the whole
+// slice is sorted.
+static void MergeSortInParallel(std::shared_ptr<ParallelSort> sort,
+                                int64_t width) {
+  int64_t num_chunks = sort->num_tasks;
+  int64_t num_step_tasks =
+      width == 0 ? num_chunks : CeilOfRatio(num_chunks, 2 * width);
+
+  auto step_task = [sort, width, num_chunks](int64_t task) {
+    // A single slice is contiguous, so chunk offsets are element offsets.
+    DCHECK_EQ(sort->sort_dims.inner_dim_size, 1);
+    auto chunk_offset = [&](int64_t chunk) {
+      return std::min(chunk, num_chunks) * sort->sort_dims.sort_dim_size /
+             num_chunks;
     };
 
-    // use "sort" for statically known number of sorted inputs (expected to be
-    // faster) and "dsort" for dynamically known number of sorted inputs.
-    // for 100 elements stable sort is 1.5 times faster than stable dsort.
-    // for 100 elements unstable sort is 2.47 times faster than unstable dsort.
-    switch (data.size()) {
-      case 1:
-        DCHECK_EQ(shapes.size(), 1);
-        if (direction.has_value()) {
-          builtin_sort(shapes[0].element_type(), *direction);
-        } else {
-          sort(std::integral_constant<size_t, 1>{});
-        }
-        break;
-      case 2:
-        sort(std::integral_constant<size_t, 2>{});
-        break;
-      case 3:
-        sort(std::integral_constant<size_t, 3>{});
-        break;
-      case 4:
-        sort(std::integral_constant<size_t, 4>{});
-        break;
-      case 5:
-        sort(std::integral_constant<size_t, 5>{});
-        break;
-      case 6:
-        sort(std::integral_constant<size_t, 6>{});
-        break;
-      case 7:
-        sort(std::integral_constant<size_t, 7>{});
-        break;
-      case 8:
-        sort(std::integral_constant<size_t, 8>{});
-        break;
-      case 9:
-        sort(std::integral_constant<size_t, 9>{});
-        break;
-      case 10:
-        sort(std::integral_constant<size_t, 10>{});
-        break;
-      case 11:
-        sort(std::integral_constant<size_t, 11>{});
-        break;
-      case 12:
-        sort(std::integral_constant<size_t, 12>{});
-        break;
-      case 13:
-        sort(std::integral_constant<size_t, 13>{});
-        break;
-      case 14:
-        sort(std::integral_constant<size_t, 14>{});
-        break;
-      case 15:
-        sort(std::integral_constant<size_t, 15>{});
-        break;
-      case 16:
-        sort(std::integral_constant<size_t, 16>{});
-        break;
-      case 17:
-        sort(std::integral_constant<size_t, 17>{});
-        break;
-      case 18:
-        sort(std::integral_constant<size_t, 18>{});
-        break;
-      case 19:
-        sort(std::integral_constant<size_t, 19>{});
-        break;
-      case 20:
-        sort(std::integral_constant<size_t, 20>{});
-        break;
-      case 21:
-        sort(std::integral_constant<size_t, 21>{});
-        break;
-      case 22:
-        sort(std::integral_constant<size_t, 22>{});
-        break;
-      case 23:
-        sort(std::integral_constant<size_t, 23>{});
-        break;
-      case 24:
-        sort(std::integral_constant<size_t, 24>{});
-        break;
-      case 25:
-        sort(std::integral_constant<size_t, 25>{});
-        break;
-      default:
-        dsort(data.size());
-        break;
+    int64_t first_chunk = width == 0 ? task : 2 * width * task;
+    int64_t begin = chunk_offset(first_chunk);
+    int64_t mid = chunk_offset(first_chunk + width);
+    int64_t end = chunk_offset(width == 0 ? task + 1 : first_chunk + 2 * width);
+
+    // The last run has nothing to merge with if the number of runs is odd.
+    if (width == 0 || mid < end) {
+      SortDims range_dims = sort->sort_dims;
+      range_dims.sort_dim_size = end - begin;
+      SortSlice(range_dims, begin, /*merge_point=*/mid - begin,
+                absl::MakeSpan(sort->data), sort->shapes, sort->is_stable,
+                sort->less_than, sort->direction);
     }
-  }
 
-  return absl::OkStatus();
+    if (sort->pending_tasks.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      int64_t next_width = width == 0 ? 1 : 2 * width;
+      if (next_width >= num_chunks) {
+        sort->event.SetStateConcrete();
+      } else {
+        MergeSortInParallel(sort, next_width);
+      }
+    }
+  };
+
+  sort->pending_tasks.store(num_step_tasks, std::memory_order_relaxed);
+  ScheduleAll(sort->intra_op_threadpool, num_step_tasks, std::move(step_task));
 }
 
 tsl::AsyncValueRef<SortThunk::ExecuteEvent> SortThunk::Execute(
@@ -789,10 +913,41 @@ tsl::AsyncValueRef<SortThunk::ExecuteEvent> SortThunk::Execute(
   TF_RETURN_IF_ERROR(less_than_.status());
   LessThan* less_than = &less_than_.value();
 
-  TF_RETURN_IF_ERROR(SortInplace(absl::MakeSpan(data), shapes, dimension_,
-                                 is_stable_, less_than, direction_));
-
-  return OkExecuteEvent();
+  // All inputs have the same dimensions and layout, so we can use the first
+  // shape to get the sort dimensions.
+  SortDims sort_dims = GetSortDims(shapes[0], dimension_);
+  int64_t num_tasks = GetNumSortTasks(sort_dims, params.intra_op_threadpool);
+
+  if (ABSL_PREDICT_TRUE(num_tasks == 1)) {
+    SortSlices(sort_dims, 0, sort_dims.num_iterations, absl::MakeSpan(data),
+               shapes, is_stable_, less_than, direction_);
+    return OkExecuteEvent();
+  }
+
+  VLOG(3) << absl::StreamFormat("  sort %d slices of %d elements in %d tasks",
+                                sort_dims.num_iterations,
+                                sort_dims.sort_dim_size, num_tasks);
+
+  auto sort = std::make_shared<ParallelSort>();
+  sort->data = std::move(data);
+  sort->shapes = std::move(shapes);
+  sort->sort_dims = sort_dims;
+  sort->is_stable = is_stable_;
+  sort->less_than = less_than;
+  sort->direction = direction_;
+  sort->intra_op_threadpool = params.intra_op_threadpool;
+  sort->num_tasks = num_tasks;
+  sort->event = tsl::MakeConstructedAsyncValueRef<ExecuteEvent>();
+
+  // Independent slices are sorted in parallel, and a single large slice with a
+  // parallel merge sort.
+  tsl::AsyncValueRef<ExecuteEvent> event = sort->event;
+  if (sort_dims.num_iterations > 1) {
+    SortSlicesInParallel(std::move(sort));
+  } else {
+    MergeSortInParallel(std::move(sort), /*width=*/0);
+  }
+  return event;
 }
 
 SortThunk::BufferUses SortThunk::buffer_uses() const {
@@ -38,6 +38,10 @@ namespace xla::cpu {
 
 // Sorts data in the input buffers along the given dimension with a custom
 // less-than comparator function.
+//
+// Large sorts run in the intra-op thread pool: independent 1-dimensional slices
+// are sorted in parallel, and a single large slice is sorted in chunks that are
+// then merged.
 class SortThunk final : public Thunk {
  public:
   using LessThan = absl::AnyInvocable<bool(const void** data)>;
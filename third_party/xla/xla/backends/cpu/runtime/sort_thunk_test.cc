@@ -21,10 +21,12 @@ limitations under the License.
 #include <cstdint>
 #include <functional>
 #include <numeric>
+#include <optional>
 #include <random>
 #include <string_view>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/status/statusor.h"
 #include "xla/backends/cpu/runtime/buffer_allocations.h"
 #include "xla/backends/cpu/runtime/function_library.h"
@@ -37,10 +39,17 @@ limitations under the License.
 #include "xla/shape_util.h"
 #include "xla/stream_executor/device_memory.h"
 #include "xla/tsl/concurrency/async_value_ref.h"
+#include "tsl/platform/env.h"
 #include "tsl/platform/logging.h"
 #include "tsl/platform/statusor.h"
 #include "tsl/platform/test.h"
 #include "tsl/platform/test_benchmark.h"
+#include "tsl/platform/threadpool.h"
+
+#define EIGEN_USE_THREADS
+
+#include "Eigen/ThreadPool"
+#include "unsupported/Eigen/CXX11/Tensor"
 
 namespace xla::cpu {
 namespace {
@@ -371,6 +380,148 @@ TEST_P(SortThunkTest, Sort2DWithLayout) {
   EXPECT_EQ(indices, expected_indices);
 }
 
+// Large enough to be sorted in parallel with a thread pool.
+constexpr int64_t kParallelSortSize = 256 * 1024;
+
+TEST_P(SortThunkTest, ParallelSortPlainArray) {
+  bool is_stable = GetParam();
+
+  std::vector<float> data(kParallelSortSize);
+  std::default_random_engine gen;
+  std::uniform_real_distribution<float> distribution(0.0, 1000.0);
+  for (float& value : data) value = distribution(gen);
+
+  const size_t size_in_bytes = data.size() * sizeof(float);
+  std::vector<MaybeOwningDeviceMemory> buffers;
+  buffers.emplace_back(se::DeviceMemoryBase(data.data(), size_in_bytes));
+
+  const BufferAllocations allocations(buffers);
+  const BufferAllocation alloc(0, size_in_bytes, 0);
+  const BufferAllocation::Slice slice0(&alloc, 0, size_in_bytes);
+  const Shape data_shape = ShapeUtil::MakeShape(F32, {kParallelSortSize});
+
+  auto fake_less_than = [](const void** data) { return false; };
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto thunk, SortThunk::Create({"sort"}, {{slice0, data_shape}},
+                                    /*dimension=*/0, is_stable, fake_less_than,
+                                    SortThunk::SortDirection::kDescending));
+
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "sort-test", 8);
+  Eigen::ThreadPoolDevice device(thread_pool.AsEigenThreadPool(),
+                                 thread_pool.NumThreads());
+
+  Thunk::ExecuteParams params;
+  params.buffer_allocations = &allocations;
+  params.intra_op_threadpool = &device;
+
+  auto execute_event = thunk->Execute(params);
+  tsl::BlockUntilReady(execute_event);
+  ASSERT_FALSE(execute_event.IsError());
+
+  EXPECT_TRUE(
+      std::is_sorted(data.cbegin(), data.cend(), std::greater<float>()));
+}
+
+TEST_P(SortThunkTest, ParallelSort1D) {
+  bool is_stable = GetParam();
+
+  // Few distinct keys, so that a stable sort must keep the indices of equal
+  // keys in order across the merged chunks.
+  std::vector<float> data(kParallelSortSize);
+  std::vector<int32_t> indices(kParallelSortSize);
+  std::default_random_engine gen;
+  std::uniform_int_distribution<int32_t> distribution(0, 15);
+  for (float& value : data) value = distribution(gen);
+  std::iota(indices.begin(), indices.end(), 0);
+
+  const size_t size_in_bytes = data.size() * sizeof(float);
+  std::vector<MaybeOwningDeviceMemory> buffers;
+  buffers.emplace_back(se::DeviceMemoryBase(data.data(), size_in_bytes));
+  buffers.emplace_back(se::DeviceMemoryBase(indices.data(), size_in_bytes));
+
+  const BufferAllocations allocations(buffers);
+  const BufferAllocation alloc0(0, size_in_bytes, 0);
+  const BufferAllocation alloc1(1, size_in_bytes, 0);
+  const BufferAllocation::Slice slice0(&alloc0, 0, size_in_bytes);
+  const BufferAllocation::Slice slice1(&alloc1, 0, size_in_bytes);
+  const Shape data_shape = ShapeUtil::MakeShape(F32, {kParallelSortSize});
+  const Shape indices_shape = ShapeUtil::MakeShape(S32, {kParallelSortSize});
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto thunk, SortThunk::Create(
+                      {"sort"}, {{slice0, data_shape}, {slice1, indices_shape}},
+                      /*dimension=*/0, is_stable, LessThan,
+                      SortThunk::SortDirection::kAscending));
+
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "sort-test", 8);
+  Eigen::ThreadPoolDevice device(thread_pool.AsEigenThreadPool(),
+                                 thread_pool.NumThreads());
+
+  Thunk::ExecuteParams params;
+  params.buffer_allocations = &allocations;
+  params.intra_op_threadpool = &device;
+
+  auto execute_event = thunk->Execute(params);
+  tsl::BlockUntilReady(execute_event);
+  ASSERT_FALSE(execute_event.IsError());
+
+  std::vector<bool> seen(kParallelSortSize);
+  for (int64_t i = 0; i < kParallelSortSize; ++i) {
+    seen[indices[i]] = true;
+    if (i == 0) continue;
+    ASSERT_LE(data[i - 1], data[i]) << "at " << i;
+    if (is_stable && data[i - 1] == data[i]) {
+      ASSERT_LT(indices[i - 1], indices[i]) << "at " << i;
+    }
+  }
+  EXPECT_EQ(absl::c_count(seen, true), kParallelSortSize);
+}
+
+TEST_P(SortThunkTest, ParallelSort2D) {
+  bool is_stable = GetParam();
+
+  // Sorts each row of a [kBatchSize, kRowSize] array.
+  constexpr int64_t kBatchSize = 32;
+  constexpr int64_t kRowSize = 8 * 1024;
+
+  std::vector<float> data(kBatchSize * kRowSize);
+  std::default_random_engine gen;
+  std::uniform_real_distribution<float> distribution(0.0, 1000.0);
+  for (float& value : data) value = distribution(gen);
+
+  const size_t size_in_bytes = data.size() * sizeof(float);
+  std::vector<MaybeOwningDeviceMemory> buffers;
+  buffers.emplace_back(se::DeviceMemoryBase(data.data(), size_in_bytes));
+
+  const BufferAllocations allocations(buffers);
+  const BufferAllocation alloc(0, size_in_bytes, 0);
+  const BufferAllocation::Slice slice0(&alloc, 0, size_in_bytes);
+  const Shape data_shape = ShapeUtil::MakeShape(F32, {kBatchSize, kRowSize});
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto thunk, SortThunk::Create({"sort"}, {{slice0, data_shape}},
+                                    /*dimension=*/1, is_stable, LessThan,
+                                    /*direction=*/std::nullopt));
+
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "sort-test", 8);
+  Eigen::ThreadPoolDevice device(thread_pool.AsEigenThreadPool(),
+                                 thread_pool.NumThreads());
+
+  Thunk::ExecuteParams params;
+  params.buffer_allocations = &allocations;
+  params.intra_op_threadpool = &device;
+
+  auto execute_event = thunk->Execute(params);
+  tsl::BlockUntilReady(execute_event);
+  ASSERT_FALSE(execute_event.IsError());
+
+  for (int64_t row = 0; row < kBatchSize; ++row) {
+    auto begin = data.cbegin() + row * kRowSize;
+    EXPECT_TRUE(std::is_sorted(begin, begin + kRowSize)) << "row " << row;
+  }
+}
+
 void BM_DynamicSort1D(::testing::benchmark::State& state, bool is_stable) {
   const int total_num_of_slices = state.range(0);
   const int num_of_empty_slices = total_num_of_slices - 2;
@@ -187,6 +187,7 @@ DebugOptions DefaultDebugOptionsIgnoringFlags() {
   opts.set_xla_cpu_matmul_tiling_m_dim(8);
   opts.set_xla_cpu_matmul_tiling_n_dim(8);
   opts.set_xla_cpu_matmul_tiling_k_dim(8);
+  opts.set_xla_cpu_enable_dot_autotuning(false);
   opts.set_xla_cpu_enable_mlir_fusion_outlining(true);
   opts.set_xla_cpu_enable_experimental_deallocation(true);
 
@@ -1542,6 +1543,20 @@ void MakeDebugOptionsFlags(std::vector<tsl::Flag>* flag_list,
       int64_setter_for(&DebugOptions::set_xla_cpu_matmul_tiling_k_dim),
       debug_options->xla_cpu_matmul_tiling_k_dim(),
       "Custom tile size for matmul's K dimension."));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_enable_dot_autotuning",
+      bool_setter_for(&DebugOptions::set_xla_cpu_enable_dot_autotuning),
+      debug_options->xla_cpu_enable_dot_autotuning(),
+      "Benchmark the implementations and tile sizes of matrix-matrix dots on "
+      "the compile host, and use the fastest ones."));
+  flag_list->push_back(tsl::Flag(
+      "xla_cpu_dot_autotune_results_path",
+      string_setter_for(&DebugOptions::set_xla_cpu_dot_autotune_results_path),
+      debug_options->xla_cpu_dot_autotune_results_path(),
+      "If not empty, the results of the dot autotuning are loaded from and "
+      "saved to this file. The file is in text proto format if its extension "
+      "is .txt, .textproto, .prototxt or .pbtxt, and in binary format "
+      "otherwise."));
   flag_list->push_back(tsl::Flag(
       "xla_cpu_enable_experimental_deallocation",
       bool_setter_for(
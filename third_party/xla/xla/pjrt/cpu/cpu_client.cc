@@ -67,6 +67,7 @@ limitations under the License.
 #include "xla/literal_util.h"
 #include "xla/pjrt/compile_options.pb.h"
 #include "xla/pjrt/cpu/abstract_tfrt_cpu_buffer.h"
+#include "xla/pjrt/cpu/cpu_executable_cache.h"
 #include "xla/pjrt/cpu/cpu_topology.h"
 #include "xla/pjrt/cpu/tracked_tfrt_cpu_device_buffer.h"
 #include "xla/pjrt/host_memory_spaces.h"
@@ -396,10 +397,19 @@ absl::StatusOr<std::unique_ptr<PjRtClient>> GetTfrtCpuClient(
     devices.push_back(std::move(device));
   }
 
+  std::unique_ptr<CpuExecutableCache> executable_cache;
+  if (!options.executable_cache_directory.empty()) {
+    TF_ASSIGN_OR_RETURN(executable_cache,
+                        CpuExecutableCache::Create(
+                            std::move(options.executable_cache_directory),
+                            options.executable_cache_max_size_bytes));
+  }
+
   return std::unique_ptr<PjRtClient>(std::make_unique<TfrtCpuClient>(
       options.process_id, std::move(devices), std::move(options.collectives),
       num_threads, options.asynchronous,
-      std::move(options.customize_hlo_module_config)));
+      std::move(options.customize_hlo_module_config),
+      std::move(executable_cache)));
 }
 
 // An upper bound on the number of threads to use for intra-op parallelism. It
@@ -421,7 +431,8 @@ TfrtCpuClient::TfrtCpuClient(
     int process_index, std::vector<std::unique_ptr<TfrtCpuDevice>> devices,
     std::shared_ptr<cpu::CollectivesInterface> collectives, size_t num_threads,
     bool asynchronous,
-    std::function<void(HloModuleConfig&)> customize_hlo_module_config)
+    std::function<void(HloModuleConfig&)> customize_hlo_module_config,
+    std::unique_ptr<CpuExecutableCache> executable_cache)
     : process_index_(process_index),
       owned_devices_(std::move(devices)),
       computation_placer_(std::make_unique<ComputationPlacer>()),
@@ -444,7 +455,8 @@ TfrtCpuClient::TfrtCpuClient(
           platform_id(), platform_name(), platform_version(), owned_devices_,
           cpu::DetectMachineAttributes())),
       asynchronous_(asynchronous),
-      customize_hlo_module_config_(std::move(customize_hlo_module_config)) {
+      customize_hlo_module_config_(std::move(customize_hlo_module_config)),
+      executable_cache_(std::move(executable_cache)) {
   for (const std::unique_ptr<TfrtCpuDevice>& device : owned_devices_) {
     devices_.push_back(device.get());
     CHECK(
@@ -757,6 +769,43 @@ static absl::StatusOr<std::unique_ptr<xla::Executable>> JitCompile(
 absl::StatusOr<std::unique_ptr<PjRtLoadedExecutable>> TfrtCpuClient::Compile(
     const XlaComputation& computation, CompileOptions options) {
   tsl::profiler::TraceMe traceme("TfrtCpuClient::Compile (XlaComputation)");
+  // The callback that customizes the module config can't be part of the key.
+  if (executable_cache_ == nullptr || customize_hlo_module_config_) {
+    return CompileUncached(computation, std::move(options));
+  }
+  absl::StatusOr<std::string> key = CpuExecutableCache::ComputeKey(
+      computation.proto(), options,
+      topology_.cpu_topology().machine_attributes());
+  if (!key.ok()) {
+    // E.g. the options have a thread pool, which can't be serialized.
+    VLOG(1) << "Not caching the executable: " << key.status();
+    return CompileUncached(computation, std::move(options));
+  }
+
+  if (std::optional<std::string> cached = executable_cache_->Lookup(*key)) {
+    absl::StatusOr<std::unique_ptr<PjRtLoadedExecutable>> executable =
+        DeserializeExecutable(*cached, options);
+    if (executable.ok()) return executable;
+    // E.g. the executable was written by a different version of XLA.
+    LOG(WARNING) << "Failed to load cached executable " << *key
+                 << ", compiling it again: " << executable.status();
+    executable_cache_->Remove(*key);
+  }
+
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<PjRtLoadedExecutable> executable,
+                      CompileUncached(computation, std::move(options)));
+  absl::StatusOr<std::string> serialized = executable->SerializeExecutable();
+  absl::Status status = serialized.status();
+  if (status.ok()) status = executable_cache_->Insert(*key, *serialized);
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to cache executable " << *key << ": " << status;
+  }
+  return executable;
+}
+
+absl::StatusOr<std::unique_ptr<PjRtLoadedExecutable>>
+TfrtCpuClient::CompileUncached(const XlaComputation& computation,
+                               CompileOptions options) {
   auto input_options = options;
   ExecutableBuildOptions& build_options = options.executable_build_options;
 
@@ -44,6 +44,7 @@ limitations under the License.
 #include "xla/layout.h"
 #include "xla/literal.h"
 #include "xla/pjrt/cpu/abstract_tfrt_cpu_buffer.h"
+#include "xla/pjrt/cpu/cpu_executable_cache.h"
 #include "xla/pjrt/cpu/cpu_topology.h"
 #include "xla/pjrt/cpu/tracked_tfrt_cpu_device_buffer.h"
 #include "xla/pjrt/pjrt_client.h"
@@ -262,7 +263,8 @@ class TfrtCpuClient final : public PjRtClient {
       int process_index, std::vector<std::unique_ptr<TfrtCpuDevice>> devices,
       std::shared_ptr<cpu::CollectivesInterface> collectives,
       size_t num_threads, bool asynchronous,
-      std::function<void(HloModuleConfig&)> customize_hlo_module_config);
+      std::function<void(HloModuleConfig&)> customize_hlo_module_config,
+      std::unique_ptr<CpuExecutableCache> executable_cache = nullptr);
   ~TfrtCpuClient() override;
 
   int process_index() const override { return process_index_; }
@@ -431,9 +433,17 @@ class TfrtCpuClient final : public PjRtClient {
     return &topology_;
   }
 
+  // The persistent cache of compiled executables, or nullptr if disabled.
+  CpuExecutableCache* executable_cache() const {
+    return executable_cache_.get();
+  }
+
  private:
   friend class TfrtCpuExecutable;
 
+  absl::StatusOr<std::unique_ptr<PjRtLoadedExecutable>> CompileUncached(
+      const XlaComputation& computation, CompileOptions options);
+
   int process_index_;
   // Includes all devices, including non-addressable devices.
   std::vector<std::unique_ptr<TfrtCpuDevice>> owned_devices_;
@@ -489,6 +499,9 @@ class TfrtCpuClient final : public PjRtClient {
   // A callback to customize the HloModuleConfig for each compiled module.
   std::function<void(HloModuleConfig&)> customize_hlo_module_config_;
 
+  // Executables loaded instead of compiled, if enabled in CpuClientOptions.
+  std::unique_ptr<CpuExecutableCache> executable_cache_;
+
   // Used to prevent too much parallelism: we will not enqueue next non-parallel
   // computation until last one is done within each user thread.
   // TODO(yueshengys): Consider moving the enqueuing/ordering logic to JAX via
@@ -53,6 +53,7 @@ limitations under the License.
 #include "tsl/platform/errors.h"
 #include "tsl/platform/file_system.h"
 #include "tsl/platform/logging.h"
+#include "tsl/platform/path.h"
 #include "tsl/platform/status_matchers.h"
 #include "tsl/platform/statusor.h"
 #include "tsl/platform/test.h"
@@ -213,6 +214,56 @@ TEST(TfrtCpuClientTest, HloSnapshot) {
       LiteralUtil::CreateR2<float>({{11.0, 22.0}, {33.0, 44.0}, {55.0, 66.0}}));
 }
 
+TEST(TfrtCpuClientTest, ExecutableCache) {
+  static constexpr char kProgram[] = R"(
+    HloModule add
+    ENTRY add {
+      x = f32[2] parameter(0)
+      y = f32[2] parameter(1)
+      ROOT add = f32[2] add(x, y)
+    })";
+
+  TF_ASSERT_OK_AND_ASSIGN(auto hlo_module,
+                          ParseAndReturnUnverifiedModule(kProgram, {}));
+  XlaComputation xla_computation(hlo_module->ToProto());
+  CpuClientOptions cpu_options;
+  cpu_options.cpu_device_count = 1;
+  cpu_options.executable_cache_directory =
+      tsl::io::JoinPath(tsl::testing::TmpDir(), "executable_cache");
+
+  // The first client compiles the executable and caches it.
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(cpu_options));
+  TF_ASSERT_OK(client->Compile(xla_computation, {}).status());
+  auto* cpu_client = static_cast<TfrtCpuClient*>(client.get());
+  ASSERT_NE(cpu_client->executable_cache(), nullptr);
+  EXPECT_EQ(cpu_client->executable_cache()->stats().misses, 1);
+  EXPECT_EQ(cpu_client->executable_cache()->stats().hits, 0);
+
+  // The second client, like a new process, loads it.
+  TF_ASSERT_OK_AND_ASSIGN(client, GetTfrtCpuClient(cpu_options));
+  TF_ASSERT_OK_AND_ASSIGN(auto pjrt_executable,
+                          client->Compile(xla_computation, {}));
+  cpu_client = static_cast<TfrtCpuClient*>(client.get());
+  EXPECT_EQ(cpu_client->executable_cache()->stats().hits, 1);
+
+  std::vector<float> data{1.0, 2.0};
+  Shape shape = ShapeUtil::MakeShape(F32, {2});
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto buffer,
+      client->BufferFromHostBuffer(
+          data.data(), shape.element_type(), shape.dimensions(),
+          /*byte_strides=*/std::nullopt,
+          PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall, nullptr,
+          client->addressable_devices()[0]));
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto result,
+      pjrt_executable->Execute(
+          /*argument_handles=*/{{buffer.get(), buffer.get()}},
+          /*options=*/{}));
+  TF_ASSERT_OK_AND_ASSIGN(auto literal, result[0][0]->ToLiteralSync());
+  EXPECT_EQ(*literal, LiteralUtil::CreateR1<float>({2.0, 4.0}));
+}
+
 TEST(TfrtCpuClientTest, AsyncTransferRawData) {
   TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(CpuClientOptions()));
   xla::Shape shape = ShapeUtil::MakeShape(U32, {3, 2});
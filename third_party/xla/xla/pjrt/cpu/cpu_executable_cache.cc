@@ -0,0 +1,336 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/pjrt/cpu/cpu_executable_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "xla/debug_options_flags.h"
+#include "xla/pjrt/compile_options.pb.h"
+#include "xla/pjrt/pjrt_executable.h"
+#include "xla/service/hlo.pb.h"
+#include "xla/tsl/lib/monitoring/counter.h"
+#include "xla/tsl/lib/strings/proto_serialization.h"
+#include "xla/util.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/file_statistics.h"
+#include "tsl/platform/fingerprint.h"
+#include "tsl/platform/path.h"
+#include "tsl/platform/random.h"
+#include "tsl/platform/statusor.h"
+
+#if defined(__linux__)
+#include <elf.h>
+#include <link.h>
+#endif
+
+namespace xla {
+namespace {
+
+// Changes whenever the format of the serialized executables, or what their
+// keys depend on, changes, so that stale entries are never loaded.
+constexpr int kCacheVersion = 2;
+
+constexpr absl::string_view kFileExtension = ".xla_cpu_executable";
+
+auto* executable_cache_lookups = tsl::monitoring::Counter<1>::New(
+    "/pjrt/cpu/executable_cache/lookups",
+    "The number of lookups in the XLA:CPU executable cache, by result.",
+    "result");
+
+absl::StatusOr<tsl::Fprint128> FingerprintProto(
+    const tsl::protobuf::MessageLite& proto) {
+  std::string serialized;
+  if (!tsl::SerializeToStringDeterministic(proto, &serialized)) {
+    return Internal("Failed to serialize a proto of the executable cache key");
+  }
+  return tsl::Fingerprint128(serialized);
+}
+
+#if defined(__linux__)
+// The object file containing an address, and its GNU build-id if it has one.
+struct LoadedObject {
+  uintptr_t address;
+  bool found = false;
+  std::string path;
+  std::string build_id;
+};
+
+// dl_iterate_phdr() callback that fills the LoadedObject in `data` if `info`
+// is the object containing its address.
+int FindLoadedObject(dl_phdr_info* info, size_t size, void* data) {
+  auto* object = static_cast<LoadedObject*>(data);
+  bool contains_address = false;
+  for (int i = 0; i < info->dlpi_phnum; ++i) {
+    const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+    const uintptr_t begin = info->dlpi_addr + phdr.p_vaddr;
+    if (phdr.p_type == PT_LOAD && object->address >= begin &&
+        object->address < begin + phdr.p_memsz) {
+      contains_address = true;
+      break;
+    }
+  }
+  if (!contains_address) return 0;
+  object->found = true;
+  object->path = info->dlpi_name;
+  for (int i = 0; i < info->dlpi_phnum; ++i) {
+    const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+    if (phdr.p_type != PT_NOTE) continue;
+    const size_t alignment = phdr.p_align == 8 ? 8 : 4;
+    auto align = [alignment](size_t n) {
+      return (n + alignment - 1) & ~(alignment - 1);
+    };
+    const char* note =
+        reinterpret_cast<const char*>(info->dlpi_addr + phdr.p_vaddr);
+    const char* end = note + phdr.p_memsz;
+    while (note + sizeof(ElfW(Nhdr)) <= end) {
+      const auto* header = reinterpret_cast<const ElfW(Nhdr)*>(note);
+      const char* name = note + sizeof(ElfW(Nhdr));
+      const char* desc = name + align(header->n_namesz);
+      const char* next = desc + align(header->n_descsz);
+      if (next > end) break;
+      if (header->n_type == NT_GNU_BUILD_ID && header->n_namesz == 4 &&
+          std::memcmp(name, "GNU", 4) == 0) {
+        object->build_id.assign(desc, header->n_descsz);
+        return 1;
+      }
+      note = next;
+    }
+  }
+  return 1;
+}
+#endif  // defined(__linux__)
+
+// Returns an identity of the build of the compiler, on which the compiled code
+// depends beyond its options and flags: the GNU build-id of the binary it is
+// linked into, or else the path, size and modification time of that binary.
+std::string ComputeBuildIdentity() {
+  std::string path;
+#if defined(__linux__)
+  LoadedObject object;
+  object.address = reinterpret_cast<uintptr_t>(&ComputeBuildIdentity);
+  dl_iterate_phdr(FindLoadedObject, &object);
+  if (!object.build_id.empty()) {
+    return absl::StrCat("build-id:", absl::BytesToHexString(object.build_id));
+  }
+  // The main program has an empty name.
+  path = object.path;
+#endif
+  if (path.empty()) path = tsl::Env::Default()->GetExecutablePath();
+  tsl::FileStatistics stat;
+  if (!tsl::Env::Default()->Stat(path, &stat).ok()) {
+    LOG(WARNING) << "Failed to identify the build of " << path
+                 << ", cached executables may come from another build";
+    return path;
+  }
+  return absl::StrCat(path, ":", stat.length, ":", stat.mtime_nsec);
+}
+
+const std::string& BuildIdentity() {
+  static const std::string* build_identity =
+      new std::string(ComputeBuildIdentity());
+  return *build_identity;
+}
+
+}  // namespace
+
+CpuExecutableCache::CpuExecutableCache(std::string directory,
+                                       int64_t max_size_bytes, tsl::Env* env)
+    : directory_(std::move(directory)),
+      max_size_bytes_(max_size_bytes),
+      env_(env) {}
+
+absl::StatusOr<std::unique_ptr<CpuExecutableCache>> CpuExecutableCache::Create(
+    std::string directory, int64_t max_size_bytes, tsl::Env* env) {
+  if (max_size_bytes <= 0) {
+    return InvalidArgument("Executable cache size must be positive, got %d",
+                           max_size_bytes);
+  }
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(directory));
+  std::unique_ptr<CpuExecutableCache> cache(
+      new CpuExecutableCache(std::move(directory), max_size_bytes, env));
+  TF_RETURN_IF_ERROR(cache->Scan());
+  return cache;
+}
+
+absl::StatusOr<std::string> CpuExecutableCache::ComputeKey(
+    const HloModuleProto& hlo_module, const CompileOptions& options,
+    absl::Span<const std::string> machine_attributes) {
+  TF_ASSIGN_OR_RETURN(CompileOptionsProto options_proto, options.ToProto());
+  // Drop the module id, which only depends on the order in which modules were
+  // created by the process.
+  HloModuleProto module = hlo_module;
+  module.clear_id();
+  TF_ASSIGN_OR_RETURN(tsl::Fprint128 fingerprint, FingerprintProto(module));
+  TF_ASSIGN_OR_RETURN(tsl::Fprint128 options_fingerprint,
+                      FingerprintProto(options_proto));
+  // The compiler uses the flags for the options not set in `options`.
+  TF_ASSIGN_OR_RETURN(tsl::Fprint128 flags_fingerprint,
+                      FingerprintProto(GetDebugOptionsFromFlags()));
+  fingerprint = tsl::FingerprintCat128(fingerprint, options_fingerprint);
+  fingerprint = tsl::FingerprintCat128(fingerprint, flags_fingerprint);
+  fingerprint = tsl::FingerprintCat128(
+      fingerprint, tsl::Fingerprint128(absl::StrJoin(machine_attributes, ",")));
+  // Executables compiled by another build of XLA may be incompatible, or
+  // miss fixes and optimizations, even if nothing else changed.
+  fingerprint = tsl::FingerprintCat128(fingerprint,
+                                       tsl::Fingerprint128(BuildIdentity()));
+  fingerprint = tsl::FingerprintCat128(fingerprint, kCacheVersion);
+  return absl::StrFormat("%016x%016x", fingerprint.high64, fingerprint.low64);
+}
+
+std::string CpuExecutableCache::FilePath(absl::string_view key) const {
+  return tsl::io::JoinPath(directory_, absl::StrCat(key, kFileExtension));
+}
+
+absl::Status CpuExecutableCache::Scan() {
+  std::vector<std::string> children;
+  TF_RETURN_IF_ERROR(env_->GetChildren(directory_, &children));
+  struct File {
+    std::string key;
+    tsl::FileStatistics stat;
+  };
+  std::vector<File> files;
+  for (const std::string& child : children) {
+    if (!absl::EndsWith(child, kFileExtension)) continue;
+    File file;
+    file.key = child.substr(0, child.size() - kFileExtension.size());
+    if (!env_->Stat(tsl::io::JoinPath(directory_, child), &file.stat).ok()) {
+      continue;
+    }
+    files.push_back(std::move(file));
+  }
+  std::sort(files.begin(), files.end(), [](const File& a, const File& b) {
+    return a.stat.mtime_nsec < b.stat.mtime_nsec;
+  });
+  absl::MutexLock lock(&mu_);
+  for (const File& file : files) {
+    TouchLocked(file.key, std::max<int64_t>(file.stat.length, 0));
+  }
+  VLOG(1) << "Opened XLA:CPU executable cache in " << directory_ << " with "
+          << lru_.size() << " executables, " << size_bytes_ << " bytes";
+  return absl::OkStatus();
+}
+
+std::optional<std::string> CpuExecutableCache::Lookup(absl::string_view key) {
+  std::string serialized;
+  // Another process may have added the executable since the cache was opened,
+  // or evicted it.
+  absl::Status status =
+      tsl::ReadFileToString(env_, FilePath(key), &serialized);
+  absl::MutexLock lock(&mu_);
+  if (!status.ok()) {
+    if (!absl::IsNotFound(status)) {
+      LOG(WARNING) << "Failed to read cached executable " << key << ": "
+                   << status;
+    }
+    EraseLocked(key);
+    ++stats_.misses;
+    executable_cache_lookups->GetCell("miss")->IncrementBy(1);
+    return std::nullopt;
+  }
+  TouchLocked(key, serialized.size());
+  ++stats_.hits;
+  executable_cache_lookups->GetCell("hit")->IncrementBy(1);
+  return serialized;
+}
+
+absl::Status CpuExecutableCache::Insert(absl::string_view key,
+                                        absl::string_view serialized) {
+  const std::string path = FilePath(key);
+  const std::string temp_path =
+      absl::StrCat(path, ".tmp.", absl::Hex(tsl::random::New64()));
+  absl::Status status = tsl::WriteStringToFile(env_, temp_path, serialized);
+  if (status.ok()) status = env_->RenameFile(temp_path, path);
+  if (!status.ok()) {
+    env_->DeleteFile(temp_path).IgnoreError();
+    return status;
+  }
+
+  std::vector<std::string> evicted;
+  {
+    absl::MutexLock lock(&mu_);
+    TouchLocked(key, serialized.size());
+    // Never evict the executable just inserted, even if it is larger than the
+    // cache.
+    while (size_bytes_ > max_size_bytes_ && lru_.size() > 1) {
+      evicted.push_back(lru_.front().key);
+      EraseLocked(evicted.back());
+      ++stats_.evictions;
+    }
+  }
+  for (const std::string& evicted_key : evicted) {
+    VLOG(2) << "Evicting cached executable " << evicted_key;
+    env_->DeleteFile(FilePath(evicted_key)).IgnoreError();
+  }
+  return absl::OkStatus();
+}
+
+void CpuExecutableCache::Remove(absl::string_view key) {
+  {
+    absl::MutexLock lock(&mu_);
+    EraseLocked(key);
+  }
+  env_->DeleteFile(FilePath(key)).IgnoreError();
+}
+
+CpuExecutableCache::Stats CpuExecutableCache::stats() const {
+  absl::MutexLock lock(&mu_);
+  return stats_;
+}
+
+int64_t CpuExecutableCache::size_bytes() const {
+  absl::MutexLock lock(&mu_);
+  return size_bytes_;
+}
+
+void CpuExecutableCache::TouchLocked(absl::string_view key,
+                                     int64_t size_bytes) {
+  EraseLocked(key);
+  lru_.push_back(Entry{std::string(key), size_bytes});
+  entries_[key] = std::prev(lru_.end());
+  size_bytes_ += size_bytes;
+}
+
+void CpuExecutableCache::EraseLocked(absl::string_view key) {
+  auto it = entries_.find(key);
+  if (it == entries_.end()) return;
+  size_bytes_ -= it->second->size_bytes;
+  lru_.erase(it->second);
+  entries_.erase(it);
+}
+
+}  // namespace xla
@@ -0,0 +1,117 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_PJRT_CPU_CPU_EXECUTABLE_CACHE_H_
+#define XLA_PJRT_CPU_CPU_EXECUTABLE_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "xla/pjrt/pjrt_executable.h"
+#include "xla/service/hlo.pb.h"
+#include "tsl/platform/env.h"
+
+namespace xla {
+
+// A cache of serialized XLA:CPU executables in a directory, which lets a
+// process load the executables compiled by an earlier one instead of compiling
+// them again.
+//
+// Each executable is stored in its own file, named after its key. Files are
+// written to a temporary file first and then renamed, so that concurrent
+// readers, including other processes sharing the directory, never see a
+// partial file. When the files take more than `max_size_bytes`, the least
+// recently used ones are deleted. Files not used since the cache was opened
+// are ordered by modification time.
+class CpuExecutableCache {
+ public:
+  struct Stats {
+    int64_t hits = 0;
+    int64_t misses = 0;
+    int64_t evictions = 0;
+  };
+
+  // Opens the cache in `directory`, creating the directory if needed.
+  static absl::StatusOr<std::unique_ptr<CpuExecutableCache>> Create(
+      std::string directory, int64_t max_size_bytes,
+      tsl::Env* env = tsl::Env::Default());
+
+  // Returns the key of the executable compiled from `hlo_module` with
+  // `options` for a CPU with `machine_attributes`. The key also depends on the
+  // XLA flags, on the build of XLA and on the version of the cache format.
+  static absl::StatusOr<std::string> ComputeKey(
+      const HloModuleProto& hlo_module, const CompileOptions& options,
+      absl::Span<const std::string> machine_attributes);
+
+  // Returns the serialized executable with `key`, or std::nullopt on a miss.
+  std::optional<std::string> Lookup(absl::string_view key);
+
+  // Stores the serialized executable with `key`, and evicts the least recently
+  // used executables if the cache is full.
+  absl::Status Insert(absl::string_view key, absl::string_view serialized);
+
+  // Removes the executable with `key`, e.g. because it can't be loaded.
+  void Remove(absl::string_view key);
+
+  Stats stats() const;
+
+  // The total size of the cached executables, in bytes.
+  int64_t size_bytes() const;
+
+ private:
+  struct Entry {
+    std::string key;
+    int64_t size_bytes;
+  };
+
+  CpuExecutableCache(std::string directory, int64_t max_size_bytes,
+                     tsl::Env* env);
+
+  std::string FilePath(absl::string_view key) const;
+
+  // Adds the files already in the directory to the index.
+  absl::Status Scan();
+
+  // Moves `key` to the most recently used end of `lru_`, adding it if needed.
+  void TouchLocked(absl::string_view key, int64_t size_bytes)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void EraseLocked(absl::string_view key) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const std::string directory_;
+  const int64_t max_size_bytes_;
+  tsl::Env* const env_;
+
+  mutable absl::Mutex mu_;
+  // The entries from the least to the most recently used.
+  std::list<Entry> lru_ ABSL_GUARDED_BY(mu_);
+  absl::flat_hash_map<std::string, std::list<Entry>::iterator> entries_
+      ABSL_GUARDED_BY(mu_);
+  int64_t size_bytes_ ABSL_GUARDED_BY(mu_) = 0;
+  Stats stats_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace xla
+
+#endif  // XLA_PJRT_CPU_CPU_EXECUTABLE_CACHE_H_
@@ -0,0 +1,134 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/pjrt/cpu/cpu_executable_cache.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "xla/pjrt/pjrt_executable.h"
+#include "xla/service/hlo.pb.h"
+#include "xla/tsl/lib/core/status_test_util.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/path.h"
+#include "tsl/platform/status_matchers.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/test.h"
+
+namespace xla {
+namespace {
+
+using ::testing::Optional;
+
+// Returns a new directory for the cache of a test.
+std::string CacheDirectory() {
+  const testing::TestInfo* test_info =
+      testing::UnitTest::GetInstance()->current_test_info();
+  return tsl::io::JoinPath(tsl::testing::TmpDir(),
+                           absl::StrCat("cache_", test_info->name()));
+}
+
+TEST(CpuExecutableCacheTest, InsertAndLookup) {
+  TF_ASSERT_OK_AND_ASSIGN(auto cache,
+                          CpuExecutableCache::Create(CacheDirectory(), 1024));
+  EXPECT_EQ(cache->Lookup("a"), std::nullopt);
+  TF_ASSERT_OK(cache->Insert("a", "executable"));
+  EXPECT_THAT(cache->Lookup("a"), Optional(std::string("executable")));
+  EXPECT_EQ(cache->size_bytes(), 10);
+
+  CpuExecutableCache::Stats stats = cache->stats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.evictions, 0);
+
+  cache->Remove("a");
+  EXPECT_EQ(cache->Lookup("a"), std::nullopt);
+  EXPECT_EQ(cache->size_bytes(), 0);
+}
+
+TEST(CpuExecutableCacheTest, EvictsLeastRecentlyUsed) {
+  TF_ASSERT_OK_AND_ASSIGN(auto cache,
+                          CpuExecutableCache::Create(CacheDirectory(), 20));
+  TF_ASSERT_OK(cache->Insert("a", "0123456789"));
+  TF_ASSERT_OK(cache->Insert("b", "0123456789"));
+  // Makes "b" the least recently used.
+  EXPECT_NE(cache->Lookup("a"), std::nullopt);
+  TF_ASSERT_OK(cache->Insert("c", "0123456789"));
+
+  EXPECT_EQ(cache->stats().evictions, 1);
+  EXPECT_EQ(cache->size_bytes(), 20);
+  EXPECT_NE(cache->Lookup("a"), std::nullopt);
+  EXPECT_EQ(cache->Lookup("b"), std::nullopt);
+  EXPECT_NE(cache->Lookup("c"), std::nullopt);
+}
+
+TEST(CpuExecutableCacheTest, KeepsExecutableLargerThanCache) {
+  TF_ASSERT_OK_AND_ASSIGN(auto cache,
+                          CpuExecutableCache::Create(CacheDirectory(), 4));
+  TF_ASSERT_OK(cache->Insert("a", "0123456789"));
+  EXPECT_NE(cache->Lookup("a"), std::nullopt);
+}
+
+TEST(CpuExecutableCacheTest, PersistsAcrossInstances) {
+  const std::string directory = CacheDirectory();
+  {
+    TF_ASSERT_OK_AND_ASSIGN(auto cache,
+                            CpuExecutableCache::Create(directory, 1024));
+    TF_ASSERT_OK(cache->Insert("a", "executable"));
+  }
+  TF_ASSERT_OK_AND_ASSIGN(auto cache,
+                          CpuExecutableCache::Create(directory, 1024));
+  EXPECT_EQ(cache->size_bytes(), 10);
+  EXPECT_THAT(cache->Lookup("a"), Optional(std::string("executable")));
+}
+
+TEST(CpuExecutableCacheTest, RejectsInvalidSize) {
+  EXPECT_FALSE(CpuExecutableCache::Create(CacheDirectory(), 0).ok());
+}
+
+TEST(CpuExecutableCacheTest, KeyDependsOnModuleOptionsAndMachine) {
+  HloModuleProto module;
+  module.set_name("module");
+  CompileOptions options;
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::string key,
+      CpuExecutableCache::ComputeKey(module, options, {"+avx2"}));
+  EXPECT_EQ(key.size(), 32);
+
+  // The module id doesn't change the key.
+  HloModuleProto module_with_id = module;
+  module_with_id.set_id(42);
+  EXPECT_THAT(CpuExecutableCache::ComputeKey(module_with_id, options,
+                                             {"+avx2"}),
+              tsl::testing::IsOkAndHolds(key));
+
+  HloModuleProto other_module = module;
+  other_module.set_name("other_module");
+  EXPECT_THAT(CpuExecutableCache::ComputeKey(other_module, options, {"+avx2"}),
+              tsl::testing::IsOkAndHolds(testing::Ne(key)));
+
+  CompileOptions other_options;
+  other_options.executable_build_options.set_num_replicas(2);
+  EXPECT_THAT(CpuExecutableCache::ComputeKey(module, other_options, {"+avx2"}),
+              tsl::testing::IsOkAndHolds(testing::Ne(key)));
+
+  EXPECT_THAT(CpuExecutableCache::ComputeKey(module, options, {"-avx2"}),
+              tsl::testing::IsOkAndHolds(testing::Ne(key)));
+}
+
+}  // namespace
+}  // namespace xla
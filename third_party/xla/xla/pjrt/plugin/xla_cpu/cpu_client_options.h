@@ -16,9 +16,11 @@ limitations under the License.
 #ifndef XLA_PJRT_PLUGIN_XLA_CPU_CPU_CLIENT_OPTIONS_H_
 #define XLA_PJRT_PLUGIN_XLA_CPU_CPU_CLIENT_OPTIONS_H_
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <optional>
+#include <string>
 
 #include "xla/service/cpu/collectives_interface.h"
 #include "xla/service/hlo_module_config.h"
@@ -50,6 +52,17 @@ struct CpuClientOptions {
   // If defined this function will be called on the HloModuleConfig before
   // compilation, and allows users to set custom flags.
   std::function<void(HloModuleConfig&)> customize_hlo_module_config;
+
+  // If not empty, Compile() caches the compiled executables in this directory
+  // and loads them from it when the same computation is compiled again with
+  // the same options, on the same kind of CPU, e.g. after a restart. The
+  // directory may be shared by several processes. Computations are not cached
+  // when `customize_hlo_module_config` is set, as its effect is unknown.
+  std::string executable_cache_directory;
+
+  // The size of the cached executables above which the least recently used
+  // ones are deleted.
+  int64_t executable_cache_max_size_bytes = int64_t{1} << 30;
 };
 
 }  // namespace xla
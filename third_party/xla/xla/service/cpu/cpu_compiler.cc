@@ -156,6 +156,7 @@ limitations under the License.
 #include "xla/service/cpu/cpu_instruction_fusion.h"
 #include "xla/service/cpu/cpu_layout_assignment.h"
 #include "xla/service/cpu/cpu_options.h"
+#include "xla/service/cpu/dot_autotuner.h"
 #include "xla/service/cpu/dot_op_emitter.h"
 #include "xla/service/cpu/executable.pb.h"
 #include "xla/service/cpu/ir_emitter.h"
@@ -845,6 +846,21 @@ absl::Status CpuCompiler::RunHloPassesAfterLayoutAssn(
     pipeline.AddPass<HloCSE>(/*is_layout_sensitive=*/true);
   }();
 
+  // Benchmark the implementations of the dots on the compile host, which is
+  // only the host the code runs on for JIT compilation.
+  if (!is_aot_compile &&
+      module->config().debug_options().xla_cpu_enable_dot_autotuning()) {
+    pipeline.AddPass<DotAutotuner>(
+        target_machine_features,
+        absl::StrCat(llvm::sys::getHostCPUName().str(), ",",
+                     target_machine_features->get_target_feature_string()),
+        module->config().debug_options().xla_cpu_dot_autotune_results_path(),
+        max_parallelism, [this](std::unique_ptr<HloModule> dot_module) {
+          return RunBackend(std::move(dot_module), /*stream_exec=*/nullptr,
+                            CompileOptions{});
+        });
+  }
+
   // Outline ops in the entry computation into calls to subcomputations.
   if (!is_aot_compile) {
     // Run ParallelTaskAssigner to assign parallel tasks to HLOs in module.
@@ -0,0 +1,436 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include "xla/service/cpu/dot_autotuner.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "unsupported/Eigen/CXX11/Tensor"
+#include "xla/autotune_results.pb.h"
+#include "xla/autotuning.pb.h"
+#include "xla/backends/cpu/codegen/target_machine_features.h"
+#include "xla/cpu_function_runtime.h"
+#include "xla/executable_run_options.h"
+#include "xla/hlo/ir/hlo_computation.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/hlo/ir/hlo_opcode.h"
+#include "xla/service/buffer_assignment.h"
+#include "xla/service/cpu/backend_config.pb.h"
+#include "xla/service/cpu/cpu_executable.h"
+#include "xla/service/cpu/dot_op_emitter.h"
+#include "xla/service/executable.h"
+#include "xla/service/hlo_module_config.h"
+#include "xla/service/maybe_owning_device_memory.h"
+#include "xla/shape_util.h"
+#include "xla/stream_executor/device_memory.h"
+#include "xla/tsl/util/proto/proto_utils.h"
+#include "xla/util.h"
+#include "xla/xla.pb.h"
+#include "tsl/platform/casts.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/mem.h"
+#include "tsl/platform/protobuf.h"
+#include "tsl/platform/random.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/threadpool.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+// The version of the AutotuneResults files written by the autotuner. Files with
+// another version are ignored.
+constexpr int kVersion = 1;
+
+// The number of timed runs of each candidate, after a warm-up run.
+constexpr int kNumProfilingRuns = 5;
+
+// The results of this process, keyed by device description and dot key.
+struct Results {
+  absl::Mutex mu;
+  absl::flat_hash_map<std::pair<std::string, std::string>, AutotuneResult>
+      results ABSL_GUARDED_BY(mu);
+  // The files the results have been loaded from.
+  absl::flat_hash_set<std::string> loaded_paths ABSL_GUARDED_BY(mu);
+};
+
+Results& GetResults() {
+  static auto* results = new Results();
+  return *results;
+}
+
+bool IsTextProtoPath(absl::string_view file_path) {
+  return absl::EndsWith(file_path, ".txt") ||
+         absl::EndsWith(file_path, ".textproto") ||
+         absl::EndsWith(file_path, ".prototxt") ||
+         absl::EndsWith(file_path, ".pbtxt");
+}
+
+// Adds the results in `path` to the results of the process, unless they were
+// already loaded. A missing file is not an error.
+absl::Status MaybeLoadResults(const std::string& path) {
+  Results& results = GetResults();
+  {
+    absl::MutexLock lock(&results.mu);
+    if (!results.loaded_paths.insert(path).second) return absl::OkStatus();
+  }
+  tsl::Env* env = tsl::Env::Default();
+  if (!env->FileExists(path).ok()) return absl::OkStatus();
+
+  std::string data;
+  TF_RETURN_IF_ERROR(tsl::ReadFileToString(env, path, &data));
+  AutotuneResults file_results;
+  bool parsed =
+      IsTextProtoPath(path)
+          ? tsl::protobuf::TextFormat::ParseFromString(data, &file_results)
+          : file_results.ParseFromString(data);
+  if (!parsed) {
+    return InvalidArgument("Failed to parse the autotune results in %s", path);
+  }
+  if (file_results.version() != kVersion) {
+    return InvalidArgument(
+        "Version mismatch in the autotune results in %s: expected %d but was "
+        "%d",
+        path, kVersion, file_results.version());
+  }
+
+  absl::MutexLock lock(&results.mu);
+  for (AutotuneResults::Entry& entry : *file_results.mutable_results()) {
+    if (!entry.result().has_cpu_dot()) continue;
+    results.results.try_emplace(
+        std::make_pair(std::move(*entry.mutable_device()),
+                       std::move(*entry.mutable_hlo())),
+        std::move(*entry.mutable_result()));
+  }
+  VLOG(1) << "Loaded dot autotune results from " << path;
+  return absl::OkStatus();
+}
+
+// Writes all the results of the process to `path`.
+absl::Status SaveResults(const std::string& path) {
+  AutotuneResults file_results;
+  file_results.set_version(kVersion);
+  {
+    Results& results = GetResults();
+    absl::MutexLock lock(&results.mu);
+    for (const auto& [key, result] : results.results) {
+      AutotuneResults::Entry* entry = file_results.add_results();
+      entry->set_device(key.first);
+      entry->set_hlo(key.second);
+      *entry->mutable_result() = result;
+    }
+  }
+  // Sorts the entries so that the file doesn't change when the results don't.
+  std::sort(file_results.mutable_results()->begin(),
+            file_results.mutable_results()->end(),
+            [](const AutotuneResults::Entry& a,
+               const AutotuneResults::Entry& b) {
+              return std::tie(a.device(), a.hlo()) <
+                     std::tie(b.device(), b.hlo());
+            });
+
+  std::string data;
+  if (IsTextProtoPath(path)) {
+    if (!tsl::protobuf::TextFormat::PrintToString(file_results, &data)) {
+      return Internal("Failed to print the dot autotune results");
+    }
+  } else {
+    data = file_results.SerializeAsString();
+  }
+  // Writes to a temporary file first, so that a concurrent compilation never
+  // reads a partial file.
+  tsl::Env* env = tsl::Env::Default();
+  const std::string temp_path =
+      absl::StrCat(path, ".tmp.", absl::Hex(tsl::random::New64()));
+  absl::Status status = tsl::WriteStringToFile(env, temp_path, data);
+  if (status.ok()) status = env->RenameFile(temp_path, path);
+  if (!status.ok()) env->DeleteFile(temp_path).IgnoreError();
+  return status;
+}
+
+// Deletes the buffers allocated for profiling.
+struct AlignedFreeDeleter {
+  void operator()(void* data) const { tsl::port::AlignedFree(data); }
+};
+
+}  // namespace
+
+DotAutotuner::DotAutotuner(const TargetMachineFeatures* target_machine_features,
+                           std::string device_description,
+                           std::string results_path, int max_parallelism,
+                           CompileFn compile)
+    : target_machine_features_(*target_machine_features),
+      device_description_(std::move(device_description)),
+      results_path_(std::move(results_path)),
+      max_parallelism_(max_parallelism),
+      compile_(std::move(compile)) {}
+
+std::vector<AutotuneResult::CpuDotKey> DotAutotuner::GetCandidates(
+    absl::Span<const DotImplementationStrategy> strategies) {
+  std::vector<AutotuneResult::CpuDotKey> candidates;
+  for (DotImplementationStrategy strategy : strategies) {
+    AutotuneResult::CpuDotKey candidate;
+    switch (strategy) {
+      case DotImplementationStrategy::kEigen:
+        candidate.set_strategy(AutotuneResult::CpuDotKey::STRATEGY_EIGEN);
+        candidates.push_back(candidate);
+        break;
+      case DotImplementationStrategy::kTiledLlvmIrGemm:
+        candidate.set_strategy(
+            AutotuneResult::CpuDotKey::STRATEGY_TILED_LLVM_IR_GEMM);
+        // Includes the default tile size of the dot emitter, 11x9x1.
+        for (int64_t tile_size_m : {4, 8, 11, 16}) {
+          for (int64_t tile_size_k : {4, 9, 16}) {
+            for (int64_t tile_size_n_in_vector_width : {1, 2}) {
+              candidate.set_tile_size_m(tile_size_m);
+              candidate.set_tile_size_k(tile_size_k);
+              candidate.set_tile_size_n_in_vector_width(
+                  tile_size_n_in_vector_width);
+              candidates.push_back(candidate);
+            }
+          }
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  return candidates;
+}
+
+std::string DotAutotuner::GetDotKey(const HloInstruction& dot) {
+  return absl::StrCat(
+      ShapeUtil::HumanStringWithLayout(dot.operand(0)->shape()), ", ",
+      ShapeUtil::HumanStringWithLayout(dot.operand(1)->shape()), " -> ",
+      ShapeUtil::HumanStringWithLayout(dot.shape()), ", ",
+      DotDimensionNumbersToString(dot.dot_dimension_numbers()));
+}
+
+absl::StatusOr<absl::Duration> DotAutotuner::Profile(
+    Executable& executable, const Eigen::ThreadPoolDevice* intra_op_device) {
+  auto* cpu_executable = tensorflow::down_cast<CpuExecutable*>(&executable);
+
+  // The run time of a dot doesn't depend on the values of its operands, so
+  // all the buffers are filled with zeros.
+  std::vector<std::unique_ptr<void, AlignedFreeDeleter>> storage;
+  std::vector<MaybeOwningDeviceMemory> buffers;
+  for (const BufferAllocation& allocation :
+       cpu_executable->buffer_assignment().Allocations()) {
+    if (allocation.is_thread_local()) {
+      buffers.emplace_back(se::DeviceMemoryBase());
+      continue;
+    }
+    if (allocation.is_constant()) {
+      absl::Span<const CpuExecutable::ConstantAllocation> constants =
+          cpu_executable->constants();
+      buffers.emplace_back(
+          allocation.index() < constants.size()
+              ? constants[allocation.index()].AsDeviceMemoryBase()
+              : se::DeviceMemoryBase());
+      continue;
+    }
+    const int64_t size = std::max<int64_t>(allocation.size(), 1);
+    void* data =
+        tsl::port::AlignedMalloc(size, cpu_function_runtime::MinAlign());
+    if (data == nullptr) {
+      return ResourceExhausted("Failed to allocate %d bytes", size);
+    }
+    storage.emplace_back(data);
+    std::memset(data, 0, size);
+    buffers.emplace_back(se::DeviceMemoryBase(data, size));
+  }
+
+  ExecutableRunOptions run_options;
+  run_options.set_device_ordinal(0);
+  run_options.set_intra_op_thread_pool(intra_op_device);
+  auto run = [&]() {
+    return cpu_executable->has_thunks()
+               ? cpu_executable->ExecuteThunks(&run_options, buffers)
+               : cpu_executable->ExecuteComputeFunction(&run_options, buffers);
+  };
+
+  TF_RETURN_IF_ERROR(run());
+  absl::Duration best = absl::InfiniteDuration();
+  for (int i = 0; i < kNumProfilingRuns; ++i) {
+    absl::Time start = absl::Now();
+    TF_RETURN_IF_ERROR(run());
+    best = std::min(best, absl::Now() - start);
+  }
+  return best;
+}
+
+void DotAutotuner::ClearResults() {
+  Results& results = GetResults();
+  absl::MutexLock lock(&results.mu);
+  results.results.clear();
+  results.loaded_paths.clear();
+}
+
+absl::StatusOr<AutotuneResult> DotAutotuner::Tune(
+    const HloInstruction& dot,
+    const Eigen::ThreadPoolDevice* intra_op_device) {
+  const std::vector<AutotuneResult::CpuDotKey> candidates = GetCandidates(
+      GetTunableDotImplementationStrategies(dot, target_machine_features_));
+
+  // Compiles the dot alone, without dumping it.
+  DebugOptions debug_options = dot.GetModule()->config().debug_options();
+  debug_options.clear_xla_dump_to();
+  HloModuleConfig config;
+  config.set_debug_options(debug_options);
+  config.set_intra_op_parallelism_threads(max_parallelism_);
+
+  AutotuneResult best;
+  absl::Duration best_run_time = absl::InfiniteDuration();
+  for (const AutotuneResult::CpuDotKey& candidate : candidates) {
+    auto module = std::make_unique<HloModule>(
+        absl::StrCat("autotune_", dot.name()), config);
+    HloComputation::Builder builder("entry");
+    HloInstruction* lhs = builder.AddInstruction(
+        HloInstruction::CreateParameter(0, dot.operand(0)->shape(), "lhs"));
+    HloInstruction* rhs = builder.AddInstruction(
+        HloInstruction::CreateParameter(1, dot.operand(1)->shape(), "rhs"));
+    HloInstruction* candidate_dot = builder.AddInstruction(
+        dot.CloneWithNewOperands(dot.shape(), {lhs, rhs}));
+    BackendConfig backend_config;
+    *backend_config.mutable_dot_config() = candidate;
+    TF_RETURN_IF_ERROR(candidate_dot->set_backend_config(backend_config));
+    module->AddEntryComputationWithLayouts(builder.Build());
+
+    absl::StatusOr<std::unique_ptr<Executable>> executable =
+        compile_(std::move(module));
+    absl::StatusOr<absl::Duration> run_time =
+        executable.ok() ? Profile(**executable, intra_op_device)
+                        : executable.status();
+    if (!run_time.ok()) {
+      VLOG(1) << "Skipping dot config " << candidate.ShortDebugString()
+              << ": " << run_time.status();
+      continue;
+    }
+    VLOG(2) << "Dot config " << candidate.ShortDebugString() << " of "
+            << dot.name() << " runs in " << *run_time;
+    if (*run_time < best_run_time) {
+      best_run_time = *run_time;
+      *best.mutable_cpu_dot() = candidate;
+    }
+  }
+  if (!best.has_cpu_dot()) {
+    return Internal("No dot config of %s could be profiled", dot.name());
+  }
+  *best.mutable_run_time() = tsl::proto_utils::ToDurationProto(best_run_time);
+  return best;
+}
+
+absl::StatusOr<bool> DotAutotuner::Run(
+    HloModule* module,
+    const absl::flat_hash_set<absl::string_view>& execution_threads) {
+  if (!results_path_.empty()) {
+    absl::Status status = MaybeLoadResults(results_path_);
+    if (!status.ok()) {
+      LOG(WARNING) << "Ignoring the dot autotune results: " << status;
+    }
+  }
+
+  // Created when the first dot is benchmarked.
+  std::unique_ptr<tsl::thread::ThreadPool> intra_op_pool;
+  std::unique_ptr<Eigen::ThreadPoolDevice> intra_op_device;
+
+  Results& results = GetResults();
+  bool changed = false;
+  bool tuned = false;
+  for (HloComputation* computation :
+       module->MakeNonfusionComputations(execution_threads)) {
+    for (HloInstruction* instruction : computation->instructions()) {
+      if (instruction->opcode() != HloOpcode::kDot ||
+          GetTunableDotImplementationStrategies(*instruction,
+                                                target_machine_features_)
+              .empty()) {
+        continue;
+      }
+
+      auto key = std::make_pair(device_description_, GetDotKey(*instruction));
+      AutotuneResult result;
+      bool found;
+      {
+        absl::MutexLock lock(&results.mu);
+        auto it = results.results.find(key);
+        found = it != results.results.end();
+        if (found) result = it->second;
+      }
+      if (!found) {
+        if (intra_op_pool == nullptr) {
+          intra_op_pool = std::make_unique<tsl::thread::ThreadPool>(
+              tsl::Env::Default(), "XLADotAutotuner", max_parallelism_);
+          intra_op_device = std::make_unique<Eigen::ThreadPoolDevice>(
+              intra_op_pool->AsEigenThreadPool(), intra_op_pool->NumThreads());
+        }
+        absl::StatusOr<AutotuneResult> tuned_result =
+            Tune(*instruction, intra_op_device.get());
+        if (!tuned_result.ok()) {
+          LOG(WARNING) << "Failed to autotune " << instruction->name() << ": "
+                       << tuned_result.status();
+          continue;
+        }
+        result = *std::move(tuned_result);
+        VLOG(1) << "Autotuned " << key.second << ": "
+                << result.cpu_dot().ShortDebugString();
+        absl::MutexLock lock(&results.mu);
+        results.results.insert_or_assign(key, result);
+        tuned = true;
+      }
+
+      TF_ASSIGN_OR_RETURN(BackendConfig backend_config,
+                          instruction->backend_config<BackendConfig>());
+      *backend_config.mutable_dot_config() = result.cpu_dot();
+      TF_RETURN_IF_ERROR(instruction->set_backend_config(backend_config));
+      changed = true;
+    }
+  }
+
+  if (tuned && !results_path_.empty()) {
+    absl::Status status = SaveResults(results_path_);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to save the dot autotune results to "
+                   << results_path_ << ": " << status;
+    }
+  }
+  return changed;
+}
+
+}  // namespace cpu
+}  // namespace xla
@@ -0,0 +1,101 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_SERVICE_CPU_DOT_AUTOTUNER_H_
+#define XLA_SERVICE_CPU_DOT_AUTOTUNER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "xla/autotuning.pb.h"
+#include "xla/backends/cpu/codegen/target_machine_features.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/hlo/pass/hlo_pass_interface.h"
+#include "xla/service/cpu/dot_op_emitter.h"
+#include "xla/service/executable.h"
+
+namespace Eigen {
+struct ThreadPoolDevice;
+}  // namespace Eigen
+
+namespace xla {
+namespace cpu {
+
+// An HLO pass that benchmarks the strategies and tile sizes that can implement
+// each matrix-matrix dot on the compile host, and stores the fastest one in the
+// backend config of the dot, where the dot emitter picks it up.
+//
+// Dots with the same shapes, layouts and dimension numbers share their result,
+// which is kept for the life of the process and, if `results_path` is not
+// empty, in that file as an AutotuneResults proto, so that the dots of a model
+// are only benchmarked once per machine.
+class DotAutotuner : public HloModulePass {
+ public:
+  // Compiles a module holding a single dot, whose layouts are assigned, with
+  // the backend of the compiler.
+  using CompileFn =
+      absl::AnyInvocable<absl::StatusOr<std::unique_ptr<Executable>>(
+          std::unique_ptr<HloModule>)>;
+
+  DotAutotuner(const TargetMachineFeatures* target_machine_features,
+               std::string device_description, std::string results_path,
+               int max_parallelism, CompileFn compile);
+
+  absl::string_view name() const override { return "dot-autotuner"; }
+  using HloPassInterface::Run;
+  absl::StatusOr<bool> Run(
+      HloModule* module,
+      const absl::flat_hash_set<absl::string_view>& execution_threads) override;
+
+  // Returns the configs to benchmark for a dot that can be implemented with
+  // `strategies`.
+  static std::vector<AutotuneResult::CpuDotKey> GetCandidates(
+      absl::Span<const DotImplementationStrategy> strategies);
+
+  // Returns the key of the result for `dot`.
+  static std::string GetDotKey(const HloInstruction& dot);
+
+  // Returns the best of a few run times of `executable`, which must be a
+  // CpuExecutable, on buffers filled with zeros.
+  static absl::StatusOr<absl::Duration> Profile(
+      Executable& executable, const Eigen::ThreadPoolDevice* intra_op_device);
+
+  // Forgets the results of this process, including the ones loaded from files.
+  static void ClearResults();
+
+ private:
+  absl::StatusOr<AutotuneResult> Tune(
+      const HloInstruction& dot,
+      const Eigen::ThreadPoolDevice* intra_op_device);
+
+  const TargetMachineFeatures& target_machine_features_;
+  const std::string device_description_;
+  const std::string results_path_;
+  const int max_parallelism_;
+  CompileFn compile_;
+};
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // XLA_SERVICE_CPU_DOT_AUTOTUNER_H_
@@ -29,6 +29,7 @@ limitations under the License.
 
 #include "absl/algorithm/container.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/CallingConv.h"
@@ -40,6 +41,7 @@ limitations under the License.
 #include "llvm/IR/Value.h"
 #include "llvm/Support/Alignment.h"
 #include "llvm/Support/Casting.h"
+#include "xla/autotuning.pb.h"
 #include "xla/backends/cpu/codegen/target_machine_features.h"
 #include "xla/hlo/ir/hlo_casting_utils.h"
 #include "xla/hlo/ir/hlo_instructions.h"
@@ -120,6 +122,27 @@ bool IsAlignedGemm(const DotInfo& dot_info,
                        dot_info.result_shape, target_machine_features);
 }
 
+// Returns true if the aligned GEMM `dot_info` can be lowered to a tiled LLVM
+// IR GEMM, whether or not it is profitable.
+bool IsTiledLlvmIrGemmSupported(const DotInfo& dot_info) {
+  bool lhs_canonical = dot_info.dim_nums.lhs_contracting_dimensions(0) == 1;
+  bool rhs_canonical = dot_info.dim_nums.rhs_contracting_dimensions(0) == 0;
+
+  if (!(lhs_canonical && rhs_canonical)) {
+    return false;
+  }
+
+  if (dot_info.result_shape.element_type() == F16 ||
+      dot_info.result_shape.element_type() == C64 ||
+      dot_info.result_shape.element_type() == C128) {
+    // TODO(sanjoy): This is probably easy to fix, but I want to keep the CL
+    // adding this comment NFC.
+    return false;
+  }
+
+  return true;
+}
+
 bool CanEmitTiledLlvmIrGemm(
     const HloModuleConfig& config, const DotInfo& dot_info,
     const TargetMachineFeatures& target_machine_features) {
@@ -143,22 +166,7 @@ bool CanEmitTiledLlvmIrGemm(
     }
   }
 
-  bool lhs_canonical = dot_info.dim_nums.lhs_contracting_dimensions(0) == 1;
-  bool rhs_canonical = dot_info.dim_nums.rhs_contracting_dimensions(0) == 0;
-
-  if (!(lhs_canonical && rhs_canonical)) {
-    return false;
-  }
-
-  if (dot_info.result_shape.element_type() == F16 ||
-      dot_info.result_shape.element_type() == C64 ||
-      dot_info.result_shape.element_type() == C128) {
-    // TODO(sanjoy): This is probably easy to fix, but I want to keep the CL
-    // adding this comment NFC.
-    return false;
-  }
-
-  return true;
+  return IsTiledLlvmIrGemmSupported(dot_info);
 }
 
 // Returns dot implementation strategy for non-batch dot operations.
@@ -200,6 +208,14 @@ DotImplementationStrategy GetNonBatchDotImplementationStrategy(
   }
 
   if (IsAlignedGemm(dot_info, target_machine_features)) {
+    // The autotuner has benchmarked the strategy on this machine, so it takes
+    // precedence over the heuristics below.
+    std::optional<DotImplementationStrategy> tuned = dot_info.tuned_strategy;
+    if (tuned == DotImplementationStrategy::kEigen ||
+        (tuned == DotImplementationStrategy::kTiledLlvmIrGemm &&
+         IsTiledLlvmIrGemmSupported(dot_info))) {
+      return *tuned;
+    }
     if (CanEmitTiledLlvmIrGemm(config, dot_info, target_machine_features)) {
       return DotImplementationStrategy::kTiledLlvmIrGemm;
     }
@@ -300,6 +316,9 @@ class DotOpEmitter {
     // information in one place.
     const std::tuple<int64_t, int64_t, int64_t> kDefaultTileSize =
         std::tuple<int64_t, int64_t, int64_t>(11, 9, 1);
+    if (dot_info_.tuned_gemm_tile_size.has_value()) {
+      return *dot_info_.tuned_gemm_tile_size;
+    }
     return options::LlvmIrGemmTileSize(hlo_module_config_)
         .value_or(kDefaultTileSize);
   }
@@ -1302,6 +1321,36 @@ bool IsBatchDot(const HloInstruction& instr) {
   return false;
 }
 
+DotInfo::DotInfo(const HloInstruction& instr) {
+  CHECK_EQ(instr.opcode(), HloOpcode::kDot);
+  lhs_shape = instr.operand(0)->shape();
+  rhs_shape = instr.operand(1)->shape();
+  result_shape = instr.shape();
+  dim_nums = instr.dot_dimension_numbers();
+
+  if (!instr.has_backend_config()) return;
+  absl::StatusOr<BackendConfig> backend_config =
+      instr.backend_config<BackendConfig>();
+  if (!backend_config.ok() || !backend_config->has_dot_config()) return;
+  const AutotuneResult::CpuDotKey& dot_config = backend_config->dot_config();
+  switch (dot_config.strategy()) {
+    case AutotuneResult::CpuDotKey::STRATEGY_TILED_LLVM_IR_GEMM:
+      tuned_strategy = DotImplementationStrategy::kTiledLlvmIrGemm;
+      break;
+    case AutotuneResult::CpuDotKey::STRATEGY_EIGEN:
+      tuned_strategy = DotImplementationStrategy::kEigen;
+      break;
+    default:
+      break;
+  }
+  if (dot_config.tile_size_m() > 0 && dot_config.tile_size_k() > 0 &&
+      dot_config.tile_size_n_in_vector_width() > 0) {
+    tuned_gemm_tile_size = std::make_tuple(
+        dot_config.tile_size_m(), dot_config.tile_size_k(),
+        dot_config.tile_size_n_in_vector_width());
+  }
+}
+
 bool IsBatchDot(const DotInfo& dot_info) {
   return dot_info.dim_nums.lhs_batch_dimensions_size() > 0;
 }
@@ -1343,6 +1392,27 @@ DotImplementationStrategy GetDotImplementationStrategy(
       target_machine_features);
 }
 
+std::vector<DotImplementationStrategy> GetTunableDotImplementationStrategies(
+    const HloInstruction& dot_instr,
+    const TargetMachineFeatures& target_machine_features) {
+  if (IsBatchDot(dot_instr)) return {};
+  DotInfo dot_info(dot_instr);
+  dot_info.tuned_strategy.reset();
+  dot_info.tuned_gemm_tile_size.reset();
+
+  // Layout assignment made the operands and the result of these strategies
+  // row major, which both of them support.
+  DotImplementationStrategy strategy = GetNonBatchDotImplementationStrategy(
+      dot_instr.GetModule()->config(), dot_info, target_machine_features);
+  if (strategy != DotImplementationStrategy::kTiledLlvmIrGemm &&
+      strategy != DotImplementationStrategy::kEigen) {
+    return {};
+  }
+  if (!IsTiledLlvmIrGemmSupported(dot_info)) return {};
+  return {DotImplementationStrategy::kEigen,
+          DotImplementationStrategy::kTiledLlvmIrGemm};
+}
+
 bool DotImplementationCanHandleTranspose(
     const HloInstruction& dot_instr,
     const TargetMachineFeatures& target_machine_features) {
@@ -18,6 +18,8 @@ limitations under the License.
 
 #include <cstdint>
 #include <optional>
+#include <tuple>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "llvm/IR/IRBuilder.h"
@@ -69,15 +71,17 @@ struct DotInfo {
   Shape result_shape;
   DotDimensionNumbers dim_nums;
 
+  // The strategy chosen by the autotuner, if any.
+  std::optional<DotImplementationStrategy> tuned_strategy;
+
+  // The tile sizes chosen by the autotuner for kTiledLlvmIrGemm, if any, in
+  // the order (M, K, N in vector registers).
+  std::optional<std::tuple<int64_t, int64_t, int64_t>> tuned_gemm_tile_size;
+
   DotInfo() = default;
 
-  explicit DotInfo(const HloInstruction& instr) {
-    CHECK_EQ(instr.opcode(), HloOpcode::kDot);
-    lhs_shape = instr.operand(0)->shape();
-    rhs_shape = instr.operand(1)->shape();
-    result_shape = instr.shape();
-    dim_nums = instr.dot_dimension_numbers();
-  }
+  // Also reads the tuned strategy from the backend config of `instr`.
+  explicit DotInfo(const HloInstruction& instr);
 };
 
 // Returns true if `instr` is a batch dot.
@@ -95,6 +99,13 @@ DotImplementationStrategy GetDotImplementationStrategy(
     const HloModuleConfig& config, const HloInstruction& instr,
     const TargetMachineFeatures& target_machine_features);
 
+// Returns the strategies that can implement `dot_instr` with its current
+// layouts, for the autotuner to pick from. Returns an empty list if the
+// strategy of `dot_instr` is not tunable, e.g. for matrix-vector products.
+std::vector<DotImplementationStrategy> GetTunableDotImplementationStrategies(
+    const HloInstruction& dot_instr,
+    const TargetMachineFeatures& target_machine_features);
+
 // Returns true if the two operands and the output of `dot_instr` must have row
 // major layout.
 bool DotOperandsAndResultMustHaveRowMajorLayout(
@@ -0,0 +1,151 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "xla/autotune_results.pb.h"
+#include "xla/autotuning.pb.h"
+#include "xla/error_spec.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/hlo/ir/hlo_opcode.h"
+#include "xla/service/cpu/backend_config.pb.h"
+#include "xla/service/cpu/dot_autotuner.h"
+#include "xla/tests/hlo_test_base.h"
+#include "xla/tsl/lib/core/status_test_util.h"
+#include "xla/xla.pb.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/path.h"
+#include "tsl/platform/protobuf.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+constexpr char kDotHlo[] = R"(
+HloModule dot
+
+ENTRY main {
+  lhs = f32[64,64] parameter(0)
+  rhs = f32[64,64] parameter(1)
+  ROOT dot = f32[64,64] dot(lhs, rhs), lhs_contracting_dims={1},
+                                      rhs_contracting_dims={0}
+}
+)";
+
+class CpuDotAutotuningTest : public HloTestBase {
+ protected:
+  void SetUp() override {
+    HloTestBase::SetUp();
+    const testing::TestInfo* test_info =
+        testing::UnitTest::GetInstance()->current_test_info();
+    results_path_ = tsl::io::JoinPath(
+        tsl::testing::TmpDir(),
+        absl::StrCat("dot_autotune_", test_info->name(), ".textproto"));
+    tsl::Env::Default()->DeleteFile(results_path_).IgnoreError();
+    DotAutotuner::ClearResults();
+  }
+
+  DebugOptions GetDebugOptionsForTest() const override {
+    DebugOptions debug_options = HloTestBase::GetDebugOptionsForTest();
+    debug_options.set_xla_cpu_enable_dot_autotuning(true);
+    debug_options.set_xla_cpu_dot_autotune_results_path(results_path_);
+    return debug_options;
+  }
+
+  absl::StatusOr<AutotuneResults> ReadResults() {
+    std::string data;
+    TF_RETURN_IF_ERROR(
+        tsl::ReadFileToString(tsl::Env::Default(), results_path_, &data));
+    AutotuneResults results;
+    if (!tsl::protobuf::TextFormat::ParseFromString(data, &results)) {
+      return absl::InternalError("Failed to parse the autotune results");
+    }
+    return results;
+  }
+
+  std::string results_path_;
+};
+
+TEST_F(CpuDotAutotuningTest, TunesAndSavesDot) {
+  EXPECT_TRUE(RunAndCompare(kDotHlo, ErrorSpec{1e-3, 1e-3}));
+
+  TF_ASSERT_OK_AND_ASSIGN(AutotuneResults results, ReadResults());
+  ASSERT_EQ(results.results_size(), 1);
+  EXPECT_TRUE(results.results(0).result().has_cpu_dot());
+  EXPECT_TRUE(results.results(0).result().has_run_time());
+}
+
+TEST_F(CpuDotAutotuningTest, UsesSavedResult) {
+  TF_ASSERT_OK(GetOptimizedModule(kDotHlo).status());
+
+  // Replaces the result of the autotuner with a config it may not pick.
+  TF_ASSERT_OK_AND_ASSIGN(AutotuneResults results, ReadResults());
+  ASSERT_EQ(results.results_size(), 1);
+  AutotuneResult::CpuDotKey* config =
+      results.mutable_results(0)->mutable_result()->mutable_cpu_dot();
+  config->set_strategy(AutotuneResult::CpuDotKey::STRATEGY_TILED_LLVM_IR_GEMM);
+  config->set_tile_size_m(4);
+  config->set_tile_size_k(16);
+  config->set_tile_size_n_in_vector_width(2);
+  std::string data;
+  ASSERT_TRUE(tsl::protobuf::TextFormat::PrintToString(results, &data));
+  TF_ASSERT_OK(
+      tsl::WriteStringToFile(tsl::Env::Default(), results_path_, data));
+  DotAutotuner::ClearResults();
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> module,
+                          GetOptimizedModule(kDotHlo));
+  const HloInstruction* dot = FindInstruction(module.get(), HloOpcode::kDot);
+  ASSERT_NE(dot, nullptr);
+  TF_ASSERT_OK_AND_ASSIGN(BackendConfig backend_config,
+                          dot->backend_config<BackendConfig>());
+  EXPECT_EQ(backend_config.dot_config().strategy(),
+            AutotuneResult::CpuDotKey::STRATEGY_TILED_LLVM_IR_GEMM);
+  EXPECT_EQ(backend_config.dot_config().tile_size_m(), 4);
+  EXPECT_EQ(backend_config.dot_config().tile_size_k(), 16);
+  EXPECT_EQ(backend_config.dot_config().tile_size_n_in_vector_width(), 2);
+
+  // The saved result is not benchmarked again.
+  TF_ASSERT_OK_AND_ASSIGN(AutotuneResults saved_results, ReadResults());
+  EXPECT_EQ(saved_results.results(0).result().cpu_dot().tile_size_m(), 4);
+}
+
+TEST_F(CpuDotAutotuningTest, CandidatesIncludeDefaultTileSize) {
+  bool has_default = false;
+  for (const AutotuneResult::CpuDotKey& candidate :
+       DotAutotuner::GetCandidates(
+           {DotImplementationStrategy::kTiledLlvmIrGemm})) {
+    has_default |= candidate.tile_size_m() == 11 &&
+                   candidate.tile_size_k() == 9 &&
+                   candidate.tile_size_n_in_vector_width() == 1;
+  }
+  EXPECT_TRUE(has_default);
+  EXPECT_EQ(
+      DotAutotuner::GetCandidates({DotImplementationStrategy::kEigen}).size(),
+      1);
+  EXPECT_TRUE(
+      DotAutotuner::GetCandidates({DotImplementationStrategy::kNaiveLlvmIr})
+          .empty());
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
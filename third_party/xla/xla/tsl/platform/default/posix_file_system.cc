@@ -22,6 +22,7 @@ limitations under the License.
 
 #if defined(__linux__)
 #include <sys/sendfile.h>
+#include <sys/syscall.h>
 #endif
 #include <sys/stat.h>
 #include <sys/time.h>
@@ -29,6 +30,30 @@ limitations under the License.
 #include <time.h>
 #include <unistd.h>
 
+// Batched reads use io_uring when the kernel headers declare IORING_OP_READ,
+// which was added with IORING_FEAT_RW_CUR_POS in Linux 5.6.
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && \
+    defined(IORING_FEAT_RW_CUR_POS)
+#define TSL_POSIX_FILE_SYSTEM_USE_IO_URING 1
+#endif
+#endif
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+
 #include "xla/tsl/platform/default/posix_file_system.h"
 #include "xla/tsl/protobuf/error_codes.pb.h"
 #include "tsl/platform/env.h"
@@ -45,6 +70,221 @@ using ::tsl::errors::IOError;
 // 128KB of copy buffer
 constexpr size_t kPosixCopyFileBufferSize = 128 * 1024;
 
+#if defined(TSL_POSIX_FILE_SYSTEM_USE_IO_URING)
+
+// A minimal io_uring, which lets a single thread keep many reads in flight.
+// Not thread-safe: each thread uses its own ring.
+class IoUring {
+ public:
+  // Returns the ring of the calling thread, or nullptr if io_uring is not
+  // available, e.g. because a seccomp filter blocks it.
+  static IoUring* ForCurrentThread() {
+    static std::atomic<bool> unavailable(false);
+    if (unavailable.load(std::memory_order_relaxed)) return nullptr;
+    thread_local std::unique_ptr<IoUring> ring = [] {
+      std::unique_ptr<IoUring> ring = Create();
+      if (ring == nullptr) unavailable.store(true, std::memory_order_relaxed);
+      return ring;
+    }();
+    return ring.get();
+  }
+
+  ~IoUring() {
+    if (sqes_ != nullptr) munmap(sqes_, sqes_size_);
+    if (cq_ring_ != nullptr) munmap(cq_ring_, cq_ring_size_);
+    if (sq_ring_ != nullptr) munmap(sq_ring_, sq_ring_size_);
+    close(ring_fd_);
+  }
+
+  // Reads `requests` from `fd`, and returns the first non-OK status of the
+  // requests. Reads that io_uring fails are retried with `file.Read()`. If
+  // io_uring_enter() fails, the reads in flight are waited for, and the
+  // requests not read in full fail with its error.
+  absl::Status Read(int fd, absl::Span<RandomAccessFile::ReadRequest> requests,
+                    const RandomAccessFile& file) {
+    // The number of bytes read by each request so far.
+    std::vector<size_t> bytes_read(requests.size(), 0);
+    // The requests to submit, including the rest of short reads.
+    std::deque<size_t> pending;
+    for (size_t i = 0; i < requests.size(); ++i) {
+      requests[i].status = absl::OkStatus();
+      if (requests[i].n > 0) pending.push_back(i);
+    }
+
+    // The number of reads in the submission queue, including the ones not
+    // submitted yet, or in flight.
+    unsigned num_reads = 0;
+    unsigned num_unsubmitted = 0;
+    // The error of io_uring_enter(), after which nothing is submitted.
+    absl::Status enter_status;
+    while ((enter_status.ok() && !pending.empty()) || num_reads > 0) {
+      // Only this thread writes the tail of the submission queue.
+      unsigned sq_tail = *sq_tail_;
+      while (enter_status.ok() && !pending.empty() &&
+             num_reads < num_entries_) {
+        size_t i = pending.front();
+        pending.pop_front();
+        RandomAccessFile::ReadRequest& request = requests[i];
+
+        unsigned index = sq_tail & sq_mask_;
+        io_uring_sqe* sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(request.scratch + bytes_read[i]);
+        // Splits reads into at most INT32_MAX bytes, as Read() does.
+        sqe->len = std::min<size_t>(request.n - bytes_read[i], INT32_MAX);
+        sqe->off = request.offset + bytes_read[i];
+        sqe->user_data = i;
+        sq_array_[index] = index;
+
+        ++sq_tail;
+        ++num_reads;
+        ++num_unsubmitted;
+      }
+      __atomic_store_n(sq_tail_, sq_tail, __ATOMIC_RELEASE);
+
+      int submitted = syscall(__NR_io_uring_enter, ring_fd_, num_unsubmitted,
+                              /*min_complete=*/1, IORING_ENTER_GETEVENTS,
+                              /*sig=*/nullptr, /*sigsz=*/0);
+      if (submitted < 0) {
+        if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+        if (enter_status.ok()) {
+          enter_status = IOError("io_uring_enter()", errno);
+          // Takes back the reads the kernel hasn't consumed, so that the next
+          // Read() on this ring doesn't submit them.
+          __atomic_store_n(sq_tail_, sq_tail - num_unsubmitted,
+                           __ATOMIC_RELEASE);
+          num_reads -= num_unsubmitted;
+          num_unsubmitted = 0;
+        }
+        // The kernel may still write into the scratch buffers of the reads in
+        // flight, so keep reaping them before returning.
+        continue;
+      }
+      num_unsubmitted -= submitted;
+
+      unsigned cq_head = *cq_head_;
+      unsigned cq_tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      for (; cq_head != cq_tail; ++cq_head) {
+        const io_uring_cqe& cqe = cqes_[cq_head & cq_mask_];
+        size_t i = cqe.user_data;
+        RandomAccessFile::ReadRequest& request = requests[i];
+        --num_reads;
+
+        if (cqe.res > 0) {
+          bytes_read[i] += cqe.res;
+          if (bytes_read[i] < request.n) pending.push_back(i);
+        } else if (cqe.res == 0) {
+          request.status = absl::Status(absl::StatusCode::kOutOfRange,
+                                        "Read less bytes than requested");
+        } else if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+          pending.push_back(i);
+        } else {
+          absl::string_view result;
+          request.status = file.Read(
+              request.offset + bytes_read[i], request.n - bytes_read[i],
+              &result, request.scratch + bytes_read[i]);
+          bytes_read[i] += result.size();
+        }
+      }
+      __atomic_store_n(cq_head_, cq_head, __ATOMIC_RELEASE);
+    }
+
+    absl::Status status;
+    for (size_t i = 0; i < requests.size(); ++i) {
+      RandomAccessFile::ReadRequest& request = requests[i];
+      request.result = absl::string_view(request.scratch, bytes_read[i]);
+      if (request.status.ok() && bytes_read[i] < request.n) {
+        request.status = enter_status;
+      }
+      status.Update(request.status);
+    }
+    return status;
+  }
+
+ private:
+  // The number of entries of the submission queue.
+  static constexpr unsigned kNumEntries = 64;
+
+  explicit IoUring(int ring_fd) : ring_fd_(ring_fd) {}
+
+  static std::unique_ptr<IoUring> Create() {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int ring_fd = syscall(__NR_io_uring_setup, kNumEntries, &params);
+    if (ring_fd < 0) {
+      VLOG(1) << "io_uring is not available: " << strerror(errno);
+      return nullptr;
+    }
+    // Kernels without IORING_FEAT_RW_CUR_POS predate IORING_OP_READ.
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+      VLOG(1) << "io_uring doesn't support IORING_OP_READ";
+      close(ring_fd);
+      return nullptr;
+    }
+    std::unique_ptr<IoUring> ring(new IoUring(ring_fd));
+    if (!ring->Map(params)) {
+      VLOG(1) << "Failed to map the io_uring queues: " << strerror(errno);
+      return nullptr;
+    }
+    return ring;
+  }
+
+  // Maps the submission and completion queues of the ring.
+  bool Map(const io_uring_params& params) {
+    auto map = [&](size_t size, off_t offset) -> char* {
+      void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+      return ptr == MAP_FAILED ? nullptr : static_cast<char*>(ptr);
+    };
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+
+    char* sq_ring = map(sq_ring_size_, IORING_OFF_SQ_RING);
+    sq_ring_ = sq_ring;
+    char* cq_ring = map(cq_ring_size_, IORING_OFF_CQ_RING);
+    cq_ring_ = cq_ring;
+    sqes_ = reinterpret_cast<io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+    if (sq_ring == nullptr || cq_ring == nullptr || sqes_ == nullptr) {
+      return false;
+    }
+
+    num_entries_ = params.sq_entries;
+    sq_tail_ = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq_ring + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq_ring + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq_ring + params.cq_off.cqes);
+    return true;
+  }
+
+  int ring_fd_;
+  unsigned num_entries_ = 0;
+
+  void* sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  unsigned* sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned* sq_array_ = nullptr;
+  io_uring_sqe* sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  void* cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  io_uring_cqe* cqes_ = nullptr;
+};
+
+#endif  // TSL_POSIX_FILE_SYSTEM_USE_IO_URING
+
 // pread() based random-access
 class PosixRandomAccessFile : public RandomAccessFile {
  private:
@@ -97,6 +337,20 @@ class PosixRandomAccessFile : public RandomAccessFile {
     return s;
   }
 
+  void ReadBatch(absl::Span<ReadRequest> requests,
+                 std::function<void(const absl::Status&)> done) const override {
+#if defined(TSL_POSIX_FILE_SYSTEM_USE_IO_URING)
+    // A single read gains nothing from io_uring.
+    IoUring* ring =
+        requests.size() > 1 ? IoUring::ForCurrentThread() : nullptr;
+    if (ring != nullptr) {
+      done(ring->Read(fd_, requests, *this));
+      return;
+    }
+#endif
+    RandomAccessFile::ReadBatch(requests, std::move(done));
+  }
+
 #if defined(TF_CORD_SUPPORT)
   absl::Status Read(uint64 offset, size_t n, absl::Cord* cord) const override {
     if (n == 0) {